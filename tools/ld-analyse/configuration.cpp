@@ -24,8 +24,10 @@
 
 #include "configuration.h"
 
+#include "framecache.h"
+
 // This define should be incremented if the settings file format changes
-static const qint32 SETTINGSVERSION = 4;
+static const qint32 SETTINGSVERSION = 5;
 
 Configuration::Configuration(QObject *parent) : QObject(parent)
 {
@@ -80,6 +82,11 @@ void Configuration::writeConfiguration(void)
     configuration->setValue("chromaDecoderConfigDialogGeometry", settings.windows.chromaDecoderConfigDialogGeometry);
     configuration->endGroup();
 
+    // Decoding
+    configuration->beginGroup("decoding");
+    configuration->setValue("frameCacheSize", settings.decoding.frameCacheSize);
+    configuration->endGroup();
+
     // Sync the settings with disk
     qDebug() << "Configuration::writeConfiguration(): Writing configuration to disk";
     configuration->sync();
@@ -111,6 +118,11 @@ void Configuration::readConfiguration(void)
     settings.windows.closedCaptionDialogGeometry = configuration->value("closedCaptionDialogGeometry").toByteArray();
     settings.windows.chromaDecoderConfigDialogGeometry = configuration->value("chromaDecoderConfigDialogGeometry").toByteArray();
     configuration->endGroup();
+
+    // Decoding
+    configuration->beginGroup("decoding");
+    settings.decoding.frameCacheSize = configuration->value("frameCacheSize").toInt();
+    configuration->endGroup();
 }
 
 void Configuration::setDefault(void)
@@ -134,6 +146,9 @@ void Configuration::setDefault(void)
     settings.windows.closedCaptionDialogGeometry = QByteArray();
     settings.windows.chromaDecoderConfigDialogGeometry = QByteArray();
 
+    // Decoding
+    settings.decoding.frameCacheSize = FrameCache::DEFAULT_SIZE_MB;
+
     // Write the configuration
     writeConfiguration();
 }
@@ -261,3 +276,14 @@ QByteArray Configuration::getChromaDecoderConfigDialogGeometry(void)
 {
     return settings.windows.chromaDecoderConfigDialogGeometry;
 }
+
+// Decoding
+void Configuration::setFrameCacheSize(qint32 frameCacheSize)
+{
+    settings.decoding.frameCacheSize = frameCacheSize;
+}
+
+qint32 Configuration::getFrameCacheSize(void)
+{
+    return settings.decoding.frameCacheSize;
+}
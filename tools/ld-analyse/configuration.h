@@ -71,6 +71,10 @@ public:
     void setChromaDecoderConfigDialogGeometry(QByteArray chromaDecoderConfigDialogGeometry);
     QByteArray getChromaDecoderConfigDialogGeometry(void);
 
+    // Get and set methods - decoding
+    void setFrameCacheSize(qint32 frameCacheSize);
+    qint32 getFrameCacheSize(void);
+
 signals:
 
 public slots:
@@ -98,11 +102,17 @@ private:
         QByteArray chromaDecoderConfigDialogGeometry;
     };
 
+    // Decoding settings
+    struct Decoding {
+        qint32 frameCacheSize; // Maximum memory used for decoded frames, in megabytes
+    };
+
     // Overall settings structure
     struct Settings {
         qint32 version;
         Directories directories;
         Windows windows;
+        Decoding decoding;
     } settings;
 
     void setDefault(void);
@@ -25,6 +25,7 @@
 #include "dropoutanalysisdialog.h"
 #include "ui_dropoutanalysisdialog.h"
 
+#include <QEvent>
 #include <QPen>
 
 DropoutAnalysisDialog::DropoutAnalysisDialog(QWidget *parent) :
@@ -40,7 +41,6 @@ DropoutAnalysisDialog::DropoutAnalysisDialog(QWidget *parent) :
     panner = new QwtPlotPanner(plot->canvas());
     grid = new QwtPlotGrid();
     curve = new QwtPlotCurve();
-    points = new QPolygonF();
     plotMarker = new QwtPlotMarker();
 
     ui->verticalLayout->addWidget(plot);
@@ -51,6 +51,9 @@ DropoutAnalysisDialog::DropoutAnalysisDialog(QWidget *parent) :
     // Set the default number of frames
     numberOfFrames = 0;
 
+    // Resample the curve when the canvas changes size
+    plot->canvas()->installEventFilter(this);
+
     // Connect to scale changed slot
     connect(((QObject*)plot->axisWidget(QwtPlot::xBottom)) , SIGNAL(scaleDivChanged() ), this, SLOT(scaleDivChangedSlot() ));
 }
@@ -66,24 +69,23 @@ void DropoutAnalysisDialog::startUpdate(qint32 _numberOfFrames)
 {
     removeChartContents();
     numberOfFrames = _numberOfFrames;
-    points->reserve(numberOfFrames);
 }
 
 // Remove the axes and series from the chart, giving ownership back to this object
 void DropoutAnalysisDialog::removeChartContents()
 {
     maxY = 0;
-    points->clear();
+    graphData = GraphData();
     plot->replot();
 }
 
-// Add a data point to the chart
-void DropoutAnalysisDialog::addDataPoint(qint32 frameNumber, qreal doLength)
+// Set the data to plot
+void DropoutAnalysisDialog::setGraphData(const GraphData &_graphData)
 {
-    points->append(QPointF(frameNumber, doLength));
+    graphData = _graphData;
 
     // Keep track of the maximum Y value
-    if (doLength > maxY) maxY = doLength;
+    if (graphData.getMaximum() > maxY) maxY = graphData.getMaximum();
 }
 
 // Finish the update and render the graph
@@ -109,7 +111,6 @@ void DropoutAnalysisDialog::finishUpdate(qint32 _currentFrameNumber)
     curve->setTitle("Dropout length");
     curve->setPen(Qt::darkMagenta, 1);
     curve->setRenderHint(QwtPlotItem::RenderAntialiased, true);
-    curve->setSamples(*points);
     curve->attach(plot);
 
     // Define the plot marker
@@ -118,8 +119,9 @@ void DropoutAnalysisDialog::finishUpdate(qint32 _currentFrameNumber)
     plotMarker->setXValue(static_cast<double>(_currentFrameNumber));
     plotMarker->attach(plot);
 
-    // Update the axis
+    // Update the axis, and fetch the points to plot for it
     plot->updateAxes();
+    updateCurve();
 
     // Update the plot zoomer base
     zoomer->setZoomBase(true);
@@ -155,6 +157,23 @@ void DropoutAnalysisDialog::scaleDivChangedSlot()
         plot->setAxisScale(QwtPlot::xBottom, 0, numberOfFrames, (numberOfFrames / 10));
         if (maxY < 10) plot->setAxisScale(QwtPlot::yLeft, 0, 10);
         else plot->setAxisScale(QwtPlot::yLeft, 0, maxY);
+        updateCurve();
         plot->replot();
+    } else {
+        updateCurve();
     }
 }
+
+bool DropoutAnalysisDialog::eventFilter(QObject *object, QEvent *event)
+{
+    if (object == plot->canvas() && event->type() == QEvent::Resize) updateCurve();
+
+    return QDialog::eventFilter(object, event);
+}
+
+// Fetch points for the visible part of the graph, at the canvas's resolution
+void DropoutAnalysisDialog::updateCurve()
+{
+    const QwtScaleDiv &xScaleDiv = plot->axisScaleDiv(QwtPlot::xBottom);
+    curve->setSamples(graphData.getPoints(xScaleDiv.lowerBound(), xScaleDiv.upperBound(), plot->canvas()->width()));
+}
@@ -0,0 +1,165 @@
+/************************************************************************
+
+    framecache.cpp
+
+    ld-analyse - TBC output analysis
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "framecache.h"
+
+#include <QMutexLocker>
+
+// Definitions of static constexpr data members, for compatibility with
+// pre-C++17 compilers
+constexpr qint32 FrameCache::DEFAULT_SIZE_MB;
+
+FrameCache::FrameCache(SourceVideo &sourceVideo, QMutex &sourceMutex, const LdDecodeMetaData &ldDecodeMetaData,
+                       QObject *parent)
+    : QThread(parent), frameDecoder(sourceVideo, sourceMutex, ldDecodeMetaData),
+      stopRequested(false), chromaOn(false), prefetchingFrame(-1)
+{
+    setMaximumSize(DEFAULT_SIZE_MB);
+}
+
+FrameCache::~FrameCache()
+{
+    {
+        QMutexLocker locker(&mutex);
+        stopRequested = true;
+        prefetchFrames.clear();
+        prefetchAvailable.wakeAll();
+    }
+
+    wait();
+}
+
+void FrameCache::setMaximumSize(qint32 megabytes)
+{
+    QMutexLocker locker(&mutex);
+
+    frames.setMaxCost(qMax(megabytes, 1) * 1024);
+}
+
+void FrameCache::setChromaOn(bool _chromaOn)
+{
+    QMutexLocker locker(&mutex);
+
+    cancelPrefetchLocked();
+    frames.clear();
+
+    chromaOn = _chromaOn;
+}
+
+void FrameCache::setConfiguration(const PalColour::Configuration &palConfiguration,
+                                  const Comb::Configuration &ntscConfiguration,
+                                  const OutputWriter::Configuration &outputConfiguration)
+{
+    QMutexLocker locker(&mutex);
+
+    // The prefetch thread must be idle while its decoder is reconfigured
+    cancelPrefetchLocked();
+    frames.clear();
+
+    frameDecoder.setConfiguration(palConfiguration, ntscConfiguration, outputConfiguration);
+}
+
+bool FrameCache::getFrame(qint32 frameNumber, bool needComponentFrame, DecodedFrame &frame)
+{
+    QMutexLocker locker(&mutex);
+
+    // If the prefetch thread is decoding this frame, it'll be ready sooner
+    // than if we decode it ourselves
+    while (prefetchingFrame == frameNumber) prefetchFinished.wait(&mutex);
+
+    const DecodedFrame *cachedFrame = frames.object(frameNumber);
+    if (cachedFrame == nullptr) return false;
+    if (needComponentFrame && !cachedFrame->hasComponentFrame) return false;
+
+    frame = *cachedFrame;
+    return true;
+}
+
+void FrameCache::insertFrame(qint32 frameNumber, const DecodedFrame &frame)
+{
+    QMutexLocker locker(&mutex);
+
+    insertFrameLocked(frameNumber, frame);
+}
+
+void FrameCache::prefetch(const QVector<qint32> &frameNumbers)
+{
+    QMutexLocker locker(&mutex);
+
+    prefetchFrames = frameNumbers;
+    if (!isRunning()) start(QThread::LowPriority);
+    prefetchAvailable.wakeAll();
+}
+
+void FrameCache::clear()
+{
+    QMutexLocker locker(&mutex);
+
+    cancelPrefetchLocked();
+    frames.clear();
+}
+
+void FrameCache::run()
+{
+    QMutexLocker locker(&mutex);
+
+    while (!stopRequested) {
+        if (prefetchFrames.isEmpty()) {
+            prefetchAvailable.wait(&mutex);
+            continue;
+        }
+
+        const qint32 frameNumber = prefetchFrames.takeFirst();
+        if (frames.contains(frameNumber)) continue;
+
+        // Decode the frame without holding the lock, so the cache can still
+        // be used in the meantime
+        prefetchingFrame = frameNumber;
+        const bool decodeChroma = chromaOn;
+        locker.unlock();
+
+        const DecodedFrame frame = frameDecoder.decodeFrame(frameNumber, decodeChroma, false);
+
+        locker.relock();
+        insertFrameLocked(frameNumber, frame);
+        prefetchingFrame = -1;
+        prefetchFinished.wakeAll();
+    }
+}
+
+// Discard any pending prefetches, and wait for the one in progress to finish.
+// You must hold mutex to call this.
+void FrameCache::cancelPrefetchLocked()
+{
+    prefetchFrames.clear();
+    while (prefetchingFrame != -1) prefetchFinished.wait(&mutex);
+}
+
+// Add a frame to the cache. You must hold mutex to call this.
+void FrameCache::insertFrameLocked(qint32 frameNumber, const DecodedFrame &frame)
+{
+    // If the frame is bigger than the whole cache, QCache will discard it
+    const qint32 cost = static_cast<qint32>(qMax(frame.getSize() / 1024, static_cast<qint64>(1)));
+    frames.insert(frameNumber, new DecodedFrame(frame), cost);
+}
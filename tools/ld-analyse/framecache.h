@@ -0,0 +1,107 @@
+/************************************************************************
+
+    framecache.h
+
+    ld-analyse - TBC output analysis
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "framedecoder.h"
+
+// A cache of decoded frames, with a thread that decodes the frames the user
+// is likely to look at next.
+//
+// The least recently used frames are discarded when the cache is over its
+// maximum size. All the frames in the cache were decoded with the same
+// options; clear it (or set a new configuration) when they change.
+//
+// The prefetch thread works through the list of frames given to prefetch()
+// in order, skipping any that are already cached. A new list replaces the old
+// one, so stale requests are dropped when the user moves to another frame.
+//
+// Apart from the prefetch thread, only one thread should use the cache.
+class FrameCache : public QThread
+{
+    Q_OBJECT
+public:
+    // Default maximum size of the cache, in megabytes
+    static constexpr qint32 DEFAULT_SIZE_MB = 512;
+
+    FrameCache(SourceVideo &sourceVideo, QMutex &sourceMutex, const LdDecodeMetaData &ldDecodeMetaData,
+               QObject *parent = nullptr);
+    ~FrameCache() override;
+
+    // Set the maximum size of the cache, in megabytes
+    void setMaximumSize(qint32 megabytes);
+
+    // Set the options to decode frames with. These clear the cache.
+    void setChromaOn(bool chromaOn);
+    void setConfiguration(const PalColour::Configuration &palConfiguration,
+                          const Comb::Configuration &ntscConfiguration,
+                          const OutputWriter::Configuration &outputConfiguration);
+
+    // Get a frame from the cache, waiting for it if it's being prefetched.
+    // Returns false if it's not cached, or doesn't have the ComponentFrame
+    // when one is needed.
+    bool getFrame(qint32 frameNumber, bool needComponentFrame, DecodedFrame &frame);
+
+    // Add a frame to the cache
+    void insertFrame(qint32 frameNumber, const DecodedFrame &frame);
+
+    // Set the frames to decode in the background, in order of priority
+    void prefetch(const QVector<qint32> &frameNumbers);
+
+    // Cancel any prefetching, and empty the cache. The metadata and
+    // SourceVideo can be changed once this returns, until the next call to
+    // prefetch().
+    void clear();
+
+protected:
+    void run() override;
+
+private:
+    // Decoder for the prefetch thread
+    FrameDecoder frameDecoder;
+
+    // Everything below is guarded by mutex
+    QMutex mutex;
+    QWaitCondition prefetchAvailable;
+    QWaitCondition prefetchFinished;
+    bool stopRequested;
+    bool chromaOn;
+    QVector<qint32> prefetchFrames;
+    qint32 prefetchingFrame;
+
+    // Decoded frames, with their sizes in kilobytes as the cost
+    QCache<qint32, DecodedFrame> frames;
+
+    void cancelPrefetchLocked();
+    void insertFrameLocked(qint32 frameNumber, const DecodedFrame &frame);
+};
+
+#endif // FRAMECACHE_H
@@ -0,0 +1,195 @@
+/************************************************************************
+
+    framedecoder.cpp
+
+    ld-analyse - TBC output analysis
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "framedecoder.h"
+
+#include <QDebug>
+#include <QMutexLocker>
+
+#include <utility>
+
+qint64 DecodedFrame::getSize() const
+{
+    qint64 size = static_cast<qint64>(firstFieldData.size() + secondFieldData.size()) * sizeof(quint16);
+    size += static_cast<qint64>(image.bytesPerLine()) * image.height();
+
+    // Y, U and V
+    if (hasComponentFrame) {
+        size += static_cast<qint64>(componentFrame.getWidth()) * componentFrame.getHeight() * 3 * sizeof(double);
+    }
+
+    return size;
+}
+
+FrameDecoder::FrameDecoder(SourceVideo &_sourceVideo, QMutex &_sourceMutex, const LdDecodeMetaData &_ldDecodeMetaData)
+    : sourceVideo(_sourceVideo), sourceMutex(_sourceMutex), ldDecodeMetaData(_ldDecodeMetaData),
+      configurationApplied(false)
+{
+}
+
+void FrameDecoder::setConfiguration(const PalColour::Configuration &_palConfiguration,
+                                    const Comb::Configuration &_ntscConfiguration,
+                                    const OutputWriter::Configuration &_outputConfiguration)
+{
+    palConfiguration = _palConfiguration;
+    ntscConfiguration = _ntscConfiguration;
+    outputConfiguration = _outputConfiguration;
+    configurationApplied = false;
+}
+
+DecodedFrame FrameDecoder::decodeFrame(qint32 frameNumber, bool chromaOn, bool needComponentFrame)
+{
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    const bool decodeChroma = chromaOn || needComponentFrame;
+
+    // Configure the chroma decoder
+    if (!configurationApplied) {
+        if (videoParameters.isSourcePal) {
+            palColour.updateConfiguration(videoParameters, palConfiguration);
+        } else {
+            ntscColour.updateConfiguration(videoParameters, ntscConfiguration);
+        }
+
+        // Because we have padding disabled, this won't change the VideoParameters.
+        outputWriter.updateConfiguration(videoParameters, outputConfiguration);
+
+        configurationApplied = true;
+    }
+
+    // Work out how many frames ahead/behind we need to fetch
+    qint32 lookBehind = 0;
+    qint32 lookAhead = 0;
+    if (decodeChroma) {
+        if (videoParameters.isSourcePal) {
+            lookBehind = palConfiguration.getLookBehind();
+            lookAhead = palConfiguration.getLookAhead();
+        } else {
+            lookBehind = ntscConfiguration.getLookBehind();
+            lookAhead = ntscConfiguration.getLookAhead();
+        }
+    }
+
+    // Fetch the input fields and metadata
+    qint32 inputStartIndex, inputEndIndex;
+    {
+        QMutexLocker locker(&sourceMutex);
+        SourceField::loadFields(sourceVideo, ldDecodeMetaData,
+                                frameNumber, 1, lookBehind, lookAhead,
+                                inputFields, inputStartIndex, inputEndIndex);
+    }
+
+    DecodedFrame frame;
+    frame.firstFieldData = inputFields[inputStartIndex].data;
+    frame.secondFieldData = inputFields[inputStartIndex + 1].data;
+
+    if (decodeChroma) {
+        // Decode the frame to components
+        componentFrames.resize(1);
+        if (videoParameters.isSourcePal) {
+            // PAL source
+            palColour.decodeFrames(inputFields, inputStartIndex, inputEndIndex, componentFrames);
+        } else {
+            // NTSC source
+            ntscColour.decodeFrames(inputFields, inputStartIndex, inputEndIndex, componentFrames);
+        }
+
+        frame.hasComponentFrame = true;
+        frame.componentFrame = std::move(componentFrames[0]);
+    }
+
+    frame.image = generateQImage(frameNumber, videoParameters, chromaOn, frame);
+
+    return frame;
+}
+
+// Method to create a QImage for a source video frame
+QImage FrameDecoder::generateQImage(qint32 frameNumber, const LdDecodeMetaData::VideoParameters &videoParameters,
+                                    bool chromaOn, const DecodedFrame &frame)
+{
+    // Calculate the frame height
+    qint32 frameHeight = (videoParameters.fieldHeight * 2) - 1;
+
+    // Show debug information
+    if (chromaOn) {
+        qDebug().nospace() << "FrameDecoder::generateQImage(): Generating a chroma image from frame " << frameNumber <<
+                    " (" << videoParameters.fieldWidth << "x" << frameHeight << ")";
+    } else {
+        qDebug().nospace() << "FrameDecoder::generateQImage(): Generating a source image from frame " << frameNumber <<
+                    " (" << videoParameters.fieldWidth << "x" << frameHeight << ")";
+    }
+
+    // Create a QImage
+    QImage frameImage = QImage(videoParameters.fieldWidth, frameHeight, QImage::Format_RGB888);
+
+    if (chromaOn) {
+        // Convert component video to RGB
+        OutputFrame outputFrame;
+        outputWriter.convert(frame.componentFrame, outputFrame);
+
+        // Get a pointer to the RGB data
+        const quint16 *rgbPointer = outputFrame.data();
+
+        // Fill the QImage with black
+        frameImage.fill(Qt::black);
+
+        // Copy the RGB16-16-16 data into the RGB888 QImage
+        const qint32 activeHeight = videoParameters.lastActiveFrameLine - videoParameters.firstActiveFrameLine;
+        const qint32 activeWidth = videoParameters.activeVideoEnd - videoParameters.activeVideoStart;
+        for (qint32 y = 0; y < activeHeight; y++) {
+            const quint16 *inputLine = rgbPointer + (y * activeWidth * 3);
+            uchar *outputLine = frameImage.scanLine(y + videoParameters.firstActiveFrameLine)
+                                + (videoParameters.activeVideoStart * 3);
+
+            // Take just the MSB of the RGB input data
+            for (qint32 i = 0; i < activeWidth * 3; i++) {
+                *outputLine++ = static_cast<uchar>((*inputLine++) / 256);
+            }
+        }
+    } else {
+        // Get pointers to the 16-bit greyscale data
+        const quint16 *firstFieldPointer = frame.firstFieldData.constData();
+        const quint16 *secondFieldPointer = frame.secondFieldData.constData();
+
+        // Copy the raw 16-bit grayscale data into the RGB888 QImage
+        for (qint32 y = 0; y < frameHeight; y++) {
+            for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
+                // Take just the MSB of the input data
+                qint32 pixelOffset = (videoParameters.fieldWidth * (y / 2)) + x;
+                uchar pixelValue;
+                if (y % 2) {
+                    pixelValue = static_cast<uchar>(secondFieldPointer[pixelOffset] / 256);
+                } else {
+                    pixelValue = static_cast<uchar>(firstFieldPointer[pixelOffset] / 256);
+                }
+
+                qint32 xpp = x * 3;
+                *(frameImage.scanLine(y) + xpp + 0) = static_cast<uchar>(pixelValue); // R
+                *(frameImage.scanLine(y) + xpp + 1) = static_cast<uchar>(pixelValue); // G
+                *(frameImage.scanLine(y) + xpp + 2) = static_cast<uchar>(pixelValue); // B
+            }
+        }
+    }
+
+    return frameImage;
+}
@@ -0,0 +1,105 @@
+/************************************************************************
+
+    framedecoder.h
+
+    ld-analyse - TBC output analysis
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QImage>
+#include <QMutex>
+#include <QVector>
+
+// TBC library includes
+#include "sourcevideo.h"
+#include "lddecodemetadata.h"
+
+// Chroma decoder includes
+#include "componentframe.h"
+#include "comb.h"
+#include "outputwriter.h"
+#include "palcolour.h"
+#include "sourcefield.h"
+
+// A frame decoded for display, along with the fields it was decoded from
+struct DecodedFrame {
+    SourceVideo::Data firstFieldData;
+    SourceVideo::Data secondFieldData;
+
+    // The frame as an RGB888 image: either the composite signal in
+    // greyscale, or the chroma decoder's output
+    QImage image;
+
+    // The chroma decoder's output, if it was needed
+    bool hasComponentFrame = false;
+    ComponentFrame componentFrame;
+
+    // Return the approximate amount of memory used, in bytes
+    qint64 getSize() const;
+};
+
+// Decodes frames from a TBC source for display.
+//
+// Each FrameDecoder has its own chroma decoder, so different threads can
+// decode frames at the same time using their own FrameDecoders. The metadata
+// must not be changed while a frame is being decoded, and all access to the
+// SourceVideo must hold sourceMutex.
+class FrameDecoder
+{
+public:
+    FrameDecoder(SourceVideo &sourceVideo, QMutex &sourceMutex, const LdDecodeMetaData &ldDecodeMetaData);
+
+    // Set the chroma decoder configuration. This takes effect when the next
+    // frame is decoded, using the video parameters of the source then.
+    void setConfiguration(const PalColour::Configuration &palConfiguration, const Comb::Configuration &ntscConfiguration,
+                          const OutputWriter::Configuration &outputConfiguration);
+
+    // Decode a frame. If chromaOn is true, the image is the chroma decoder's
+    // output; if not, the chroma decoder is only run if needComponentFrame
+    // is true.
+    DecodedFrame decodeFrame(qint32 frameNumber, bool chromaOn, bool needComponentFrame);
+
+private:
+    SourceVideo &sourceVideo;
+    QMutex &sourceMutex;
+    const LdDecodeMetaData &ldDecodeMetaData;
+
+    // Chroma decoder configuration
+    PalColour::Configuration palConfiguration;
+    Comb::Configuration ntscConfiguration;
+    OutputWriter::Configuration outputConfiguration;
+    bool configurationApplied;
+
+    // Chroma decoder objects
+    PalColour palColour;
+    Comb ntscColour;
+    OutputWriter outputWriter;
+
+    // Buffers reused between frames
+    QVector<SourceField> inputFields;
+    QVector<ComponentFrame> componentFrames;
+
+    QImage generateQImage(qint32 frameNumber, const LdDecodeMetaData::VideoParameters &videoParameters,
+                          bool chromaOn, const DecodedFrame &frame);
+};
+
+#endif // FRAMEDECODER_H
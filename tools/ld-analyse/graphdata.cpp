@@ -0,0 +1,242 @@
+/************************************************************************
+
+    graphdata.cpp
+
+    ld-analyse - TBC output analysis
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "graphdata.h"
+
+#include <cmath>
+#include <limits>
+
+GraphData::GraphData(const QVector<qreal> &values)
+{
+    if (values.isEmpty()) return;
+
+    Level valueLevel;
+    valueLevel.minimum = values;
+    valueLevel.maximum = values;
+    valueLevel.mean = values;
+    levels.append(valueLevel);
+
+    // The number of non-NaN values in each block, for weighting the means
+    QVector<qint32> belowCount(values.size());
+    for (qint32 i = 0; i < values.size(); i++) belowCount[i] = std::isnan(values[i]) ? 0 : 1;
+
+    // Build each level from the one below until there's a single block.
+    // fmin/fmax ignore NaN unless both arguments are NaN.
+    while (levels.last().minimum.size() > 1) {
+        const Level &below = levels.last();
+        const qint32 belowSize = below.minimum.size();
+        const qint32 size = (belowSize + 1) / 2;
+
+        Level level;
+        level.minimum.resize(size);
+        level.maximum.resize(size);
+        level.mean.resize(size);
+        QVector<qint32> count(size);
+        for (qint32 i = 0; i < size; i++) {
+            const qint32 first = 2 * i;
+            const qint32 second = first + 1;
+
+            // If there's an odd number of blocks, the last one is carried up
+            if (second == belowSize) {
+                level.minimum[i] = below.minimum[first];
+                level.maximum[i] = below.maximum[first];
+                level.mean[i] = below.mean[first];
+                count[i] = belowCount[first];
+                continue;
+            }
+
+            level.minimum[i] = std::fmin(below.minimum[first], below.minimum[second]);
+            level.maximum[i] = std::fmax(below.maximum[first], below.maximum[second]);
+
+            count[i] = belowCount[first] + belowCount[second];
+            if (count[i] == 0) {
+                level.mean[i] = std::numeric_limits<qreal>::quiet_NaN();
+            } else {
+                qreal total = 0;
+                if (belowCount[first] != 0) total += below.mean[first] * belowCount[first];
+                if (belowCount[second] != 0) total += below.mean[second] * belowCount[second];
+                level.mean[i] = total / count[i];
+            }
+        }
+
+        levels.append(level);
+        belowCount = count;
+    }
+}
+
+qint32 GraphData::size() const
+{
+    if (levels.isEmpty()) return 0;
+    return levels.first().minimum.size();
+}
+
+qreal GraphData::getMaximum() const
+{
+    if (levels.isEmpty()) return std::numeric_limits<qreal>::quiet_NaN();
+    return levels.last().maximum.first();
+}
+
+QPolygonF GraphData::getPoints(qreal firstFrame, qreal lastFrame, qint32 maxPoints) const
+{
+    QPolygonF points;
+    if (levels.isEmpty()) return points;
+
+    qint32 levelNumber, firstBlock, lastBlock;
+    findBlocks(firstFrame, lastFrame, maxPoints, levelNumber, firstBlock, lastBlock);
+    const Level &level = levels[levelNumber];
+    const qint32 blockSize = 1 << levelNumber;
+
+    points.reserve(2 * (lastBlock - firstBlock + 1));
+    for (qint32 block = firstBlock; block <= lastBlock; block++) {
+        const qreal minimum = level.minimum[block];
+        const qreal maximum = level.maximum[block];
+        if (std::isnan(minimum)) continue;
+
+        // Plot the block at the frame in its centre
+        const qreal x = (block * blockSize) + 1 + ((blockSize - 1) / 2.0);
+        points.append(QPointF(x, minimum));
+        if (maximum != minimum) points.append(QPointF(x, maximum));
+    }
+
+    return points;
+}
+
+QPolygonF GraphData::getMeanPoints(qreal firstFrame, qreal lastFrame, qint32 maxPoints) const
+{
+    QPolygonF points;
+    if (levels.isEmpty()) return points;
+
+    qint32 levelNumber, firstBlock, lastBlock;
+    findBlocks(firstFrame, lastFrame, maxPoints, levelNumber, firstBlock, lastBlock);
+    const Level &level = levels[levelNumber];
+    const qint32 blockSize = 1 << levelNumber;
+
+    points.reserve(lastBlock - firstBlock + 1);
+    for (qint32 block = firstBlock; block <= lastBlock; block++) {
+        const qreal mean = level.mean[block];
+        if (std::isnan(mean)) continue;
+
+        const qreal x = (block * blockSize) + 1 + ((blockSize - 1) / 2.0);
+        points.append(QPointF(x, mean));
+    }
+
+    return points;
+}
+
+// Read or write a vector's contents as raw data
+template <typename T>
+static bool readVector(QIODevice &device, QVector<T> &vector, qint32 size)
+{
+    // Check the data's there before allocating space for it
+    const qint64 bytes = static_cast<qint64>(size) * static_cast<qint64>(sizeof(T));
+    if (device.bytesAvailable() < bytes) return false;
+
+    vector.resize(size);
+    return device.read(reinterpret_cast<char *>(vector.data()), bytes) == bytes;
+}
+
+template <typename T>
+static bool writeVector(QIODevice &device, const QVector<T> &vector)
+{
+    const qint64 bytes = static_cast<qint64>(vector.size()) * static_cast<qint64>(sizeof(T));
+    return device.write(reinterpret_cast<const char *>(vector.constData()), bytes) == bytes;
+}
+
+// The data is written as the number of values, followed by the values, then
+// the minimum, maximum and mean of each level above them, in host byte order.
+// The sizes of the levels follow from the number of values.
+bool GraphData::write(QIODevice &device) const
+{
+    const qint32 numberOfValues = size();
+    if (device.write(reinterpret_cast<const char *>(&numberOfValues), sizeof(numberOfValues)) != sizeof(numberOfValues)) {
+        return false;
+    }
+
+    for (qint32 levelNumber = 0; levelNumber < levels.size(); levelNumber++) {
+        const Level &level = levels[levelNumber];
+        if (!writeVector(device, level.minimum)) return false;
+        if (levelNumber == 0) continue;
+        if (!writeVector(device, level.maximum) || !writeVector(device, level.mean)) return false;
+    }
+
+    return true;
+}
+
+bool GraphData::read(QIODevice &device)
+{
+    levels.clear();
+
+    qint32 numberOfValues;
+    if (device.read(reinterpret_cast<char *>(&numberOfValues), sizeof(numberOfValues)) != sizeof(numberOfValues)
+        || numberOfValues < 0) {
+        return false;
+    }
+    if (numberOfValues == 0) return true;
+
+    Level valueLevel;
+    if (!readVector(device, valueLevel.minimum, numberOfValues)) return false;
+    valueLevel.maximum = valueLevel.minimum;
+    valueLevel.mean = valueLevel.minimum;
+    levels.append(valueLevel);
+
+    qint32 size = numberOfValues;
+    while (size > 1) {
+        size = (size + 1) / 2;
+
+        Level level;
+        if (!readVector(device, level.minimum, size)
+            || !readVector(device, level.maximum, size)
+            || !readVector(device, level.mean, size)) {
+            levels.clear();
+            return false;
+        }
+        levels.append(level);
+    }
+
+    return true;
+}
+
+// Find the finest level that covers the range from firstFrame to lastFrame in
+// at most maxPoints blocks, and the blocks in that level that cover the range
+void GraphData::findBlocks(qreal firstFrame, qreal lastFrame, qint32 maxPoints,
+                           qint32 &levelNumber, qint32 &firstBlock, qint32 &lastBlock) const
+{
+    const qreal range = qMax(lastFrame - firstFrame, static_cast<qreal>(1));
+    maxPoints = qMax(maxPoints, 1);
+    levelNumber = 0;
+    while ((levelNumber + 1) < levels.size() && (range / static_cast<qreal>(1 << levelNumber)) > maxPoints) {
+        levelNumber++;
+    }
+    const Level &level = levels[levelNumber];
+    const qint32 blockSize = 1 << levelNumber;
+
+    // Include a block either side of the range, so the line runs to the edges
+    const qreal lastBlockNumber = static_cast<qreal>(level.minimum.size() - 1);
+    firstBlock = static_cast<qint32>(qBound(static_cast<qreal>(0),
+                                            std::floor((firstFrame - 1) / blockSize) - 1,
+                                            lastBlockNumber));
+    lastBlock = static_cast<qint32>(qBound(static_cast<qreal>(0),
+                                           std::floor((lastFrame - 1) / blockSize) + 1,
+                                           lastBlockNumber));
+}
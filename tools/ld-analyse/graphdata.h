@@ -0,0 +1,82 @@
+/************************************************************************
+
+    graphdata.h
+
+    ld-analyse - TBC output analysis
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef GRAPHDATA_H
+#define GRAPHDATA_H
+
+#include <QIODevice>
+#include <QPolygonF>
+#include <QVector>
+
+// A per-frame series for the analysis graphs.
+//
+// As well as the values themselves, this keeps a pyramid of summaries: each
+// level above the values holds the minimum, maximum and mean of pairs of
+// blocks in the level below it, so level n summarises blocks of 2^n frames. A
+// graph can then ask for just as many points as it has pixels to draw them
+// in, and still show every peak in the data.
+//
+// Values may be NaN where a frame has no data; these are left out of the
+// summaries and the graph.
+class GraphData
+{
+public:
+    GraphData() = default;
+    explicit GraphData(const QVector<qreal> &values);
+
+    // Return the number of frames
+    qint32 size() const;
+
+    // Return the largest value, or NaN if there are no values
+    qreal getMaximum() const;
+
+    // Return points to plot for frames firstFrame to lastFrame (numbered
+    // from 1), from the finest level that needs no more than maxPoints blocks
+    // to cover the range. Each block is plotted as a vertical line from its
+    // minimum to its maximum.
+    QPolygonF getPoints(qreal firstFrame, qreal lastFrame, qint32 maxPoints) const;
+
+    // As getPoints, but plot each block as a single point at its mean
+    QPolygonF getMeanPoints(qreal firstFrame, qreal lastFrame, qint32 maxPoints) const;
+
+    // Write the values and summaries to a cache file, or read them back.
+    // read() returns false if the data is truncated or inconsistent.
+    bool write(QIODevice &device) const;
+    bool read(QIODevice &device);
+
+private:
+    struct Level {
+        QVector<qreal> minimum;
+        QVector<qreal> maximum;
+        QVector<qreal> mean;
+    };
+
+    // Level 0 holds the values as the minimum, maximum and mean
+    QVector<Level> levels;
+
+    void findBlocks(qreal firstFrame, qreal lastFrame, qint32 maxPoints,
+                    qint32 &levelNumber, qint32 &firstBlock, qint32 &lastBlock) const;
+};
+
+#endif // GRAPHDATA_H
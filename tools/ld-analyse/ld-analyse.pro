@@ -37,8 +37,12 @@ SOURCES += \
     vbidialog.cpp \
     configuration.cpp \
     dropoutanalysisdialog.cpp \
+    framecache.cpp \
+    framedecoder.cpp \
+    graphdata.cpp \
     ../ld-chroma-decoder/palcolour.cpp \
     ../ld-chroma-decoder/comb.cpp \
+    ../ld-chroma-decoder/combkernels.cpp \
     ../ld-chroma-decoder/componentframe.cpp \
     ../ld-chroma-decoder/outputwriter.cpp \
     ../ld-chroma-decoder/transformpal.cpp \
@@ -46,12 +50,17 @@ SOURCES += \
     ../ld-chroma-decoder/transformpal3d.cpp \
     ../ld-chroma-decoder/framecanvas.cpp \
     ../ld-chroma-decoder/sourcefield.cpp \
+    ../library/tbc/fieldprefetcher.cpp \
+    ../library/tbc/jsonio.cpp \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/sourcevideo.cpp \
+    ../library/tbc/videobuffer.cpp \
+    ../library/tbc/videobufferpool.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/filters.cpp \
     ../library/tbc/logging.cpp \
     ../library/tbc/dropouts.cpp \
+    ../library/tbc/dropoutindex.cpp \
     visibledropoutanalysisdialog.cpp \
     whitesnranalysisdialog.cpp
 
@@ -67,8 +76,12 @@ HEADERS += \
     vbidialog.h \
     configuration.h \
     dropoutanalysisdialog.h \
+    framecache.h \
+    framedecoder.h \
+    graphdata.h \
     ../ld-chroma-decoder/palcolour.h \
     ../ld-chroma-decoder/comb.h \
+    ../ld-chroma-decoder/combkernels.h \
     ../ld-chroma-decoder/componentframe.h \
     ../ld-chroma-decoder/outputwriter.h \
     ../ld-chroma-decoder/transformpal.h \
@@ -76,13 +89,19 @@ HEADERS += \
     ../ld-chroma-decoder/transformpal3d.h \
     ../ld-chroma-decoder/framecanvas.h \
     ../ld-chroma-decoder/sourcefield.h \
+    ../library/cpu/cpufeatures.h \
     ../library/filter/firfilter.h \
+    ../library/tbc/fieldprefetcher.h \
+    ../library/tbc/jsonio.h \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/sourcevideo.h \
+    ../library/tbc/videobuffer.h \
+    ../library/tbc/videobufferpool.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/filters.h \
     ../library/tbc/logging.h \
     ../library/tbc/dropouts.h \
+    ../library/tbc/dropoutindex.h \
     visibledropoutanalysisdialog.h \
     whitesnranalysisdialog.h
 
@@ -100,6 +119,7 @@ FORMS += \
     whitesnranalysisdialog.ui
 
 # Add external includes to the include path
+INCLUDEPATH += ../library/cpu
 INCLUDEPATH += ../library/filter
 INCLUDEPATH += ../library/tbc
 INCLUDEPATH += ../ld-chroma-decoder
@@ -94,6 +94,7 @@ MainWindow::MainWindow(QString inputFilenameParam, QWidget *parent) :
     whiteSnrAnalysisDialog->restoreGeometry(configuration.getWhiteSnrAnalysisDialogGeometry());
     closedCaptionDialog->restoreGeometry(configuration.getClosedCaptionDialogGeometry());
     chromaDecoderConfigDialog->restoreGeometry(configuration.getChromaDecoderConfigDialogGeometry());
+    tbcSource.setFrameCacheSize(configuration.getFrameCacheSize());
 
     // Store the current button palette for the show dropouts button
     buttonPalette = ui->dropoutsPushButton->palette();
@@ -980,17 +981,10 @@ void MainWindow::on_finishedLoading()
         blackSnrAnalysisDialog->startUpdate(tbcSource.getNumberOfFrames());
         whiteSnrAnalysisDialog->startUpdate(tbcSource.getNumberOfFrames());
 
-        QVector<qreal> doGraphData = tbcSource.getDropOutGraphData();
-        QVector<qreal> visibleDoGraphData = tbcSource.getVisibleDropOutGraphData();
-        QVector<qreal> blackSnrGraphData = tbcSource.getBlackSnrGraphData();
-        QVector<qreal> whiteSnrGraphData = tbcSource.getWhiteSnrGraphData();
-
-        for (qint32 frameNumber = 0; frameNumber < tbcSource.getNumberOfFrames(); frameNumber++) {
-            dropoutAnalysisDialog->addDataPoint(frameNumber + 1, doGraphData[frameNumber]);
-            visibleDropoutAnalysisDialog->addDataPoint(frameNumber + 1, visibleDoGraphData[frameNumber]);
-            blackSnrAnalysisDialog->addDataPoint(frameNumber + 1, blackSnrGraphData[frameNumber]);
-            whiteSnrAnalysisDialog->addDataPoint(frameNumber + 1, whiteSnrGraphData[frameNumber]);
-        }
+        dropoutAnalysisDialog->setGraphData(tbcSource.getDropOutGraphData());
+        visibleDropoutAnalysisDialog->setGraphData(tbcSource.getVisibleDropOutGraphData());
+        blackSnrAnalysisDialog->setGraphData(tbcSource.getBlackSnrGraphData());
+        whiteSnrAnalysisDialog->setGraphData(tbcSource.getWhiteSnrGraphData());
 
         dropoutAnalysisDialog->finishUpdate(currentFrameNumber);
         visibleDropoutAnalysisDialog->finishUpdate(currentFrameNumber);
@@ -27,14 +27,22 @@
 
 #include "sourcefield.h"
 
-TbcSource::TbcSource(QObject *parent) : QObject(parent)
+#include <QSaveFile>
+#include <cstring>
+
+// Definitions of static constexpr data members, for compatibility with
+// pre-C++17 compilers
+constexpr qint32 TbcSource::PREFETCH_AHEAD;
+constexpr qint32 TbcSource::PREFETCH_BEHIND;
+
+TbcSource::TbcSource(QObject *parent) : QObject(parent),
+    frameDecoder(sourceVideo, sourceMutex, ldDecodeMetaData),
+    frameCache(sourceVideo, sourceMutex, ldDecodeMetaData)
 {
     resetState();
 
     // Configure the chroma decoder
-    palConfiguration = palColour.getConfiguration();
     palConfiguration.chromaFilter = PalColour::transform2DFilter;
-    ntscConfiguration = ntscColour.getConfiguration();
     outputConfiguration.pixelFormat = OutputWriter::PixelFormat::RGB48;
     outputConfiguration.paddingAmount = 1;
 }
@@ -65,8 +73,8 @@ void TbcSource::loadSource(QString sourceFilename)
 // Method to unload a TBC source file
 void TbcSource::unloadSource()
 {
-    sourceVideo.close();
     resetState();
+    sourceVideo.close();
 }
 
 // Method returns true is a TBC source is loaded
@@ -86,7 +94,8 @@ QString TbcSource::getCurrentSourceFilename()
 // Method to set the highlight dropouts mode (true = dropouts highlighted)
 void TbcSource::setHighlightDropouts(bool _state)
 {
-    invalidateFrameCache();
+    // The decoded frames don't include the highlighting, so they're still valid
+    frameImageValid = false;
     dropoutsOn = _state;
 }
 
@@ -95,12 +104,15 @@ void TbcSource::setChromaDecoder(bool _state)
 {
     invalidateFrameCache();
     chromaOn = _state;
+    frameCache.setChromaOn(chromaOn);
 }
 
 // Method to set the field order (true = reversed, false = normal)
 void TbcSource::setFieldOrder(bool _state)
 {
+    // Stop prefetching before changing the metadata
     invalidateFrameCache();
+    frameCache.clear();
     reverseFoOn = _state;
 
     if (reverseFoOn) ldDecodeMetaData.setIsFirstFieldFirst(false);
@@ -130,10 +142,21 @@ void TbcSource::loadFrame(qint32 frameNumber)
 {
     // If there's no source, or we've already loaded that frame, nothing to do
     if (!sourceReady || loadedFrameNumber == frameNumber) return;
+    const qint32 previousFrameNumber = loadedFrameNumber;
     loadedFrameNumber = frameNumber;
-    inputFieldsValid = false;
     invalidateFrameCache();
 
+    // Decode the frames the user is likely to look at next in the background.
+    // This replaces any earlier requests, so jumping elsewhere cancels them.
+    const qint32 direction = (frameNumber < previousFrameNumber) ? -1 : 1;
+    QVector<qint32> prefetchFrames;
+    for (qint32 i = 1; i <= PREFETCH_AHEAD; i++) prefetchFrames.append(frameNumber + (i * direction));
+    for (qint32 i = 1; i <= PREFETCH_BEHIND; i++) prefetchFrames.append(frameNumber - (i * direction));
+    for (qint32 i = prefetchFrames.size() - 1; i >= 0; i--) {
+        if (prefetchFrames[i] < 1 || prefetchFrames[i] > getNumberOfFrames()) prefetchFrames.remove(i);
+    }
+    frameCache.prefetch(prefetchFrames);
+
     // Get the required field numbers
     firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
     secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
@@ -155,6 +178,10 @@ void TbcSource::loadFrame(qint32 frameNumber)
     // Get the field metadata
     firstField = ldDecodeMetaData.getField(firstFieldNumber);
     secondField = ldDecodeMetaData.getField(secondFieldNumber);
+
+    // Index the fields' dropouts by line
+    firstFieldDropOutIndex = DropOutIndex(firstField.dropOuts);
+    secondFieldDropOutIndex = DropOutIndex(secondField.dropOuts);
 }
 
 // Method to get a QImage from a frame number
@@ -163,16 +190,17 @@ QImage TbcSource::getFrameImage()
     if (loadedFrameNumber == -1) return QImage();
 
     // Check cached QImage
-    if (frameCacheValid) return frameCache;
+    if (frameImageValid) return frameImage;
 
-    // Get a QImage for the frame
-    QImage frameImage = generateQImage();
+    // Get a QImage for the frame (painting on this copy won't change the decoded frame)
+    decodeFrame(false);
+    QImage image = decodedFrame.image;
 
     // Highlight dropouts
     if (dropoutsOn) {
         // Create a painter object
         QPainter imagePainter;
-        imagePainter.begin(&frameImage);
+        imagePainter.begin(&image);
 
         // Draw the drop out data for the first field
         imagePainter.setPen(Qt::red);
@@ -198,8 +226,8 @@ QImage TbcSource::getFrameImage()
         imagePainter.end();
     }
 
-    frameCache = frameImage;
-    frameCacheValid = true;
+    frameImage = image;
+    frameImageValid = true;
     return frameImage;
 }
 
@@ -256,25 +284,25 @@ qint32 TbcSource::getFrameWidth()
 }
 
 // Get black SNR data for graphing
-QVector<qreal> TbcSource::getBlackSnrGraphData()
+GraphData TbcSource::getBlackSnrGraphData()
 {
     return blackSnrGraphData;
 }
 
 // Get white SNR data for graphing
-QVector<qreal> TbcSource::getWhiteSnrGraphData()
+GraphData TbcSource::getWhiteSnrGraphData()
 {
     return whiteSnrGraphData;
 }
 
 // Get dropout data for graphing
-QVector<qreal> TbcSource::getDropOutGraphData()
+GraphData TbcSource::getDropOutGraphData()
 {
     return dropoutGraphData;
 }
 
 // Get visible dropout data for graphing
-QVector<qreal> TbcSource::getVisibleDropOutGraphData()
+GraphData TbcSource::getVisibleDropOutGraphData()
 {
     return visibleDropoutGraphData;
 }
@@ -331,16 +359,15 @@ TbcSource::ScanLineData TbcSource::getScanLineData(qint32 scanLine)
     scanLineData.isActiveLine = (scanLine - 1) >= videoParameters.firstActiveFrameLine
                                 && (scanLine -1) < videoParameters.lastActiveFrameLine;
 
-    // Load and decode SourceFields for the current frame
-    loadInputFields();
-    decodeFrame();
+    // Load and decode the current frame
+    decodeFrame(true);
 
     // Get the field video and dropout data
-    const SourceVideo::Data &fieldData = isFieldTop ? inputFields[inputStartIndex].data
-                                                    : inputFields[inputStartIndex + 1].data;
-    const ComponentFrame &componentFrame = componentFrames[0];
-    DropOuts &dropouts = isFieldTop ? firstField.dropOuts
-                                    : secondField.dropOuts;
+    const SourceVideo::Data &fieldData = isFieldTop ? decodedFrame.firstFieldData
+                                                    : decodedFrame.secondFieldData;
+    const ComponentFrame &componentFrame = decodedFrame.componentFrame;
+    const DropOutIndex &dropOutIndex = isFieldTop ? firstFieldDropOutIndex
+                                                  : secondFieldDropOutIndex;
 
     scanLineData.composite.resize(videoParameters.fieldWidth);
     scanLineData.luma.resize(videoParameters.fieldWidth);
@@ -353,12 +380,7 @@ TbcSource::ScanLineData TbcSource::getScanLineData(qint32 scanLine)
         // Get the decoded luma value for the current pixel (only computed in the active region)
         scanLineData.luma[xPosition] = static_cast<qint32>(componentFrame.y(scanLine - 1)[xPosition]);
 
-        scanLineData.isDropout[xPosition] = false;
-        for (qint32 doCount = 0; doCount < dropouts.size(); doCount++) {
-            if (dropouts.fieldLine(doCount) == fieldLine) {
-                if (xPosition >= dropouts.startx(doCount) && xPosition <= dropouts.endx(doCount)) scanLineData.isDropout[xPosition] = true;
-            }
-        }
+        scanLineData.isDropout[xPosition] = dropOutIndex.isDropout(fieldLine, xPosition);
     }
 
     return scanLineData;
@@ -418,23 +440,11 @@ void TbcSource::setChromaConfiguration(const PalColour::Configuration &_palConfi
                                        const Comb::Configuration &_ntscConfiguration,
                                        const OutputWriter::Configuration &_outputConfiguration)
 {
-    invalidateFrameCache();
-
     palConfiguration = _palConfiguration;
     ntscConfiguration = _ntscConfiguration;
     outputConfiguration = _outputConfiguration;
 
-    // Configure the chroma decoder
-    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
-    if (videoParameters.isSourcePal) {
-        palColour.updateConfiguration(videoParameters, palConfiguration);
-    } else {
-        ntscColour.updateConfiguration(videoParameters, ntscConfiguration);
-    }
-
-    // Configure the OutputWriter.
-    // Because we have padding disabled, this won't change the VideoParameters.
-    outputWriter.updateConfiguration(videoParameters, outputConfiguration);
+    updateDecoderConfiguration();
 }
 
 const PalColour::Configuration &TbcSource::getPalConfiguration()
@@ -452,6 +462,12 @@ const OutputWriter::Configuration &TbcSource::getOutputConfiguration()
     return outputConfiguration;
 }
 
+// Set the maximum amount of memory used to cache decoded frames
+void TbcSource::setFrameCacheSize(qint32 megabytes)
+{
+    frameCache.setMaximumSize(megabytes);
+}
+
 // Return the frame number of the start of the next chapter
 qint32 TbcSource::startOfNextChapter(qint32 currentFrameNumber)
 {
@@ -510,269 +526,133 @@ void TbcSource::resetState()
 
     // Cache state
     loadedFrameNumber = -1;
-    inputFieldsValid = false;
     decodedFrameValid = false;
-    frameCacheValid = false;
+    frameImageValid = false;
+    frameCache.setChromaOn(chromaOn);
 }
 
 // Mark any cached data for the current frame as invalid
 void TbcSource::invalidateFrameCache()
 {
-    // Note this includes the input fields, because the number of fields we
-    // load depends on the decoder parameters
-    inputFieldsValid = false;
+    decodedFrame = DecodedFrame();
     decodedFrameValid = false;
-    frameCacheValid = false;
+    frameImageValid = false;
 }
 
-// Ensure the SourceFields for the current frame are loaded
-void TbcSource::loadInputFields()
+// Pass the current decoding options to the frame decoders. Any frames
+// decoded with the old options are discarded.
+void TbcSource::updateDecoderConfiguration()
 {
-    if (inputFieldsValid) return;
-
-    // Work out how many frames ahead/behind we need to fetch
-    qint32 lookBehind, lookAhead;
-    if (getIsSourcePal()) {
-        lookBehind = palConfiguration.getLookBehind();
-        lookAhead = palConfiguration.getLookAhead();
-    } else {
-        lookBehind = ntscConfiguration.getLookBehind();
-        lookAhead = ntscConfiguration.getLookAhead();
-    }
-
-    // Fetch the input fields and metadata
-    SourceField::loadFields(sourceVideo, ldDecodeMetaData,
-                            loadedFrameNumber, 1, lookBehind, lookAhead,
-                            inputFields, inputStartIndex, inputEndIndex);
-
-    inputFieldsValid = true;
+    invalidateFrameCache();
+    frameDecoder.setConfiguration(palConfiguration, ntscConfiguration, outputConfiguration);
+    frameCache.setConfiguration(palConfiguration, ntscConfiguration, outputConfiguration);
 }
 
-// Ensure the current frame has been decoded
-void TbcSource::decodeFrame()
+// Ensure the current frame has been decoded, using the cache if possible
+void TbcSource::decodeFrame(bool needComponentFrame)
 {
-    if (decodedFrameValid) return;
+    if (decodedFrameValid && (decodedFrame.hasComponentFrame || !needComponentFrame)) return;
 
-    loadInputFields();
-
-    // Decode the current frame to components
-    componentFrames.resize(1);
-    if (getIsSourcePal()) {
-        // PAL source
-        palColour.decodeFrames(inputFields, inputStartIndex, inputEndIndex, componentFrames);
-    } else {
-        // NTSC source
-        ntscColour.decodeFrames(inputFields, inputStartIndex, inputEndIndex, componentFrames);
+    if (!frameCache.getFrame(loadedFrameNumber, needComponentFrame, decodedFrame)) {
+        decodedFrame = frameDecoder.decodeFrame(loadedFrameNumber, chromaOn, needComponentFrame);
+        frameCache.insertFrame(loadedFrameNumber, decodedFrame);
     }
 
     decodedFrameValid = true;
 }
 
-// Method to create a QImage for a source video frame
-QImage TbcSource::generateQImage()
-{
-    // Get the metadata for the video parameters
-    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
-
-    // Calculate the frame height
-    qint32 frameHeight = (videoParameters.fieldHeight * 2) - 1;
-
-    // Show debug information
-    if (chromaOn) {
-        qDebug().nospace() << "TbcSource::generateQImage(): Generating a chroma image from frame " << loadedFrameNumber <<
-                    " (" << videoParameters.fieldWidth << "x" << frameHeight << ")";
-    } else {
-        qDebug().nospace() << "TbcSource::generateQImage(): Generating a source image from frame " << loadedFrameNumber <<
-                    " (" << videoParameters.fieldWidth << "x" << frameHeight << ")";
-    }
-
-    // Create a QImage
-    QImage frameImage = QImage(videoParameters.fieldWidth, frameHeight, QImage::Format_RGB888);
-
-    if (chromaOn) {
-        // Chroma decode the current frame
-        decodeFrame();
-
-        // Convert component video to RGB
-        OutputFrame outputFrame;
-        outputWriter.convert(componentFrames[0], outputFrame);
-
-        // Get a pointer to the RGB data
-        const quint16 *rgbPointer = outputFrame.data();
-
-        // Fill the QImage with black
-        frameImage.fill(Qt::black);
-
-        // Copy the RGB16-16-16 data into the RGB888 QImage
-        const qint32 activeHeight = videoParameters.lastActiveFrameLine - videoParameters.firstActiveFrameLine;
-        const qint32 activeWidth = videoParameters.activeVideoEnd - videoParameters.activeVideoStart;
-        for (qint32 y = 0; y < activeHeight; y++) {
-            const quint16 *inputLine = rgbPointer + (y * activeWidth * 3);
-            uchar *outputLine = frameImage.scanLine(y + videoParameters.firstActiveFrameLine)
-                                + (videoParameters.activeVideoStart * 3);
-
-            // Take just the MSB of the RGB input data
-            for (qint32 i = 0; i < activeWidth * 3; i++) {
-                *outputLine++ = static_cast<uchar>((*inputLine++) / 256);
-            }
-        }
-    } else {
-        // Load SourceFields for the current frame
-        loadInputFields();
-
-        // Get pointers to the 16-bit greyscale data
-        const quint16 *firstFieldPointer = inputFields[inputStartIndex].data.data();
-        const quint16 *secondFieldPointer = inputFields[inputStartIndex + 1].data.data();
-
-        // Copy the raw 16-bit grayscale data into the RGB888 QImage
-        for (qint32 y = 0; y < frameHeight; y++) {
-            for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
-                // Take just the MSB of the input data
-                qint32 pixelOffset = (videoParameters.fieldWidth * (y / 2)) + x;
-                uchar pixelValue;
-                if (y % 2) {
-                    pixelValue = static_cast<uchar>(secondFieldPointer[pixelOffset] / 256);
-                } else {
-                    pixelValue = static_cast<uchar>(firstFieldPointer[pixelOffset] / 256);
-                }
-
-                qint32 xpp = x * 3;
-                *(frameImage.scanLine(y) + xpp + 0) = static_cast<uchar>(pixelValue); // R
-                *(frameImage.scanLine(y) + xpp + 1) = static_cast<uchar>(pixelValue); // G
-                *(frameImage.scanLine(y) + xpp + 2) = static_cast<uchar>(pixelValue); // B
-            }
-        }
-    }
-
-    return frameImage;
-}
-
-// Generate the data points for the Drop-out and SNR analysis graphs, and the chapter map.
-// We do these all at the same time to reduce calls to the metadata.
+// Generate the data points for the Drop-out and SNR analysis graphs, and the chapter map
 void TbcSource::generateData()
 {
-    dropoutGraphData.clear();
-    visibleDropoutGraphData.clear();
-    blackSnrGraphData.clear();
-    whiteSnrGraphData.clear();
-
-    dropoutGraphData.resize(ldDecodeMetaData.getNumberOfFrames());
-    visibleDropoutGraphData.resize(ldDecodeMetaData.getNumberOfFrames());
-    blackSnrGraphData.resize(ldDecodeMetaData.getNumberOfFrames());
-    whiteSnrGraphData.resize(ldDecodeMetaData.getNumberOfFrames());
-
-    bool ignoreChapters = false;
-    qint32 lastChapter = -1;
-    qint32 giveUpCounter = 0;
-    chapterMap.clear();
-
     const qint32 numFrames = ldDecodeMetaData.getNumberOfFrames();
-    for (qint32 frameNumber = 0; frameNumber < numFrames; frameNumber++) {
-        qreal doLength = 0;
-        qreal visibleDoLength = 0;
-        qreal blackSnrTotal = 0;
-        qreal whiteSnrTotal = 0;
-
-        // SNR data may be missing in some fields, so we count the points to prevent
-        // the frame average from being thrown-off by missing data
-        qreal blackSnrPoints = 0;
-        qreal whiteSnrPoints = 0;
-
-        LdDecodeMetaData::Field firstField = ldDecodeMetaData.getField(ldDecodeMetaData.getFirstFieldNumber(frameNumber + 1));
-        LdDecodeMetaData::Field secondField = ldDecodeMetaData.getField(ldDecodeMetaData.getSecondFieldNumber(frameNumber + 1));
-
-        // Get the first field DOs
-        if (firstField.dropOuts.size() > 0) {
-            // Calculate the total length of the dropouts
-            for (qint32 i = 0; i < firstField.dropOuts.size(); i++) {
-                doLength += firstField.dropOuts.endx(i) - firstField.dropOuts.startx(i);
-            }
-        }
-
-        // Get the second field DOs
-        if (secondField.dropOuts.size() > 0) {
-            // Calculate the total length of the dropouts
-            for (qint32 i = 0; i < secondField.dropOuts.size(); i++) {
-                doLength += secondField.dropOuts.endx(i) - secondField.dropOuts.startx(i);
-            }
-        }
-
-        // Get the first field visible DOs
-        LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
-
-        if (firstField.dropOuts.size() > 0) {
-            // Calculate the total length of the visible dropouts
-            for (qint32 i = 0; i < firstField.dropOuts.size(); i++) {
-                // Does the drop out start in the visible area?
-                if ((firstField.dropOuts.fieldLine(i) >= videoParameters.firstActiveFieldLine) &&
-                    (firstField.dropOuts.fieldLine(i) <= videoParameters.lastActiveFieldLine)) {
-                    if (firstField.dropOuts.startx(i) >= videoParameters.activeVideoStart) {
-                        qint32 startx = firstField.dropOuts.startx(i);
-                        qint32 endx;
-                        if (firstField.dropOuts.endx(i) < videoParameters.activeVideoEnd) endx = firstField.dropOuts.endx(i);
-                        else endx = videoParameters.activeVideoEnd;
-
-                        visibleDoLength += endx - startx;
+    const LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+
+    QVector<qreal> dropoutValues(numFrames);
+    QVector<qreal> visibleDropoutValues(numFrames);
+    QVector<qreal> blackSnrValues(numFrames);
+    QVector<qreal> whiteSnrValues(numFrames);
+    qreal *dropoutData = dropoutValues.data();
+    qreal *visibleDropoutData = visibleDropoutValues.data();
+    qreal *blackSnrData = blackSnrValues.data();
+    qreal *whiteSnrData = whiteSnrValues.data();
+
+    // Each frame's values depend only on its own metadata, so the frames are
+    // processed in parallel, in blocks to keep the overhead down
+    const qint32 blockSize = 1000;
+    QVector<qint32> blockStarts;
+    for (qint32 frameNumber = 0; frameNumber < numFrames; frameNumber += blockSize) blockStarts.append(frameNumber);
+
+    QtConcurrent::blockingMap(blockStarts, [&](const qint32 &blockStart) {
+        const qint32 blockEnd = qMin(blockStart + blockSize, numFrames);
+        for (qint32 frameNumber = blockStart; frameNumber < blockEnd; frameNumber++) {
+            qreal doLength = 0;
+            qreal visibleDoLength = 0;
+            qreal blackSnrTotal = 0;
+            qreal whiteSnrTotal = 0;
+
+            // SNR data may be missing in some fields, so we count the points to prevent
+            // the frame average from being thrown-off by missing data
+            qreal blackSnrPoints = 0;
+            qreal whiteSnrPoints = 0;
+
+            const qint32 fieldNumbers[] = {
+                ldDecodeMetaData.getFirstFieldNumber(frameNumber + 1),
+                ldDecodeMetaData.getSecondFieldNumber(frameNumber + 1)
+            };
+            for (qint32 fieldNumber : fieldNumbers) {
+                // Calculate the total length of the dropouts, and of the visible dropouts
+                const DropOuts &dropOuts = ldDecodeMetaData.getFieldDropOuts(fieldNumber);
+                for (qint32 i = 0; i < dropOuts.size(); i++) {
+                    doLength += dropOuts.endx(i) - dropOuts.startx(i);
+
+                    // Does the drop out start in the visible area?
+                    if ((dropOuts.fieldLine(i) >= videoParameters.firstActiveFieldLine) &&
+                        (dropOuts.fieldLine(i) <= videoParameters.lastActiveFieldLine) &&
+                        (dropOuts.startx(i) >= videoParameters.activeVideoStart)) {
+                        visibleDoLength += qMin(dropOuts.endx(i), videoParameters.activeVideoEnd) - dropOuts.startx(i);
                     }
                 }
-            }
-        }
 
-        // Get the second field visible DOs
-        if (secondField.dropOuts.size() > 0) {
-            // Calculate the total length of the visible dropouts
-            for (qint32 i = 0; i < secondField.dropOuts.size(); i++) {
-                // Does the drop out start in the visible area?
-                if ((secondField.dropOuts.fieldLine(i) >= videoParameters.firstActiveFieldLine) &&
-                    (secondField.dropOuts.fieldLine(i) <= videoParameters.lastActiveFieldLine)) {
-                    if (secondField.dropOuts.startx(i) >= videoParameters.activeVideoStart) {
-                        qint32 startx = secondField.dropOuts.startx(i);
-                        qint32 endx;
-                        if (secondField.dropOuts.endx(i) < videoParameters.activeVideoEnd) endx = secondField.dropOuts.endx(i);
-                        else endx = videoParameters.activeVideoEnd;
-
-                        visibleDoLength += endx - startx;
+                // Get the SNRs
+                const LdDecodeMetaData::VitsMetrics vitsMetrics = ldDecodeMetaData.getFieldVitsMetrics(fieldNumber);
+                if (vitsMetrics.inUse) {
+                    if (vitsMetrics.bPSNR > 0) {
+                        blackSnrTotal += vitsMetrics.bPSNR;
+                        blackSnrPoints++;
+                    }
+                    if (vitsMetrics.wSNR > 0) {
+                        whiteSnrTotal += vitsMetrics.wSNR;
+                        whiteSnrPoints++;
                     }
                 }
             }
-        }
 
-        // Get the first field SNRs
-        if (firstField.vitsMetrics.inUse) {
-            if (firstField.vitsMetrics.bPSNR > 0) {
-                blackSnrTotal += firstField.vitsMetrics.bPSNR;
-                blackSnrPoints++;
-            }
-            if (firstField.vitsMetrics.wSNR > 0) {
-                whiteSnrTotal += firstField.vitsMetrics.wSNR;
-                whiteSnrPoints++;
-            }
+            // Add the result to the vectors
+            dropoutData[frameNumber] = doLength;
+            visibleDropoutData[frameNumber] = visibleDoLength;
+            blackSnrData[frameNumber] = blackSnrTotal / blackSnrPoints; // Calc average for frame
+            whiteSnrData[frameNumber] = whiteSnrTotal / whiteSnrPoints; // Calc average for frame
         }
+    });
 
-        // Get the second field SNRs
-        if (secondField.vitsMetrics.inUse) {
-            if (secondField.vitsMetrics.bPSNR > 0) {
-                blackSnrTotal += secondField.vitsMetrics.bPSNR;
-                blackSnrPoints++;
-            }
-            if (secondField.vitsMetrics.wSNR > 0) {
-                whiteSnrTotal += secondField.vitsMetrics.wSNR;
-                whiteSnrPoints++;
-            }
-        }
+    dropoutGraphData = GraphData(dropoutValues);
+    visibleDropoutGraphData = GraphData(visibleDropoutValues);
+    blackSnrGraphData = GraphData(blackSnrValues);
+    whiteSnrGraphData = GraphData(whiteSnrValues);
 
-        // Add the result to the vectors
-        dropoutGraphData[frameNumber] = doLength;
-        visibleDropoutGraphData[frameNumber] = visibleDoLength;
-        blackSnrGraphData[frameNumber] = blackSnrTotal / blackSnrPoints; // Calc average for frame
-        whiteSnrGraphData[frameNumber] = whiteSnrTotal / whiteSnrPoints; // Calc average for frame
+    // The chapter map depends on the frames before each one, so it's built in order
+    qint32 lastChapter = -1;
+    qint32 giveUpCounter = 0;
+    chapterMap.clear();
 
-        if (ignoreChapters) continue;
+    for (qint32 frameNumber = 0; frameNumber < numFrames; frameNumber++) {
+        const LdDecodeMetaData::Vbi firstVbi = ldDecodeMetaData.getFieldVbi(ldDecodeMetaData.getFirstFieldNumber(frameNumber + 1));
+        const LdDecodeMetaData::Vbi secondVbi = ldDecodeMetaData.getFieldVbi(ldDecodeMetaData.getSecondFieldNumber(frameNumber + 1));
 
         // Decode the VBI
         VbiDecoder::Vbi vbi = vbiDecoder.decodeFrame(
-            firstField.vbi.vbiData[0], firstField.vbi.vbiData[1], firstField.vbi.vbiData[2],
-            secondField.vbi.vbiData[0], secondField.vbi.vbiData[1], secondField.vbi.vbiData[2]);
+            firstVbi.vbiData[0], firstVbi.vbiData[1], firstVbi.vbiData[2],
+            secondVbi.vbiData[0], secondVbi.vbiData[1], secondVbi.vbiData[2]);
 
         // Get the chapter number
         qint32 currentChapter = vbi.chNo;
@@ -785,11 +665,139 @@ void TbcSource::generateData()
 
         if (frameNumber == 100 && giveUpCounter < 50) {
             qDebug() << "Not seeing valid chapter numbers, giving up chapter mapping";
-            ignoreChapters = true;
+            break;
         }
     }
 }
 
+// The graph data and chapter map are cached alongside the JSON file (with
+// the .json extension replaced by .graphs), so they don't need to be
+// generated again the next time the same file is loaded. As with the
+// metadata's binary sidecar, the cache records the size and modification
+// time of the JSON file it was generated from, and is ignored if the JSON
+// has changed since.
+//
+// The layout, in host byte order (little-endian only), is:
+//   GraphCacheHeader
+//   qint32[numberOfChapters] - the chapter map
+//   GraphData for the dropouts, visible dropouts, black SNR and white SNR
+//
+// If the layout changes, increase graphCacheVersion.
+
+static const char graphCacheMagic[8] = {'L', 'D', 'A', 'G', 'R', 'P', 'H', '\0'};
+static const quint32 graphCacheVersion = 1;
+
+struct GraphCacheHeader {
+    char magic[8];
+    quint32 version;
+    qint32 numberOfChapters;
+    qint64 jsonSize;
+    qint64 jsonModified;
+};
+
+// Return the name of the graph cache for a JSON file
+static QString getGraphCacheFileName(const QString &jsonFileName)
+{
+    if (jsonFileName.endsWith(".json")) return jsonFileName.left(jsonFileName.size() - 5) + ".graphs";
+    return jsonFileName + ".graphs";
+}
+
+// Load the graph data and chapter map from the cache, if it's valid and
+// matches the JSON file. Returns true on success; on failure, the caller
+// should generate the data instead.
+bool TbcSource::readGraphCache(const QString &jsonFileName)
+{
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    // The cache is only supported on little-endian machines
+    return false;
+#endif
+
+    const QString cacheFileName = getGraphCacheFileName(jsonFileName);
+    if (!QFileInfo::exists(cacheFileName)) return false;
+
+    QFile cacheFile(cacheFileName);
+    if (!cacheFile.open(QIODevice::ReadOnly)) {
+        qDebug() << "TbcSource::readGraphCache(): Cannot open graph cache -" << cacheFile.errorString();
+        return false;
+    }
+
+    // Check the header matches this version and the JSON file
+    const QFileInfo jsonFileInfo(jsonFileName);
+    GraphCacheHeader header;
+    if (cacheFile.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+        || memcmp(header.magic, graphCacheMagic, sizeof(graphCacheMagic)) != 0
+        || header.version != graphCacheVersion) {
+        qDebug() << "TbcSource::readGraphCache(): Graph cache is not in a supported format";
+        return false;
+    }
+    if (header.jsonSize != jsonFileInfo.size()
+        || header.jsonModified != jsonFileInfo.lastModified().toMSecsSinceEpoch()) {
+        qDebug() << "TbcSource::readGraphCache(): Graph cache is out of date, ignoring it";
+        return false;
+    }
+
+    // Read the contents, checking they're complete and match the metadata
+    const qint32 numFrames = ldDecodeMetaData.getNumberOfFrames();
+    const qint64 chapterMapBytes = static_cast<qint64>(header.numberOfChapters) * static_cast<qint64>(sizeof(qint32));
+    if (header.numberOfChapters < 0 || chapterMapBytes > cacheFile.bytesAvailable()) {
+        qDebug() << "TbcSource::readGraphCache(): Graph cache is truncated or corrupt";
+        return false;
+    }
+
+    QVector<qint32> cachedChapterMap(header.numberOfChapters);
+    GraphData cachedDropoutGraphData, cachedVisibleDropoutGraphData, cachedBlackSnrGraphData, cachedWhiteSnrGraphData;
+    if (cacheFile.read(reinterpret_cast<char *>(cachedChapterMap.data()), chapterMapBytes) != chapterMapBytes
+        || !cachedDropoutGraphData.read(cacheFile) || cachedDropoutGraphData.size() != numFrames
+        || !cachedVisibleDropoutGraphData.read(cacheFile) || cachedVisibleDropoutGraphData.size() != numFrames
+        || !cachedBlackSnrGraphData.read(cacheFile) || cachedBlackSnrGraphData.size() != numFrames
+        || !cachedWhiteSnrGraphData.read(cacheFile) || cachedWhiteSnrGraphData.size() != numFrames) {
+        qDebug() << "TbcSource::readGraphCache(): Graph cache is truncated or corrupt";
+        return false;
+    }
+
+    chapterMap = cachedChapterMap;
+    dropoutGraphData = cachedDropoutGraphData;
+    visibleDropoutGraphData = cachedVisibleDropoutGraphData;
+    blackSnrGraphData = cachedBlackSnrGraphData;
+    whiteSnrGraphData = cachedWhiteSnrGraphData;
+
+    return true;
+}
+
+// Write the graph data and chapter map to the cache. Returns true on success.
+bool TbcSource::writeGraphCache(const QString &jsonFileName) const
+{
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    return false;
+#endif
+
+    const QFileInfo jsonFileInfo(jsonFileName);
+    GraphCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, graphCacheMagic, sizeof(graphCacheMagic));
+    header.version = graphCacheVersion;
+    header.numberOfChapters = chapterMap.size();
+    header.jsonSize = jsonFileInfo.size();
+    header.jsonModified = jsonFileInfo.lastModified().toMSecsSinceEpoch();
+
+    // Write the file. Using QSaveFile means a reader will never see a
+    // partly-written cache, and the file is discarded if a write fails.
+    QSaveFile cacheFile(getGraphCacheFileName(jsonFileName));
+    if (!cacheFile.open(QIODevice::WriteOnly)) return false;
+
+    const qint64 chapterMapBytes = static_cast<qint64>(chapterMap.size()) * static_cast<qint64>(sizeof(qint32));
+    if (cacheFile.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+        || cacheFile.write(reinterpret_cast<const char *>(chapterMap.constData()), chapterMapBytes) != chapterMapBytes
+        || !dropoutGraphData.write(cacheFile)
+        || !visibleDropoutGraphData.write(cacheFile)
+        || !blackSnrGraphData.write(cacheFile)
+        || !whiteSnrGraphData.write(cacheFile)) {
+        return false;
+    }
+
+    return cacheFile.commit();
+}
+
 void TbcSource::startBackgroundLoad(QString sourceFilename)
 {
     // Open the TBC metadata file
@@ -839,23 +847,23 @@ void TbcSource::startBackgroundLoad(QString sourceFilename)
         }
     }
 
-    // Get the video parameters
-    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
-
     // Configure the chroma decoder
-    if (getIsSourcePal()) {
-        palColour.updateConfiguration(videoParameters, palConfiguration);
-    } else {
+    if (!getIsSourcePal()) {
         // Enable this option by default if we are loading a vhs-decode chroma only tbc file.
         if(chroma_tbc) {
             ntscConfiguration.phaseCompensation = true;
         }
-        ntscColour.updateConfiguration(videoParameters, ntscConfiguration);
     }
+    updateDecoderConfiguration();
 
-    // Analyse the metadata
+    // Analyse the metadata, unless the results are already in the cache
     emit busyLoading("Generating graph data and chapter map...");
-    generateData();
+    if (!(sourceReady && readGraphCache(jsonFileName))) {
+        generateData();
+        if (sourceReady && !writeGraphCache(jsonFileName)) {
+            qDebug() << "TbcSource::startBackgroundLoad(): Could not write graph cache";
+        }
+    }
 }
 
 void TbcSource::finishBackgroundLoad()
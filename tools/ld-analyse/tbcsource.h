@@ -28,6 +28,7 @@
 
 #include <QObject>
 #include <QImage>
+#include <QMutex>
 #include <QPainter>
 #include <QtConcurrent/QtConcurrent>
 #include <QDebug>
@@ -35,6 +36,7 @@
 // TBC library includes
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "dropoutindex.h"
 #include "vbidecoder.h"
 #include "filters.h"
 
@@ -43,6 +45,10 @@
 #include "palcolour.h"
 #include "comb.h"
 
+#include "framecache.h"
+#include "framedecoder.h"
+#include "graphdata.h"
+
 class TbcSource : public QObject
 {
     Q_OBJECT
@@ -89,10 +95,10 @@ public:
     VbiDecoder::Vbi getFrameVbi();
     bool getIsFrameVbiValid();
 
-    QVector<qreal> getBlackSnrGraphData();
-    QVector<qreal> getWhiteSnrGraphData();
-    QVector<qreal> getDropOutGraphData();
-    QVector<qreal> getVisibleDropOutGraphData();
+    GraphData getBlackSnrGraphData();
+    GraphData getWhiteSnrGraphData();
+    GraphData getDropOutGraphData();
+    GraphData getVisibleDropOutGraphData();
     qint32 getGraphDataSize();
 
     bool getIsDropoutPresent();
@@ -110,6 +116,8 @@ public:
     const Comb::Configuration &getNtscConfiguration();
     const OutputWriter::Configuration &getOutputConfiguration();
 
+    void setFrameCacheSize(qint32 megabytes);
+
     qint32 startOfNextChapter(qint32 currentFrameNumber);
     qint32 startOfChapter(qint32 currentFrameNumber);
 
@@ -124,10 +132,10 @@ private:
     bool sourceReady;
 
     // Frame data
-    QVector<qreal> blackSnrGraphData;
-    QVector<qreal> whiteSnrGraphData;
-    QVector<qreal> dropoutGraphData;
-    QVector<qreal> visibleDropoutGraphData;
+    GraphData blackSnrGraphData;
+    GraphData whiteSnrGraphData;
+    GraphData dropoutGraphData;
+    GraphData visibleDropoutGraphData;
 
     // Frame image options
     bool chromaOn;
@@ -136,14 +144,19 @@ private:
 
     // Source globals
     SourceVideo sourceVideo;
+    QMutex sourceMutex;
     LdDecodeMetaData ldDecodeMetaData;
     QString currentSourceFilename;
     QString lastLoadError;
 
-    // Chroma decoder objects
-    PalColour palColour;
-    Comb ntscColour;
-    OutputWriter outputWriter;
+    // Number of frames to decode in the background ahead of the current
+    // frame (in the direction the user is moving), and behind it
+    static constexpr qint32 PREFETCH_AHEAD = 8;
+    static constexpr qint32 PREFETCH_BEHIND = 2;
+
+    // Frame decoders, for the current frame and for prefetching
+    FrameDecoder frameDecoder;
+    FrameCache frameCache;
 
     // VBI decoder
     VbiDecoder vbiDecoder;
@@ -155,20 +168,16 @@ private:
     // Metadata for the loaded frame
     qint32 firstFieldNumber, secondFieldNumber;
     LdDecodeMetaData::Field firstField, secondField;
+    DropOutIndex firstFieldDropOutIndex, secondFieldDropOutIndex;
     qint32 loadedFrameNumber;
 
-    // Source fields needed to decode the loaded frame
-    QVector<SourceField> inputFields;
-    qint32 inputStartIndex, inputEndIndex;
-    bool inputFieldsValid;
-
-    // Chroma decoder output for the loaded frame
-    QVector<ComponentFrame> componentFrames;
+    // Decoded data for the loaded frame
+    DecodedFrame decodedFrame;
     bool decodedFrameValid;
 
-    // RGB image data for the loaded frame
-    QImage frameCache;
-    bool frameCacheValid;
+    // RGB image data for the loaded frame, with dropouts highlighted
+    QImage frameImage;
+    bool frameImageValid;
 
     // Chroma decoder configuration
     PalColour::Configuration palConfiguration;
@@ -180,10 +189,11 @@ private:
 
     void resetState();
     void invalidateFrameCache();
-    void loadInputFields();
-    void decodeFrame();
-    QImage generateQImage();
+    void updateDecoderConfiguration();
+    void decodeFrame(bool needComponentFrame);
     void generateData();
+    bool readGraphCache(const QString &jsonFileName);
+    bool writeGraphCache(const QString &jsonFileName) const;
     void startBackgroundLoad(QString sourceFilename);
 };
 
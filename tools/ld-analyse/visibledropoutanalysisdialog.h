@@ -38,6 +38,7 @@
 #include <qwt_plot_marker.h>
 
 #include "lddecodemetadata.h"
+#include "graphdata.h"
 
 namespace Ui {
 class VisibleDropOutAnalysisDialog;
@@ -52,15 +53,19 @@ public:
     ~VisibleDropOutAnalysisDialog();
 
     void startUpdate(qint32 _numberOfFrames);
-    void addDataPoint(qint32 frameNumber, qreal doLength);
+    void setGraphData(const GraphData &_graphData);
     void finishUpdate(qint32 _currentFrameNumber);
     void updateFrameMarker(qint32 _currentFrameNumber);
 
+protected:
+    bool eventFilter(QObject *object, QEvent *event) override;
+
 private slots:
     void scaleDivChangedSlot();
 
 private:
     void removeChartContents();
+    void updateCurve();
 
     Ui::VisibleDropOutAnalysisDialog *ui;
     QwtPlotZoomer *zoomer;
@@ -68,10 +73,10 @@ private:
     QwtPlot *plot;
     QwtLegend *legend;
     QwtPlotGrid *grid;
-    QPolygonF *points;
     QwtPlotCurve *curve;
     QwtPlotMarker *plotMarker;
 
+    GraphData graphData;
     double maxY;
     qint32 numberOfFrames;
 };
@@ -25,6 +25,7 @@
 #include "whitesnranalysisdialog.h"
 #include "ui_whitesnranalysisdialog.h"
 
+#include <QEvent>
 #include <QPen>
 
 WhiteSnrAnalysisDialog::WhiteSnrAnalysisDialog(QWidget *parent) :
@@ -40,7 +41,6 @@ WhiteSnrAnalysisDialog::WhiteSnrAnalysisDialog(QWidget *parent) :
     panner = new QwtPlotPanner(plot->canvas());
     grid = new QwtPlotGrid();
     whiteCurve = new QwtPlotCurve();
-    whitePoints = new QPolygonF();
     trendCurve = new QwtPlotCurve();
     trendPoints = new QPolygonF();
     plotMarker = new QwtPlotMarker();
@@ -53,6 +53,9 @@ WhiteSnrAnalysisDialog::WhiteSnrAnalysisDialog(QWidget *parent) :
     // Set the default number of frames
     numberOfFrames = 0;
 
+    // Resample the curve when the canvas changes size
+    plot->canvas()->installEventFilter(this);
+
     // Connect to scale changed slot
     connect(((QObject*)plot->axisWidget(QwtPlot::xBottom)) , SIGNAL(scaleDivChanged () ), this, SLOT(scaleDivChangedSlot () ));
 }
@@ -68,33 +71,25 @@ void WhiteSnrAnalysisDialog::startUpdate(qint32 _numberOfFrames)
 {
     removeChartContents();
     numberOfFrames = _numberOfFrames;
-    tlPoint.resize(numberOfFrames + 1);
-    whitePoints->reserve(numberOfFrames);
 }
 
 // Remove the axes and series from the chart, giving ownership back to this object
 void WhiteSnrAnalysisDialog::removeChartContents()
 {
     maxY = 42;
-    whitePoints->clear();
-    tlPoint.clear();
+    graphData = GraphData();
     trendPoints->clear();
     plot->replot();
 }
 
-// Add a data point to the chart
-void WhiteSnrAnalysisDialog::addDataPoint(qint32 frameNumber, qreal whiteSnr)
+// Set the data to plot
+void WhiteSnrAnalysisDialog::setGraphData(const GraphData &_graphData)
 {
-    if (!std::isnan(static_cast<float>(whiteSnr))) {
-        whitePoints->append(QPointF(frameNumber, whiteSnr));
-        if (whiteSnr > maxY) maxY = ceil(whiteSnr); // Round up
+    graphData = _graphData;
 
-        // Add to trendline data
-        tlPoint[frameNumber] = whiteSnr;
-    } else {
-        // Add to trendline data (mark as null value)
-        tlPoint[frameNumber] = -1;
-    }
+    // Keep track of the maximum Y value (frames with no data are NaN, and ignored)
+    const qreal maximum = graphData.getMaximum();
+    if (maximum > maxY) maxY = ceil(maximum); // Round up
 }
 
 // Finish the update and render the graph
@@ -119,7 +114,6 @@ void WhiteSnrAnalysisDialog::finishUpdate(qint32 _currentFrameNumber)
     whiteCurve->setTitle("White SNR");
     whiteCurve->setPen(Qt::darkGray, 1);
     whiteCurve->setRenderHint(QwtPlotItem::RenderAntialiased, true);
-    whiteCurve->setSamples(*whitePoints);
     whiteCurve->attach(plot);
 
     // Attach the trend line curve data to the chart
@@ -136,8 +130,9 @@ void WhiteSnrAnalysisDialog::finishUpdate(qint32 _currentFrameNumber)
     plotMarker->setXValue(static_cast<double>(_currentFrameNumber));
     plotMarker->attach(plot);
 
-    // Update the axis
+    // Update the axis, and fetch the points to plot for it
     plot->updateAxes();
+    updateCurve();
 
     // Update the plot zoomer base
     zoomer->setZoomBase(true);
@@ -172,37 +167,34 @@ void WhiteSnrAnalysisDialog::scaleDivChangedSlot()
     if (zoomer->zoomRectIndex() == 0) {
         plot->setAxisScale(QwtPlot::xBottom, 0, numberOfFrames, (numberOfFrames / 10));
         plot->setAxisScale(QwtPlot::yLeft, 14, maxY, 4);
+        updateCurve();
         plot->replot();
+    } else {
+        updateCurve();
     }
 }
 
-// Method to generate the trendline points
+bool WhiteSnrAnalysisDialog::eventFilter(QObject *object, QEvent *event)
+{
+    if (object == plot->canvas() && event->type() == QEvent::Resize) updateCurve();
+
+    return QDialog::eventFilter(object, event);
+}
+
+// Fetch points for the visible part of the graph, at the canvas's resolution
+void WhiteSnrAnalysisDialog::updateCurve()
+{
+    const QwtScaleDiv &xScaleDiv = plot->axisScaleDiv(QwtPlot::xBottom);
+    whiteCurve->setSamples(graphData.getPoints(xScaleDiv.lowerBound(), xScaleDiv.upperBound(), plot->canvas()->width()));
+}
+
+// Method to generate the trendline points, from the means of blocks of frames
 void WhiteSnrAnalysisDialog::generateTrendLine()
 {
     // Only add a trend line if there are 5000 or more frames
     if (numberOfFrames < 5000) return;
 
-    qint32 elements = 0;
-    qint32 count = 0;
-    double avgSum = 0;
-    qint32 target = numberOfFrames / 500; // Number of frames to average
-
-    for (qint32 f = 0; f < numberOfFrames; f++) {
-        if (tlPoint[f] != -1) {
-            avgSum += tlPoint[f];
-            elements++;
-        }
-        count++;
-
-        if (count == target) {
-            if (avgSum > 0 && elements > 0) {
-                avgSum = avgSum / static_cast<double>(elements);
-                trendPoints->append(QPointF(f-target, avgSum));
-            }
-            avgSum = 0;
-            count = 0;
-            elements = 0;
-        }
-    }
+    // Average over about 500 blocks (blocks with no data are left out)
+    *trendPoints = graphData.getMeanPoints(1, numberOfFrames, 500);
 }
 
@@ -40,6 +40,7 @@
 #include <qwt_plot_marker.h>
 
 #include "lddecodemetadata.h"
+#include "graphdata.h"
 
 namespace Ui {
 class WhiteSnrAnalysisDialog;
@@ -54,15 +55,19 @@ public:
     ~WhiteSnrAnalysisDialog();
 
     void startUpdate(qint32 _numberOfFrames);
-    void addDataPoint(qint32 frameNumber, qreal whiteSnr);
+    void setGraphData(const GraphData &_graphData);
     void finishUpdate(qint32 _currentFrameNumber);
     void updateFrameMarker(qint32 _currentFrameNumber);
 
+protected:
+    bool eventFilter(QObject *object, QEvent *event) override;
+
 private slots:
     void scaleDivChangedSlot();
 
 private:
     void removeChartContents();
+    void updateCurve();
     void generateTrendLine();
 
     Ui::WhiteSnrAnalysisDialog *ui;
@@ -71,15 +76,14 @@ private:
     QwtPlot *plot;
     QwtLegend *legend;
     QwtPlotGrid *grid;
-    QPolygonF *whitePoints;
     QwtPlotCurve *whiteCurve;
     QPolygonF *trendPoints;
     QwtPlotCurve *trendCurve;
     QwtPlotMarker *plotMarker;
 
+    GraphData graphData;
     double maxY;
     qint32 numberOfFrames;
-    QVector<double> tlPoint;
 };
 
 #endif // WHITESNRANALYSISDIALOG_H
@@ -27,12 +27,13 @@
 
 #include "comb.h"
 
+#include "combkernels.h"
 #include "framecanvas.h"
 
 #include "deemp.h"
 
-#include <QScopedPointer>
 #include <cmath>
+#include <cstring>
 
 // Definitions of static constexpr data members, for compatibility with
 // pre-C++17 compilers
@@ -79,6 +80,33 @@ constexpr double cos4fsc(const qint32 i) {
     return sin4fsc(i + 1);
 }
 
+// Call the chroma filter kernels for a given sample type
+static inline void split1DLine(const CombKernels::Functions &kernels, const quint16 *line, double *output,
+                               qint32 startH, qint32 endH)
+{
+    kernels.split1D(line, output, startH, endH);
+}
+
+static inline void split1DLine(const CombKernels::Functions &kernels, const quint16 *line, float *output,
+                               qint32 startH, qint32 endH)
+{
+    kernels.split1DFloat(line, output, startH, endH);
+}
+
+static inline void split2DLine(const CombKernels::Functions &kernels,
+                               const double *previousLine, const double *currentLine, const double *nextLine,
+                               double *output, qint32 startH, qint32 endH, double kRange)
+{
+    kernels.split2D(previousLine, currentLine, nextLine, output, startH, endH, kRange);
+}
+
+static inline void split2DLine(const CombKernels::Functions &kernels,
+                               const float *previousLine, const float *currentLine, const float *nextLine,
+                               float *output, qint32 startH, qint32 endH, double kRange)
+{
+    kernels.split2DFloat(previousLine, currentLine, nextLine, output, startH, endH, static_cast<float>(kRange));
+}
+
 // Public methods -----------------------------------------------------------------------------------------------------
 
 Comb::Comb()
@@ -129,6 +157,12 @@ void Comb::updateConfiguration(const LdDecodeMetaData::VideoParameters &_videoPa
         qCritical() << "Data is not in 4fsc sample rate, color decoding will not work properly!";
     }
 
+    // Discard any existing frame buffers, since they depend on the video parameters
+    for (qint32 i = 0; i < 3; i++) {
+        doubleFrameBuffers[i].reset();
+        floatFrameBuffers[i].reset();
+    }
+
     configurationSet = true;
 }
 
@@ -138,13 +172,31 @@ void Comb::decodeFrames(const QVector<SourceField> &inputFields, qint32 startInd
     assert(configurationSet);
     assert((componentFrames.size() * 2) == (endIndex - startIndex));
 
+    if (configuration.singlePrecision) {
+        decodeFramesWith(floatFrameBuffers, inputFields, startIndex, endIndex, componentFrames);
+    } else {
+        decodeFramesWith(doubleFrameBuffers, inputFields, startIndex, endIndex, componentFrames);
+    }
+}
+
+// Private methods ----------------------------------------------------------------------------------------------------
+
+template <typename SampleType>
+void Comb::decodeFramesWith(QScopedPointer<FrameBuffer<SampleType>> (&frameBuffers)[3],
+                            const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
+                            QVector<ComponentFrame> &componentFrames)
+{
     // Buffers for the next, current and previous frame.
-    // Because we only need three of these, we allocate them upfront then
-    // rotate the pointers below.
-    QScopedPointer<FrameBuffer> nextFrameBuffer, currentFrameBuffer, previousFrameBuffer;
-    nextFrameBuffer.reset(new FrameBuffer(videoParameters, configuration));
-    currentFrameBuffer.reset(new FrameBuffer(videoParameters, configuration));
-    previousFrameBuffer.reset(new FrameBuffer(videoParameters, configuration));
+    // Because we only need three of these, we allocate them the first time
+    // through, then rotate the pointers below. The lookbehind frames are
+    // reloaded at the start of each call, so it doesn't matter which buffer
+    // holds which frame between calls.
+    for (qint32 i = 0; i < 3; i++) {
+        if (frameBuffers[i].isNull()) frameBuffers[i].reset(new FrameBuffer<SampleType>(videoParameters, configuration));
+    }
+    QScopedPointer<FrameBuffer<SampleType>> &nextFrameBuffer = frameBuffers[0];
+    QScopedPointer<FrameBuffer<SampleType>> &currentFrameBuffer = frameBuffers[1];
+    QScopedPointer<FrameBuffer<SampleType>> &previousFrameBuffer = frameBuffers[2];
 
     // Decode each pair of fields into a frame.
     // To support 3D operation, where we need to see three input frames at a time,
@@ -156,7 +208,7 @@ void Comb::decodeFrames(const QVector<SourceField> &inputFields, qint32 startInd
 
         // Rotate the buffers
         {
-            QScopedPointer<FrameBuffer> recycle(previousFrameBuffer.take());
+            QScopedPointer<FrameBuffer<SampleType>> recycle(previousFrameBuffer.take());
             previousFrameBuffer.reset(currentFrameBuffer.take());
             currentFrameBuffer.reset(nextFrameBuffer.take());
             nextFrameBuffer.reset(recycle.take());
@@ -214,10 +266,9 @@ void Comb::decodeFrames(const QVector<SourceField> &inputFields, qint32 startInd
     }
 }
 
-// Private methods ----------------------------------------------------------------------------------------------------
-
-Comb::FrameBuffer::FrameBuffer(const LdDecodeMetaData::VideoParameters &videoParameters_,
-                               const Configuration &configuration_)
+template <typename SampleType>
+Comb::FrameBuffer<SampleType>::FrameBuffer(const LdDecodeMetaData::VideoParameters &videoParameters_,
+                                           const Configuration &configuration_)
     : videoParameters(videoParameters_), configuration(configuration_)
 {
     // Set the frame height
@@ -225,6 +276,23 @@ Comb::FrameBuffer::FrameBuffer(const LdDecodeMetaData::VideoParameters &videoPar
 
     // Set the IRE scale
     irescale = (videoParameters.white16bIre - videoParameters.black16bIre) / 100;
+
+    // Allocate the interlaced frame
+    rawbuffer.resize(videoParameters.fieldHeight * 2 * videoParameters.fieldWidth);
+
+    // Clear clpbuffer.
+    // The filters only ever write within the active area, and they write every
+    // sample there for each frame, so the rest stays clear after this.
+    for (qint32 buf = 0; buf < 3; buf++) {
+        for (qint32 y = 0; y < MAX_HEIGHT; y++) {
+            for (qint32 x = 0; x < MAX_WIDTH; x++) {
+                clpbuffer[buf].pixel[y][x] = 0.0;
+            }
+        }
+    }
+
+    // No component frame yet
+    componentFrame = nullptr;
 }
 
 /*
@@ -240,7 +308,8 @@ Comb::FrameBuffer::FrameBuffer(const LdDecodeMetaData::VideoParameters &videoPar
  * getLinePhase returns true if the color burst is rising at the leading edge.
  */
 
-inline qint32 Comb::FrameBuffer::getFieldID(qint32 lineNumber) const
+template <typename SampleType>
+inline qint32 Comb::FrameBuffer<SampleType>::getFieldID(qint32 lineNumber) const
 {
     bool isFirstField = ((lineNumber % 2) == 0);
 
@@ -248,7 +317,8 @@ inline qint32 Comb::FrameBuffer::getFieldID(qint32 lineNumber) const
 }
 
 // NOTE:  lineNumber is presumed to be starting at 1.  (This lines up with how splitIQ calls it)
-inline bool Comb::FrameBuffer::getLinePhase(qint32 lineNumber) const
+template <typename SampleType>
+inline bool Comb::FrameBuffer<SampleType>::getLinePhase(qint32 lineNumber) const
 {
     qint32 fieldID = getFieldID(lineNumber);
     bool isPositivePhaseOnEvenLines = (fieldID == 1) || (fieldID == 4);
@@ -260,30 +330,25 @@ inline bool Comb::FrameBuffer::getLinePhase(qint32 lineNumber) const
 }
 
 // Interlace two source fields into the framebuffer.
-void Comb::FrameBuffer::loadFields(const SourceField &firstField, const SourceField &secondField)
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::loadFields(const SourceField &firstField, const SourceField &secondField)
 {
     // Interlace the input fields and place in the frame buffer
-    qint32 fieldLine = 0;
-    rawbuffer.clear();
-    for (qint32 frameLine = 0; frameLine < frameHeight; frameLine += 2) {
-        rawbuffer.append(firstField.data.mid(fieldLine * videoParameters.fieldWidth, videoParameters.fieldWidth));
-        rawbuffer.append(secondField.data.mid(fieldLine * videoParameters.fieldWidth, videoParameters.fieldWidth));
-        fieldLine++;
+    const qint32 lineSize = videoParameters.fieldWidth * sizeof(quint16);
+    const quint16 *firstData = firstField.data.constData();
+    const quint16 *secondData = secondField.data.constData();
+    quint16 *outputData = rawbuffer.data();
+    for (qint32 fieldLine = 0; fieldLine < videoParameters.fieldHeight; fieldLine++) {
+        memcpy(outputData, firstData + (fieldLine * videoParameters.fieldWidth), lineSize);
+        outputData += videoParameters.fieldWidth;
+        memcpy(outputData, secondData + (fieldLine * videoParameters.fieldWidth), lineSize);
+        outputData += videoParameters.fieldWidth;
     }
 
     // Set the phase IDs for the frame
     firstFieldPhaseID = firstField.field.fieldPhaseID;
     secondFieldPhaseID = secondField.field.fieldPhaseID;
 
-    // Clear clpbuffer
-    for (qint32 buf = 0; buf < 3; buf++) {
-        for (qint32 y = 0; y < MAX_HEIGHT; y++) {
-            for (qint32 x = 0; x < MAX_WIDTH; x++) {
-                clpbuffer[buf].pixel[y][x] = 0.0;
-            }
-        }
-    }
-
     // No component frame yet
     componentFrame = nullptr;
 }
@@ -296,18 +361,17 @@ void Comb::FrameBuffer::loadFields(const SourceField &firstField, const SourceFi
 //
 // This also acts as an alias removal pre-filter for the quadrature detector in
 // splitIQ, so we use its result for split2D rather than the raw signal.
-void Comb::FrameBuffer::split1D()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::split1D()
 {
+    const CombKernels::Functions &kernels = CombKernels::getBestFunctions();
+
     for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
         // Get a pointer to the line's data
         const quint16 *line = rawbuffer.data() + (lineNumber * videoParameters.fieldWidth);
 
-        for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
-            double tc1 = (line[h] - ((line[h - 2] + line[h + 2]) / 2.0)) / 2.0;
-
-            // Record the 1D C value
-            clpbuffer[0].pixel[lineNumber][h] = tc1;
-        }
+        // Record the 1D C values
+        split1DLine(kernels, line, clpbuffer[0].pixel[lineNumber], videoParameters.activeVideoStart, videoParameters.activeVideoEnd);
     }
 }
 
@@ -321,76 +385,33 @@ void Comb::FrameBuffer::split1D()
 // The "3-line adaptive" part means that we look at both surrounding lines to
 // estimate how similar they are to this one. We can then compute the 2D chroma
 // value as a blend of the two differences, weighted by similarity.
-void Comb::FrameBuffer::split2D()
+// (The per-sample computation is in CombKernels.)
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::split2D()
 {
     // Dummy black line
-    static constexpr double blackLine[MAX_WIDTH] = {0};
+    static constexpr SampleType blackLine[MAX_WIDTH] = {0};
+
+    const CombKernels::Functions &kernels = CombKernels::getBestFunctions();
+
+    // Differences larger than kRange mean the lines are out of phase
+    const double kRange = 45 * irescale;
 
     for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
         // Get pointers to the surrounding lines of 1D chroma.
         // If a line we need is outside the active area, use blackLine instead.
-        const double *previousLine = blackLine;
+        const SampleType *previousLine = blackLine;
         if (lineNumber - 2 >= videoParameters.firstActiveFrameLine) {
             previousLine = clpbuffer[0].pixel[lineNumber - 2];
         }
-        const double *currentLine = clpbuffer[0].pixel[lineNumber];
-        const double *nextLine = blackLine;
+        const SampleType *currentLine = clpbuffer[0].pixel[lineNumber];
+        const SampleType *nextLine = blackLine;
         if (lineNumber + 2 < videoParameters.lastActiveFrameLine) {
             nextLine = clpbuffer[0].pixel[lineNumber + 2];
         }
 
-        for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
-            double kp, kn;
-
-            // Summing the differences of the *absolute* values of the 1D chroma samples
-            // will give us a low value if the two lines are nearly in phase (strong Y)
-            // or nearly 180 degrees out of phase (strong C) -- i.e. the two cases where
-            // the 2D filter is probably usable. Also give a small bonus if
-            // there's a large signal (we think).
-            kp  = fabs(fabs(currentLine[h]) - fabs(previousLine[h]));
-            kp += fabs(fabs(currentLine[h - 1]) - fabs(previousLine[h - 1]));
-            kp -= (fabs(currentLine[h]) + fabs(previousLine[h - 1])) * .10;
-            kn  = fabs(fabs(currentLine[h]) - fabs(nextLine[h]));
-            kn += fabs(fabs(currentLine[h - 1]) - fabs(nextLine[h - 1]));
-            kn -= (fabs(currentLine[h]) + fabs(nextLine[h - 1])) * .10;
-
-            // Map the difference into a weighting 0-1.
-            // 1 means in phase or unknown; 0 means out of phase (more than kRange difference).
-            const double kRange = 45 * irescale;
-            kp = qBound(0.0, 1 - (kp / kRange), 1.0);
-            kn = qBound(0.0, 1 - (kn / kRange), 1.0);
-
-            double sc = 1.0;
-
-            if ((kn > 0) || (kp > 0)) {
-                // At least one of the next/previous lines has a good phase relationship.
-
-                // If one of them is much better than the other, only use that one
-                if (kn > (3 * kp)) kp = 0;
-                else if (kp > (3 * kn)) kn = 0;
-
-                sc = (2.0 / (kn + kp));
-                if (sc < 1.0) sc = 1.0;
-            } else {
-                // Neither line has a good phase relationship.
-
-                // But are they similar to each other? If so, we can use both of them!
-                if ((fabs(fabs(previousLine[h]) - fabs(nextLine[h])) - fabs((nextLine[h] + previousLine[h]) * .2)) <= 0) {
-                    kn = kp = 1;
-                }
-
-                // Else kn = kp = 0, so we won't extract any chroma for this sample.
-                // (Some NTSC decoders fall back to the 1D chroma in this situation.)
-            }
-
-            // Compute the weighted sum of differences, giving the 2D chroma value
-            double tc1;
-            tc1  = ((currentLine[h] - previousLine[h]) * kp * sc);
-            tc1 += ((currentLine[h] - nextLine[h]) * kn * sc);
-            tc1 /= 4;
-
-            clpbuffer[1].pixel[lineNumber][h] = tc1;
-        }
+        split2DLine(kernels, previousLine, currentLine, nextLine, clpbuffer[1].pixel[lineNumber],
+                    videoParameters.activeVideoStart, videoParameters.activeVideoEnd, kRange);
     }
 }
 
@@ -400,7 +421,8 @@ void Comb::FrameBuffer::split2D()
 // should have a 180 degree phase relationship to the current sample, and look
 // like they have similar luma/chroma content. It then picks the most similar
 // candidate.
-void Comb::FrameBuffer::split3D(const FrameBuffer &previousFrame, const FrameBuffer &nextFrame)
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::split3D(const FrameBuffer &previousFrame, const FrameBuffer &nextFrame)
 {
     for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
         for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
@@ -423,9 +445,10 @@ void Comb::FrameBuffer::split3D(const FrameBuffer &previousFrame, const FrameBuf
 }
 
 // Evaluate all candidates for 3D decoding for a given position, and return the best one
-void Comb::FrameBuffer::getBestCandidate(qint32 lineNumber, qint32 h,
-                                         const FrameBuffer &previousFrame, const FrameBuffer &nextFrame,
-                                         qint32 &bestIndex, double &bestSample) const
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::getBestCandidate(qint32 lineNumber, qint32 h,
+                                                     const FrameBuffer &previousFrame, const FrameBuffer &nextFrame,
+                                                     qint32 &bestIndex, double &bestSample) const
 {
     Candidate candidates[8];
 
@@ -470,9 +493,10 @@ void Comb::FrameBuffer::getBestCandidate(qint32 lineNumber, qint32 h,
 }
 
 // Evaluate a candidate for 3D decoding
-Comb::FrameBuffer::Candidate Comb::FrameBuffer::getCandidate(qint32 refLineNumber, qint32 refH,
-                                                             const FrameBuffer &frameBuffer, qint32 lineNumber, qint32 h,
-                                                             double adjustPenalty) const
+template <typename SampleType>
+typename Comb::FrameBuffer<SampleType>::Candidate Comb::FrameBuffer<SampleType>::getCandidate(qint32 refLineNumber, qint32 refH,
+                                                                                             const FrameBuffer &frameBuffer, qint32 lineNumber, qint32 h,
+                                                                                             double adjustPenalty) const
 {
     Candidate result;
     result.sample = frameBuffer.clpbuffer[0].pixel[lineNumber][h];
@@ -569,7 +593,8 @@ namespace {
 }
 
 // Split I and Q, taking burst phase into account.
-void Comb::FrameBuffer::splitIQlocked()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::splitIQlocked()
 {
     for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
         // Get a pointer to the line's data
@@ -582,7 +607,7 @@ void Comb::FrameBuffer::splitIQlocked()
         double *Q = componentFrame->v(lineNumber);
 
         for (qint32 h = videoParameters.activeVideoStart; h < videoParameters.activeVideoEnd; h++) {
-            const auto val = clpbuffer[configuration.dimensions - 1].pixel[lineNumber][h];
+            const double val = clpbuffer[configuration.dimensions - 1].pixel[lineNumber][h];
 
             // Demodulate the sine and cosine components.
             const auto lsin = val * sin4fsc(h) * 2;
@@ -603,7 +628,8 @@ void Comb::FrameBuffer::splitIQlocked()
 }
 
 // Spilt the I and Q
-void Comb::FrameBuffer::splitIQ()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::splitIQ()
 {
     for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
         // Get a pointer to the line's data
@@ -639,7 +665,8 @@ void Comb::FrameBuffer::splitIQ()
 }
 
 // Filter the IQ from the component frame
-void Comb::FrameBuffer::filterIQ()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::filterIQ()
 {
     auto iFilter(f_colorlpi);
     auto qFilter(configuration.colorlpf_hq ? f_colorlpi : f_colorlpq);
@@ -674,7 +701,8 @@ void Comb::FrameBuffer::filterIQ()
 
 
 // Filter the full set of I and Q values from the input buffer.
-void Comb::FrameBuffer::filterIQFull()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::filterIQFull()
 {
     auto iFilter(f_colorlpi);
     auto qFilter(configuration.colorlpf_hq ? f_colorlpi : f_colorlpq);
@@ -701,7 +729,8 @@ void Comb::FrameBuffer::filterIQFull()
 }
 
 // Remove the colour data from the baseband (Y)
-void Comb::FrameBuffer::adjustY()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::adjustY()
 {
     // remove color data from baseband (Y)
     for (qint32 lineNumber = videoParameters.firstActiveFrameLine; lineNumber < videoParameters.lastActiveFrameLine; lineNumber++) {
@@ -737,7 +766,8 @@ void Comb::FrameBuffer::adjustY()
  * which removes small high frequency noise.
  */
 
-void Comb::FrameBuffer::doCNR()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::doCNR()
 {
     if (configuration.cNRLevel == 0) return;
 
@@ -794,7 +824,8 @@ void Comb::FrameBuffer::doCNR()
     }
 }
 
-void Comb::FrameBuffer::doYNR()
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::doYNR()
 {
     if (configuration.yNRLevel == 0) return;
 
@@ -839,7 +870,8 @@ void Comb::FrameBuffer::doYNR()
 }
 
 // Transform I/Q into U/V, and apply chroma gain
-void Comb::FrameBuffer::transformIQ(double chromaGain, double chromaPhase)
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::transformIQ(double chromaGain, double chromaPhase)
 {
     // Compute components for the rotation vector
     const double theta = ((33 + chromaPhase) * M_PI) / 180;
@@ -862,7 +894,8 @@ void Comb::FrameBuffer::transformIQ(double chromaGain, double chromaPhase)
 }
 
 // Overlay the 3D filter map onto the output
-void Comb::FrameBuffer::overlayMap(const FrameBuffer &previousFrame, const FrameBuffer &nextFrame)
+template <typename SampleType>
+void Comb::FrameBuffer<SampleType>::overlayMap(const FrameBuffer &previousFrame, const FrameBuffer &nextFrame)
 {
     qDebug() << "Comb::FrameBuffer::overlayMap(): Overlaying map onto output";
 
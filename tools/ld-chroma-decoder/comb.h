@@ -31,6 +31,7 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QFile>
+#include <QScopedPointer>
 #include <QtMath>
 
 #include "lddecodemetadata.h"
@@ -56,6 +57,10 @@ public:
         bool showMap = false;
         bool phaseCompensation = false;
 
+        // Hold the intermediate chroma in single precision, halving the
+        // memory used per frame buffer. Output is still in double precision.
+        bool singlePrecision = false;
+
         double cNRLevel = 0.0;
         double yNRLevel = 1.0;
 
@@ -83,7 +88,9 @@ private:
     Configuration configuration;
     LdDecodeMetaData::VideoParameters videoParameters;
 
-    // An input frame in the process of being decoded
+    // An input frame in the process of being decoded.
+    // SampleType is the type used for the filtered chroma samples.
+    template <typename SampleType>
     class FrameBuffer {
     public:
         FrameBuffer(const LdDecodeMetaData::VideoParameters &videoParameters_, const Configuration &configuration_);
@@ -128,7 +135,7 @@ private:
 
         // 1D, 2D and 3D-filtered chroma samples
         struct Sample {
-            double pixel[MAX_HEIGHT][MAX_WIDTH];
+            SampleType pixel[MAX_HEIGHT][MAX_WIDTH];
         } clpbuffer[3];
 
         // Result of evaluating a 3D candidate
@@ -149,6 +156,16 @@ private:
                                const FrameBuffer &frameBuffer, qint32 lineNumber, qint32 h,
                                double adjustPenalty) const;
     };
+
+    // Frame buffers for each sample type. These are allocated on first use
+    // and kept between calls to decodeFrames.
+    QScopedPointer<FrameBuffer<double>> doubleFrameBuffers[3];
+    QScopedPointer<FrameBuffer<float>> floatFrameBuffers[3];
+
+    template <typename SampleType>
+    void decodeFramesWith(QScopedPointer<FrameBuffer<SampleType>> (&frameBuffers)[3],
+                          const QVector<SourceField> &inputFields, qint32 startIndex, qint32 endIndex,
+                          QVector<ComponentFrame> &componentFrames);
 };
 
 #endif // COMB_H
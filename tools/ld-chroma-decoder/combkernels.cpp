@@ -0,0 +1,551 @@
+/************************************************************************
+
+    combkernels.cpp
+
+    ld-chroma-decoder - Colourisation filter for ld-decode
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "combkernels.h"
+
+#include <QtMath>
+
+#include <cmath>
+#include <cstring>
+
+#include "cpufeatures.h"
+
+// The SSE4.2 and AVX2 kernels below are selected at runtime by
+// getBestFunctions, as Comb runs the same kernel for every line of every field
+#ifdef CPUFEATURES_X86
+#include <immintrin.h>
+#endif
+
+// Scalar implementations, used as the reference and for leftover samples at
+// the end of a line. These are templated over the sample type so that the
+// single-precision versions do all their arithmetic in float, like the vector
+// versions do.
+
+template <typename SampleType>
+static inline SampleType split1DSample(const quint16 *line, qint32 h)
+{
+    const SampleType half = 0.5;
+    return (line[h] - ((line[h - 2] + line[h + 2]) * half)) * half;
+}
+
+template <typename SampleType>
+static inline SampleType split2DSample(const SampleType *previousLine, const SampleType *currentLine, const SampleType *nextLine,
+                                       qint32 h, SampleType kRange)
+{
+    const SampleType zero = 0.0;
+    const SampleType one = 1.0;
+    const SampleType bonus = .10;
+    const SampleType similar = .2;
+    SampleType kp, kn;
+
+    // Summing the differences of the *absolute* values of the 1D chroma samples
+    // will give us a low value if the two lines are nearly in phase (strong Y)
+    // or nearly 180 degrees out of phase (strong C) -- i.e. the two cases where
+    // the 2D filter is probably usable. Also give a small bonus if
+    // there's a large signal (we think).
+    kp  = std::fabs(std::fabs(currentLine[h]) - std::fabs(previousLine[h]));
+    kp += std::fabs(std::fabs(currentLine[h - 1]) - std::fabs(previousLine[h - 1]));
+    kp -= (std::fabs(currentLine[h]) + std::fabs(previousLine[h - 1])) * bonus;
+    kn  = std::fabs(std::fabs(currentLine[h]) - std::fabs(nextLine[h]));
+    kn += std::fabs(std::fabs(currentLine[h - 1]) - std::fabs(nextLine[h - 1]));
+    kn -= (std::fabs(currentLine[h]) + std::fabs(nextLine[h - 1])) * bonus;
+
+    // Map the difference into a weighting 0-1.
+    // 1 means in phase or unknown; 0 means out of phase (more than kRange difference).
+    kp = qBound(zero, one - (kp / kRange), one);
+    kn = qBound(zero, one - (kn / kRange), one);
+
+    SampleType sc = one;
+
+    if ((kn > 0) || (kp > 0)) {
+        // At least one of the next/previous lines has a good phase relationship.
+
+        // If one of them is much better than the other, only use that one
+        if (kn > (3 * kp)) kp = 0;
+        else if (kp > (3 * kn)) kn = 0;
+
+        sc = (SampleType(2.0) / (kn + kp));
+        if (sc < one) sc = one;
+    } else {
+        // Neither line has a good phase relationship.
+
+        // But are they similar to each other? If so, we can use both of them!
+        if ((std::fabs(std::fabs(previousLine[h]) - std::fabs(nextLine[h])) - std::fabs((nextLine[h] + previousLine[h]) * similar)) <= 0) {
+            kn = kp = 1;
+        }
+
+        // Else kn = kp = 0, so we won't extract any chroma for this sample.
+        // (Some NTSC decoders fall back to the 1D chroma in this situation.)
+    }
+
+    // Compute the weighted sum of differences, giving the 2D chroma value
+    SampleType tc1;
+    tc1  = ((currentLine[h] - previousLine[h]) * kp * sc);
+    tc1 += ((currentLine[h] - nextLine[h]) * kn * sc);
+    tc1 *= SampleType(0.25);
+
+    return tc1;
+}
+
+template <typename SampleType>
+static void split1DScalar(const quint16 *line, SampleType *output, qint32 startH, qint32 endH)
+{
+    for (qint32 h = startH; h < endH; h++) {
+        output[h] = split1DSample<SampleType>(line, h);
+    }
+}
+
+template <typename SampleType>
+static void split2DScalar(const SampleType *previousLine, const SampleType *currentLine, const SampleType *nextLine,
+                          SampleType *output, qint32 startH, qint32 endH, SampleType kRange)
+{
+    for (qint32 h = startH; h < endH; h++) {
+        output[h] = split2DSample(previousLine, currentLine, nextLine, h, kRange);
+    }
+}
+
+#ifdef CPUFEATURES_X86
+
+// SSE4.2 implementations, processing two samples at a time.
+//
+// These mirror the scalar code above operation-for-operation.
+
+__attribute__((target("sse4.2")))
+static inline __m128d loadSamples2(const quint16 *samples)
+{
+    qint32 packed;
+    memcpy(&packed, samples, sizeof(packed));
+    return _mm_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_cvtsi32_si128(packed)));
+}
+
+__attribute__((target("sse4.2")))
+static void split1DSse42(const quint16 *line, double *output, qint32 startH, qint32 endH)
+{
+    const __m128d half = _mm_set1_pd(0.5);
+
+    qint32 h = startH;
+    for (; h + 2 <= endH; h += 2) {
+        const __m128d centre = loadSamples2(line + h);
+        const __m128d sides = _mm_add_pd(loadSamples2(line + h - 2), loadSamples2(line + h + 2));
+        const __m128d tc1 = _mm_mul_pd(_mm_sub_pd(centre, _mm_mul_pd(sides, half)), half);
+        _mm_storeu_pd(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split1DSample<double>(line, h);
+    }
+}
+
+__attribute__((target("sse4.2")))
+static void split2DSse42(const double *previousLine, const double *currentLine, const double *nextLine,
+                         double *output, qint32 startH, qint32 endH, double kRange)
+{
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d two = _mm_set1_pd(2.0);
+    const __m128d three = _mm_set1_pd(3.0);
+    const __m128d bonus = _mm_set1_pd(.10);
+    const __m128d similar = _mm_set1_pd(.2);
+    const __m128d quarter = _mm_set1_pd(0.25);
+    const __m128d range = _mm_set1_pd(kRange);
+
+    qint32 h = startH;
+    for (; h + 2 <= endH; h += 2) {
+        const __m128d c0 = _mm_loadu_pd(currentLine + h);
+        const __m128d p0 = _mm_loadu_pd(previousLine + h);
+        const __m128d n0 = _mm_loadu_pd(nextLine + h);
+        const __m128d ac0 = _mm_and_pd(c0, absMask);
+        const __m128d ap0 = _mm_and_pd(p0, absMask);
+        const __m128d an0 = _mm_and_pd(n0, absMask);
+        const __m128d ac1 = _mm_and_pd(_mm_loadu_pd(currentLine + h - 1), absMask);
+        const __m128d ap1 = _mm_and_pd(_mm_loadu_pd(previousLine + h - 1), absMask);
+        const __m128d an1 = _mm_and_pd(_mm_loadu_pd(nextLine + h - 1), absMask);
+
+        __m128d kp = _mm_and_pd(_mm_sub_pd(ac0, ap0), absMask);
+        kp = _mm_add_pd(kp, _mm_and_pd(_mm_sub_pd(ac1, ap1), absMask));
+        kp = _mm_sub_pd(kp, _mm_mul_pd(_mm_add_pd(ac0, ap1), bonus));
+        __m128d kn = _mm_and_pd(_mm_sub_pd(ac0, an0), absMask);
+        kn = _mm_add_pd(kn, _mm_and_pd(_mm_sub_pd(ac1, an1), absMask));
+        kn = _mm_sub_pd(kn, _mm_mul_pd(_mm_add_pd(ac0, an1), bonus));
+
+        kp = _mm_max_pd(_mm_min_pd(one, _mm_sub_pd(one, _mm_div_pd(kp, range))), zero);
+        kn = _mm_max_pd(_mm_min_pd(one, _mm_sub_pd(one, _mm_div_pd(kn, range))), zero);
+
+        // Samples where at least one line has a good phase relationship
+        const __m128d good = _mm_or_pd(_mm_cmpgt_pd(kn, zero), _mm_cmpgt_pd(kp, zero));
+        const __m128d knBetter = _mm_cmpgt_pd(kn, _mm_mul_pd(three, kp));
+        const __m128d kpBetter = _mm_andnot_pd(knBetter, _mm_cmpgt_pd(kp, _mm_mul_pd(three, kn)));
+        const __m128d goodKp = _mm_andnot_pd(knBetter, kp);
+        const __m128d goodKn = _mm_andnot_pd(kpBetter, kn);
+        const __m128d goodSc = _mm_max_pd(_mm_div_pd(two, _mm_add_pd(goodKn, goodKp)), one);
+
+        // Samples where neither does, but the surrounding lines are similar
+        const __m128d bothSimilar = _mm_cmple_pd(_mm_sub_pd(_mm_and_pd(_mm_sub_pd(ap0, an0), absMask),
+                                                            _mm_and_pd(_mm_mul_pd(_mm_add_pd(n0, p0), similar), absMask)),
+                                                 zero);
+        const __m128d badKp = _mm_blendv_pd(kp, one, bothSimilar);
+        const __m128d badKn = _mm_blendv_pd(kn, one, bothSimilar);
+
+        kp = _mm_blendv_pd(badKp, goodKp, good);
+        kn = _mm_blendv_pd(badKn, goodKn, good);
+        const __m128d sc = _mm_blendv_pd(one, goodSc, good);
+
+        __m128d tc1 = _mm_mul_pd(_mm_mul_pd(_mm_sub_pd(c0, p0), kp), sc);
+        tc1 = _mm_add_pd(tc1, _mm_mul_pd(_mm_mul_pd(_mm_sub_pd(c0, n0), kn), sc));
+        tc1 = _mm_mul_pd(tc1, quarter);
+
+        _mm_storeu_pd(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split2DSample(previousLine, currentLine, nextLine, h, kRange);
+    }
+}
+
+// Single-precision SSE4.2 implementations, processing four samples at a time
+
+__attribute__((target("sse4.2")))
+static inline __m128 loadSamples4Float(const quint16 *samples)
+{
+    return _mm_cvtepi32_ps(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples))));
+}
+
+__attribute__((target("sse4.2")))
+static void split1DFloatSse42(const quint16 *line, float *output, qint32 startH, qint32 endH)
+{
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    qint32 h = startH;
+    for (; h + 4 <= endH; h += 4) {
+        const __m128 centre = loadSamples4Float(line + h);
+        const __m128 sides = _mm_add_ps(loadSamples4Float(line + h - 2), loadSamples4Float(line + h + 2));
+        const __m128 tc1 = _mm_mul_ps(_mm_sub_ps(centre, _mm_mul_ps(sides, half)), half);
+        _mm_storeu_ps(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split1DSample<float>(line, h);
+    }
+}
+
+__attribute__((target("sse4.2")))
+static void split2DFloatSse42(const float *previousLine, const float *currentLine, const float *nextLine,
+                              float *output, qint32 startH, qint32 endH, float kRange)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 three = _mm_set1_ps(3.0f);
+    const __m128 bonus = _mm_set1_ps(.10f);
+    const __m128 similar = _mm_set1_ps(.2f);
+    const __m128 quarter = _mm_set1_ps(0.25f);
+    const __m128 range = _mm_set1_ps(kRange);
+
+    qint32 h = startH;
+    for (; h + 4 <= endH; h += 4) {
+        const __m128 c0 = _mm_loadu_ps(currentLine + h);
+        const __m128 p0 = _mm_loadu_ps(previousLine + h);
+        const __m128 n0 = _mm_loadu_ps(nextLine + h);
+        const __m128 ac0 = _mm_and_ps(c0, absMask);
+        const __m128 ap0 = _mm_and_ps(p0, absMask);
+        const __m128 an0 = _mm_and_ps(n0, absMask);
+        const __m128 ac1 = _mm_and_ps(_mm_loadu_ps(currentLine + h - 1), absMask);
+        const __m128 ap1 = _mm_and_ps(_mm_loadu_ps(previousLine + h - 1), absMask);
+        const __m128 an1 = _mm_and_ps(_mm_loadu_ps(nextLine + h - 1), absMask);
+
+        __m128 kp = _mm_and_ps(_mm_sub_ps(ac0, ap0), absMask);
+        kp = _mm_add_ps(kp, _mm_and_ps(_mm_sub_ps(ac1, ap1), absMask));
+        kp = _mm_sub_ps(kp, _mm_mul_ps(_mm_add_ps(ac0, ap1), bonus));
+        __m128 kn = _mm_and_ps(_mm_sub_ps(ac0, an0), absMask);
+        kn = _mm_add_ps(kn, _mm_and_ps(_mm_sub_ps(ac1, an1), absMask));
+        kn = _mm_sub_ps(kn, _mm_mul_ps(_mm_add_ps(ac0, an1), bonus));
+
+        kp = _mm_max_ps(_mm_min_ps(one, _mm_sub_ps(one, _mm_div_ps(kp, range))), zero);
+        kn = _mm_max_ps(_mm_min_ps(one, _mm_sub_ps(one, _mm_div_ps(kn, range))), zero);
+
+        // Samples where at least one line has a good phase relationship
+        const __m128 good = _mm_or_ps(_mm_cmpgt_ps(kn, zero), _mm_cmpgt_ps(kp, zero));
+        const __m128 knBetter = _mm_cmpgt_ps(kn, _mm_mul_ps(three, kp));
+        const __m128 kpBetter = _mm_andnot_ps(knBetter, _mm_cmpgt_ps(kp, _mm_mul_ps(three, kn)));
+        const __m128 goodKp = _mm_andnot_ps(knBetter, kp);
+        const __m128 goodKn = _mm_andnot_ps(kpBetter, kn);
+        const __m128 goodSc = _mm_max_ps(_mm_div_ps(two, _mm_add_ps(goodKn, goodKp)), one);
+
+        // Samples where neither does, but the surrounding lines are similar
+        const __m128 bothSimilar = _mm_cmple_ps(_mm_sub_ps(_mm_and_ps(_mm_sub_ps(ap0, an0), absMask),
+                                                           _mm_and_ps(_mm_mul_ps(_mm_add_ps(n0, p0), similar), absMask)),
+                                                zero);
+        const __m128 badKp = _mm_blendv_ps(kp, one, bothSimilar);
+        const __m128 badKn = _mm_blendv_ps(kn, one, bothSimilar);
+
+        kp = _mm_blendv_ps(badKp, goodKp, good);
+        kn = _mm_blendv_ps(badKn, goodKn, good);
+        const __m128 sc = _mm_blendv_ps(one, goodSc, good);
+
+        __m128 tc1 = _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(c0, p0), kp), sc);
+        tc1 = _mm_add_ps(tc1, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(c0, n0), kn), sc));
+        tc1 = _mm_mul_ps(tc1, quarter);
+
+        _mm_storeu_ps(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split2DSample(previousLine, currentLine, nextLine, h, kRange);
+    }
+}
+
+// AVX2 implementations, processing four samples at a time
+
+__attribute__((target("avx2")))
+static inline __m256d loadSamples4(const quint16 *samples)
+{
+    return _mm256_cvtepi32_pd(_mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(samples))));
+}
+
+__attribute__((target("avx2")))
+static void split1DAvx2(const quint16 *line, double *output, qint32 startH, qint32 endH)
+{
+    const __m256d half = _mm256_set1_pd(0.5);
+
+    qint32 h = startH;
+    for (; h + 4 <= endH; h += 4) {
+        const __m256d centre = loadSamples4(line + h);
+        const __m256d sides = _mm256_add_pd(loadSamples4(line + h - 2), loadSamples4(line + h + 2));
+        const __m256d tc1 = _mm256_mul_pd(_mm256_sub_pd(centre, _mm256_mul_pd(sides, half)), half);
+        _mm256_storeu_pd(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split1DSample<double>(line, h);
+    }
+}
+
+__attribute__((target("avx2")))
+static void split2DAvx2(const double *previousLine, const double *currentLine, const double *nextLine,
+                        double *output, qint32 startH, qint32 endH, double kRange)
+{
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFLL));
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d two = _mm256_set1_pd(2.0);
+    const __m256d three = _mm256_set1_pd(3.0);
+    const __m256d bonus = _mm256_set1_pd(.10);
+    const __m256d similar = _mm256_set1_pd(.2);
+    const __m256d quarter = _mm256_set1_pd(0.25);
+    const __m256d range = _mm256_set1_pd(kRange);
+
+    qint32 h = startH;
+    for (; h + 4 <= endH; h += 4) {
+        const __m256d c0 = _mm256_loadu_pd(currentLine + h);
+        const __m256d p0 = _mm256_loadu_pd(previousLine + h);
+        const __m256d n0 = _mm256_loadu_pd(nextLine + h);
+        const __m256d ac0 = _mm256_and_pd(c0, absMask);
+        const __m256d ap0 = _mm256_and_pd(p0, absMask);
+        const __m256d an0 = _mm256_and_pd(n0, absMask);
+        const __m256d ac1 = _mm256_and_pd(_mm256_loadu_pd(currentLine + h - 1), absMask);
+        const __m256d ap1 = _mm256_and_pd(_mm256_loadu_pd(previousLine + h - 1), absMask);
+        const __m256d an1 = _mm256_and_pd(_mm256_loadu_pd(nextLine + h - 1), absMask);
+
+        __m256d kp = _mm256_and_pd(_mm256_sub_pd(ac0, ap0), absMask);
+        kp = _mm256_add_pd(kp, _mm256_and_pd(_mm256_sub_pd(ac1, ap1), absMask));
+        kp = _mm256_sub_pd(kp, _mm256_mul_pd(_mm256_add_pd(ac0, ap1), bonus));
+        __m256d kn = _mm256_and_pd(_mm256_sub_pd(ac0, an0), absMask);
+        kn = _mm256_add_pd(kn, _mm256_and_pd(_mm256_sub_pd(ac1, an1), absMask));
+        kn = _mm256_sub_pd(kn, _mm256_mul_pd(_mm256_add_pd(ac0, an1), bonus));
+
+        kp = _mm256_max_pd(_mm256_min_pd(one, _mm256_sub_pd(one, _mm256_div_pd(kp, range))), zero);
+        kn = _mm256_max_pd(_mm256_min_pd(one, _mm256_sub_pd(one, _mm256_div_pd(kn, range))), zero);
+
+        // Samples where at least one line has a good phase relationship
+        const __m256d good = _mm256_or_pd(_mm256_cmp_pd(kn, zero, _CMP_GT_OQ), _mm256_cmp_pd(kp, zero, _CMP_GT_OQ));
+        const __m256d knBetter = _mm256_cmp_pd(kn, _mm256_mul_pd(three, kp), _CMP_GT_OQ);
+        const __m256d kpBetter = _mm256_andnot_pd(knBetter, _mm256_cmp_pd(kp, _mm256_mul_pd(three, kn), _CMP_GT_OQ));
+        const __m256d goodKp = _mm256_andnot_pd(knBetter, kp);
+        const __m256d goodKn = _mm256_andnot_pd(kpBetter, kn);
+        const __m256d goodSc = _mm256_max_pd(_mm256_div_pd(two, _mm256_add_pd(goodKn, goodKp)), one);
+
+        // Samples where neither does, but the surrounding lines are similar
+        const __m256d bothSimilar = _mm256_cmp_pd(_mm256_sub_pd(_mm256_and_pd(_mm256_sub_pd(ap0, an0), absMask),
+                                                                _mm256_and_pd(_mm256_mul_pd(_mm256_add_pd(n0, p0), similar), absMask)),
+                                                  zero, _CMP_LE_OQ);
+        const __m256d badKp = _mm256_blendv_pd(kp, one, bothSimilar);
+        const __m256d badKn = _mm256_blendv_pd(kn, one, bothSimilar);
+
+        kp = _mm256_blendv_pd(badKp, goodKp, good);
+        kn = _mm256_blendv_pd(badKn, goodKn, good);
+        const __m256d sc = _mm256_blendv_pd(one, goodSc, good);
+
+        __m256d tc1 = _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(c0, p0), kp), sc);
+        tc1 = _mm256_add_pd(tc1, _mm256_mul_pd(_mm256_mul_pd(_mm256_sub_pd(c0, n0), kn), sc));
+        tc1 = _mm256_mul_pd(tc1, quarter);
+
+        _mm256_storeu_pd(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split2DSample(previousLine, currentLine, nextLine, h, kRange);
+    }
+}
+
+// Single-precision AVX2 implementations, processing eight samples at a time
+
+__attribute__((target("avx2")))
+static inline __m256 loadSamples8Float(const quint16 *samples)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(samples))));
+}
+
+__attribute__((target("avx2")))
+static void split1DFloatAvx2(const quint16 *line, float *output, qint32 startH, qint32 endH)
+{
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    qint32 h = startH;
+    for (; h + 8 <= endH; h += 8) {
+        const __m256 centre = loadSamples8Float(line + h);
+        const __m256 sides = _mm256_add_ps(loadSamples8Float(line + h - 2), loadSamples8Float(line + h + 2));
+        const __m256 tc1 = _mm256_mul_ps(_mm256_sub_ps(centre, _mm256_mul_ps(sides, half)), half);
+        _mm256_storeu_ps(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split1DSample<float>(line, h);
+    }
+}
+
+__attribute__((target("avx2")))
+static void split2DFloatAvx2(const float *previousLine, const float *currentLine, const float *nextLine,
+                             float *output, qint32 startH, qint32 endH, float kRange)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    const __m256 bonus = _mm256_set1_ps(.10f);
+    const __m256 similar = _mm256_set1_ps(.2f);
+    const __m256 quarter = _mm256_set1_ps(0.25f);
+    const __m256 range = _mm256_set1_ps(kRange);
+
+    qint32 h = startH;
+    for (; h + 8 <= endH; h += 8) {
+        const __m256 c0 = _mm256_loadu_ps(currentLine + h);
+        const __m256 p0 = _mm256_loadu_ps(previousLine + h);
+        const __m256 n0 = _mm256_loadu_ps(nextLine + h);
+        const __m256 ac0 = _mm256_and_ps(c0, absMask);
+        const __m256 ap0 = _mm256_and_ps(p0, absMask);
+        const __m256 an0 = _mm256_and_ps(n0, absMask);
+        const __m256 ac1 = _mm256_and_ps(_mm256_loadu_ps(currentLine + h - 1), absMask);
+        const __m256 ap1 = _mm256_and_ps(_mm256_loadu_ps(previousLine + h - 1), absMask);
+        const __m256 an1 = _mm256_and_ps(_mm256_loadu_ps(nextLine + h - 1), absMask);
+
+        __m256 kp = _mm256_and_ps(_mm256_sub_ps(ac0, ap0), absMask);
+        kp = _mm256_add_ps(kp, _mm256_and_ps(_mm256_sub_ps(ac1, ap1), absMask));
+        kp = _mm256_sub_ps(kp, _mm256_mul_ps(_mm256_add_ps(ac0, ap1), bonus));
+        __m256 kn = _mm256_and_ps(_mm256_sub_ps(ac0, an0), absMask);
+        kn = _mm256_add_ps(kn, _mm256_and_ps(_mm256_sub_ps(ac1, an1), absMask));
+        kn = _mm256_sub_ps(kn, _mm256_mul_ps(_mm256_add_ps(ac0, an1), bonus));
+
+        kp = _mm256_max_ps(_mm256_min_ps(one, _mm256_sub_ps(one, _mm256_div_ps(kp, range))), zero);
+        kn = _mm256_max_ps(_mm256_min_ps(one, _mm256_sub_ps(one, _mm256_div_ps(kn, range))), zero);
+
+        // Samples where at least one line has a good phase relationship
+        const __m256 good = _mm256_or_ps(_mm256_cmp_ps(kn, zero, _CMP_GT_OQ), _mm256_cmp_ps(kp, zero, _CMP_GT_OQ));
+        const __m256 knBetter = _mm256_cmp_ps(kn, _mm256_mul_ps(three, kp), _CMP_GT_OQ);
+        const __m256 kpBetter = _mm256_andnot_ps(knBetter, _mm256_cmp_ps(kp, _mm256_mul_ps(three, kn), _CMP_GT_OQ));
+        const __m256 goodKp = _mm256_andnot_ps(knBetter, kp);
+        const __m256 goodKn = _mm256_andnot_ps(kpBetter, kn);
+        const __m256 goodSc = _mm256_max_ps(_mm256_div_ps(two, _mm256_add_ps(goodKn, goodKp)), one);
+
+        // Samples where neither does, but the surrounding lines are similar
+        const __m256 bothSimilar = _mm256_cmp_ps(_mm256_sub_ps(_mm256_and_ps(_mm256_sub_ps(ap0, an0), absMask),
+                                                               _mm256_and_ps(_mm256_mul_ps(_mm256_add_ps(n0, p0), similar), absMask)),
+                                                 zero, _CMP_LE_OQ);
+        const __m256 badKp = _mm256_blendv_ps(kp, one, bothSimilar);
+        const __m256 badKn = _mm256_blendv_ps(kn, one, bothSimilar);
+
+        kp = _mm256_blendv_ps(badKp, goodKp, good);
+        kn = _mm256_blendv_ps(badKn, goodKn, good);
+        const __m256 sc = _mm256_blendv_ps(one, goodSc, good);
+
+        __m256 tc1 = _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(c0, p0), kp), sc);
+        tc1 = _mm256_add_ps(tc1, _mm256_mul_ps(_mm256_mul_ps(_mm256_sub_ps(c0, n0), kn), sc));
+        tc1 = _mm256_mul_ps(tc1, quarter);
+
+        _mm256_storeu_ps(output + h, tc1);
+    }
+    for (; h < endH; h++) {
+        output[h] = split2DSample(previousLine, currentLine, nextLine, h, kRange);
+    }
+}
+
+#endif // CPUFEATURES_X86
+
+CombKernels::InstructionSet CombKernels::getBestInstructionSet()
+{
+    if (isSupported(avx2)) return avx2;
+    if (isSupported(sse42)) return sse42;
+    return scalar;
+}
+
+bool CombKernels::isSupported(InstructionSet instructionSet)
+{
+    switch (instructionSet) {
+    case scalar:
+        return true;
+    case sse42:
+        return CpuFeatures::isSupported(CpuFeatures::sse42);
+    case avx2:
+        return CpuFeatures::isSupported(CpuFeatures::avx2);
+    default:
+        return false;
+    }
+}
+
+const char *CombKernels::getName(InstructionSet instructionSet)
+{
+    switch (instructionSet) {
+    case sse42:
+        return "SSE4.2";
+    case avx2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+CombKernels::Functions CombKernels::getFunctions(InstructionSet instructionSet)
+{
+    switch (instructionSet) {
+#ifdef CPUFEATURES_X86
+    case sse42:
+        return {split1DSse42, split2DSse42, split1DFloatSse42, split2DFloatSse42};
+    case avx2:
+        return {split1DAvx2, split2DAvx2, split1DFloatAvx2, split2DFloatAvx2};
+#endif
+    default:
+        return {split1DScalar<double>, split2DScalar<double>, split1DScalar<float>, split2DScalar<float>};
+    }
+}
+
+const CombKernels::Functions &CombKernels::getBestFunctions()
+{
+    static const Functions bestFunctions = getFunctions(getBestInstructionSet());
+    return bestFunctions;
+}
@@ -0,0 +1,87 @@
+/************************************************************************
+
+    combkernels.h
+
+    ld-chroma-decoder - Colourisation filter for ld-decode
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef COMBKERNELS_H
+#define COMBKERNELS_H
+
+#include <QtGlobal>
+
+// Per-line inner loops for Comb's 1D and 2D chroma filters.
+//
+// There is a scalar implementation, which is the reference, plus SSE4.2 and
+// AVX2 implementations on x86 CPUs that support them. The vector versions
+// perform the same arithmetic in the same order as the scalar version, so the
+// results should be identical; testcombkernels checks this.
+//
+// Each kernel comes in double and single-precision versions; the latter are
+// used when Comb is configured for single precision, and process twice as
+// many samples per vector.
+class CombKernels
+{
+public:
+    enum InstructionSet {
+        scalar = 0,
+        sse42,
+        avx2
+    };
+
+    // Compute 1D chroma for samples [startH, endH) of one line.
+    // line must be readable from startH - 2 to endH + 2.
+    using Split1DFunction = void (*)(const quint16 *line, double *output, qint32 startH, qint32 endH);
+
+    // Compute 2D chroma for samples [startH, endH) of one line, given the 1D
+    // chroma for this line and the lines above and below it.
+    // The input lines must be readable from startH - 1.
+    using Split2DFunction = void (*)(const double *previousLine, const double *currentLine, const double *nextLine,
+                                     double *output, qint32 startH, qint32 endH, double kRange);
+
+    // Single-precision versions of the above
+    using Split1DFloatFunction = void (*)(const quint16 *line, float *output, qint32 startH, qint32 endH);
+    using Split2DFloatFunction = void (*)(const float *previousLine, const float *currentLine, const float *nextLine,
+                                          float *output, qint32 startH, qint32 endH, float kRange);
+
+    struct Functions {
+        Split1DFunction split1D;
+        Split2DFunction split2D;
+        Split1DFloatFunction split1DFloat;
+        Split2DFloatFunction split2DFloat;
+    };
+
+    // Return the best instruction set supported by this CPU
+    static InstructionSet getBestInstructionSet();
+
+    // Return true if this CPU (and this build) supports the given instruction set
+    static bool isSupported(InstructionSet instructionSet);
+
+    // Return the name of an instruction set, for messages
+    static const char *getName(InstructionSet instructionSet);
+
+    // Return the kernels for the given instruction set, which must be supported
+    static Functions getFunctions(InstructionSet instructionSet);
+
+    // Return the kernels for the best supported instruction set
+    static const Functions &getBestFunctions();
+};
+
+#endif // COMBKERNELS_H
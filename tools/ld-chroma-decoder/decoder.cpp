@@ -69,7 +69,9 @@ void DecoderThread::run()
             outputWriter.convert(componentFrames[i], outputFrames[i]);
         }
 
-        // Write the frames to the output file
+        // Write the frames to the output file. This takes the frames out of
+        // outputFrames, so the next batch is converted into new buffers
+        // rather than ones the writer may still be using.
         if (!decoderPool.putOutputFrames(startFrameNumber, outputFrames)) {
             abort = true;
             break;
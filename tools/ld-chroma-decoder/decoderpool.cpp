@@ -26,6 +26,8 @@
 
 #include "decoderpool.h"
 
+#include "videobufferpool.h"
+
 // Definitions of static constexpr data members, for compatibility with
 // pre-C++17 compilers
 constexpr qint32 DecoderPool::DEFAULT_BATCH_SIZE;
@@ -36,8 +38,8 @@ DecoderPool::DecoderPool(Decoder &_decoder, QString _inputFileName,
                          qint32 _startFrame, qint32 _length, qint32 _maxThreads)
     : decoder(_decoder), inputFileName(_inputFileName),
       outputConfig(_outputConfig), outputFileName(_outputFileName),
-      startFrame(_startFrame), length(_length), maxThreads(_maxThreads),
-      abort(false), ldDecodeMetaData(_ldDecodeMetaData)
+      startFrame(_startFrame), length(_length), maxThreads(_maxThreads), batchSize(1),
+      abort(false), ldDecodeMetaData(_ldDecodeMetaData), fieldPrefetcher(nullptr)
 {
 }
 
@@ -114,11 +116,41 @@ bool DecoderPool::process()
     qInfo() << "Using" << maxThreads << "threads";
     qInfo() << "Processing from start frame #" << startFrame << "with a length of" << length << "frames";
 
+    // Work out a reasonable batch size to provide work for all threads.
+    // This assumes that the synchronisation to get a new batch is less
+    // expensive than computing a single frame, so a batch size of 1 is
+    // reasonable.
+    batchSize = qMin(DEFAULT_BATCH_SIZE, qMax(1, length / maxThreads));
+
     // Initialise processing state
     inputFrameNumber = startFrame;
     outputFrameNumber = startFrame;
     lastFrameNumber = length + (startFrame - 1);
     totalTimer.start();
+    const qint64 startBytesCopied = VideoBuffer::getBytesCopied();
+
+    // Size the output ring so that every worker can have a batch waiting to
+    // be written while the writer waits for the earliest one. It must hold at
+    // least one batch, or the worker with the next frame to write could block.
+    outputCapacity = (maxThreads + 1) * batchSize;
+    outputSlotFrameNumbers.fill(-1, outputCapacity);
+    outputSlots.clear();
+    outputSlots.resize(outputCapacity);
+
+    // Start reading fields ahead of the workers, covering the decoder's
+    // lookbehind and lookahead
+    const qint32 firstPrefetchFrame = qMax(1, startFrame - decoderLookBehind);
+    const qint32 lastPrefetchFrame = qMin(ldDecodeMetaData.getNumberOfFrames(), lastFrameNumber + decoderLookAhead);
+    fieldPrefetcher = new FieldPrefetcher(sourceVideo, FieldPrefetcher::DEFAULT_DEPTH_FRAMES,
+                                          decoderLookBehind + decoderLookAhead + 1);
+    fieldPrefetcher->startPrefetch(qMin(ldDecodeMetaData.getFirstFieldNumber(firstPrefetchFrame),
+                                        ldDecodeMetaData.getSecondFieldNumber(firstPrefetchFrame)),
+                                   qMax(ldDecodeMetaData.getFirstFieldNumber(lastPrefetchFrame),
+                                        ldDecodeMetaData.getSecondFieldNumber(lastPrefetchFrame)));
+
+    // Start the thread that writes frames to the output file
+    WriterThread writerThread(*this);
+    writerThread.start();
 
     // Start a vector of filtering threads to process the video
     QVector<QThread *> threads;
@@ -134,6 +166,20 @@ bool DecoderPool::process()
         delete threads[i];
     }
 
+    // Wait for the writer to finish. If a worker aborted, the writer may be
+    // waiting for a frame that will never arrive, so wake it up.
+    {
+        QMutexLocker locker(&outputMutex);
+        outputFrameAvailable.wakeAll();
+    }
+    writerThread.wait();
+
+    // Stop the prefetcher
+    fieldPrefetcher->stopPrefetch();
+    const qint64 prefetchStalls = fieldPrefetcher->getStallCount();
+    delete fieldPrefetcher;
+    fieldPrefetcher = nullptr;
+
     // Did any of the threads abort?
     if (abort) {
         sourceVideo.close();
@@ -142,8 +188,7 @@ bool DecoderPool::process()
     }
 
     // Check we've processed all the frames, now the workers have finished
-    if (inputFrameNumber != (lastFrameNumber + 1) || outputFrameNumber != (lastFrameNumber + 1)
-        || !pendingOutputFrames.empty()) {
+    if (inputFrameNumber != (lastFrameNumber + 1) || outputFrameNumber != (lastFrameNumber + 1)) {
         qCritical() << "Incorrect state at end of processing";
         sourceVideo.close();
         targetVideo.close();
@@ -153,6 +198,12 @@ bool DecoderPool::process()
     double totalSecs = (static_cast<double>(totalTimer.elapsed()) / 1000.0);
     qInfo() << "Processing complete -" << length << "frames in" << totalSecs << "seconds (" <<
                length / totalSecs << "FPS )";
+    qInfo() << "Input prefetcher stalled" << prefetchStalls << "times";
+    qInfo() << "Copied" << (VideoBuffer::getBytesCopied() - startBytesCopied) / qMax(length, 1)
+            << "bytes of field data per frame between threads";
+    const VideoBufferPool::Statistics poolStatistics = VideoBufferPool::getStatistics();
+    qInfo() << "Buffer pool allocated" << poolStatistics.allocations << "buffers and reused" << poolStatistics.reuses
+            << "(" << poolStatistics.bytesReserved / (1024 * 1024) << "MiB reserved )";
 
     // Close the source video
     sourceVideo.close();
@@ -167,14 +218,8 @@ bool DecoderPool::getInputFrames(qint32 &startFrameNumber, QVector<SourceField>
 {
     QMutexLocker locker(&inputMutex);
 
-    // Work out a reasonable batch size to provide work for all threads.
-    // This assumes that the synchronisation to get a new batch is less
-    // expensive than computing a single frame, so a batch size of 1 is
-    // reasonable.
-    const qint32 maxBatchSize = qMin(DEFAULT_BATCH_SIZE, qMax(1, length / maxThreads));
-
     // Work out how many frames will be in this batch
-    qint32 batchFrames = qMin(maxBatchSize, lastFrameNumber + 1 - inputFrameNumber);
+    qint32 batchFrames = qMin(batchSize, lastFrameNumber + 1 - inputFrameNumber);
     if (batchFrames == 0) {
         // No more input frames
         return false;
@@ -184,59 +229,108 @@ bool DecoderPool::getInputFrames(qint32 &startFrameNumber, QVector<SourceField>
     startFrameNumber = inputFrameNumber;
     inputFrameNumber += batchFrames;
 
-    // Load the fields
-    SourceField::loadFields(sourceVideo, ldDecodeMetaData,
-                            startFrameNumber, batchFrames, decoderLookBehind, decoderLookAhead,
-                            fields, startIndex, endIndex);
+    // Load the field data
+    SourceField::loadFieldData(*fieldPrefetcher, ldDecodeMetaData,
+                               startFrameNumber, batchFrames, decoderLookBehind, decoderLookAhead,
+                               fields, startIndex, endIndex);
+    locker.unlock();
+
+    // Load the metadata (which doesn't need the lock, as the metadata isn't
+    // changed while threads are running)
+    SourceField::loadFieldMetadata(ldDecodeMetaData, fields);
 
     return true;
 }
 
-bool DecoderPool::putOutputFrames(qint32 startFrameNumber, const QVector<OutputFrame> &outputFrames)
+bool DecoderPool::putOutputFrames(qint32 startFrameNumber, QVector<OutputFrame> &outputFrames)
 {
     QMutexLocker locker(&outputMutex);
 
     for (qint32 i = 0; i < outputFrames.size(); i++) {
-        if (!putOutputFrame(startFrameNumber + i, outputFrames[i])) {
+        if (!putOutputFrame(startFrameNumber + i, std::move(outputFrames[i]))) {
             return false;
         }
     }
+    outputFrames.clear();
 
     return true;
 }
 
-// Write one output frame. You must hold outputMutex to call this.
+// Queue one output frame for writing. You must hold outputMutex to call this.
 //
 // The worker threads will complete frames in an arbitrary order, so we can't
-// just write the frames to the output file directly. Instead, we keep a map of
-// frames that haven't yet been written; when a new frame comes in, we check
-// whether we can now write some of them out.
+// just write the frames to the output file directly. Instead, we put each
+// frame into the output ring at a slot given by its frame number, and the
+// writer thread takes them out in order. If the frame is too far ahead of the
+// writer to fit in the ring, wait for space.
 //
 // Returns true on success, false on failure.
-bool DecoderPool::putOutputFrame(qint32 frameNumber, const OutputFrame &outputFrame)
+bool DecoderPool::putOutputFrame(qint32 frameNumber, OutputFrame &&outputFrame)
+{
+    // Wait until the frame fits in the ring. Workers don't wake each other if
+    // they abort, so check the abort flag periodically.
+    while (!abort && frameNumber >= outputFrameNumber + outputCapacity) {
+        outputSpaceAvailable.wait(&outputMutex, 100);
+    }
+    if (abort) return false;
+
+    // Put this frame into the ring
+    const qint32 slot = frameNumber % outputCapacity;
+    outputSlots[slot] = std::move(outputFrame);
+    outputSlotFrameNumbers[slot] = frameNumber;
+
+    // If it's the one the writer is waiting for, wake it up
+    if (frameNumber == outputFrameNumber) outputFrameAvailable.wakeAll();
+
+    return true;
+}
+
+// Writer thread: write frames from the output ring to the output file, in
+// frame number order, until all frames have been written or processing is
+// aborted. outputMutex isn't held while writing, so workers can keep queueing
+// frames.
+void DecoderPool::writeOutputFrames()
 {
-    // Put this frame into the map
-    pendingOutputFrames[frameNumber] = outputFrame;
+    QMutexLocker locker(&outputMutex);
+
+    while (outputFrameNumber <= lastFrameNumber) {
+        // Wait for the next frame to be available
+        const qint32 slot = outputFrameNumber % outputCapacity;
+        while (!abort && outputSlotFrameNumbers[slot] != outputFrameNumber) {
+            outputFrameAvailable.wait(&outputMutex);
+        }
+        if (abort) break;
 
-    // Write out as many frames as possible
-    while (pendingOutputFrames.contains(outputFrameNumber)) {
-        const OutputFrame& outputData = pendingOutputFrames.value(outputFrameNumber);
+        // Take the frame out of the slot. The slot stays occupied while we're
+        // writing it, since the window doesn't move on until
+        // outputFrameNumber is incremented.
+        const OutputFrame outputData = std::move(outputSlots[slot]);
+        locker.unlock();
 
         // Write the frame header (if there is one)
+        bool writeOK = true;
         const QByteArray frameHeader = outputWriter.getFrameHeader();
         if (frameHeader.size() != 0 && targetVideo.write(frameHeader) == -1) {
-            qCritical() << "Writing to the output video file failed";
-            return false;
+            writeOK = false;
         }
 
         // Write the frame data
-        if (targetVideo.write(reinterpret_cast<const char *>(outputData.data()), outputData.size() * 2) == -1) {
+        if (writeOK && targetVideo.write(reinterpret_cast<const char *>(outputData.data()), outputData.size() * 2) == -1) {
+            writeOK = false;
+        }
+
+        locker.relock();
+
+        if (!writeOK) {
             qCritical() << "Writing to the output video file failed";
-            return false;
+            abort = true;
+            outputSpaceAvailable.wakeAll();
+            break;
         }
 
-        pendingOutputFrames.remove(outputFrameNumber);
+        outputSlotFrameNumbers[slot] = -1;
         outputFrameNumber++;
+        outputSpaceAvailable.wakeAll();
 
         const qint32 outputCount = outputFrameNumber - startFrame;
         if ((outputCount % 32) == 0) {
@@ -245,6 +339,4 @@ bool DecoderPool::putOutputFrame(qint32 frameNumber, const OutputFrame &outputFr
             qInfo() << outputCount << "frames processed -" << fps << "FPS";
         }
     }
-
-    return true;
 }
@@ -28,11 +28,12 @@
 #include <QObject>
 #include <QAtomicInt>
 #include <QElapsedTimer>
-#include <QMap>
 #include <QMutex>
 #include <QThread>
 #include <QVector>
+#include <QWaitCondition>
 
+#include "fieldprefetcher.h"
 #include "lddecodemetadata.h"
 #include "sourcevideo.h"
 
@@ -76,13 +77,31 @@ public:
     // For worker threads: return decoded frames to write to the output file.
     //
     // outputFrames should contain RGB48, YUV444P16, or GRAY16 output frames,
-    // with the first frame being startFrameNumber.
+    // with the first frame being startFrameNumber. The frames are moved out of
+    // outputFrames, leaving it empty, and written by a separate writer
+    // thread; this only blocks if the output window is full, i.e. the writer
+    // is waiting for an earlier frame from another worker.
     //
     // Returns true on success, false on failure.
-    bool putOutputFrames(qint32 startFrameNumber, const QVector<OutputFrame> &outputFrames);
+    bool putOutputFrames(qint32 startFrameNumber, QVector<OutputFrame> &outputFrames);
 
 private:
-    bool putOutputFrame(qint32 frameNumber, const OutputFrame &outputFrame);
+    // Thread that writes completed frames to the output file, in order
+    class WriterThread : public QThread {
+    public:
+        explicit WriterThread(DecoderPool &_decoderPool) : decoderPool(_decoderPool) {}
+
+    protected:
+        void run() override {
+            decoderPool.writeOutputFrames();
+        }
+
+    private:
+        DecoderPool &decoderPool;
+    };
+
+    bool putOutputFrame(qint32 frameNumber, OutputFrame &&outputFrame);
+    void writeOutputFrames();
 
     // Default batch size, in frames
     static constexpr qint32 DEFAULT_BATCH_SIZE = 16;
@@ -95,6 +114,7 @@ private:
     qint32 startFrame;
     qint32 length;
     qint32 maxThreads;
+    qint32 batchSize;
 
     // Atomic abort flag shared by worker threads; workers watch this, and shut
     // down as soon as possible if it becomes true
@@ -108,11 +128,18 @@ private:
     qint32 lastFrameNumber;
     LdDecodeMetaData &ldDecodeMetaData;
     SourceVideo sourceVideo;
+    FieldPrefetcher *fieldPrefetcher;
 
-    // Output stream information (all guarded by outputMutex while threads are running)
+    // Output stream information (all guarded by outputMutex while threads are running).
+    // Completed frames are held in a ring indexed by frame number until the
+    // writer thread gets to them; outputFrameNumber is the next frame to write.
     QMutex outputMutex;
+    QWaitCondition outputSpaceAvailable;
+    QWaitCondition outputFrameAvailable;
     qint32 outputFrameNumber;
-    QMap<qint32, OutputFrame> pendingOutputFrames;
+    qint32 outputCapacity;
+    QVector<qint32> outputSlotFrameNumbers;
+    QVector<OutputFrame> outputSlots;
     OutputWriter outputWriter;
     QFile targetVideo;
     QElapsedTimer totalTimer;
@@ -20,6 +20,7 @@ win32:DEFINES += _USE_MATH_DEFINES
 SOURCES += \
     main.cpp \
     palencoder.cpp \
+    ../../library/tbc/jsonio.cpp \
     ../../library/tbc/lddecodemetadata.cpp \
     ../../library/tbc/logging.cpp \
     ../../library/tbc/vbidecoder.cpp \
@@ -28,6 +29,7 @@ SOURCES += \
 HEADERS += \
     palencoder.h \
     ../../library/filter/firfilter.h \
+    ../../library/tbc/jsonio.h \
     ../../library/tbc/lddecodemetadata.h \
     ../../library/tbc/logging.h \
     ../../library/tbc/vbidecoder.h \
@@ -16,6 +16,7 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
     comb.cpp \
+    combkernels.cpp \
     componentframe.cpp \
     decoder.cpp \
     decoderpool.cpp \
@@ -30,14 +31,19 @@ SOURCES += \
     transformpal.cpp \
     transformpal2d.cpp \
     transformpal3d.cpp \
+    ../library/tbc/fieldprefetcher.cpp \
+    ../library/tbc/jsonio.cpp \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/sourcevideo.cpp \
+    ../library/tbc/videobuffer.cpp \
+    ../library/tbc/videobufferpool.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp \
     ../library/tbc/dropouts.cpp
 
 HEADERS += \
     comb.h \
+    combkernels.h \
     componentframe.h \
     decoder.h \
     decoderpool.h \
@@ -51,16 +57,22 @@ HEADERS += \
     transformpal.h \
     transformpal2d.h \
     transformpal3d.h \
+    ../library/cpu/cpufeatures.h \
     ../library/filter/deemp.h \
     ../library/filter/firfilter.h \
     ../library/filter/iirfilter.h \
+    ../library/tbc/fieldprefetcher.h \
+    ../library/tbc/jsonio.h \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/sourcevideo.h \
+    ../library/tbc/videobuffer.h \
+    ../library/tbc/videobufferpool.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h \
     ../library/tbc/dropouts.h
 
 # Add external includes to the include path
+INCLUDEPATH += ../library/cpu
 INCLUDEPATH += ../library/filter
 INCLUDEPATH += ../library/tbc
 
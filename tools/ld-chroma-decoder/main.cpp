@@ -44,6 +44,7 @@
 #include "palcolour.h"
 #include "paldecoder.h"
 #include "transformpal.h"
+#include "videobufferpool.h"
 
 // Load the thresholds file for the Transform decoders, if specified. We must
 // do this after PalColour has been configured, so we know how many values to
@@ -192,6 +193,11 @@ int main(int argc, char *argv[])
                                      QCoreApplication::translate("main", "number"));
     parser.addOption(threadsOption);
 
+    // Option to back field buffers with huge pages
+    QCommandLineOption hugePagesOption(QStringList() << "huge-pages",
+                                       QCoreApplication::translate("main", "Ask the system to use huge pages for video buffers (uses more memory, may be faster)"));
+    parser.addOption(hugePagesOption);
+
     // Option to override calculated firstActiveFieldLine in our video parameters (-ffll)
     QCommandLineOption firstFieldLineOption(QStringList() << "ffll" << "first_active_field_line",
                                             QCoreApplication::translate("main", "The first visible line of a field. Range 1-259 for NTSC (default: 20), 2-308 for PAL (default: 22)"),
@@ -235,6 +241,11 @@ int main(int argc, char *argv[])
                                     QCoreApplication::translate("main", "number"));
     parser.addOption(lumaNROption);
 
+    // Option to hold the intermediate chroma in single precision
+    QCommandLineOption singlePrecisionOption(QStringList() << "single-precision",
+                                             QCoreApplication::translate("main", "NTSC: Filter chroma in single precision (uses less memory, slightly less accurate)"));
+    parser.addOption(singlePrecisionOption);
+
     // -- PAL decoder options --
 
     // Option to use Simple PAL UV filter
@@ -260,6 +271,12 @@ int main(int argc, char *argv[])
                                                  QCoreApplication::translate("main", "file"));
     parser.addOption(transformThresholdsOption);
 
+    // Option to select the FFTW planning effort
+    QCommandLineOption transformPlannerOption(QStringList() << "transform-planner",
+                                              QCoreApplication::translate("main", "Transform: FFTW planning effort (estimate, measure, patient; default measure). Plans are cached between runs, so patient is only slow the first time"),
+                                              QCoreApplication::translate("main", "effort"));
+    parser.addOption(transformPlannerOption);
+
     // Option to overlay the FFTs
     QCommandLineOption showFFTsOption(QStringList() << "show-ffts",
                                       QCoreApplication::translate("main", "Transform: Overlay the input and output FFTs"));
@@ -348,6 +365,10 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (parser.isSet(hugePagesOption)) {
+        VideoBufferPool::setHugePages(true);
+    }
+
     if (parser.isSet(chromaGainOption)) {
         const double value = parser.value(chromaGainOption).toDouble();
         palConfig.chromaGain = value;
@@ -411,6 +432,22 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (parser.isSet(transformPlannerOption)) {
+        const QString name = parser.value(transformPlannerOption);
+
+        if (name == "estimate") {
+            palConfig.transformPlanner = TransformPal::estimatePlanner;
+        } else if (name == "measure") {
+            palConfig.transformPlanner = TransformPal::measurePlanner;
+        } else if (name == "patient") {
+            palConfig.transformPlanner = TransformPal::patientPlanner;
+        } else {
+            // Quit with error
+            qCritical() << "Unknown Transform planner effort" << name;
+            return -1;
+        }
+    }
+
     if (parser.isSet(simplePALOption)) {
         palConfig.simplePAL = true;
     }
@@ -428,6 +465,10 @@ int main(int argc, char *argv[])
     if (parser.isSet(ntscPhaseComp)) {
         combConfig.phaseCompensation = true;
     }
+
+    if (parser.isSet(singlePrecisionOption)) {
+        combConfig.singlePrecision = true;
+    }
     
     LdDecodeMetaData::LineParameters lineParameters;
     if (parser.isSet(firstFieldLineOption)) {
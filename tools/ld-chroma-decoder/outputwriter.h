@@ -31,13 +31,14 @@
 #include <QVector>
 
 #include "lddecodemetadata.h"
+#include "videobuffer.h"
 
 class ComponentFrame;
 
 // A frame (two interlaced fields), converted to one of the supported output formats.
 // Since all the formats currently supported use 16-bit samples, this is just a
-// vector of 16-bit numbers.
-using OutputFrame = QVector<quint16>;
+// buffer of 16-bit numbers, which can be handed to the writer without copying.
+using OutputFrame = VideoBuffer;
 
 class OutputWriter {
 public:
@@ -123,9 +123,9 @@ void PalColour::updateConfiguration(const LdDecodeMetaData::VideoParameters &_vi
     if (configuration.chromaFilter == transform2DFilter || configuration.chromaFilter == transform3DFilter) {
         // Create the Transform PAL filter
         if (configuration.chromaFilter == transform2DFilter) {
-            transformPal.reset(new TransformPal2D);
+            transformPal.reset(new TransformPal2D(configuration.transformPlanner));
         } else {
-            transformPal.reset(new TransformPal3D);
+            transformPal.reset(new TransformPal3D(configuration.transformPlanner));
         }
 
         // Configure the filter
@@ -63,6 +63,7 @@ public:
         TransformPal::TransformMode transformMode = TransformPal::thresholdMode;
         double transformThreshold = 0.4;
         QVector<double> transformThresholds;
+        TransformPal::PlannerEffort transformPlanner = TransformPal::measurePlanner;
         bool showFFTs = false;
         qint32 showPositionX = 200;
         qint32 showPositionY = 200;
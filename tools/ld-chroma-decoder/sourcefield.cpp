@@ -24,12 +24,15 @@
 
 #include "sourcefield.h"
 
+#include "fieldprefetcher.h"
 #include "sourcevideo.h"
 
-void SourceField::loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecodeMetaData,
-                             qint32 firstFrameNumber, qint32 numFrames,
-                             qint32 lookBehindFrames, qint32 lookAheadFrames,
-                             QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex)
+// Implementation of loadFieldData, for either a SourceVideo or a FieldPrefetcher
+template <typename FieldReader>
+static void loadFieldDataFrom(FieldReader &sourceVideo, const LdDecodeMetaData &ldDecodeMetaData,
+                           qint32 firstFrameNumber, qint32 numFrames,
+                           qint32 lookBehindFrames, qint32 lookAheadFrames,
+                           QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex)
 {
     const LdDecodeMetaData::VideoParameters &videoParameters = ldDecodeMetaData.getVideoParameters();
 
@@ -52,9 +55,9 @@ void SourceField::loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecod
         qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(useBlankFrame ? 1 : frameNumber);
         qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(useBlankFrame ? 1 : frameNumber);
 
-        // Fetch the input metadata
-        fields[i].field = ldDecodeMetaData.getField(firstFieldNumber);
-        fields[i + 1].field = ldDecodeMetaData.getField(secondFieldNumber);
+        // Record which fields these are, for loadFieldMetadata
+        fields[i].field.seqNo = firstFieldNumber;
+        fields[i + 1].field.seqNo = secondFieldNumber;
 
         const quint16 black = videoParameters.black16bIre;
 
@@ -86,3 +89,29 @@ void SourceField::loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecod
         frameNumber++;
     }
 }
+
+void SourceField::loadFields(SourceVideo &sourceVideo, const LdDecodeMetaData &ldDecodeMetaData,
+                             qint32 firstFrameNumber, qint32 numFrames,
+                             qint32 lookBehindFrames, qint32 lookAheadFrames,
+                             QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex)
+{
+    loadFieldDataFrom(sourceVideo, ldDecodeMetaData, firstFrameNumber, numFrames, lookBehindFrames, lookAheadFrames,
+                      fields, startIndex, endIndex);
+    loadFieldMetadata(ldDecodeMetaData, fields);
+}
+
+void SourceField::loadFieldData(FieldPrefetcher &fieldPrefetcher, const LdDecodeMetaData &ldDecodeMetaData,
+                                qint32 firstFrameNumber, qint32 numFrames,
+                                qint32 lookBehindFrames, qint32 lookAheadFrames,
+                                QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex)
+{
+    loadFieldDataFrom(fieldPrefetcher, ldDecodeMetaData, firstFrameNumber, numFrames, lookBehindFrames, lookAheadFrames,
+                      fields, startIndex, endIndex);
+}
+
+void SourceField::loadFieldMetadata(const LdDecodeMetaData &ldDecodeMetaData, QVector<SourceField> &fields)
+{
+    for (SourceField &sourceField : fields) {
+        sourceField.field = ldDecodeMetaData.getField(sourceField.field.seqNo);
+    }
+}
@@ -28,6 +28,8 @@
 #include "lddecodemetadata.h"
 #include "sourcevideo.h"
 
+class FieldPrefetcher;
+
 // A field read from the input, with metadata and data
 struct SourceField {
     LdDecodeMetaData::Field field;
@@ -37,11 +39,22 @@ struct SourceField {
     //
     // fields will contain {lookbehind fields... [startIndex] real fields... [endIndex] lookahead fields...}.
     // Fields requested outside the bounds of the file will have dummy metadata and black data.
-    static void loadFields(SourceVideo &sourceVideo, LdDecodeMetaData &ldDecodeMetaData,
+    static void loadFields(SourceVideo &sourceVideo, const LdDecodeMetaData &ldDecodeMetaData,
                            qint32 firstFrameNumber, qint32 numFrames,
                            qint32 lookBehindFrames, qint32 lookAheadFrames,
                            QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex);
 
+    // As above, but reading the fields through a FieldPrefetcher, and split
+    // into two steps. loadFieldData reads the data, and must be called in
+    // frame order; it leaves only field.seqNo set in the metadata.
+    // loadFieldMetadata then fills in the rest of the metadata, and can be
+    // called from any thread without locking.
+    static void loadFieldData(FieldPrefetcher &fieldPrefetcher, const LdDecodeMetaData &ldDecodeMetaData,
+                              qint32 firstFrameNumber, qint32 numFrames,
+                              qint32 lookBehindFrames, qint32 lookAheadFrames,
+                              QVector<SourceField> &fields, qint32 &startIndex, qint32 &endIndex);
+    static void loadFieldMetadata(const LdDecodeMetaData &ldDecodeMetaData, QVector<SourceField> &fields);
+
     // Return the vertical offset of this field within the interlaced frame
     // (i.e. 0 for the top field, 1 for the bottom field).
     qint32 getOffset() const {
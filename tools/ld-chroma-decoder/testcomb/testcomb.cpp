@@ -0,0 +1,206 @@
+/************************************************************************
+
+    testcomb.cpp
+
+    Unit tests and benchmark for Comb
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+using std::cerr;
+
+#include "comb.h"
+#include "componentframe.h"
+#include "sourcefield.h"
+#include "testfields.h"
+
+// Number of frames in the synthetic input
+static constexpr qint32 NUM_FRAMES = 8;
+
+// Decode numFrames frames starting from firstFrame into outputFrames, giving
+// comb the look-behind and look-ahead frames it needs, as SourceField::loadFields would
+void decodeBatch(Comb &comb, const QVector<SourceField> &fields, qint32 firstFrame, qint32 numFrames,
+                 QVector<ComponentFrame> &outputFrames)
+{
+    const qint32 lookBehind = comb.getConfiguration().getLookBehind();
+    const qint32 lookAhead = comb.getConfiguration().getLookAhead();
+    assert(firstFrame - lookBehind >= 0);
+    assert(firstFrame + numFrames + lookAhead <= NUM_FRAMES);
+
+    const QVector<SourceField> inputFields = fields.mid((firstFrame - lookBehind) * 2,
+                                                        (lookBehind + numFrames + lookAhead) * 2);
+    const qint32 startIndex = lookBehind * 2;
+    const qint32 endIndex = startIndex + (numFrames * 2);
+
+    QVector<ComponentFrame> componentFrames(numFrames);
+    comb.decodeFrames(inputFields, startIndex, endIndex, componentFrames);
+    for (qint32 i = 0; i < numFrames; i++) outputFrames[firstFrame + i] = componentFrames[i];
+}
+
+// Return true if two component frames contain exactly the same samples
+bool sameFrame(const ComponentFrame &a, const ComponentFrame &b)
+{
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return false;
+
+    const size_t bytes = static_cast<size_t>(a.getWidth()) * a.getHeight() * sizeof(double);
+    return memcmp(a.y(0), b.y(0), bytes) == 0
+           && memcmp(a.u(0), b.u(0), bytes) == 0
+           && memcmp(a.v(0), b.v(0), bytes) == 0;
+}
+
+// Decoding frames with one Comb, which reuses its frame buffers between
+// batches, should give exactly the same output as decoding each frame with a
+// new Comb, whatever order the batches come in
+void testReuse(const char *name, const Comb::Configuration &configuration,
+               const LdDecodeMetaData::VideoParameters &videoParameters, const QVector<SourceField> &fields)
+{
+    cerr << "Testing frame buffer reuse with " << name << "\n";
+
+    const qint32 firstFrame = configuration.getLookBehind();
+    const qint32 lastFrame = NUM_FRAMES - configuration.getLookAhead() - 1;
+
+    // Each frame decoded with freshly-allocated buffers
+    QVector<ComponentFrame> expectedFrames(NUM_FRAMES);
+    for (qint32 frame = firstFrame; frame <= lastFrame; frame++) {
+        Comb comb;
+        comb.updateConfiguration(videoParameters, configuration);
+        decodeBatch(comb, fields, frame, 1, expectedFrames);
+    }
+
+    // Forwards, in batches of different sizes
+    QVector<ComponentFrame> forwardFrames(NUM_FRAMES);
+    {
+        Comb comb;
+        comb.updateConfiguration(videoParameters, configuration);
+        qint32 batchSize = 1;
+        for (qint32 frame = firstFrame; frame <= lastFrame; frame += batchSize) {
+            batchSize = qMin((batchSize % 3) + 1, lastFrame + 1 - frame);
+            decodeBatch(comb, fields, frame, batchSize, forwardFrames);
+        }
+    }
+
+    // Backwards, one frame at a time, so the buffers hold later frames
+    QVector<ComponentFrame> backwardFrames(NUM_FRAMES);
+    {
+        Comb comb;
+        comb.updateConfiguration(videoParameters, configuration);
+        for (qint32 frame = lastFrame; frame >= firstFrame; frame--) {
+            decodeBatch(comb, fields, frame, 1, backwardFrames);
+        }
+    }
+
+    // Make sure the decoder did produce some chroma
+    const ComponentFrame &firstExpected = expectedFrames[firstFrame];
+    const qint32 middle = (firstExpected.getHeight() / 2) * firstExpected.getWidth();
+    assert(std::fabs(firstExpected.u(0)[middle + videoParameters.activeVideoStart + 400]) > 0.0);
+
+    for (qint32 frame = firstFrame; frame <= lastFrame; frame++) {
+        if (!sameFrame(forwardFrames[frame], expectedFrames[frame])
+            || !sameFrame(backwardFrames[frame], expectedFrames[frame])) {
+            cerr << "Frame " << frame << " differs when the frame buffers are reused\n";
+            exit(1);
+        }
+    }
+}
+
+// Compare the speed of decoding with one Comb against creating a new Comb
+// (and so new frame buffers) for every batch
+void benchmarkReuse(const char *name, const Comb::Configuration &configuration,
+                    const LdDecodeMetaData::VideoParameters &videoParameters, const QVector<SourceField> &fields)
+{
+    const qint32 firstFrame = configuration.getLookBehind();
+    const qint32 lastFrame = NUM_FRAMES - configuration.getLookAhead() - 1;
+    const qint32 rounds = 4;
+    const qint32 numFrames = rounds * (lastFrame + 1 - firstFrame);
+    QVector<ComponentFrame> outputFrames(NUM_FRAMES);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (qint32 round = 0; round < rounds; round++) {
+        for (qint32 frame = firstFrame; frame <= lastFrame; frame++) {
+            Comb comb;
+            comb.updateConfiguration(videoParameters, configuration);
+            decodeBatch(comb, fields, frame, 1, outputFrames);
+        }
+    }
+    const qint64 newTime = timer.nsecsElapsed();
+
+    Comb comb;
+    comb.updateConfiguration(videoParameters, configuration);
+    timer.restart();
+    for (qint32 round = 0; round < rounds; round++) {
+        for (qint32 frame = firstFrame; frame <= lastFrame; frame++) {
+            decodeBatch(comb, fields, frame, 1, outputFrames);
+        }
+    }
+    const qint64 reuseTime = timer.nsecsElapsed();
+
+    cerr << "Decoding with " << name << ": new buffers " << (numFrames * 1e9 / newTime) << " FPS, "
+         << "reused buffers " << (numFrames * 1e9 / reuseTime) << " FPS\n";
+}
+
+int main()
+{
+    const LdDecodeMetaData::VideoParameters videoParameters = makeVideoParameters(false);
+    const QVector<SourceField> fields = makeFields(videoParameters, NUM_FRAMES);
+
+    Comb::Configuration config1D;
+    config1D.dimensions = 1;
+    Comb::Configuration config2D;
+    config2D.dimensions = 2;
+    Comb::Configuration config2DFiltered = config2D;
+    config2DFiltered.colorlpf = true;
+    config2DFiltered.cNRLevel = 2.0;
+    config2DFiltered.yNRLevel = 2.0;
+    Comb::Configuration config2DLocked = config2D;
+    config2DLocked.phaseCompensation = true;
+    Comb::Configuration config3D;
+    config3D.dimensions = 3;
+    Comb::Configuration config3DMap = config3D;
+    config3DMap.showMap = true;
+    Comb::Configuration config3DNonAdaptive = config3D;
+    config3DNonAdaptive.adaptive = false;
+    Comb::Configuration config2DFloat = config2D;
+    config2DFloat.singlePrecision = true;
+    Comb::Configuration config3DFloat = config3D;
+    config3DFloat.singlePrecision = true;
+
+    testReuse("1D", config1D, videoParameters, fields);
+    testReuse("2D", config2D, videoParameters, fields);
+    testReuse("2D, filtered", config2DFiltered, videoParameters, fields);
+    testReuse("2D, phase compensation", config2DLocked, videoParameters, fields);
+    testReuse("3D", config3D, videoParameters, fields);
+    testReuse("3D, map", config3DMap, videoParameters, fields);
+    testReuse("3D, non-adaptive", config3DNonAdaptive, videoParameters, fields);
+    testReuse("2D, single precision", config2DFloat, videoParameters, fields);
+    testReuse("3D, single precision", config3DFloat, videoParameters, fields);
+
+    benchmarkReuse("2D", config2D, videoParameters, fields);
+    benchmarkReuse("3D", config3D, videoParameters, fields);
+    benchmarkReuse("3D, single precision", config3DFloat, videoParameters, fields);
+
+    return 0;
+}
@@ -0,0 +1,34 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testcomb.cpp \
+    ../comb.cpp \
+    ../combkernels.cpp \
+    ../componentframe.cpp \
+    ../framecanvas.cpp \
+    ../../library/tbc/videobuffer.cpp \
+    ../../library/tbc/videobufferpool.cpp \
+    ../testcommon/testfields.cpp
+
+HEADERS += \
+    ../comb.h \
+    ../combkernels.h \
+    ../componentframe.h \
+    ../framecanvas.h \
+    ../sourcefield.h \
+    ../../library/cpu/cpufeatures.h \
+    ../../library/tbc/lddecodemetadata.h \
+    ../../library/tbc/sourcevideo.h \
+    ../../library/tbc/videobuffer.h \
+    ../../library/tbc/videobufferpool.h \
+    ../testcommon/testfields.h
+
+INCLUDEPATH += \
+    .. \
+    ../testcommon \
+    ../../library/cpu \
+    ../../library/filter \
+    ../../library/tbc
+
+target.CONFIG += no_default_install
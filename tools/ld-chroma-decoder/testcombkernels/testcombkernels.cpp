@@ -0,0 +1,283 @@
+/************************************************************************
+
+    testcombkernels.cpp
+
+    Unit tests for CombKernels
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using std::cerr;
+using std::vector;
+
+#include "combkernels.h"
+
+// The vector kernels should give identical results to the scalar ones, but
+// allow a little slack in case the compiler reorders the scalar arithmetic
+static constexpr double TOLERANCE = 1e-9;
+static constexpr double FLOAT_TOLERANCE = 1e-2;
+
+// Minimum acceptable PSNR of the single-precision chroma relative to the
+// double-precision chroma, in dB
+static constexpr double MIN_FLOAT_PSNR = 100.0;
+
+// Line width, and the range of samples to process (matching NTSC 4fSC)
+static constexpr qint32 WIDTH = 910;
+static constexpr qint32 START_H = 134;
+static constexpr qint32 END_H = 894;
+
+// IRE scale for the 2D filter, as computed by Comb for typical NTSC video
+static constexpr double IRESCALE = 327.68;
+
+// Tolerance for comparing kernels of a given sample type
+template <typename SampleType>
+double getTolerance();
+
+template <>
+double getTolerance<double>()
+{
+    return TOLERANCE;
+}
+
+template <>
+double getTolerance<float>()
+{
+    return FLOAT_TOLERANCE;
+}
+
+// Call the kernel for a given sample type
+void split1D(const CombKernels::Functions &kernels, const quint16 *line, double *output, qint32 startH, qint32 endH)
+{
+    kernels.split1D(line, output, startH, endH);
+}
+
+void split1D(const CombKernels::Functions &kernels, const quint16 *line, float *output, qint32 startH, qint32 endH)
+{
+    kernels.split1DFloat(line, output, startH, endH);
+}
+
+void split2D(const CombKernels::Functions &kernels, const double *previousLine, const double *currentLine, const double *nextLine,
+             double *output, qint32 startH, qint32 endH, double kRange)
+{
+    kernels.split2D(previousLine, currentLine, nextLine, output, startH, endH, kRange);
+}
+
+void split2D(const CombKernels::Functions &kernels, const float *previousLine, const float *currentLine, const float *nextLine,
+             float *output, qint32 startH, qint32 endH, double kRange)
+{
+    kernels.split2DFloat(previousLine, currentLine, nextLine, output, startH, endH, static_cast<float>(kRange));
+}
+
+// Check that two output lines match over the processed range
+template <typename SampleType>
+void checkLine(const char *name, CombKernels::InstructionSet instructionSet, qint32 testNumber,
+               const vector<SampleType> &actual, const vector<SampleType> &expected, qint32 startH, qint32 endH)
+{
+    for (qint32 h = startH; h < endH; h++) {
+        if (std::fabs(actual[h] - expected[h]) > getTolerance<SampleType>()) {
+            cerr << "Mismatch in " << name << " (" << CombKernels::getName(instructionSet) << ") test " << testNumber
+                 << " at " << h << ": " << actual[h] << " != " << expected[h] << "\n";
+            exit(1);
+        }
+    }
+}
+
+// Compare split1D for an instruction set against the scalar version
+template <typename SampleType>
+void testSplit1D(const char *name, CombKernels::InstructionSet instructionSet, std::mt19937 &rng)
+{
+    cerr << "Testing " << name << " (" << CombKernels::getName(instructionSet) << ")\n";
+
+    const CombKernels::Functions reference = CombKernels::getFunctions(CombKernels::scalar);
+    const CombKernels::Functions kernels = CombKernels::getFunctions(instructionSet);
+    std::uniform_int_distribution<qint32> sampleDist(0, 65535);
+
+    for (qint32 test = 0; test < 100; test++) {
+        vector<quint16> line(WIDTH);
+        for (quint16 &sample : line) sample = static_cast<quint16>(sampleDist(rng));
+
+        // Vary the range so that all the leftover-sample paths get used
+        const qint32 startH = START_H + (test % 4);
+        const qint32 endH = END_H - (test % 7);
+
+        vector<SampleType> expected(WIDTH), actual(WIDTH);
+        split1D(reference, line.data(), expected.data(), startH, endH);
+        split1D(kernels, line.data(), actual.data(), startH, endH);
+
+        checkLine(name, instructionSet, test, actual, expected, startH, endH);
+    }
+}
+
+// Compare split2D for an instruction set against the scalar version
+template <typename SampleType>
+void testSplit2D(const char *name, CombKernels::InstructionSet instructionSet, std::mt19937 &rng)
+{
+    cerr << "Testing " << name << " (" << CombKernels::getName(instructionSet) << ")\n";
+
+    const CombKernels::Functions reference = CombKernels::getFunctions(CombKernels::scalar);
+    const CombKernels::Functions kernels = CombKernels::getFunctions(instructionSet);
+    std::uniform_real_distribution<double> chromaDist(-20000.0, 20000.0);
+    std::uniform_real_distribution<double> noiseDist(-500.0, 500.0);
+    const double kRange = 45 * IRESCALE;
+
+    for (qint32 test = 0; test < 400; test++) {
+        vector<SampleType> previousLine(WIDTH), currentLine(WIDTH), nextLine(WIDTH);
+
+        // Build lines that exercise each branch of the filter: unrelated
+        // lines, lines in and out of phase with this one, and black lines
+        for (qint32 h = 0; h < WIDTH; h++) {
+            currentLine[h] = chromaDist(rng);
+            switch (test % 5) {
+            case 0:
+                previousLine[h] = chromaDist(rng);
+                nextLine[h] = chromaDist(rng);
+                break;
+            case 1:
+                previousLine[h] = -currentLine[h] + noiseDist(rng);
+                nextLine[h] = chromaDist(rng);
+                break;
+            case 2:
+                previousLine[h] = chromaDist(rng);
+                nextLine[h] = currentLine[h] + noiseDist(rng);
+                break;
+            case 3:
+                previousLine[h] = chromaDist(rng);
+                nextLine[h] = previousLine[h] + noiseDist(rng);
+                break;
+            default:
+                previousLine[h] = 0;
+                nextLine[h] = 0;
+                break;
+            }
+        }
+
+        const qint32 startH = START_H + (test % 4);
+        const qint32 endH = END_H - (test % 7);
+
+        vector<SampleType> expected(WIDTH), actual(WIDTH);
+        split2D(reference, previousLine.data(), currentLine.data(), nextLine.data(), expected.data(), startH, endH, kRange);
+        split2D(kernels, previousLine.data(), currentLine.data(), nextLine.data(), actual.data(), startH, endH, kRange);
+
+        checkLine(name, instructionSet, test, actual, expected, startH, endH);
+    }
+}
+
+// Run the 1D and 2D filters over a synthetic frame, returning the 2D chroma
+template <typename SampleType>
+vector<vector<SampleType>> filterFrame(const CombKernels::Functions &kernels, const vector<vector<quint16>> &frame)
+{
+    const qint32 height = static_cast<qint32>(frame.size());
+    const double kRange = 45 * IRESCALE;
+
+    vector<vector<SampleType>> chroma1D(height, vector<SampleType>(WIDTH));
+    for (qint32 y = 0; y < height; y++) {
+        split1D(kernels, frame[y].data(), chroma1D[y].data(), START_H, END_H);
+    }
+
+    // Lines outside the frame are black, as in Comb
+    const vector<SampleType> blackLine(WIDTH);
+    vector<vector<SampleType>> chroma2D(height, vector<SampleType>(WIDTH));
+    for (qint32 y = 0; y < height; y++) {
+        const vector<SampleType> &previousLine = (y > 0) ? chroma1D[y - 1] : blackLine;
+        const vector<SampleType> &nextLine = (y + 1 < height) ? chroma1D[y + 1] : blackLine;
+        split2D(kernels, previousLine.data(), chroma1D[y].data(), nextLine.data(), chroma2D[y].data(), START_H, END_H, kRange);
+    }
+
+    return chroma2D;
+}
+
+// Measure the quality impact of single-precision processing, by comparing
+// the 2D chroma for a synthetic NTSC field against the double-precision result
+void testFloatPsnr(CombKernels::InstructionSet instructionSet, std::mt19937 &rng)
+{
+    cerr << "Testing single-precision PSNR (" << CombKernels::getName(instructionSet) << ")\n";
+
+    const CombKernels::Functions reference = CombKernels::getFunctions(CombKernels::scalar);
+    const CombKernels::Functions kernels = CombKernels::getFunctions(instructionSet);
+    std::normal_distribution<double> noiseDist(0.0, 200.0);
+
+    // Build a field of vertical bars, with a luma ramp and a different
+    // chroma amplitude and phase in each bar. The subcarrier is at 4fSC and
+    // inverts from line to line, as in NTSC.
+    static constexpr qint32 HEIGHT = 263;
+    static constexpr double BLACK = 15360.0;
+    static constexpr double WHITE = 51200.0;
+    vector<vector<quint16>> frame(HEIGHT, vector<quint16>(WIDTH));
+    for (qint32 y = 0; y < HEIGHT; y++) {
+        for (qint32 h = 0; h < WIDTH; h++) {
+            const qint32 bar = (h * 8) / WIDTH;
+            const double luma = BLACK + ((WHITE - BLACK) * h) / WIDTH;
+            const double amplitude = 2000.0 * (bar % 4);
+            const double phase = (bar * M_PI / 4) + ((h + 2 * (y % 2)) * M_PI / 2);
+            const double sample = luma + (amplitude * std::sin(phase)) + noiseDist(rng);
+            frame[y][h] = static_cast<quint16>(std::max(0.0, std::min(65535.0, sample)));
+        }
+    }
+
+    const vector<vector<double>> expected = filterFrame<double>(reference, frame);
+    const vector<vector<float>> actual = filterFrame<float>(kernels, frame);
+
+    double squaredError = 0.0;
+    qint64 count = 0;
+    for (qint32 y = 0; y < HEIGHT; y++) {
+        for (qint32 h = START_H; h < END_H; h++) {
+            const double error = actual[y][h] - expected[y][h];
+            squaredError += error * error;
+            count++;
+        }
+    }
+
+    const double mse = squaredError / count;
+    const double psnr = (mse == 0.0) ? INFINITY : 10 * std::log10((65535.0 * 65535.0) / mse);
+    cerr << "PSNR is " << psnr << " dB\n";
+
+    if (psnr < MIN_FLOAT_PSNR) {
+        cerr << "Single-precision PSNR (" << CombKernels::getName(instructionSet) << ") is below "
+             << MIN_FLOAT_PSNR << " dB\n";
+        exit(1);
+    }
+}
+
+int main()
+{
+    cerr << "Best instruction set is " << CombKernels::getName(CombKernels::getBestInstructionSet()) << "\n";
+
+    std::mt19937 rng(42);
+    for (CombKernels::InstructionSet instructionSet : {CombKernels::scalar, CombKernels::sse42, CombKernels::avx2}) {
+        if (!CombKernels::isSupported(instructionSet)) {
+            cerr << "Skipping " << CombKernels::getName(instructionSet) << ", not supported on this CPU\n";
+            continue;
+        }
+
+        testSplit1D<double>("split1D", instructionSet, rng);
+        testSplit2D<double>("split2D", instructionSet, rng);
+        testSplit1D<float>("split1DFloat", instructionSet, rng);
+        testSplit2D<float>("split2DFloat", instructionSet, rng);
+        testFloatPsnr(instructionSet, rng);
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+/************************************************************************
+
+    testfields.cpp
+
+    Synthetic input fields for the ld-chroma-decoder tests
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "testfields.h"
+
+#include <cmath>
+#include <random>
+
+LdDecodeMetaData::VideoParameters makeVideoParameters(bool isSourcePal)
+{
+    LdDecodeMetaData::VideoParameters videoParameters;
+    videoParameters.isSourcePal = isSourcePal;
+    if (isSourcePal) {
+        videoParameters.colourBurstStart = 98;
+        videoParameters.colourBurstEnd = 138;
+        videoParameters.activeVideoStart = 185;
+        videoParameters.activeVideoEnd = 1107;
+        videoParameters.white16bIre = 54016;
+        videoParameters.black16bIre = 16384;
+        videoParameters.fieldWidth = 1135;
+        videoParameters.fieldHeight = 313;
+        videoParameters.fsc = 4433618.75;
+        videoParameters.firstActiveFieldLine = 22;
+        videoParameters.lastActiveFieldLine = 308;
+        videoParameters.firstActiveFrameLine = 44;
+        videoParameters.lastActiveFrameLine = 620;
+    } else {
+        videoParameters.colourBurstStart = 78;
+        videoParameters.colourBurstEnd = 110;
+        videoParameters.activeVideoStart = 134;
+        videoParameters.activeVideoEnd = 894;
+        videoParameters.white16bIre = 51200;
+        videoParameters.black16bIre = 15360;
+        videoParameters.fieldWidth = 910;
+        videoParameters.fieldHeight = 263;
+        videoParameters.fsc = 3579545;
+        videoParameters.firstActiveFieldLine = 20;
+        videoParameters.lastActiveFieldLine = 259;
+        videoParameters.firstActiveFrameLine = 40;
+        videoParameters.lastActiveFrameLine = 525;
+    }
+    videoParameters.sampleRate = 4 * videoParameters.fsc;
+    videoParameters.isValid = true;
+    return videoParameters;
+}
+
+// Return the number of the colour bar containing sample x
+static qint32 getBar(const LdDecodeMetaData::VideoParameters &videoParameters, qint32 x)
+{
+    return ((x - videoParameters.activeVideoStart) * 8)
+           / (videoParameters.activeVideoEnd - videoParameters.activeVideoStart);
+}
+
+double getBarLuma(const LdDecodeMetaData::VideoParameters &videoParameters, qint32 x)
+{
+    return 20.0 + (getBar(videoParameters, x) * 7.0);
+}
+
+static SourceField makeField(const LdDecodeMetaData::VideoParameters &videoParameters, qint32 frameNumber,
+                             bool isFirstField, std::mt19937 &rng)
+{
+    // PAL has an eight-field sequence, and NTSC four
+    const qint32 fieldSequenceLength = videoParameters.isSourcePal ? 8 : 4;
+
+    SourceField sourceField;
+    sourceField.field.seqNo = (frameNumber * 2) + (isFirstField ? 1 : 2);
+    sourceField.field.isFirstField = isFirstField;
+    sourceField.field.fieldPhaseID = (((frameNumber * 2) + (isFirstField ? 0 : 1)) % fieldSequenceLength) + 1;
+
+    const double ireScale = (videoParameters.white16bIre - videoParameters.black16bIre) / 100.0;
+    const bool isPositivePhaseOnEvenLines = (sourceField.field.fieldPhaseID == 1)
+                                            || (sourceField.field.fieldPhaseID == 4);
+    std::normal_distribution<double> noiseDist(0.0, 1.0);
+
+    sourceField.data.resize(videoParameters.fieldWidth * videoParameters.fieldHeight);
+    for (qint32 line = 0; line < videoParameters.fieldHeight; line++) {
+        const qint32 frameLine = (line * 2) + (isFirstField ? 0 : 1);
+
+        // For NTSC, the subcarrier phase inverts on alternate lines. For PAL,
+        // there are 283.75 cycles of subcarrier per line, so the phase
+        // advances by three quarters of a cycle per line (counting through
+        // the 625-line frame), and the V component switches phase on
+        // alternate lines.
+        const double ntscLinePhase = (((line % 2) == 0) == isPositivePhaseOnEvenLines) ? 1.0 : -1.0;
+        const qint32 palLine = (frameNumber * 625) + (isFirstField ? 0 : 313) + line;
+        const double palVSwitch = (palLine % 2) == 0 ? 1.0 : -1.0;
+        const double palLinePhase = (palLine % 4) * (3.0 * M_PI / 2.0);
+
+        for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
+            const double palPhase = (x * M_PI / 2.0) + palLinePhase;
+
+            double ire = 0.0;
+            if (x >= videoParameters.colourBurstStart && x < videoParameters.colourBurstEnd) {
+                if (videoParameters.isSourcePal) {
+                    ire = 20.0 * std::sin(palPhase + (palVSwitch * 3.0 * M_PI / 4.0));
+                } else {
+                    ire = 20.0 * ntscLinePhase * std::sin(((x % 4) * M_PI / 2.0) + M_PI);
+                }
+            } else if (x >= videoParameters.activeVideoStart && x < videoParameters.activeVideoEnd) {
+                // Eight bars, each with a different hue
+                const double hue = getBar(videoParameters, x) * (M_PI / 4.0);
+                ire = getBarLuma(videoParameters, x);
+                if (videoParameters.isSourcePal) {
+                    ire += 25.0 * ((std::cos(hue) * std::sin(palPhase)) + (palVSwitch * std::sin(hue) * std::cos(palPhase)));
+                } else {
+                    ire += 25.0 * ntscLinePhase * std::sin(((x % 4) * M_PI / 2.0) + hue);
+                }
+
+                // The moving box
+                const qint32 boxX = videoParameters.activeVideoStart + 100 + (frameNumber * 23);
+                const qint32 boxY = 100 + (frameNumber * 11);
+                if (x >= boxX && x < boxX + 120 && frameLine >= boxY && frameLine < boxY + 80) ire += 30.0;
+
+                ire += 2.0 * noiseDist(rng);
+            }
+
+            const double sample = videoParameters.black16bIre + (ire * ireScale);
+            sourceField.data[(line * videoParameters.fieldWidth) + x] = static_cast<quint16>(qBound(0.0, sample, 65535.0));
+        }
+    }
+
+    return sourceField;
+}
+
+QVector<SourceField> makeFields(const LdDecodeMetaData::VideoParameters &videoParameters, qint32 numFrames)
+{
+    std::mt19937 rng(42);
+    QVector<SourceField> fields;
+    for (qint32 frameNumber = 0; frameNumber < numFrames; frameNumber++) {
+        fields.append(makeField(videoParameters, frameNumber, true, rng));
+        fields.append(makeField(videoParameters, frameNumber, false, rng));
+    }
+    return fields;
+}
@@ -0,0 +1,46 @@
+/************************************************************************
+
+    testfields.h
+
+    Synthetic input fields for the ld-chroma-decoder tests
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef TESTFIELDS_H
+#define TESTFIELDS_H
+
+#include <QVector>
+
+#include "lddecodemetadata.h"
+#include "sourcefield.h"
+
+// Return video parameters for NTSC or PAL 4fSC, as ld-decode produces
+LdDecodeMetaData::VideoParameters makeVideoParameters(bool isSourcePal);
+
+// Generate numFrames frames (two fields each) of synthetic composite video:
+// eight colour bars modulated onto the subcarrier, each with a different
+// luma level, a bright box that moves from frame to frame (so the 3D filters
+// have motion to adapt to), and some noise. The output is the same every
+// time for the same arguments.
+QVector<SourceField> makeFields(const LdDecodeMetaData::VideoParameters &videoParameters, qint32 numFrames);
+
+// Return the luma level of the colour bar containing sample x, in IRE
+double getBarLuma(const LdDecodeMetaData::VideoParameters &videoParameters, qint32 x);
+
+#endif // TESTFIELDS_H
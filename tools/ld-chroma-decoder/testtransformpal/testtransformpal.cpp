@@ -0,0 +1,142 @@
+/************************************************************************
+
+    testtransformpal.cpp
+
+    Unit tests and benchmark for Transform PAL
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-chroma-decoder is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+using std::cerr;
+
+#include "sourcefield.h"
+#include "testfields.h"
+#include "transformpal2d.h"
+#include "transformpal3d.h"
+
+// Number of frames in the synthetic input
+static constexpr qint32 NUM_FRAMES = 8;
+
+// Largest acceptable RMS error in the separated luma, in IRE
+static constexpr double MAX_LUMA_ERROR = 2.0;
+
+// Filter the fields that have enough surrounding fields for the 3D filter,
+// returning pointers to the chroma for each
+QVector<const double *> filterAll(TransformPal &transformPal, const QVector<SourceField> &fields)
+{
+    const qint32 startIndex = TransformPal3D::getLookBehind() * 2;
+    const qint32 endIndex = fields.size() - (TransformPal3D::getLookAhead() * 2);
+
+    QVector<const double *> outputFields(endIndex - startIndex);
+    transformPal.filterFields(fields, startIndex, endIndex, outputFields);
+    return outputFields;
+}
+
+// Return the RMS difference, in IRE, between the luma left when the chroma
+// is subtracted from the input and the luma of the colour bars. This is
+// measured below the moving box, and away from the edges of the bars.
+double getLumaError(const QVector<SourceField> &fields, const QVector<const double *> &chromaFields,
+                    const LdDecodeMetaData::VideoParameters &videoParameters)
+{
+    const double ireScale = (videoParameters.white16bIre - videoParameters.black16bIre) / 100.0;
+    const qint32 barWidth = (videoParameters.activeVideoEnd - videoParameters.activeVideoStart) / 8;
+    const qint32 startIndex = TransformPal3D::getLookBehind() * 2;
+
+    double totalSquared = 0.0;
+    qint64 count = 0;
+    for (qint32 i = 0; i < chromaFields.size(); i++) {
+        const SourceField &field = fields[startIndex + i];
+        for (qint32 line = 150; line < videoParameters.lastActiveFieldLine - 10; line++) {
+            for (qint32 x = videoParameters.activeVideoStart; x < videoParameters.activeVideoEnd; x++) {
+                const qint32 barX = (x - videoParameters.activeVideoStart) % barWidth;
+                if (barX < 20 || barX >= barWidth - 20) continue;
+
+                const qint32 index = (line * videoParameters.fieldWidth) + x;
+                const double luma = (field.data[index] - chromaFields[i][index] - videoParameters.black16bIre) / ireScale;
+                const double error = luma - getBarLuma(videoParameters, x);
+                totalSquared += error * error;
+                count++;
+            }
+        }
+    }
+    assert(count > 0);
+
+    return std::sqrt(totalSquared / count);
+}
+
+// The filter should separate the chroma from the luma, so that the luma left
+// is as flat as the colour bars in the input. The input has 25 IRE of chroma
+// (about 18 IRE RMS), and 2 IRE of noise, some of which the filter will
+// take as chroma.
+void testSeparation(const char *name, TransformPal &transformPal, TransformPal::TransformMode mode,
+                    const LdDecodeMetaData::VideoParameters &videoParameters, const QVector<SourceField> &fields)
+{
+    cerr << "Testing chroma separation with " << name << "\n";
+
+    transformPal.updateConfiguration(videoParameters, mode, 0.4, QVector<double>());
+    const double error = getLumaError(fields, filterAll(transformPal, fields), videoParameters);
+    if (error > MAX_LUMA_ERROR) {
+        cerr << "Luma differs from the input's by " << error << " IRE RMS (limit " << MAX_LUMA_ERROR << ")\n";
+        exit(1);
+    }
+}
+
+// Measure the speed of filtering with a Transform PAL filter
+void benchmarkFilter(const char *name, TransformPal &transformPal,
+                     const LdDecodeMetaData::VideoParameters &videoParameters, const QVector<SourceField> &fields)
+{
+    const qint32 rounds = 4;
+    transformPal.updateConfiguration(videoParameters, TransformPal::thresholdMode, 0.4, QVector<double>());
+
+    // Warm up, so planning isn't counted
+    const qint32 numFields = rounds * filterAll(transformPal, fields).size();
+
+    QElapsedTimer timer;
+    timer.start();
+    for (qint32 round = 0; round < rounds; round++) {
+        filterAll(transformPal, fields);
+    }
+    const qint64 time = timer.nsecsElapsed();
+
+    cerr << "Filtering with " << name << ": " << (numFields * 1e9 / time) << " fields/sec\n";
+}
+
+int main()
+{
+    const LdDecodeMetaData::VideoParameters videoParameters = makeVideoParameters(true);
+    const QVector<SourceField> fields = makeFields(videoParameters, NUM_FRAMES);
+
+    TransformPal2D transformPal2D(TransformPal::estimatePlanner);
+    TransformPal3D transformPal3D(TransformPal::estimatePlanner);
+    testSeparation("2D, threshold mode", transformPal2D, TransformPal::thresholdMode, videoParameters, fields);
+    testSeparation("2D, level mode", transformPal2D, TransformPal::levelMode, videoParameters, fields);
+    testSeparation("3D, threshold mode", transformPal3D, TransformPal::thresholdMode, videoParameters, fields);
+    testSeparation("3D, level mode", transformPal3D, TransformPal::levelMode, videoParameters, fields);
+
+    benchmarkFilter("2D", transformPal2D, videoParameters, fields);
+    benchmarkFilter("3D", transformPal3D, videoParameters, fields);
+
+    return 0;
+}
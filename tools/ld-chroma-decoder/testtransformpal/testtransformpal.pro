@@ -0,0 +1,41 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testtransformpal.cpp \
+    ../componentframe.cpp \
+    ../framecanvas.cpp \
+    ../transformpal.cpp \
+    ../transformpal2d.cpp \
+    ../transformpal3d.cpp \
+    ../../library/tbc/videobuffer.cpp \
+    ../../library/tbc/videobufferpool.cpp \
+    ../testcommon/testfields.cpp
+
+HEADERS += \
+    ../componentframe.h \
+    ../framecanvas.h \
+    ../sourcefield.h \
+    ../transformpal.h \
+    ../transformpal2d.h \
+    ../transformpal3d.h \
+    ../../library/tbc/lddecodemetadata.h \
+    ../../library/tbc/sourcevideo.h \
+    ../../library/tbc/videobuffer.h \
+    ../../library/tbc/videobufferpool.h \
+    ../testcommon/testfields.h
+
+INCLUDEPATH += \
+    .. \
+    ../testcommon \
+    ../../library/filter \
+    ../../library/tbc
+
+# FFTW, as for ld-chroma-decoder
+macx {
+INCLUDEPATH += "/usr/local/include"
+}
+LIBS += -L"/usr/local/lib"
+LIBS += -lfftw3
+
+target.CONFIG += no_default_install
@@ -27,11 +27,128 @@
 
 #include "transformpal.h"
 
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+#include <QPair>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 
-TransformPal::TransformPal(qint32 _xComplex, qint32 _yComplex, qint32 _zComplex)
-    : xComplex(_xComplex), yComplex(_yComplex), zComplex(_zComplex), configurationSet(false)
+// Shared FFTW plans, indexed by transform size and planner flags (with the low
+// bit set for forward transforms). FFTW's planner isn't thread-safe, so all
+// planning and wisdom handling happens while holding planMutex.
+static QMutex planMutex;
+static QMap<QPair<QVector<int>, unsigned>, fftw_plan> planCache;
+static bool wisdomLoaded = false;
+
+// Return the name of the file used to store FFTW wisdom between runs
+static QString getWisdomFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/ld-decode/fftw-wisdom";
+}
+
+// Import FFTW wisdom from the cache file, if it exists.
+// You must hold planMutex to call this.
+static void loadWisdom()
+{
+    QFile wisdomFile(getWisdomFileName());
+    if (!wisdomFile.open(QIODevice::ReadOnly)) {
+        // No wisdom saved yet
+        return;
+    }
+
+    const QByteArray wisdom = wisdomFile.readAll();
+    if (!fftw_import_wisdom_from_string(wisdom.constData())) {
+        qWarning() << "Ignoring invalid FFTW wisdom file" << wisdomFile.fileName();
+    }
+}
+
+// Export all FFTW wisdom to the cache file, replacing it atomically so that
+// other processes never see a partial file.
+// You must hold planMutex to call this.
+static void saveWisdom()
+{
+    char *wisdom = fftw_export_wisdom_to_string();
+    if (wisdom == nullptr) return;
+
+    const QString fileName = getWisdomFileName();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile wisdomFile(fileName);
+    if (!wisdomFile.open(QIODevice::WriteOnly) || wisdomFile.write(wisdom) == -1 || !wisdomFile.commit()) {
+        qDebug() << "Couldn't save FFTW wisdom to" << fileName;
+    }
+
+    // FFTW allocates the string with malloc
+    free(wisdom);
+}
+
+// Get a plan from the cache, or create it if it's not there
+static fftw_plan getCachedPlan(const QVector<int> &dimensions, bool forward, TransformPal::PlannerEffort plannerEffort)
+{
+    unsigned flags;
+    switch (plannerEffort) {
+    case TransformPal::estimatePlanner:
+        flags = FFTW_ESTIMATE;
+        break;
+    case TransformPal::patientPlanner:
+        flags = FFTW_PATIENT;
+        break;
+    default:
+        flags = FFTW_MEASURE;
+        break;
+    }
+
+    QMutexLocker locker(&planMutex);
+
+    const QPair<QVector<int>, unsigned> key(dimensions, (flags << 1) | (forward ? 1 : 0));
+    const auto it = planCache.constFind(key);
+    if (it != planCache.constEnd()) return it.value();
+
+    if (!wisdomLoaded) {
+        loadWisdom();
+        wisdomLoaded = true;
+    }
+
+    // Work out the array sizes. The last dimension of the complex array is
+    // roughly half the size of the real one, since the input data is real.
+    qint32 realSize = 1;
+    qint32 complexSize = 1;
+    for (qint32 i = 0; i < dimensions.size(); i++) {
+        realSize *= dimensions[i];
+        complexSize *= (i == dimensions.size() - 1) ? (dimensions[i] / 2) + 1 : dimensions[i];
+    }
+
+    // Plan using temporary arrays. Measuring overwrites the arrays, so we
+    // can't plan using the caller's buffers anyway; because the arrays are
+    // allocated by FFTW, the plan is valid for any other arrays it allocates.
+    double *fftReal = fftw_alloc_real(realSize);
+    fftw_complex *fftComplex = fftw_alloc_complex(complexSize);
+    fftw_plan plan;
+    if (forward) {
+        plan = fftw_plan_dft_r2c(dimensions.size(), dimensions.data(), fftReal, fftComplex, flags);
+    } else {
+        plan = fftw_plan_dft_c2r(dimensions.size(), dimensions.data(), fftComplex, fftReal, flags);
+    }
+    fftw_free(fftReal);
+    fftw_free(fftComplex);
+
+    planCache.insert(key, plan);
+
+    // Save any new wisdom for the next run (estimating doesn't produce any)
+    if (plannerEffort != TransformPal::estimatePlanner) saveWisdom();
+
+    return plan;
+}
+
+TransformPal::TransformPal(qint32 _xComplex, qint32 _yComplex, qint32 _zComplex, PlannerEffort _plannerEffort)
+    : xComplex(_xComplex), yComplex(_yComplex), zComplex(_zComplex), plannerEffort(_plannerEffort),
+      configurationSet(false)
 {
 }
 
@@ -75,6 +192,16 @@ void TransformPal::overlayFFT(qint32 positionX, qint32 positionY,
     }
 }
 
+fftw_plan TransformPal::getForwardPlan(const QVector<int> &dimensions)
+{
+    return getCachedPlan(dimensions, true, plannerEffort);
+}
+
+fftw_plan TransformPal::getInversePlan(const QVector<int> &dimensions)
+{
+    return getCachedPlan(dimensions, false, plannerEffort);
+}
+
 // Overlay the input and output FFT arrays, in either 2D or 3D
 void TransformPal::overlayFFTArrays(const fftw_complex *fftIn, const fftw_complex *fftOut,
                                     FrameCanvas &canvas)
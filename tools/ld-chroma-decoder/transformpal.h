@@ -41,7 +41,19 @@
 // Abstract base class for Transform PAL filters.
 class TransformPal {
 public:
-    TransformPal(qint32 xComplex, qint32 yComplex, qint32 zComplex);
+    // Specify how much effort FFTW should put into planning the transforms.
+    // Plans are saved as FFTW wisdom in a cache file, so the cost of the more
+    // thorough options is only paid the first time they're used.
+    enum PlannerEffort {
+        // Guess a reasonable plan, without measuring anything
+        estimatePlanner = 0,
+        // Measure a few candidate plans and pick the fastest
+        measurePlanner,
+        // Measure a wider range of plans (slow unless wisdom exists)
+        patientPlanner
+    };
+
+    TransformPal(qint32 xComplex, qint32 yComplex, qint32 zComplex, PlannerEffort plannerEffort);
     virtual ~TransformPal();
 
     // Specify what the frequency-domain filter should do to each pair of
@@ -91,10 +103,20 @@ protected:
     void overlayFFTArrays(const fftw_complex *fftIn, const fftw_complex *fftOut,
                           FrameCanvas &canvas);
 
+    // Get FFTW plans for a real-to-complex transform of the given size
+    // (slowest-varying dimension first), and its inverse.
+    //
+    // Plans are cached and shared between all TransformPal objects, and live
+    // until the program exits. They must be run using the new-array execute
+    // functions (fftw_execute_dft_r2c/c2r), on arrays allocated by FFTW.
+    fftw_plan getForwardPlan(const QVector<int> &dimensions);
+    fftw_plan getInversePlan(const QVector<int> &dimensions);
+
     // FFT size
     qint32 xComplex;
     qint32 yComplex;
     qint32 zComplex;
+    PlannerEffort plannerEffort;
 
     // Configuration parameters
     bool configurationSet;
@@ -60,8 +60,8 @@ static double computeWindow(qint32 element, qint32 limit)
     return 0.5 - (0.5 * cos((2 * M_PI * (element + 0.5)) / limit));
 }
 
-TransformPal2D::TransformPal2D()
-    : TransformPal(XCOMPLEX, YCOMPLEX, 1)
+TransformPal2D::TransformPal2D(PlannerEffort _plannerEffort)
+    : TransformPal(XCOMPLEX, YCOMPLEX, 1, _plannerEffort)
 {
     // Compute the window function.
     for (qint32 y = 0; y < YTILE; y++) {
@@ -78,16 +78,15 @@ TransformPal2D::TransformPal2D()
     fftComplexIn = fftw_alloc_complex(YCOMPLEX * XCOMPLEX);
     fftComplexOut = fftw_alloc_complex(YCOMPLEX * XCOMPLEX);
 
-    // Plan FFTW operations
-    forwardPlan = fftw_plan_dft_r2c_2d(YTILE, XTILE, fftReal, fftComplexIn, FFTW_MEASURE);
-    inversePlan = fftw_plan_dft_c2r_2d(YTILE, XTILE, fftComplexOut, fftReal, FFTW_MEASURE);
+    // Get FFTW plans from the shared cache
+    const QVector<int> dimensions {YTILE, XTILE};
+    forwardPlan = getForwardPlan(dimensions);
+    inversePlan = getInversePlan(dimensions);
 }
 
 TransformPal2D::~TransformPal2D()
 {
-    // Free FFTW plans and buffers
-    fftw_destroy_plan(forwardPlan);
-    fftw_destroy_plan(inversePlan);
+    // Free FFTW buffers (the plans belong to the cache)
     fftw_free(fftReal);
     fftw_free(fftComplexIn);
     fftw_free(fftComplexOut);
@@ -177,7 +176,7 @@ void TransformPal2D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 startY, q
     }
 
     // Convert time domain in fftReal to frequency domain in fftComplexIn
-    fftw_execute(forwardPlan);
+    fftw_execute_dft_r2c(forwardPlan, fftReal, fftComplexIn);
 }
 
 // Apply the inverse FFT to fftComplexOut, overlaying the result into chromaBuf[outputIndex]
@@ -188,7 +187,7 @@ void TransformPal2D::inverseFFTTile(qint32 tileX, qint32 tileY, qint32 startY, q
     const qint32 endX = qMin(videoParameters.activeVideoEnd - tileX, XTILE);
 
     // Convert frequency domain in fftComplexOut back to time domain in fftReal
-    fftw_execute(inversePlan);
+    fftw_execute_dft_c2r(inversePlan, fftComplexOut, fftReal);
 
     // Overlay the result, normalising the FFTW output, into chromaBuf
     double *outputPtr = chromaBuf[outputIndex].data();
@@ -38,7 +38,7 @@
 
 class TransformPal2D : public TransformPal {
 public:
-    TransformPal2D();
+    TransformPal2D(PlannerEffort plannerEffort = measurePlanner);
     virtual ~TransformPal2D();
 
     // Return the expected size of the thresholds array.
@@ -80,7 +80,7 @@ protected:
     fftw_complex *fftComplexIn;
     fftw_complex *fftComplexOut;
 
-    // FFT plans
+    // FFT plans, shared with other instances
     fftw_plan forwardPlan, inversePlan;
 
     // The combined result of all the FFT processing for each input field.
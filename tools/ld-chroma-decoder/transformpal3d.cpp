@@ -66,8 +66,8 @@ static double computeWindow(qint32 element, qint32 limit)
     return 0.5 - (0.5 * cos((2 * M_PI * (element + 0.5)) / limit));
 }
 
-TransformPal3D::TransformPal3D()
-    : TransformPal(XCOMPLEX, YCOMPLEX, ZCOMPLEX)
+TransformPal3D::TransformPal3D(PlannerEffort _plannerEffort)
+    : TransformPal(XCOMPLEX, YCOMPLEX, ZCOMPLEX, _plannerEffort)
 {
     // Compute the window function.
     for (qint32 z = 0; z < ZTILE; z++) {
@@ -87,16 +87,15 @@ TransformPal3D::TransformPal3D()
     fftComplexIn = fftw_alloc_complex(ZCOMPLEX * YCOMPLEX * XCOMPLEX);
     fftComplexOut = fftw_alloc_complex(ZCOMPLEX * YCOMPLEX * XCOMPLEX);
 
-    // Plan FFTW operations
-    forwardPlan = fftw_plan_dft_r2c_3d(ZTILE, YTILE, XTILE, fftReal, fftComplexIn, FFTW_MEASURE);
-    inversePlan = fftw_plan_dft_c2r_3d(ZTILE, YTILE, XTILE, fftComplexOut, fftReal, FFTW_MEASURE);
+    // Get FFTW plans from the shared cache
+    const QVector<int> dimensions {ZTILE, YTILE, XTILE};
+    forwardPlan = getForwardPlan(dimensions);
+    inversePlan = getInversePlan(dimensions);
 }
 
 TransformPal3D::~TransformPal3D()
 {
-    // Free FFTW plans and buffers
-    fftw_destroy_plan(forwardPlan);
-    fftw_destroy_plan(inversePlan);
+    // Free FFTW buffers (the plans belong to the cache)
     fftw_free(fftReal);
     fftw_free(fftComplexIn);
     fftw_free(fftComplexOut);
@@ -202,7 +201,7 @@ void TransformPal3D::forwardFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, co
     }
 
     // Convert time domain in fftReal to frequency domain in fftComplexIn
-    fftw_execute(forwardPlan);
+    fftw_execute_dft_r2c(forwardPlan, fftReal, fftComplexIn);
 }
 
 // Apply the inverse FFT to fftComplexOut, overlaying the result into chromaBuf
@@ -217,7 +216,7 @@ void TransformPal3D::inverseFFTTile(qint32 tileX, qint32 tileY, qint32 tileZ, qi
     const qint32 endZ = qMin(endIndex - tileZ, ZTILE);
 
     // Convert frequency domain in fftComplexOut back to time domain in fftReal
-    fftw_execute(inversePlan);
+    fftw_execute_dft_c2r(inversePlan, fftComplexOut, fftReal);
 
     // Overlay the result, normalising the FFTW output, into the chroma buffers
     for (qint32 z = startZ; z < endZ; z++) {
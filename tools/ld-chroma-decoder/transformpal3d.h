@@ -38,7 +38,7 @@
 
 class TransformPal3D : public TransformPal {
 public:
-    TransformPal3D();
+    TransformPal3D(PlannerEffort plannerEffort = measurePlanner);
     ~TransformPal3D();
 
     // Return the expected size of the thresholds array.
@@ -93,7 +93,7 @@ protected:
     fftw_complex *fftComplexIn;
     fftw_complex *fftComplexOut;
 
-    // FFT plans
+    // FFT plans, shared with other instances
     fftw_plan forwardPlan, inversePlan;
 
     // The combined result of all the FFT processing for each input field.
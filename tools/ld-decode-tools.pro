@@ -10,8 +10,21 @@ SUBDIRS = \
     ld-export-metadata \
     ld-lds-converter \
     ld-process-efm \
+    ld-process-efm/cli \
     ld-process-vbi \
     ld-disc-stacker \
     ld-process-vits \
+    ld-chroma-decoder/testcomb \
+    ld-chroma-decoder/testcombkernels \
+    ld-chroma-decoder/testtransformpal \
+    ld-disc-stacker/testmediankernels \
+    ld-discmap/testdiscmapper \
+    ld-process-efm/testcircreedsolomon \
+    ld-process-efm/testefmtof3frames \
+    ld-process-efm/testf3frame \
     library/filter/testfilter \
-    library/tbc/testvbidecoder
+    library/tbc/testdropoutindex \
+    library/tbc/testfieldprefetcher \
+    library/tbc/testmetadata \
+    library/tbc/testvbidecoder \
+    library/tbc/testvideobuffer
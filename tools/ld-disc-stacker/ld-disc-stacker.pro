@@ -9,24 +9,38 @@ CONFIG -= app_bundle
 
 SOURCES += \
     main.cpp \
+    ../library/tbc/fieldprefetcher.cpp \
+    ../library/tbc/jsonio.cpp \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/sourcevideo.cpp \
+    ../library/tbc/videobuffer.cpp \
+    ../library/tbc/videobufferpool.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp \
     ../library/tbc/dropouts.cpp \
+    ../library/tbc/dropoutindex.cpp \
+    mediankernels.cpp \
     stacker.cpp \
     stackingpool.cpp
 
 HEADERS += \
+    ../library/cpu/cpufeatures.h \
+    ../library/tbc/fieldprefetcher.h \
+    ../library/tbc/jsonio.h \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/sourcevideo.h \
+    ../library/tbc/videobuffer.h \
+    ../library/tbc/videobufferpool.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h \
     ../library/tbc/dropouts.h \
+    ../library/tbc/dropoutindex.h \
+    mediankernels.h \
     stacker.h \
     stackingpool.h
 
 # Add external includes to the include path
+INCLUDEPATH += ../library/cpu
 INCLUDEPATH += ../library/tbc
 
 # Include git information definitions
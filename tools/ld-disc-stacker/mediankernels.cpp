@@ -0,0 +1,314 @@
+/************************************************************************
+
+    mediankernels.cpp
+
+    ld-disc-stacker - Disc stacking for ld-decode
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-disc-stacker is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "mediankernels.h"
+
+#include <algorithm>
+
+#include "cpufeatures.h"
+
+// The vector kernels apply the sorting networks to a whole line of samples at
+// once, one sample per lane, using packed unsigned 16-bit min/max (SSE4.1's
+// pminuw/pmaxuw, or their AVX2 forms)
+#ifdef CPUFEATURES_X86
+#include <immintrin.h>
+#endif
+
+static constexpr qint32 MIN_INPUTS = MedianKernels::MIN_INPUTS;
+static constexpr qint32 MAX_INPUTS = MedianKernels::MAX_INPUTS;
+
+// Upper bound on the number of comparators in a network (Batcher's network
+// for 16 inputs has 63)
+static constexpr qint32 MAX_COMPARATORS = 64;
+
+// A sorting network that finds the median of a fixed number of inputs.
+// Each comparator puts the smaller of its two values in the first position
+// and the larger in the second.
+struct MedianNetwork {
+    qint32 numComparators;
+    qint32 comparators[MAX_COMPARATORS][2];
+
+    // Positions of the middle values once the network has been applied
+    // (the same position for an odd number of inputs)
+    qint32 lowMiddle;
+    qint32 highMiddle;
+};
+
+// Networks for each number of inputs
+struct MedianNetworks {
+    MedianNetworks() {
+        for (qint32 numInputs = MIN_INPUTS; numInputs <= MAX_INPUTS; numInputs++) {
+            buildNetwork(numInputs, networks[numInputs]);
+        }
+    }
+
+    // Build a Batcher odd-even merge sort network for numInputs inputs, then
+    // remove the comparators that can't affect the middle values
+    static void buildNetwork(qint32 numInputs, MedianNetwork &network) {
+        // Generate the network for the next power of two. The extra inputs
+        // can be thought of as larger than any real input, so comparators
+        // that involve them never do anything and can be left out.
+        qint32 size = 1;
+        while (size < numInputs) size <<= 1;
+
+        qint32 sortComparators[MAX_COMPARATORS][2];
+        qint32 numSortComparators = 0;
+        for (qint32 p = 1; p < size; p <<= 1) {
+            for (qint32 k = p; k >= 1; k >>= 1) {
+                for (qint32 j = k % p; j + k < size; j += 2 * k) {
+                    for (qint32 i = 0; i < std::min(k, size - j - k); i++) {
+                        const qint32 a = i + j;
+                        const qint32 b = i + j + k;
+                        if ((a / (2 * p)) != (b / (2 * p))) continue;
+                        if (b >= numInputs) continue;
+
+                        sortComparators[numSortComparators][0] = a;
+                        sortComparators[numSortComparators][1] = b;
+                        numSortComparators++;
+                    }
+                }
+            }
+        }
+
+        network.lowMiddle = (numInputs - 1) / 2;
+        network.highMiddle = numInputs / 2;
+
+        // Working backwards from the middle positions, keep the comparators
+        // that affect positions whose values we need
+        bool needed[MAX_INPUTS] = {false};
+        needed[network.lowMiddle] = true;
+        needed[network.highMiddle] = true;
+
+        bool keep[MAX_COMPARATORS] = {false};
+        for (qint32 c = numSortComparators - 1; c >= 0; c--) {
+            const qint32 a = sortComparators[c][0];
+            const qint32 b = sortComparators[c][1];
+            if (needed[a] || needed[b]) {
+                keep[c] = true;
+                needed[a] = true;
+                needed[b] = true;
+            }
+        }
+
+        network.numComparators = 0;
+        for (qint32 c = 0; c < numSortComparators; c++) {
+            if (!keep[c]) continue;
+            network.comparators[network.numComparators][0] = sortComparators[c][0];
+            network.comparators[network.numComparators][1] = sortComparators[c][1];
+            network.numComparators++;
+        }
+    }
+
+    MedianNetwork networks[MAX_INPUTS + 1];
+};
+
+static const MedianNetworks medianNetworks;
+
+// Average of two values, rounded down, without overflowing
+static inline quint16 averageFloor(quint16 a, quint16 b)
+{
+    return static_cast<quint16>((a & b) + ((a ^ b) >> 1));
+}
+
+// Apply a network to one set of values in place, and return the median
+static inline quint16 applyNetwork(const MedianNetwork &network, quint16 *values)
+{
+    for (qint32 c = 0; c < network.numComparators; c++) {
+        const qint32 a = network.comparators[c][0];
+        const qint32 b = network.comparators[c][1];
+        const quint16 low = std::min(values[a], values[b]);
+        const quint16 high = std::max(values[a], values[b]);
+        values[a] = low;
+        values[b] = high;
+    }
+
+    return averageFloor(values[network.lowMiddle], values[network.highMiddle]);
+}
+
+// Scalar implementation, used as the reference and for leftover pixels at
+// the end of a line
+
+static void lineMedianScalarRange(const quint16 *inputs, qint32 numInputs, qint32 stride,
+                                  qint32 start, qint32 end, quint16 *output)
+{
+    const MedianNetwork &network = medianNetworks.networks[numInputs];
+    quint16 values[MAX_INPUTS];
+
+    for (qint32 x = start; x < end; x++) {
+        for (qint32 i = 0; i < numInputs; i++) values[i] = inputs[(i * stride) + x];
+        output[x] = applyNetwork(network, values);
+    }
+}
+
+static void lineMedianScalar(const quint16 *inputs, qint32 numInputs, qint32 stride, qint32 length,
+                             quint16 *output)
+{
+    lineMedianScalarRange(inputs, numInputs, stride, 0, length, output);
+}
+
+#ifdef CPUFEATURES_X86
+
+// SSE4.1 implementation, processing eight pixels at a time
+
+__attribute__((target("sse4.1")))
+static void lineMedianSse41(const quint16 *inputs, qint32 numInputs, qint32 stride, qint32 length,
+                            quint16 *output)
+{
+    const MedianNetwork &network = medianNetworks.networks[numInputs];
+    __m128i values[MAX_INPUTS];
+
+    qint32 x = 0;
+    for (; x + 8 <= length; x += 8) {
+        for (qint32 i = 0; i < numInputs; i++) {
+            values[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(inputs + (i * stride) + x));
+        }
+
+        for (qint32 c = 0; c < network.numComparators; c++) {
+            const qint32 a = network.comparators[c][0];
+            const qint32 b = network.comparators[c][1];
+            const __m128i low = _mm_min_epu16(values[a], values[b]);
+            const __m128i high = _mm_max_epu16(values[a], values[b]);
+            values[a] = low;
+            values[b] = high;
+        }
+
+        const __m128i lowMiddle = values[network.lowMiddle];
+        const __m128i highMiddle = values[network.highMiddle];
+        const __m128i result = _mm_add_epi16(_mm_and_si128(lowMiddle, highMiddle),
+                                             _mm_srli_epi16(_mm_xor_si128(lowMiddle, highMiddle), 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(output + x), result);
+    }
+
+    lineMedianScalarRange(inputs, numInputs, stride, x, length, output);
+}
+
+// AVX2 implementation, processing sixteen pixels at a time
+
+__attribute__((target("avx2")))
+static void lineMedianAvx2(const quint16 *inputs, qint32 numInputs, qint32 stride, qint32 length,
+                           quint16 *output)
+{
+    const MedianNetwork &network = medianNetworks.networks[numInputs];
+    __m256i values[MAX_INPUTS];
+
+    qint32 x = 0;
+    for (; x + 16 <= length; x += 16) {
+        for (qint32 i = 0; i < numInputs; i++) {
+            values[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(inputs + (i * stride) + x));
+        }
+
+        for (qint32 c = 0; c < network.numComparators; c++) {
+            const qint32 a = network.comparators[c][0];
+            const qint32 b = network.comparators[c][1];
+            const __m256i low = _mm256_min_epu16(values[a], values[b]);
+            const __m256i high = _mm256_max_epu16(values[a], values[b]);
+            values[a] = low;
+            values[b] = high;
+        }
+
+        const __m256i lowMiddle = values[network.lowMiddle];
+        const __m256i highMiddle = values[network.highMiddle];
+        const __m256i result = _mm256_add_epi16(_mm256_and_si256(lowMiddle, highMiddle),
+                                                _mm256_srli_epi16(_mm256_xor_si256(lowMiddle, highMiddle), 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + x), result);
+    }
+
+    lineMedianScalarRange(inputs, numInputs, stride, x, length, output);
+}
+
+#endif // CPUFEATURES_X86
+
+quint16 MedianKernels::median(quint16 *values, qint32 count)
+{
+    if (count >= MIN_INPUTS && count <= MAX_INPUTS) {
+        return applyNetwork(medianNetworks.networks[count], values);
+    }
+
+    if (count <= 2) {
+        return averageFloor(values[0], values[count - 1]);
+    }
+
+    // Too many values for a network - partially sort them instead. After
+    // nth_element, the values below the upper middle one are all <= it, so
+    // the lower middle value is the largest of those.
+    quint16 *highMiddle = values + (count / 2);
+    std::nth_element(values, highMiddle, values + count);
+    if (count % 2 != 0) return *highMiddle;
+
+    const quint16 lowMiddle = *std::max_element(values, highMiddle);
+    return averageFloor(lowMiddle, *highMiddle);
+}
+
+MedianKernels::InstructionSet MedianKernels::getBestInstructionSet()
+{
+    if (isSupported(avx2)) return avx2;
+    if (isSupported(sse41)) return sse41;
+    return scalar;
+}
+
+bool MedianKernels::isSupported(InstructionSet instructionSet)
+{
+    switch (instructionSet) {
+    case scalar:
+        return true;
+    case sse41:
+        return CpuFeatures::isSupported(CpuFeatures::sse41);
+    case avx2:
+        return CpuFeatures::isSupported(CpuFeatures::avx2);
+    default:
+        return false;
+    }
+}
+
+const char *MedianKernels::getName(InstructionSet instructionSet)
+{
+    switch (instructionSet) {
+    case sse41:
+        return "SSE4.1";
+    case avx2:
+        return "AVX2";
+    default:
+        return "scalar";
+    }
+}
+
+MedianKernels::LineMedianFunction MedianKernels::getLineMedianFunction(InstructionSet instructionSet)
+{
+    switch (instructionSet) {
+#ifdef CPUFEATURES_X86
+    case sse41:
+        return lineMedianSse41;
+    case avx2:
+        return lineMedianAvx2;
+#endif
+    default:
+        return lineMedianScalar;
+    }
+}
+
+MedianKernels::LineMedianFunction MedianKernels::getBestLineMedianFunction()
+{
+    static const LineMedianFunction bestFunction = getLineMedianFunction(getBestInstructionSet());
+    return bestFunction;
+}
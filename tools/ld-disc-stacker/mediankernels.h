@@ -0,0 +1,80 @@
+/************************************************************************
+
+    mediankernels.h
+
+    ld-disc-stacker - Disc stacking for ld-decode
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-disc-stacker is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef MEDIANKERNELS_H
+#define MEDIANKERNELS_H
+
+#include <QtGlobal>
+
+// Median of small sets of samples, for Stacker.
+//
+// For 3 to 16 values, the median is found using a sorting network -- a fixed
+// sequence of min/max operations, with no branches -- pruned down to the
+// comparisons that affect the middle value(s). The line kernels apply the
+// network to many pixels at once; there is a scalar implementation, which is
+// the reference, plus SSE4.1 and AVX2 implementations on x86 CPUs that
+// support them. testmediankernels checks that they all agree.
+//
+// For an even number of values, the median is the average of the two middle
+// values, rounded down.
+class MedianKernels
+{
+public:
+    enum InstructionSet {
+        scalar = 0,
+        sse41,
+        avx2
+    };
+
+    // Range of input counts that the line kernels handle
+    static constexpr qint32 MIN_INPUTS = 3;
+    static constexpr qint32 MAX_INPUTS = 16;
+
+    // For each pixel x in [0, length), compute the median of
+    // inputs[(i * stride) + x] for i in [0, numInputs), and store it in
+    // output[x]. numInputs must be between MIN_INPUTS and MAX_INPUTS.
+    using LineMedianFunction = void (*)(const quint16 *inputs, qint32 numInputs, qint32 stride, qint32 length,
+                                        quint16 *output);
+
+    // Return the median of count values (count >= 1).
+    // The values are reordered.
+    static quint16 median(quint16 *values, qint32 count);
+
+    // Return the best instruction set supported by this CPU
+    static InstructionSet getBestInstructionSet();
+
+    // Return true if this CPU (and this build) supports the given instruction set
+    static bool isSupported(InstructionSet instructionSet);
+
+    // Return the name of an instruction set, for messages
+    static const char *getName(InstructionSet instructionSet);
+
+    // Return the line kernel for the given instruction set, which must be supported
+    static LineMedianFunction getLineMedianFunction(InstructionSet instructionSet);
+
+    // Return the line kernel for the best supported instruction set
+    static LineMedianFunction getBestLineMedianFunction();
+};
+
+#endif // MEDIANKERNELS_H
@@ -24,6 +24,10 @@
 
 #include "stacker.h"
 #include "stackingpool.h"
+#include "mediankernels.h"
+#include "dropoutindex.h"
+
+#include <algorithm>
 
 Stacker::Stacker(QAtomicInt& _abort, StackingPool& _stackingPool, QObject *parent)
     : QThread(parent), abort(_abort), stackingPool(_stackingPool)
@@ -64,18 +68,21 @@ void Stacker::run()
         stackField(frameNumber, firstSourceField, videoParameters[0], firstFieldMetadata, availableSourcesForFrame, noDiffDod, passThrough, outputFirstField, outputFirstFieldDropOuts);
         stackField(frameNumber, secondSourceField, videoParameters[0], secondFieldMetadata, availableSourcesForFrame, noDiffDod, passThrough, outputSecondField, outputSecondFieldDropOuts);
 
-        // Return the processed fields
-        stackingPool.setOutputFrame(frameNumber, outputFirstField, outputSecondField,
+        // Return the processed fields (handing over the buffers, so they
+        // reach the writer without being copied)
+        stackingPool.setOutputFrame(frameNumber, std::move(outputFirstField), std::move(outputSecondField),
                                     firstFieldSeqNo[0], secondFieldSeqNo[0],
-                                    outputFirstFieldDropOuts, outputSecondFieldDropOuts);
+                                    std::move(outputFirstFieldDropOuts), std::move(outputSecondFieldDropOuts));
     }
 }
 
-// Method to stack fields
-void Stacker::stackField(qint32 frameNumber, QVector<SourceVideo::Data> inputFields,
-                                      LdDecodeMetaData::VideoParameters videoParameters,
-                                      QVector<LdDecodeMetaData::Field> fieldMetadata,
-                                      QVector<qint32> availableSourcesForFrame,
+// Method to stack fields.
+// The input fields are shared with the prefetchers, so they must only be read
+// through const references -- writing to them would copy them.
+void Stacker::stackField(qint32 frameNumber, const QVector<SourceVideo::Data> &inputFields,
+                                      const LdDecodeMetaData::VideoParameters &videoParameters,
+                                      const QVector<LdDecodeMetaData::Field> &fieldMetadata,
+                                      const QVector<qint32> &availableSourcesForFrame,
                                       bool noDiffDod, bool passThrough,
                                       SourceVideo::Data &outputField,
                                       DropOuts &dropOuts)
@@ -83,13 +90,69 @@ void Stacker::stackField(qint32 frameNumber, QVector<SourceVideo::Data> inputFie
     quint16 prevGoodValue = videoParameters.black16bIre;
     bool forceDropout = false;
 
+    const qint32 numberOfSources = availableSourcesForFrame.size();
+    const qint32 startX = videoParameters.colourBurstStart;
+    const qint32 lineLength = videoParameters.fieldWidth - startX;
+
+    // If there are enough sources, find the median of all the sources for
+    // the whole line at once using the line kernel; pixels where any source
+    // is a dropout are handled separately below
+    const bool useLineMedian = (numberOfSources >= MedianKernels::MIN_INPUTS) && (numberOfSources <= MedianKernels::MAX_INPUTS);
+    const MedianKernels::LineMedianFunction lineMedian = MedianKernels::getBestLineMedianFunction();
+
+    // Index the sources' dropouts by line
+    QVector<DropOutIndex> dropOutIndexes;
+    dropOutIndexes.reserve(numberOfSources);
+    for (qint32 i = 0; i < numberOfSources; i++) {
+        dropOutIndexes.append(DropOutIndex(fieldMetadata[availableSourcesForFrame[i]].dropOuts));
+    }
+
+    // Working storage, reused for each line and pixel
+    QVector<quint16> sourceLines(useLineMedian ? numberOfSources * lineLength : 0);
+    QVector<quint16> lineMedians(useLineMedian ? lineLength : 0);
+    QVector<quint8> isDropout(numberOfSources * lineLength);
+    QVector<qint32> validCount(lineLength);
+    QVector<quint16> inputValues;
+    inputValues.reserve(numberOfSources);
+    QVector<quint16> scratchValues;
+    scratchValues.reserve(numberOfSources);
+
     for (qint32 y = 0; y < videoParameters.fieldHeight; y++) {
-        for (qint32 x = videoParameters.colourBurstStart; x < videoParameters.fieldWidth; x++) {
+        const qint32 lineStart = (videoParameters.fieldWidth * y) + startX;
+
+        // Find which of the sources' pixels are not marked as dropouts
+        validCount.fill(0);
+        for (qint32 i = 0; i < numberOfSources; i++) {
+            const qint32 source = availableSourcesForFrame[i];
+            quint8 *sourceIsDropout = isDropout.data() + (i * lineLength);
+            dropOutIndexes[i].fillLine(y + 1, startX, lineLength, sourceIsDropout);
+            for (qint32 x = 0; x < lineLength; x++) {
+                if (!sourceIsDropout[x]) validCount[x]++;
+            }
+
+            if (useLineMedian) {
+                std::copy(inputFields[source].constData() + lineStart, inputFields[source].constData() + lineStart + lineLength,
+                          sourceLines.data() + (i * lineLength));
+            }
+        }
+
+        if (useLineMedian) lineMedian(sourceLines.constData(), numberOfSources, lineLength, lineLength, lineMedians.data());
+
+        for (qint32 x = startX; x < videoParameters.fieldWidth; x++) {
+            const qint32 lineX = x - startX;
+
+            // If all the sources are valid, the median has already been found
+            if (useLineMedian && validCount[lineX] == numberOfSources) {
+                outputField[(videoParameters.fieldWidth * y) + x] = lineMedians[lineX];
+                prevGoodValue = outputField[(videoParameters.fieldWidth * y) + x];
+                continue;
+            }
+
             // Get input values from the input sources (which are not marked as dropouts)
-            QVector<quint16> inputValues;
-            for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
+            inputValues.resize(0);
+            for (qint32 i = 0; i < numberOfSources; i++) {
                 // Include the source's pixel data if it's not marked as a dropout
-                if (!isDropout(fieldMetadata[availableSourcesForFrame[i]].dropOuts, x, y)) {
+                if (!isDropout[(i * lineLength) + lineX]) {
                     // Pixel is valid
                     inputValues.append(inputFields[availableSourcesForFrame[i]][(videoParameters.fieldWidth * y) + x]);
                 }
@@ -98,7 +161,7 @@ void Stacker::stackField(qint32 frameNumber, QVector<SourceVideo::Data> inputFie
             // If passThrough is set, the output is always marked as a dropout if all input values are dropouts
             // (regardless of the diffDOD process result).
             forceDropout = false;
-            if ((availableSourcesForFrame.size() > 0) && (passThrough)) {
+            if ((numberOfSources > 0) && (passThrough)) {
                 if (inputValues.size() == 0) {
                     forceDropout = true;
                     qInfo().nospace() << "Frame #" << frameNumber << ": All sources for field location (" << x << ", " << y << ") are marked as dropout, passing through";
@@ -108,16 +171,15 @@ void Stacker::stackField(qint32 frameNumber, QVector<SourceVideo::Data> inputFie
             // If all possible input values are dropouts (and noDiffDod is false) and there are more than 3 input sources...
             // Take the available values (marked as dropouts) and perform a diffDOD to try and determine if the dropout markings
             // are false positives.
-            if ((inputValues.size() == 0) && (availableSourcesForFrame.size() >= 3) && (noDiffDod == false)) {
-                // Clear the current input values and recreate the list including marked dropouts
-                inputValues.clear();
-                for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
+            if ((inputValues.size() == 0) && (numberOfSources >= 3) && (noDiffDod == false)) {
+                // Recreate the list including marked dropouts
+                for (qint32 i = 0; i < numberOfSources; i++) {
                     quint16 pixelValue = inputFields[availableSourcesForFrame[i]][(videoParameters.fieldWidth * y) + x];
                     if (pixelValue > 0) inputValues.append(pixelValue);
                 }
 
                 // Perform differential dropout detection to recover ld-decode false positive pixels
-                inputValues = diffDod(inputValues, videoParameters, x);
+                diffDod(inputValues, scratchValues, videoParameters, x);
 
                 if (inputValues.size() > 0) {
                     qInfo().nospace() << "Frame #" << frameNumber << ": DiffDOD recovered " << inputValues.size() <<
@@ -150,7 +212,7 @@ void Stacker::stackField(qint32 frameNumber, QVector<SourceVideo::Data> inputFie
                 if (forceDropout) dropOuts.append(x, x, y + 1);
             } else {
                 // More than 2 values available - store the median in the output field
-                outputField[(videoParameters.fieldWidth * y) + x] = median(inputValues);
+                outputField[(videoParameters.fieldWidth * y) + x] = MedianKernels::median(inputValues.data(), inputValues.size());
                 prevGoodValue = outputField[(videoParameters.fieldWidth * y) + x];
                 if (forceDropout) dropOuts.append(x, x, y + 1);
             }
@@ -161,69 +223,33 @@ void Stacker::stackField(qint32 frameNumber, QVector<SourceVideo::Data> inputFie
     if (dropOuts.size() != 0) dropOuts.concatenate();
 }
 
-// Method to find the median of a vector of quint16s
-quint16 Stacker::median(QVector<quint16> elements)
-{
-    qint32 noOfElements = elements.size();
-
-    if (noOfElements % 2 == 0) {
-        // Input set is even length
-
-        // Applying nth_element on n/2th index
-        std::nth_element(elements.begin(), elements.begin() + noOfElements / 2, elements.end());
-
-        // Applying nth_element on (n-1)/2 th index
-        std::nth_element(elements.begin(), elements.begin() + (noOfElements - 1) / 2, elements.end());
-
-        // Find the average of value at index N/2 and (N-1)/2
-        return static_cast<quint16>((elements[(noOfElements - 1) / 2] + elements[noOfElements / 2]) / 2.0);
-    } else {
-        // Input set is odd length
-
-        // Applying nth_element on n/2
-        std::nth_element(elements.begin(), elements.begin() + noOfElements / 2, elements.end());
-
-        // Value at index (N/2)th is the median
-        return static_cast<quint16>(elements[noOfElements / 2]);
-    }
-}
-
-// Method returns true if specified pixel is a dropout
-bool Stacker::isDropout(DropOuts dropOuts, qint32 fieldX, qint32 fieldY)
-{
-    for (qint32 i = 0; i < dropOuts.size(); i++) {
-        if ((dropOuts.fieldLine(i) - 1) == fieldY) {
-            if ((fieldX >= dropOuts.startx(i)) && (fieldX <= dropOuts.endx(i)))
-                return true;
-        }
-    }
-
-    return false;
-}
-
 // Use differential dropout detection to remove suspected dropout error
 // values from inputValues to produce the set of output values.  This generally improves everything, but
 // might cause an increase in errors for really noisy frames (where the DOs are in the same place in
 // multiple sources).  Another possible disadvantage is that diffDOD might pass through master plate errors
 // which, whilst not technically errors, may be undesirable.
-QVector<quint16> Stacker::diffDod(QVector<quint16> inputValues, LdDecodeMetaData::VideoParameters videoParameters, qint32 xPos)
+void Stacker::diffDod(QVector<quint16> &inputValues, QVector<quint16> &scratchValues,
+                      const LdDecodeMetaData::VideoParameters &videoParameters, qint32 xPos)
 {
-    QVector<quint16> outputValues;
-
     // Check that we have at least 3 input values
     if (inputValues.size() < 3) {
         qDebug() << "diffDOD: Only received" << inputValues.size() << "input values, exiting";
-        return outputValues;
+        inputValues.resize(0);
+        return;
     }
 
     // Check that we are in the colour burst or visible line area
     if (xPos < videoParameters.colourBurstStart) {
         qDebug() << "diffDOD: Pixel not in colourburst or visible area";
-        return outputValues;
+        inputValues.resize(0);
+        return;
     }
 
-    // Get the median value of the input values
-    double medianValue = static_cast<double>(median(inputValues));
+    // Get the median value of the input values (using a copy, as median
+    // reorders the values)
+    scratchValues.resize(inputValues.size());
+    std::copy(inputValues.constBegin(), inputValues.constEnd(), scratchValues.begin());
+    double medianValue = static_cast<double>(MedianKernels::median(scratchValues.data(), scratchValues.size()));
 
     // Set the matching threshold to +-10% of the median value
     double threshold = 10; // %
@@ -236,20 +262,22 @@ QVector<quint16> Stacker::diffDod(QVector<quint16> inputValues, LdDecodeMetaData
     quint16 minValue = minValueD;
     quint16 maxValue = maxValueD;
 
-    // Copy valid input values to the output set
+    // Show debug
+    qDebug() << "diffDOD:  Input" << inputValues;
+
+    // Keep only the valid input values
+    qint32 outputSize = 0;
     for (qint32 i = 0; i < inputValues.size(); i++) {
         if ((inputValues[i] > minValue) && (inputValues[i] < maxValue)) {
-            outputValues.append(inputValues[i]);
+            inputValues[outputSize++] = inputValues[i];
         }
     }
+    inputValues.resize(outputSize);
 
     // Show debug
-    qDebug() << "diffDOD:  Input" << inputValues;
-    if (outputValues.size() == 0) {
+    if (inputValues.size() == 0) {
         qDebug().nospace() << "diffDOD: Empty output... Range was " << minValue << "-" << maxValue << " with a median of " << medianValue;
     } else {
-        qDebug() << "diffDOD: Output" << outputValues;
+        qDebug() << "diffDOD: Output" << inputValues;
     }
-
-    return outputValues;
 }
@@ -51,12 +51,11 @@ private:
     StackingPool& stackingPool;
     QVector<LdDecodeMetaData::VideoParameters> videoParameters;
 
-    void stackField(qint32 frameNumber, QVector<SourceVideo::Data> inputFields, LdDecodeMetaData::VideoParameters videoParameters,
-                    QVector<LdDecodeMetaData::Field> fieldMetadata, QVector<qint32> availableSourcesForFrame, bool noDiffDod, bool passThrough,
+    void stackField(qint32 frameNumber, const QVector<SourceVideo::Data> &inputFields, const LdDecodeMetaData::VideoParameters &videoParameters,
+                    const QVector<LdDecodeMetaData::Field> &fieldMetadata, const QVector<qint32> &availableSourcesForFrame, bool noDiffDod, bool passThrough,
                     SourceVideo::Data &outputField, DropOuts &dropOuts);
-    quint16 median(QVector<quint16> v);
-    bool isDropout(DropOuts dropOuts, qint32 fieldX, qint32 fieldY);
-    QVector<quint16> diffDod(QVector<quint16> inputValues, LdDecodeMetaData::VideoParameters videoParameters, qint32 xPos);
+    void diffDod(QVector<quint16> &inputValues, QVector<quint16> &scratchValues,
+                 const LdDecodeMetaData::VideoParameters &videoParameters, qint32 xPos);
 };
 
 #endif // STACKER_H
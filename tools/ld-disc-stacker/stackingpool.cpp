@@ -24,6 +24,8 @@
 
 #include "stackingpool.h"
 
+#include "videobufferpool.h"
+
 StackingPool::StackingPool(QString _outputFilename, QString _outputJsonFilename,
                              qint32 _maxThreads, QVector<LdDecodeMetaData *> &_ldDecodeMetaData, QVector<SourceVideo *> &_sourceVideos,
                              bool _reverse, bool _noDiffDod, bool _passThrough, QObject *parent)
@@ -83,6 +85,14 @@ bool StackingPool::process()
     outputFrameNumber = 1;
     lastFrameNumber = ldDecodeMetaData[0]->getNumberOfFrames();
     totalTimer.start();
+    const qint64 startBytesCopied = VideoBuffer::getBytesCopied();
+
+    // Start reading fields ahead of the workers for each source
+    fieldPrefetchers.resize(sourceVideos.size());
+    for (qint32 sourceNo = 0; sourceNo < sourceVideos.size(); sourceNo++) {
+        fieldPrefetchers[sourceNo] = new FieldPrefetcher(*sourceVideos[sourceNo]);
+        fieldPrefetchers[sourceNo]->startPrefetch(1, ldDecodeMetaData[sourceNo]->getNumberOfFields());
+    }
 
     // Start a vector of decoding threads to process the video
     qInfo() << "Beginning multi-threaded disc stacking process...";
@@ -99,6 +109,15 @@ bool StackingPool::process()
         delete threads[i];
     }
 
+    // Stop the prefetchers
+    qint64 prefetchStalls = 0;
+    for (qint32 sourceNo = 0; sourceNo < fieldPrefetchers.size(); sourceNo++) {
+        fieldPrefetchers[sourceNo]->stopPrefetch();
+        prefetchStalls += fieldPrefetchers[sourceNo]->getStallCount();
+        delete fieldPrefetchers[sourceNo];
+    }
+    fieldPrefetchers.clear();
+
     // Did any of the threads abort?
     if (abort) {
         targetVideo.close();
@@ -109,8 +128,16 @@ bool StackingPool::process()
     qreal totalSecs = (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
     qInfo() << "Disc stacking complete -" << lastFrameNumber << "frames in" << totalSecs << "seconds (" <<
                lastFrameNumber / totalSecs << "FPS )";
+    qInfo() << "Input prefetcher stalled" << prefetchStalls << "times";
+    qInfo() << "Copied" << (VideoBuffer::getBytesCopied() - startBytesCopied) / qMax(lastFrameNumber, 1)
+            << "bytes of field data per frame between threads";
+    const VideoBufferPool::Statistics poolStatistics = VideoBufferPool::getStatistics();
+    qInfo() << "Buffer pool allocated" << poolStatistics.allocations << "buffers and reused" << poolStatistics.reuses
+            << "(" << poolStatistics.bytesReserved / (1024 * 1024) << "MiB reserved )";
 
     qInfo() << "Creating JSON metadata file for stacked TBC...";
+    ldDecodeMetaData[0]->applyFieldUpdates(outputFieldUpdates);
+    outputFieldUpdates.clear();
     ldDecodeMetaData[0]->write(outputJsonFilename);
 
     // Close the target video
@@ -186,16 +213,12 @@ bool StackingPool::getInputFrame(qint32& frameNumber,
         if (firstFieldNumber[sourceNo] != -1 && secondFieldNumber[sourceNo] != -1) {
             // Fetch the input data (get the fields in TBC sequence order to save seeking)
             if (firstFieldNumber[sourceNo] < secondFieldNumber[sourceNo]) {
-                firstFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
-                secondFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
+                firstFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
+                secondFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
             } else {
-                secondFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
-                firstFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
+                secondFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
+                firstFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
             }
-
-            firstFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(firstFieldNumber[sourceNo]);
-            secondFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(secondFieldNumber[sourceNo]);
-            videoParameters[sourceNo] = ldDecodeMetaData[sourceNo]->getVideoParameters();
         }
     }
 
@@ -211,6 +234,17 @@ bool StackingPool::getInputFrame(qint32& frameNumber,
     _reverse = reverse;
     _noDiffDod = noDiffDod;
     _passThrough = passThrough;
+    locker.unlock();
+
+    // Fetch the metadata for the fields (which doesn't need the lock, as the
+    // metadata isn't changed while threads are running)
+    for (qint32 sourceNo = 0; sourceNo < numberOfSources; sourceNo++) {
+        if (firstFieldNumber[sourceNo] != -1 && secondFieldNumber[sourceNo] != -1) {
+            firstFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(firstFieldNumber[sourceNo]);
+            secondFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(secondFieldNumber[sourceNo]);
+            videoParameters[sourceNo] = ldDecodeMetaData[sourceNo]->getVideoParameters();
+        }
+    }
 
     return true;
 }
@@ -224,22 +258,22 @@ bool StackingPool::getInputFrame(qint32& frameNumber,
 //
 // Returns true on success, false on failure.
 bool StackingPool::setOutputFrame(qint32 frameNumber,
-                                   SourceVideo::Data firstTargetFieldData, SourceVideo::Data secondTargetFieldData,
+                                   SourceVideo::Data &&firstTargetFieldData, SourceVideo::Data &&secondTargetFieldData,
                                    qint32 firstFieldSeqNo, qint32 secondFieldSeqNo,
-                                   DropOuts firstTargetFieldDropOuts, DropOuts secondTargetFieldDropouts)
+                                   DropOuts &&firstTargetFieldDropOuts, DropOuts &&secondTargetFieldDropouts)
 {
     QMutexLocker locker(&outputMutex);
 
     // Put the output frame into the map
     OutputFrame pendingFrame;
-    pendingFrame.firstTargetFieldData = firstTargetFieldData;
-    pendingFrame.secondTargetFieldData = secondTargetFieldData;
+    pendingFrame.firstTargetFieldData = std::move(firstTargetFieldData);
+    pendingFrame.secondTargetFieldData = std::move(secondTargetFieldData);
     pendingFrame.firstFieldSeqNo = firstFieldSeqNo;
     pendingFrame.secondFieldSeqNo = secondFieldSeqNo;
-    pendingFrame.firstTargetFieldDropOuts = firstTargetFieldDropOuts;
-    pendingFrame.secondTargetFieldDropOuts = secondTargetFieldDropouts;
+    pendingFrame.firstTargetFieldDropOuts = std::move(firstTargetFieldDropOuts);
+    pendingFrame.secondTargetFieldDropOuts = std::move(secondTargetFieldDropouts);
 
-    pendingOutputFrames[frameNumber] = pendingFrame;
+    pendingOutputFrames[frameNumber] = std::move(pendingFrame);
 
     // Write out as many frames as possible
     while (pendingOutputFrames.contains(outputFrameNumber)) {
@@ -265,13 +299,10 @@ bool StackingPool::setOutputFrame(qint32 frameNumber,
             return false;
         }
 
-        // Clear any existing dropout data
-        ldDecodeMetaData[0]->clearFieldDropOuts(outputFrame.firstFieldSeqNo);
-        ldDecodeMetaData[0]->clearFieldDropOuts(outputFrame.secondFieldSeqNo);
-
-        // Write the new dropout data into the LdDecodeMetaData output
-        ldDecodeMetaData[0]->updateFieldDropOuts(outputFrame.firstTargetFieldDropOuts, outputFrame.firstFieldSeqNo);
-        ldDecodeMetaData[0]->updateFieldDropOuts(outputFrame.secondTargetFieldDropOuts, outputFrame.secondFieldSeqNo);
+        // Save the new dropout data for the LdDecodeMetaData output (replacing
+        // the existing dropouts)
+        outputFieldUpdates.updateFieldDropOuts(outputFrame.firstTargetFieldDropOuts, outputFrame.firstFieldSeqNo);
+        outputFieldUpdates.updateFieldDropOuts(outputFrame.secondTargetFieldDropOuts, outputFrame.secondFieldSeqNo);
 
         // Show debug
         qDebug().nospace() << "Processed frame " << outputFrameNumber;
@@ -401,8 +432,8 @@ QVector<qint32> StackingPool::getAvailableSourcesForFrame(qint32 vbiFrameNumber)
             qint32 secondFieldNumber = ldDecodeMetaData[sourceNo]->getSecondFieldNumber(convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo));
 
             // Ensure the frame is not a padded field (i.e. missing)
-            if (!(ldDecodeMetaData[sourceNo]->getField(firstFieldNumber).pad &&
-                  ldDecodeMetaData[sourceNo]->getField(secondFieldNumber).pad)) {
+            if (!(ldDecodeMetaData[sourceNo]->getFieldPad(firstFieldNumber) &&
+                  ldDecodeMetaData[sourceNo]->getFieldPad(secondFieldNumber))) {
                 availableSourcesForFrame.append(sourceNo);
             }
         }
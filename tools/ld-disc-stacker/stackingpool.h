@@ -31,6 +31,7 @@
 #include <QMutex>
 #include <QThread>
 
+#include "fieldprefetcher.h"
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
 #include "stacker.h"
@@ -53,9 +54,9 @@ public:
                        bool& _reverse, bool &_noDiffDod, bool &_passThrough, QVector<qint32> &availableSourcesForFrame);
 
     bool setOutputFrame(qint32 frameNumber,
-                        SourceVideo::Data firstTargetFieldData, SourceVideo::Data secondTargetFieldData,
+                        SourceVideo::Data &&firstTargetFieldData, SourceVideo::Data &&secondTargetFieldData,
                         qint32 firstFieldSeqNo, qint32 secondFieldSeqNo,
-                        DropOuts firstTargetFieldDropOuts, DropOuts secondTargetFieldDropouts);
+                        DropOuts &&firstTargetFieldDropOuts, DropOuts &&secondTargetFieldDropouts);
 
 private:
     QString outputFilename;
@@ -76,6 +77,7 @@ private:
     qint32 lastFrameNumber;
     QVector<LdDecodeMetaData *> &ldDecodeMetaData;
     QVector<SourceVideo *> &sourceVideos;
+    QVector<FieldPrefetcher *> fieldPrefetchers;
 
     // Output stream information (all guarded by outputMutex while threads are running)
     QMutex outputMutex;
@@ -93,6 +95,10 @@ private:
     QMap<qint32, OutputFrame> pendingOutputFrames;
     QFile targetVideo;
 
+    // Changes to the metadata, applied once the threads have finished so
+    // that they can read the metadata without locking
+    LdDecodeMetaData::FieldUpdates outputFieldUpdates;
+
     // Local source information
     QVector<bool> sourceDiscTypeCav;
     QVector<qint32> sourceMinimumVbiFrame;
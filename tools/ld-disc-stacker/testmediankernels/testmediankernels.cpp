@@ -0,0 +1,174 @@
+/************************************************************************
+
+    testmediankernels.cpp
+
+    Unit tests and benchmark for MedianKernels
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-disc-stacker is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+#include <QVector>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using std::cerr;
+using std::vector;
+
+#include "mediankernels.h"
+
+// Line length to use (matching PAL 4fSC)
+static constexpr qint32 WIDTH = 1135;
+
+// The median, computed by fully sorting the values
+quint16 referenceMedian(vector<quint16> values)
+{
+    std::sort(values.begin(), values.end());
+    const size_t count = values.size();
+    return static_cast<quint16>((values[(count - 1) / 2] + values[count / 2]) / 2.0);
+}
+
+// The median as Stacker originally computed it, for the benchmark
+quint16 originalMedian(QVector<quint16> elements)
+{
+    qint32 noOfElements = elements.size();
+
+    if (noOfElements % 2 == 0) {
+        std::nth_element(elements.begin(), elements.begin() + noOfElements / 2, elements.end());
+        std::nth_element(elements.begin(), elements.begin() + (noOfElements - 1) / 2, elements.end());
+        return static_cast<quint16>((elements[(noOfElements - 1) / 2] + elements[noOfElements / 2]) / 2.0);
+    } else {
+        std::nth_element(elements.begin(), elements.begin() + noOfElements / 2, elements.end());
+        return static_cast<quint16>(elements[noOfElements / 2]);
+    }
+}
+
+// Check MedianKernels::median against the reference
+void testMedian()
+{
+    cerr << "Testing median\n";
+
+    // For the sizes that use sorting networks, try every combination of 0s
+    // and 1s (by the 0-1 principle, this shows the networks are correct)
+    for (qint32 count = MedianKernels::MIN_INPUTS; count <= MedianKernels::MAX_INPUTS; count++) {
+        for (qint32 bits = 0; bits < (1 << count); bits++) {
+            vector<quint16> values(count);
+            for (qint32 i = 0; i < count; i++) values[i] = static_cast<quint16>((bits >> i) & 1);
+            vector<quint16> input = values;
+            assert(MedianKernels::median(input.data(), count) == referenceMedian(values));
+        }
+    }
+
+    // Random values, with and without lots of repeats
+    std::mt19937 rng(42);
+    for (qint32 count = 1; count <= 40; count++) {
+        for (qint32 test = 0; test < 20000; test++) {
+            std::uniform_int_distribution<qint32> valueDist(0, (test % 2) == 0 ? 65535 : 7);
+            vector<quint16> values(count);
+            for (auto &value : values) value = static_cast<quint16>(valueDist(rng));
+            vector<quint16> input = values;
+            assert(MedianKernels::median(input.data(), count) == referenceMedian(values));
+        }
+    }
+}
+
+// Check each line kernel against MedianKernels::median
+void testLineMedian(MedianKernels::InstructionSet instructionSet)
+{
+    cerr << "Testing " << MedianKernels::getName(instructionSet) << " line median\n";
+    const MedianKernels::LineMedianFunction lineMedian = MedianKernels::getLineMedianFunction(instructionSet);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint32> valueDist(0, 65535);
+    for (qint32 numInputs = MedianKernels::MIN_INPUTS; numInputs <= MedianKernels::MAX_INPUTS; numInputs++) {
+        // Include lengths that leave some pixels over at the end
+        for (qint32 length : {1, 7, 8, 15, 16, 17, 33, WIDTH}) {
+            const qint32 stride = length + 3;
+            vector<quint16> inputs(numInputs * stride);
+            for (auto &value : inputs) value = static_cast<quint16>(valueDist(rng));
+            vector<quint16> output(length);
+            lineMedian(inputs.data(), numInputs, stride, length, output.data());
+
+            for (qint32 x = 0; x < length; x++) {
+                vector<quint16> values(numInputs);
+                for (qint32 i = 0; i < numInputs; i++) values[i] = inputs[(i * stride) + x];
+                assert(output[x] == MedianKernels::median(values.data(), numInputs));
+            }
+        }
+    }
+}
+
+// Compare the speed of the line kernels against the original per-pixel median
+void benchmarkLineMedian(qint32 numInputs)
+{
+    // One PAL field
+    const qint32 lines = 313;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint32> valueDist(0, 65535);
+    vector<quint16> inputs(numInputs * WIDTH);
+    for (auto &value : inputs) value = static_cast<quint16>(valueDist(rng));
+    vector<quint16> output(WIDTH);
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 total = 0;
+    for (qint32 line = 0; line < lines; line++) {
+        for (qint32 x = 0; x < WIDTH; x++) {
+            QVector<quint16> values;
+            for (qint32 i = 0; i < numInputs; i++) values.append(inputs[(i * WIDTH) + x]);
+            total += originalMedian(values);
+        }
+    }
+    const qint64 originalTime = timer.nsecsElapsed();
+
+    cerr << "Median of " << numInputs << " inputs for one field: original " << (originalTime / 1000) << " us";
+    for (auto instructionSet : {MedianKernels::scalar, MedianKernels::sse41, MedianKernels::avx2}) {
+        if (!MedianKernels::isSupported(instructionSet)) continue;
+        const MedianKernels::LineMedianFunction lineMedian = MedianKernels::getLineMedianFunction(instructionSet);
+
+        timer.restart();
+        qint64 kernelTotal = 0;
+        for (qint32 line = 0; line < lines; line++) {
+            lineMedian(inputs.data(), numInputs, WIDTH, WIDTH, output.data());
+            for (qint32 x = 0; x < WIDTH; x++) kernelTotal += output[x];
+        }
+        const qint64 kernelTime = timer.nsecsElapsed();
+
+        // The original median is sometimes wrong for 10 or more inputs, so
+        // only check the totals for small sets
+        if (numInputs < 10) assert(kernelTotal == total);
+        cerr << ", " << MedianKernels::getName(instructionSet) << " " << (kernelTime / 1000) << " us";
+    }
+    cerr << "\n";
+}
+
+int main()
+{
+    testMedian();
+    for (auto instructionSet : {MedianKernels::scalar, MedianKernels::sse41, MedianKernels::avx2}) {
+        if (MedianKernels::isSupported(instructionSet)) testLineMedian(instructionSet);
+    }
+
+    for (qint32 numInputs : {3, 5, 8, 10, 16}) benchmarkLineMedian(numInputs);
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testmediankernels.cpp \
+    ../mediankernels.cpp
+
+HEADERS += \
+    ../mediankernels.h \
+    ../../library/cpu/cpufeatures.h
+
+INCLUDEPATH += \
+    .. \
+    ../../library/cpu
+
+target.CONFIG += no_default_install
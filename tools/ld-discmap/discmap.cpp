@@ -185,8 +185,8 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
                             ldDecodeMetaData->getSecondFieldNumber(frameNumber)).fieldPhaseID; // -1
 
                 // Get the phaseID of the current frame
-                qint32 currentPhase1 = ldDecodeMetaData->getField(ldDecodeMetaData->getFirstFieldNumber(frameNumber + 1)).fieldPhaseID;
-                qint32 currentPhase2 = ldDecodeMetaData->getField(ldDecodeMetaData->getSecondFieldNumber(frameNumber + 1)).fieldPhaseID;
+                qint32 currentPhase1 = ldDecodeMetaData->getFieldPhaseID(ldDecodeMetaData->getFirstFieldNumber(frameNumber + 1));
+                qint32 currentPhase2 = ldDecodeMetaData->getFieldPhaseID(ldDecodeMetaData->getSecondFieldNumber(frameNumber + 1));
 
                 // Get the phaseID of the following frame (with overflow protection)
                 qint32 nextPhase1 = -1;
@@ -326,12 +326,32 @@ DiscMap::DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrde
 
     // Record the phase for both fields of each frame
     for (qint32 frameNumber = 0; frameNumber < m_numberOfFrames; frameNumber++) {
-        m_frames[frameNumber].firstFieldPhase(ldDecodeMetaData->getField(ldDecodeMetaData->getFirstFieldNumber(frameNumber + 1)).fieldPhaseID);
-        m_frames[frameNumber].secondFieldPhase(ldDecodeMetaData->getField(ldDecodeMetaData->getSecondFieldNumber(frameNumber + 1)).fieldPhaseID);
+        m_frames[frameNumber].firstFieldPhase(ldDecodeMetaData->getFieldPhaseID(ldDecodeMetaData->getFirstFieldNumber(frameNumber + 1)));
+        m_frames[frameNumber].secondFieldPhase(ldDecodeMetaData->getFieldPhaseID(ldDecodeMetaData->getSecondFieldNumber(frameNumber + 1)));
     }
 
 }
 
+// Construct a disc map directly from a list of frames (used for testing, so
+// there is no TBC metadata behind it)
+DiscMap::DiscMap(const QVector<Frame> &frames, const bool &isDiscPal, const bool &isDiscCav)
+            : m_reverseFieldOrder(false), m_noStrict(false), m_tbcValid(true),
+              m_numberOfFrames(frames.size()), m_isDiscPal(isDiscPal), m_isDiscCav(isDiscCav),
+              m_numberOfPulldowns(0), m_videoFieldLength(0), m_frames(frames), ldDecodeMetaData(nullptr)
+{
+    for (qint32 frameNumber = 0; frameNumber < m_numberOfFrames; frameNumber++) {
+        if (m_frames[frameNumber].isPullDown()) m_numberOfPulldowns++;
+    }
+
+    if (m_isDiscPal) {
+        m_audioFieldByteLength = 3528;
+        m_audioFieldSampleLength = 882;
+    } else {
+        m_audioFieldByteLength = 2944;
+        m_audioFieldSampleLength = 736;
+    }
+}
+
 DiscMap::~DiscMap()
 {
     delete ldDecodeMetaData;
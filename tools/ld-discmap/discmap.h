@@ -27,6 +27,7 @@
 
 #include <QCoreApplication>
 #include <QDebug>
+#include <QFileInfo>
 #include <QtMath>
 
 // TBC library includes
@@ -44,6 +45,7 @@ public:
     DiscMap &operator=(const DiscMap &) = default;
 
     DiscMap(const QFileInfo &metadataFileInfo, const bool &reverseFieldOrder, const bool &noStrict);
+    DiscMap(const QVector<Frame> &frames, const bool &isDiscPal, const bool &isDiscCav);
 
     QString filename() const;
     bool valid() const;
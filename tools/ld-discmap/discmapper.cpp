@@ -24,6 +24,9 @@
 
 #include "discmapper.h"
 
+#include <algorithm>
+#include <numeric>
+
 DiscMapper::DiscMapper()
 {
     // This space for sale; please enquire within
@@ -323,65 +326,60 @@ void DiscMapper::correctVbiFrameNumbersUsingSequenceAnalysis(DiscMap &discMap)
 void DiscMapper::removeDuplicateNumberedFrames(DiscMap &discMap)
 {
     qInfo() << "Searching for duplicate frames";
-    qDebug() << "Building list of VBIs that have more than one entry in the discmap...";
-    QVector<qint32> duplicatedFrameList;
-    duplicatedFrameList.reserve(discMap.numberOfFrames()); // just to speed things up a little
-    for (qint32 frameNumber = 0; frameNumber < discMap.numberOfFrames(); frameNumber++) {
-        if (!discMap.isPulldown(frameNumber)) {
-            for (qint32 i = frameNumber + 1; i < discMap.numberOfFrames(); i++) {
-                // Does the current frameNumber have a duplicate?
-                if (discMap.vbiFrameNumber(frameNumber) == discMap.vbiFrameNumber(i) && !discMap.isPulldown(i)) {
-                    duplicatedFrameList.append(discMap.vbiFrameNumber(frameNumber));
-                }
-            }
+    qDebug() << "Building an index of the discmap sorted by VBI frame number...";
+
+    // Sort the discmap addresses by VBI frame number; the sort is stable, so
+    // the addresses with the same VBI frame number stay in discmap order
+    QVector<qint32> vbiIndex(discMap.numberOfFrames());
+    std::iota(vbiIndex.begin(), vbiIndex.end(), 0);
+    std::stable_sort(vbiIndex.begin(), vbiIndex.end(), [&discMap](qint32 a, qint32 b) {
+        return discMap.vbiFrameNumber(a) < discMap.vbiFrameNumber(b);
+    });
+
+    // Find the runs of addresses in the index with the same VBI frame number
+    // where more than one of the frames is not a pulldown
+    qDebug() << "Finding VBIs that have more than one entry in the discmap...";
+    QVector<QPair<qint32, qint32>> duplicatedFrameRuns;
+    for (qint32 start = 0; start < vbiIndex.size();) {
+        qint32 end = start;
+        qint32 numberedFrames = 0;
+        while (end < vbiIndex.size() &&
+               discMap.vbiFrameNumber(vbiIndex[end]) == discMap.vbiFrameNumber(vbiIndex[start])) {
+            if (!discMap.isPulldown(vbiIndex[end])) numberedFrames++;
+            end++;
         }
-    }
-
-    qDebug() << "Sorting the duplicated frame list into numerical order...";
-    std::sort(duplicatedFrameList.begin(), duplicatedFrameList.end());
-    qDebug() << "Removing any repeated frame numbers from the duplicated frame list...";
-    auto last = std::unique(duplicatedFrameList.begin(), duplicatedFrameList.end());
-    duplicatedFrameList.erase(last, duplicatedFrameList.end());
 
-    qDebug() << "Found" << duplicatedFrameList.size() << "VBI frame numbers with more than 1 entry in the discmap";
+        if (numberedFrames > 1) duplicatedFrameRuns.append(QPair<qint32, qint32>(start, end));
+        start = end;
+    }
 
-    // The duplicated frame list is a list of VBI frame numbers that have duplicates
+    qDebug() << "Found" << duplicatedFrameRuns.size() << "VBI frame numbers with more than 1 entry in the discmap";
 
     // Process the list of duplications one by one
-    for (qint32 i = 0; i < duplicatedFrameList.size(); i++) {
-        if (duplicatedFrameList[i] != -1) {
-            qDebug() << "VBI Frame number" << duplicatedFrameList[i] << "has duplicates; searching for them...";
-            QVector<qint32> discMapDuplicateAddress;
-            for (qint32 frameNumber = 0; frameNumber < discMap.numberOfFrames(); frameNumber++) {
-                // Does the current frameNumber's VBI match the VBI in the duplicated frame list?
-                if (discMap.vbiFrameNumber(frameNumber) == duplicatedFrameList[i]) {
-                    // Add the frame number ot the duplicate disc map address list
-                    discMapDuplicateAddress.append(frameNumber);
-//                    qDebug() << "  Seq frame" << discMap.seqFrameNumber(frameNumber) << "is a duplicate of" <<
-//                                duplicatedFrameList[i] <<
-//                                "with a quality of" << discMap.frameQuality(frameNumber);
-                }
-            }
+    for (qint32 i = 0; i < duplicatedFrameRuns.size(); i++) {
+        const qint32 runStart = duplicatedFrameRuns[i].first;
+        const qint32 runEnd = duplicatedFrameRuns[i].second;
+        const qint32 vbiFrameNumber = discMap.vbiFrameNumber(vbiIndex[runStart]);
 
+        if (vbiFrameNumber != -1) {
             // Show the number of duplicates in the discMap that were found
-            qDebug() << "  Found" << discMapDuplicateAddress.size() << "duplicates of VBI frame" << duplicatedFrameList[i];
+            qDebug() << "VBI Frame number" << vbiFrameNumber << "has" << runEnd - runStart << "duplicates";
 
             // Pick the sequential frame duplicate with the best quality
-            qint32 bestDiscMapFrame = discMapDuplicateAddress.first();
-            for (qint32 i = 0; i < discMapDuplicateAddress.size(); i++) {
-                if (discMap.frameQuality(bestDiscMapFrame) < discMap.frameQuality(discMapDuplicateAddress[i])) {
-                    bestDiscMapFrame = discMapDuplicateAddress[i];
+            qint32 bestDiscMapFrame = vbiIndex[runStart];
+            for (qint32 j = runStart; j < runEnd; j++) {
+                if (discMap.frameQuality(bestDiscMapFrame) < discMap.frameQuality(vbiIndex[j])) {
+                    bestDiscMapFrame = vbiIndex[j];
                 }
             }
 
-            qDebug() << "  Highest quality duplicate of VBI" << duplicatedFrameList[i] << "is sequential frame" <<
+            qDebug() << "  Highest quality duplicate of VBI" << vbiFrameNumber << "is sequential frame" <<
                         discMap.seqFrameNumber(bestDiscMapFrame) << "with a quality of" << discMap.frameQuality(bestDiscMapFrame);
 
             // Delete all duplicates except the best sequential frame
-            for (qint32 i = 0; i < discMapDuplicateAddress.size(); i++) {
-                if (discMapDuplicateAddress[i] != bestDiscMapFrame) {
-                    discMap.setMarkedForDeletion(discMapDuplicateAddress[i]);
-                    //qDebug() << " Seq. frame" << discMap.seqFrameNumber(discMapDuplicateAddress[i]) << "marked for deletion";
+            for (qint32 j = runStart; j < runEnd; j++) {
+                if (vbiIndex[j] != bestDiscMapFrame) {
+                    discMap.setMarkedForDeletion(vbiIndex[j]);
                 }
             }
         } else {
@@ -597,11 +595,20 @@ void DiscMapper::deleteUnmappableFrames(DiscMap &discMap)
 }
 
 // Method to save the current disc map
+//
+// Most of the disc map is made up of long runs of frames that are contiguous
+// in the input files, so rather than reading and writing each field, the
+// TBC and PCM data is copied as byte ranges; RangeCopier merges neighbouring
+// ranges and copies each run in one go.
 bool DiscMapper::saveDiscMap(DiscMap &discMap)
 {
     // Open the input video file
-    SourceVideo sourceVideo;
-    sourceVideo.open(inputFileInfo.filePath(), discMap.getVideoFieldLength());
+    QFile sourceVideo(inputFileInfo.filePath());
+    if (!sourceVideo.open(QIODevice::ReadOnly)) {
+        // Could not open source video file
+        qInfo() << "Cannot open source video file:" << inputFileInfo.filePath();
+        return false;
+    }
 
     // Open the output video file
     QFile targetVideo(outputFileInfo.filePath());
@@ -613,16 +620,16 @@ bool DiscMapper::saveDiscMap(DiscMap &discMap)
     }
 
     // Initialise the input audio file
-    SourceAudio sourceAudio;
+    QFile sourceAudio;
     QFile targetAudio;
 
     if (!noAudio) {
         // Open the input audio file
-        if (!sourceAudio.open(inputFileInfo)) {
+        sourceAudio.setFileName(inputFileInfo.absolutePath() + "/" + inputFileInfo.baseName() + ".pcm");
+        if (!sourceAudio.open(QIODevice::ReadOnly)) {
             // Could not open input audio file
-            qInfo() << "Cannot open source audio file:" << inputFileInfo.absolutePath() + "/" + inputFileInfo.completeBaseName() + ".pcm";
+            qInfo() << "Cannot open source audio file:" << sourceAudio.fileName();
             sourceVideo.close();
-            sourceAudio.close();
             return false;
         }
 
@@ -643,20 +650,17 @@ bool DiscMapper::saveDiscMap(DiscMap &discMap)
         }
     }
 
+    RangeCopier videoCopier(sourceVideo, targetVideo);
+    RangeCopier audioCopier(sourceAudio, targetAudio);
+
     // Make a dummy video field to use when outputting padded frames
-    SourceVideo::Data missingFieldData;
-    missingFieldData.fill(0, discMap.getVideoFieldLength());
+    const qint64 fieldByteLength = static_cast<qint64>(discMap.getVideoFieldLength()) * 2;
+    const QByteArray missingFieldData(static_cast<qint32>(fieldByteLength), 0);
 
     // Make a dummy audio field to use when outputting padded frames
-    SourceAudio::Data missingFieldAudioData;
-    missingFieldAudioData.fill(0, discMap.getApproximateAudioFieldLength());
+    const QByteArray missingFieldAudioData(discMap.getApproximateAudioFieldLength() * 2, 0);
 
     // Create the output video file
-    SourceVideo::Data sourceFirstField;
-    SourceVideo::Data sourceSecondField;
-    SourceAudio::Data sourceAudioFirstField;
-    SourceAudio::Data sourceAudioSecondField;
-
     qInfo() << "Saving target video frames...";
     qint32 notifyInterval = discMap.numberOfFrames() / 50;
     if (notifyInterval < 1) notifyInterval = 1;
@@ -669,51 +673,33 @@ bool DiscMapper::saveDiscMap(DiscMap &discMap)
             // Real frame
             qint32 firstFieldNumber = discMap.getFirstFieldNumber(frameNumber);
             qint32 secondFieldNumber = discMap.getSecondFieldNumber(frameNumber);
-            sourceFirstField = sourceVideo.getVideoField(firstFieldNumber);
-            sourceSecondField = sourceVideo.getVideoField(secondFieldNumber);
 
             // Write the fields into the output TBC file in the same order as the source file
-            if (firstFieldNumber < secondFieldNumber) {
-                // Save the first field and then second field to the output file
-                if (!targetVideo.write(reinterpret_cast<const char *>(sourceFirstField.data()),
-                                       sourceFirstField.size() * 2)) writeFail = true;
-                if (!targetVideo.write(reinterpret_cast<const char *>(sourceSecondField.data()),
-                                       sourceSecondField.size() * 2)) writeFail = true;
-            } else {
-                // Save the second field and then first field to the output file
-                if (!targetVideo.write(reinterpret_cast<const char *>(sourceSecondField.data()),
-                                       sourceSecondField.size() * 2)) writeFail = true;
-                if (!targetVideo.write(reinterpret_cast<const char *>(sourceFirstField.data()),
-                                       sourceFirstField.size() * 2)) writeFail = true;
-            }
-
-            // Save the audio (not field order dependent)
+            // (fields are numbered from 1)
+            if (!videoCopier.copy(fieldByteLength * (qMin(firstFieldNumber, secondFieldNumber) - 1), fieldByteLength))
+                writeFail = true;
+            if (!videoCopier.copy(fieldByteLength * (qMax(firstFieldNumber, secondFieldNumber) - 1), fieldByteLength))
+                writeFail = true;
+
+            // Save the audio (not field order dependent); the positions are
+            // in stereo 16-bit sample pairs
             if (!noAudio) {
-                // Read the audio
-                sourceAudioFirstField = sourceAudio.getAudioData(discMap.getFirstFieldAudioDataStart(frameNumber),
-                                                                 discMap.getFirstFieldAudioDataLength(frameNumber));
-                sourceAudioSecondField = sourceAudio.getAudioData(discMap.getSecondFieldAudioDataStart(frameNumber),
-                                                                  discMap.getSecondFieldAudioDataLength(frameNumber));
-
-                // Write the audio
-                if (!targetAudio.write(reinterpret_cast<const char *>(sourceAudioFirstField.data()),
-                                       sourceAudioFirstField.size() * 2)) writeFail = true;
-                if (!targetAudio.write(reinterpret_cast<const char *>(sourceAudioSecondField.data()),
-                                       sourceAudioSecondField.size() * 2)) writeFail = true;
+                if (!audioCopier.copy(static_cast<qint64>(discMap.getFirstFieldAudioDataStart(frameNumber)) * 4,
+                                      static_cast<qint64>(discMap.getFirstFieldAudioDataLength(frameNumber)) * 4))
+                    writeFail = true;
+                if (!audioCopier.copy(static_cast<qint64>(discMap.getSecondFieldAudioDataStart(frameNumber)) * 4,
+                                      static_cast<qint64>(discMap.getSecondFieldAudioDataLength(frameNumber)) * 4))
+                    writeFail = true;
             }
         } else {
             // Padded frame - write two dummy fields
-            if (!targetVideo.write(reinterpret_cast<const char *>(missingFieldData.data()),
-                                   missingFieldData.size() * 2)) writeFail = true;
-            if (!targetVideo.write(reinterpret_cast<const char *>(missingFieldData.data()),
-                                   missingFieldData.size() * 2)) writeFail = true;
+            if (!videoCopier.write(missingFieldData.constData(), missingFieldData.size())) writeFail = true;
+            if (!videoCopier.write(missingFieldData.constData(), missingFieldData.size())) writeFail = true;
 
             if (!noAudio) {
                 // Write the padded audio
-                if (!targetAudio.write(reinterpret_cast<const char *>(missingFieldAudioData.data()),
-                                       missingFieldAudioData.size() * 2)) writeFail = true;
-                if (!targetAudio.write(reinterpret_cast<const char *>(missingFieldAudioData.data()),
-                                       missingFieldAudioData.size() * 2)) writeFail = true;
+                if (!audioCopier.write(missingFieldAudioData.constData(), missingFieldAudioData.size())) writeFail = true;
+                if (!audioCopier.write(missingFieldAudioData.constData(), missingFieldAudioData.size())) writeFail = true;
             }
         }
 
@@ -731,6 +717,14 @@ bool DiscMapper::saveDiscMap(DiscMap &discMap)
             return false;
         }
     }
+
+    // Copy the last run of frames
+    if (!videoCopier.flush() || (!noAudio && !audioCopier.flush())) {
+        qWarning() << "Writing fields to the target TBC file failed on the final frames";
+        targetVideo.close();
+        sourceVideo.close();
+        return false;
+    }
     qInfo() << discMap.numberOfFrames() << "video frames saved";
 
     // Close the source and target video files
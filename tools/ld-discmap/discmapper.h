@@ -31,11 +31,10 @@
 #include <QFile>
 
 // TBC library includes
-#include "sourcevideo.h"
-#include "sourceaudio.h"
 #include "lddecodemetadata.h"
 
 #include "discmap.h"
+#include "rangecopier.h"
 
 class DiscMapper
 {
@@ -46,6 +45,10 @@ public:
                  QFileInfo _outputFileInfo, bool _reverse, bool _mapOnly, bool _noStrict,
                  bool _deleteUnmappable, bool _noAudio);
 
+    // Disc map analysis
+    void correctVbiFrameNumbersUsingSequenceAnalysis(DiscMap &discMap);
+    void removeDuplicateNumberedFrames(DiscMap &discMap);
+
 private:
     QFileInfo inputFileInfo;
     QFileInfo inputMetadataFileInfo;
@@ -58,8 +61,6 @@ private:
 
     void removeLeadInOut(DiscMap &discMap);
     void removeInvalidFramesByPhase(DiscMap &discMap);
-    void correctVbiFrameNumbersUsingSequenceAnalysis(DiscMap &discMap);
-    void removeDuplicateNumberedFrames(DiscMap &discMap);
     void numberPulldownFrames(DiscMap &discMap);
     bool verifyFrameNumberPresence(DiscMap &discMap);
     void reorderFrames(DiscMap &discMap);
@@ -15,27 +15,27 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    ../library/tbc/jsonio.cpp \
     ../library/tbc/lddecodemetadata.cpp \
-    ../library/tbc/sourcevideo.cpp \
-    ../library/tbc/sourceaudio.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp \
     ../library/tbc/dropouts.cpp \
     discmap.cpp \
     discmapper.cpp \
     frame.cpp \
+    rangecopier.cpp \
     main.cpp
 
 HEADERS += \
+    ../library/tbc/jsonio.h \
     ../library/tbc/lddecodemetadata.h \
-    ../library/tbc/sourcevideo.h \
-    ../library/tbc/sourceaudio.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h \
     ../library/tbc/dropouts.h \
     discmap.h \
     discmapper.h \
-    frame.h
+    frame.h \
+    rangecopier.h
 
 # Add external includes to the include path
 INCLUDEPATH += ../library/tbc
@@ -0,0 +1,155 @@
+/************************************************************************
+
+    rangecopier.cpp
+
+    ld-discmap - TBC and VBI alignment and correction
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-discmap is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "rangecopier.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+// Size of the buffer used when copying through userspace
+static constexpr qint64 BUFFER_SIZE = 16 * 1024 * 1024;
+
+RangeCopier::RangeCopier(QFile &source, QFile &target)
+    : sourceFile(source), targetFile(target), targetPosition(target.pos()),
+      pendingPosition(0), pendingLength(0)
+{
+#if defined(Q_OS_LINUX)
+    useCopyFileRange = true;
+#else
+    useCopyFileRange = false;
+#endif
+}
+
+// Append a range from the source file. If it follows on from the pending
+// range, it's merged into it; otherwise, the pending range is written first.
+bool RangeCopier::copy(qint64 position, qint64 length)
+{
+    if (pendingLength != 0 && position == pendingPosition + pendingLength) {
+        pendingLength += length;
+        return true;
+    }
+
+    if (!flush()) return false;
+    pendingPosition = position;
+    pendingLength = length;
+    return true;
+}
+
+// Append data from memory
+bool RangeCopier::write(const char *data, qint64 length)
+{
+    if (!flush()) return false;
+
+    if (targetFile.write(data, length) != length) return false;
+    targetPosition += length;
+
+    return true;
+}
+
+bool RangeCopier::flush()
+{
+    if (pendingLength == 0) return true;
+
+    const bool success = copyRange(pendingPosition, pendingLength);
+    pendingLength = 0;
+    return success;
+}
+
+// Copy a range from the source file to the end of the target file
+bool RangeCopier::copyRange(qint64 position, qint64 length)
+{
+#if defined(Q_OS_LINUX)
+    if (useCopyFileRange) {
+        // Make sure anything written through the QFile has reached the file
+        if (!targetFile.flush()) return false;
+
+        loff_t sourceOffset = position;
+        loff_t targetOffset = targetPosition;
+        while (length > 0) {
+            const ssize_t copied = copy_file_range(sourceFile.handle(), &sourceOffset,
+                                                   targetFile.handle(), &targetOffset,
+                                                   static_cast<size_t>(length), 0);
+            if (copied > 0) {
+                length -= copied;
+                targetPosition += copied;
+                continue;
+            }
+
+            if (copied == 0) {
+                // The source file ended early
+                qDebug() << "RangeCopier::copyRange(): Source file ended before position" << sourceOffset + length;
+                return false;
+            }
+
+            if (errno == EINTR) continue;
+
+            if (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP) {
+                // The kernel can't do this copy (too old, files on different
+                // filesystems, unsupported file types...) - use the buffer
+                // from now on
+                qDebug() << "RangeCopier::copyRange(): copy_file_range not available - copying through a buffer";
+                useCopyFileRange = false;
+                return copyRangeBuffered(sourceOffset, length);
+            }
+
+            return false;
+        }
+
+        // Leave the target file's position at the end of the data
+        return targetFile.seek(targetPosition);
+    }
+#endif
+
+    return copyRangeBuffered(position, length);
+}
+
+// Copy a range from the source file to the end of the target file, through a buffer
+bool RangeCopier::copyRangeBuffered(qint64 position, qint64 length)
+{
+    if (buffer.isEmpty()) buffer.resize(static_cast<int>(BUFFER_SIZE));
+
+    if (!sourceFile.seek(position)) return false;
+    if (!targetFile.seek(targetPosition)) return false;
+
+    while (length > 0) {
+        const qint64 chunkLength = std::min(length, BUFFER_SIZE);
+        if (sourceFile.read(buffer.data(), chunkLength) != chunkLength) {
+            qDebug() << "RangeCopier::copyRangeBuffered(): Source file ended before position" << position + length;
+            return false;
+        }
+        if (targetFile.write(buffer.constData(), chunkLength) != chunkLength) return false;
+
+        position += chunkLength;
+        length -= chunkLength;
+        targetPosition += chunkLength;
+    }
+
+    return true;
+}
@@ -0,0 +1,72 @@
+/************************************************************************
+
+    rangecopier.h
+
+    ld-discmap - TBC and VBI alignment and correction
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-discmap is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef RANGECOPIER_H
+#define RANGECOPIER_H
+
+#include <QByteArray>
+#include <QFile>
+
+// Build a target file by appending byte ranges copied from a source file,
+// and blocks of data from memory.
+//
+// Ranges that are contiguous in the source file are merged and copied in a
+// single operation. On Linux this uses copy_file_range, so the data doesn't
+// pass through userspace (and may not need copying at all, on filesystems
+// that support reflinks); otherwise, or if the kernel can't copy between the
+// two files, it falls back to copying through a large buffer.
+class RangeCopier
+{
+public:
+    RangeCopier(QFile &source, QFile &target);
+
+    // Prevent copying or assignment
+    RangeCopier(const RangeCopier &) = delete;
+    RangeCopier& operator=(const RangeCopier &) = delete;
+
+    // Append length bytes from position in the source file
+    bool copy(qint64 position, qint64 length);
+
+    // Append length bytes from data
+    bool write(const char *data, qint64 length);
+
+    // Write any pending range to the target file
+    bool flush();
+
+private:
+    QFile &sourceFile;
+    QFile &targetFile;
+    qint64 targetPosition;
+    bool useCopyFileRange;
+    QByteArray buffer;
+
+    // The range waiting to be copied
+    qint64 pendingPosition;
+    qint64 pendingLength;
+
+    bool copyRange(qint64 position, qint64 length);
+    bool copyRangeBuffered(qint64 position, qint64 length);
+};
+
+#endif // RANGECOPIER_H
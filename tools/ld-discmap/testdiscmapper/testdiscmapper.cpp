@@ -0,0 +1,335 @@
+/************************************************************************
+
+    testdiscmapper.cpp
+
+    Unit tests and benchmark for DiscMapper
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-discmap is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+
+using std::cerr;
+
+#include "discmapper.h"
+
+// The original duplicate removal, which compares every pair of frames
+void referenceRemoveDuplicates(DiscMap &discMap)
+{
+    qInfo() << "Searching for duplicate frames";
+    qDebug() << "Building list of VBIs that have more than one entry in the discmap...";
+    QVector<qint32> duplicatedFrameList;
+    duplicatedFrameList.reserve(discMap.numberOfFrames()); // just to speed things up a little
+    for (qint32 frameNumber = 0; frameNumber < discMap.numberOfFrames(); frameNumber++) {
+        if (!discMap.isPulldown(frameNumber)) {
+            for (qint32 i = frameNumber + 1; i < discMap.numberOfFrames(); i++) {
+                // Does the current frameNumber have a duplicate?
+                if (discMap.vbiFrameNumber(frameNumber) == discMap.vbiFrameNumber(i) && !discMap.isPulldown(i)) {
+                    duplicatedFrameList.append(discMap.vbiFrameNumber(frameNumber));
+                }
+            }
+        }
+    }
+
+    qDebug() << "Sorting the duplicated frame list into numerical order...";
+    std::sort(duplicatedFrameList.begin(), duplicatedFrameList.end());
+    qDebug() << "Removing any repeated frame numbers from the duplicated frame list...";
+    auto last = std::unique(duplicatedFrameList.begin(), duplicatedFrameList.end());
+    duplicatedFrameList.erase(last, duplicatedFrameList.end());
+
+    qDebug() << "Found" << duplicatedFrameList.size() << "VBI frame numbers with more than 1 entry in the discmap";
+
+    // The duplicated frame list is a list of VBI frame numbers that have duplicates
+
+    // Process the list of duplications one by one
+    for (qint32 i = 0; i < duplicatedFrameList.size(); i++) {
+        if (duplicatedFrameList[i] != -1) {
+            qDebug() << "VBI Frame number" << duplicatedFrameList[i] << "has duplicates; searching for them...";
+            QVector<qint32> discMapDuplicateAddress;
+            for (qint32 frameNumber = 0; frameNumber < discMap.numberOfFrames(); frameNumber++) {
+                // Does the current frameNumber's VBI match the VBI in the duplicated frame list?
+                if (discMap.vbiFrameNumber(frameNumber) == duplicatedFrameList[i]) {
+                    // Add the frame number ot the duplicate disc map address list
+                    discMapDuplicateAddress.append(frameNumber);
+//                    qDebug() << "  Seq frame" << discMap.seqFrameNumber(frameNumber) << "is a duplicate of" <<
+//                                duplicatedFrameList[i] <<
+//                                "with a quality of" << discMap.frameQuality(frameNumber);
+                }
+            }
+
+            // Show the number of duplicates in the discMap that were found
+            qDebug() << "  Found" << discMapDuplicateAddress.size() << "duplicates of VBI frame" << duplicatedFrameList[i];
+
+            // Pick the sequential frame duplicate with the best quality
+            qint32 bestDiscMapFrame = discMapDuplicateAddress.first();
+            for (qint32 i = 0; i < discMapDuplicateAddress.size(); i++) {
+                if (discMap.frameQuality(bestDiscMapFrame) < discMap.frameQuality(discMapDuplicateAddress[i])) {
+                    bestDiscMapFrame = discMapDuplicateAddress[i];
+                }
+            }
+
+            qDebug() << "  Highest quality duplicate of VBI" << duplicatedFrameList[i] << "is sequential frame" <<
+                        discMap.seqFrameNumber(bestDiscMapFrame) << "with a quality of" << discMap.frameQuality(bestDiscMapFrame);
+
+            // Delete all duplicates except the best sequential frame
+            for (qint32 i = 0; i < discMapDuplicateAddress.size(); i++) {
+                if (discMapDuplicateAddress[i] != bestDiscMapFrame) {
+                    discMap.setMarkedForDeletion(discMapDuplicateAddress[i]);
+                    //qDebug() << " Seq. frame" << discMap.seqFrameNumber(discMapDuplicateAddress[i]) << "marked for deletion";
+                }
+            }
+        } else {
+            // Having frames without numbering (that are not pulldown) is a bad thing...
+            qInfo() << "";
+            qInfo() << "Warning:";
+            qInfo() << "There are frames without a frame number (that are not flagged as pulldown) in the duplicate frame list";
+            qInfo() << "This probably means that the disc map contains pulldown frames that do not follow the normal 1 in 5";
+            qInfo() << "pulldown pattern - and disc mapping will likely fail!";
+            qInfo() << "";
+        }
+    }
+
+    // Delete duplicates
+    qint32 originalSize = discMap.numberOfFrames();
+    discMap.flush();
+    qInfo() << "Removed" << originalSize - discMap.numberOfFrames() <<
+               "duplicate frames - disc map size now" << discMap.numberOfFrames() << "frames";
+}
+
+// Make a synthetic CAV disc map, as it would look after lead-in/out removal:
+// a run of numbered frames with 1-in-5 pulldowns (for NTSC), and with
+// repeated frames, skips and misread VBI frame numbers injected into it
+QVector<Frame> makeDiscMap(qint32 numberOfFrames, bool isDiscPal, qint32 damagePercent, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<qint32> percentDist(0, 99);
+    std::uniform_int_distribution<qint32> damageTypeDist(0, 3);
+    std::uniform_int_distribution<qint32> lengthDist(1, 30);
+    std::uniform_int_distribution<qint32> vbiDist(1, numberOfFrames);
+    std::uniform_real_distribution<qreal> qualityDist(0.0, 100.0);
+    const qint32 phases = isDiscPal ? 8 : 4;
+
+    QVector<Frame> frames;
+    qint32 vbiFrameNumber = 1;
+    qint32 phase = 1;
+    qint32 pulldownCounter = 0;
+    while (frames.size() < numberOfFrames) {
+        Frame frame(frames.size() + 1, vbiFrameNumber);
+        frame.frameQuality(qualityDist(rng));
+
+        // Every 5th NTSC frame is a pulldown, with no frame number
+        const bool isPulldown = !isDiscPal && (++pulldownCounter % 5) == 0;
+        if (isPulldown) {
+            frame.isPullDown(true);
+            frame.vbiFrameNumber(-1);
+        }
+
+        // Inject some damage
+        if (percentDist(rng) < damagePercent) {
+            switch (damageTypeDist(rng)) {
+            case 0: {
+                // The player skipped back, repeating some frames
+                const qint32 length = std::min(lengthDist(rng), frames.size());
+                for (qint32 i = frames.size() - length; i < frames.size() - 1 && frames.size() < numberOfFrames; i++) {
+                    Frame repeat = frames[i];
+                    repeat.seqFrameNumber(frames.size() + 1);
+                    repeat.frameQuality(qualityDist(rng));
+                    frames.append(repeat);
+                }
+                break;
+            }
+            case 1:
+                // The player skipped forward, missing some frames
+                vbiFrameNumber += lengthDist(rng);
+                break;
+            case 2:
+                // The VBI frame number was misread
+                if (!isPulldown) frame.vbiFrameNumber(vbiDist(rng));
+                break;
+            default:
+                // The frame was played twice (a repeating frame)
+                if (!frames.isEmpty() && frames.size() < numberOfFrames) {
+                    Frame repeat = frames.last();
+                    repeat.seqFrameNumber(frames.size() + 1);
+                    frames.append(repeat);
+                }
+                break;
+            }
+        }
+        if (frames.size() >= numberOfFrames) break;
+
+        // Set the field phases
+        frame.firstFieldPhase(phase);
+        frame.secondFieldPhase((phase % phases) + 1);
+        phase = ((phase + 1) % phases) + 1;
+
+        frame.seqFrameNumber(frames.size() + 1);
+        frames.append(frame);
+        if (!isPulldown) vbiFrameNumber++;
+    }
+
+    return frames;
+}
+
+// Check that two disc maps have the same frames in the same order
+void compareDiscMaps(const DiscMap &expected, const DiscMap &actual)
+{
+    assert(actual.numberOfFrames() == expected.numberOfFrames());
+    for (qint32 frameNumber = 0; frameNumber < expected.numberOfFrames(); frameNumber++) {
+        if (actual.seqFrameNumber(frameNumber) != expected.seqFrameNumber(frameNumber) ||
+                actual.vbiFrameNumber(frameNumber) != expected.vbiFrameNumber(frameNumber)) {
+            cerr << "Mismatch at frame " << frameNumber << ": expected seq. " << expected.seqFrameNumber(frameNumber)
+                 << " VBI " << expected.vbiFrameNumber(frameNumber) << ", got seq. " << actual.seqFrameNumber(frameNumber)
+                 << " VBI " << actual.vbiFrameNumber(frameNumber) << "\n";
+            assert(false);
+        }
+    }
+}
+
+// Check that duplicate removal gives the same results as the original
+// implementation, on disc maps that have been through sequence analysis
+void testAnalysis()
+{
+    cerr << "Testing duplicate removal against the original implementation\n";
+
+    std::mt19937 rng(42);
+    DiscMapper discMapper;
+    for (qint32 test = 0; test < 200; test++) {
+        const bool isDiscPal = (test % 2) == 0;
+        const qint32 damagePercent = test % 10;
+        const QVector<Frame> frames = makeDiscMap(2000, isDiscPal, damagePercent, rng);
+
+        DiscMap expected(frames, isDiscPal, true);
+        discMapper.correctVbiFrameNumbersUsingSequenceAnalysis(expected);
+        referenceRemoveDuplicates(expected);
+
+        DiscMap actual(frames, isDiscPal, true);
+        discMapper.correctVbiFrameNumbersUsingSequenceAnalysis(actual);
+        discMapper.removeDuplicateNumberedFrames(actual);
+
+        compareDiscMaps(expected, actual);
+    }
+}
+
+// Compare the speed of duplicate removal against the original implementation
+void benchmarkAnalysis()
+{
+    // One side of an NTSC CAV disc, with lots of skips
+    std::mt19937 rng(42);
+    const QVector<Frame> frames = makeDiscMap(54000, false, 2, rng);
+    DiscMapper discMapper;
+
+    DiscMap actual(frames, false, true);
+    discMapper.correctVbiFrameNumbersUsingSequenceAnalysis(actual);
+    QElapsedTimer timer;
+    timer.start();
+    discMapper.removeDuplicateNumberedFrames(actual);
+    const qint64 duplicateTime = timer.elapsed();
+
+    DiscMap expected(frames, false, true);
+    discMapper.correctVbiFrameNumbersUsingSequenceAnalysis(expected);
+    timer.restart();
+    referenceRemoveDuplicates(expected);
+    const qint64 referenceDuplicateTime = timer.elapsed();
+
+    compareDiscMaps(expected, actual);
+    cerr << "Analysing " << frames.size() << " frames: duplicate removal took " << duplicateTime
+         << " ms (originally " << referenceDuplicateTime << " ms)\n";
+}
+
+// Check that RangeCopier produces the same output as copying the data by hand
+void testRangeCopier()
+{
+    cerr << "Testing RangeCopier\n";
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint32> byteDist(0, 255);
+    std::uniform_int_distribution<qint32> positionDist(0, 999999);
+    std::uniform_int_distribution<qint32> lengthDist(0, 100000);
+    std::uniform_int_distribution<qint32> actionDist(0, 9);
+
+    // Make a source file full of random data
+    QByteArray sourceData(1100000, 0);
+    for (qint32 i = 0; i < sourceData.size(); i++) sourceData[i] = static_cast<char>(byteDist(rng));
+    QTemporaryFile sourceFile;
+    bool ok = sourceFile.open();
+    assert(ok);
+    const qint64 written = sourceFile.write(sourceData);
+    assert(written == sourceData.size());
+    ok = sourceFile.flush();
+    assert(ok);
+
+    QTemporaryFile targetFile;
+    ok = targetFile.open();
+    assert(ok);
+
+    // Copy a mixture of contiguous runs, separate ranges and blocks of memory
+    QByteArray expected;
+    {
+        RangeCopier copier(sourceFile, targetFile);
+        qint32 position = 0;
+        for (qint32 i = 0; i < 500; i++) {
+            const qint32 action = actionDist(rng);
+            const qint32 length = lengthDist(rng);
+            if (action == 0) {
+                const QByteArray block(length, static_cast<char>(i));
+                ok = copier.write(block.constData(), block.size());
+                assert(ok);
+                expected.append(block);
+                continue;
+            }
+
+            // Mostly carry on from the previous range
+            if (action == 1) position = positionDist(rng);
+            ok = copier.copy(position, length);
+            assert(ok);
+            expected.append(sourceData.mid(position, length));
+            position = (position + length) % 1000000;
+        }
+        ok = copier.flush();
+        assert(ok);
+    }
+
+    // Copying past the end of the source file should fail
+    {
+        RangeCopier copier(sourceFile, targetFile);
+        ok = copier.copy(sourceData.size() - 10, 20);
+        assert(ok);
+        ok = copier.flush();
+        assert(!ok);
+    }
+
+    ok = targetFile.seek(0);
+    assert(ok);
+    const QByteArray actual = targetFile.readAll();
+    assert(actual.mid(0, expected.size()) == expected);
+}
+
+int main()
+{
+    testAnalysis();
+    testRangeCopier();
+    benchmarkAnalysis();
+
+    return 0;
+}
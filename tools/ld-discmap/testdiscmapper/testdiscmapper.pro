@@ -0,0 +1,29 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testdiscmapper.cpp \
+    ../discmap.cpp \
+    ../discmapper.cpp \
+    ../frame.cpp \
+    ../rangecopier.cpp \
+    ../../library/tbc/dropouts.cpp \
+    ../../library/tbc/jsonio.cpp \
+    ../../library/tbc/lddecodemetadata.cpp \
+    ../../library/tbc/vbidecoder.cpp
+
+HEADERS += \
+    ../discmap.h \
+    ../discmapper.h \
+    ../frame.h \
+    ../rangecopier.h \
+    ../../library/tbc/dropouts.h \
+    ../../library/tbc/jsonio.h \
+    ../../library/tbc/lddecodemetadata.h \
+    ../../library/tbc/vbidecoder.h
+
+INCLUDEPATH += \
+    .. \
+    ../../library/tbc
+
+target.CONFIG += no_default_install
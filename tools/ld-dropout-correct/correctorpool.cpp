@@ -25,6 +25,8 @@
 
 #include "correctorpool.h"
 
+#include "videobufferpool.h"
+
 CorrectorPool::CorrectorPool(QString _outputFilename, QString _outputJsonFilename,
                              qint32 _maxThreads, QVector<LdDecodeMetaData *> &_ldDecodeMetaData, QVector<SourceVideo *> &_sourceVideos,
                              bool _reverse, bool _intraField, bool _overCorrect, QObject *parent)
@@ -92,6 +94,14 @@ bool CorrectorPool::process()
     outputFrameNumber = 1;
     lastFrameNumber = ldDecodeMetaData[0]->getNumberOfFrames();
     totalTimer.start();
+    const qint64 startBytesCopied = VideoBuffer::getBytesCopied();
+
+    // Start reading fields ahead of the workers for each source
+    fieldPrefetchers.resize(sourceVideos.size());
+    for (qint32 sourceNo = 0; sourceNo < sourceVideos.size(); sourceNo++) {
+        fieldPrefetchers[sourceNo] = new FieldPrefetcher(*sourceVideos[sourceNo]);
+        fieldPrefetchers[sourceNo]->startPrefetch(1, ldDecodeMetaData[sourceNo]->getNumberOfFields());
+    }
 
     // Start a vector of decoding threads to process the video
     qInfo() << "Beginning multi-threaded dropout correction process...";
@@ -108,6 +118,15 @@ bool CorrectorPool::process()
         delete threads[i];
     }
 
+    // Stop the prefetchers
+    qint64 prefetchStalls = 0;
+    for (qint32 sourceNo = 0; sourceNo < fieldPrefetchers.size(); sourceNo++) {
+        fieldPrefetchers[sourceNo]->stopPrefetch();
+        prefetchStalls += fieldPrefetchers[sourceNo]->getStallCount();
+        delete fieldPrefetchers[sourceNo];
+    }
+    fieldPrefetchers.clear();
+
     // Did any of the threads abort?
     if (abort) {
         targetVideo.close();
@@ -118,6 +137,12 @@ bool CorrectorPool::process()
     qreal totalSecs = (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
     qInfo() << "Dropout correction complete -" << lastFrameNumber << "frames in" << totalSecs << "seconds (" <<
                lastFrameNumber / totalSecs << "FPS )";
+    qInfo() << "Input prefetcher stalled" << prefetchStalls << "times";
+    qInfo() << "Copied" << (VideoBuffer::getBytesCopied() - startBytesCopied) / qMax(lastFrameNumber, 1)
+            << "bytes of field data per frame between threads";
+    const VideoBufferPool::Statistics poolStatistics = VideoBufferPool::getStatistics();
+    qInfo() << "Buffer pool allocated" << poolStatistics.allocations << "buffers and reused" << poolStatistics.reuses
+            << "(" << poolStatistics.bytesReserved / (1024 * 1024) << "MiB reserved )";
 
     qInfo() << "Creating JSON metadata file for drop-out corrected TBC...";
     ldDecodeMetaData[0]->write(outputJsonFilename);
@@ -180,8 +205,8 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
             secondFieldNumber[sourceNo] = ldDecodeMetaData[sourceNo]->getSecondFieldNumber(frameNumber);
 
             // Determine the frame quality (currently this is based on frame average black SNR)
-            qreal firstFrameSnr = ldDecodeMetaData[sourceNo]->getField(firstFieldNumber[sourceNo]).vitsMetrics.bPSNR;
-            qreal secondFrameSnr = ldDecodeMetaData[sourceNo]->getField(secondFieldNumber[sourceNo]).vitsMetrics.bPSNR;
+            qreal firstFrameSnr = ldDecodeMetaData[sourceNo]->getFieldVitsMetrics(firstFieldNumber[sourceNo]).bPSNR;
+            qreal secondFrameSnr = ldDecodeMetaData[sourceNo]->getFieldVitsMetrics(secondFieldNumber[sourceNo]).bPSNR;
             sourceFrameQuality[sourceNo] = (firstFrameSnr + secondFrameSnr) / 2.0;
 
             qDebug().nospace() << "CorrectorPool::getInputFrame(): Source #0 fields are " <<
@@ -195,8 +220,8 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
             secondFieldNumber[sourceNo] = ldDecodeMetaData[sourceNo]->getSecondFieldNumber(currentSourceFrameNumber);
 
             // Determine the frame quality (currently this is based on frame average black SNR)
-            qreal firstFrameSnr = ldDecodeMetaData[sourceNo]->getField(firstFieldNumber[sourceNo]).vitsMetrics.bPSNR;
-            qreal secondFrameSnr = ldDecodeMetaData[sourceNo]->getField(secondFieldNumber[sourceNo]).vitsMetrics.bPSNR;
+            qreal firstFrameSnr = ldDecodeMetaData[sourceNo]->getFieldVitsMetrics(firstFieldNumber[sourceNo]).bPSNR;
+            qreal secondFrameSnr = ldDecodeMetaData[sourceNo]->getFieldVitsMetrics(secondFieldNumber[sourceNo]).bPSNR;
             sourceFrameQuality[sourceNo] = (firstFrameSnr + secondFrameSnr) / 2.0;
 
             qDebug().nospace() << "CorrectorPool::getInputFrame(): Source #" << sourceNo << " has VBI frame number " << currentVbiFrame <<
@@ -210,16 +235,12 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
         if (firstFieldNumber[sourceNo] != -1 && secondFieldNumber[sourceNo] != -1) {
             // Fetch the input data (get the fields in TBC sequence order to save seeking)
             if (firstFieldNumber[sourceNo] < secondFieldNumber[sourceNo]) {
-                firstFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
-                secondFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
+                firstFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
+                secondFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
             } else {
-                secondFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
-                firstFieldVideoData[sourceNo] = sourceVideos[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
+                secondFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(secondFieldNumber[sourceNo]);
+                firstFieldVideoData[sourceNo] = fieldPrefetchers[sourceNo]->getVideoField(firstFieldNumber[sourceNo]);
             }
-
-            firstFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(firstFieldNumber[sourceNo]);
-            secondFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(secondFieldNumber[sourceNo]);
-            videoParameters[sourceNo] = ldDecodeMetaData[sourceNo]->getVideoParameters();
         }
     }
 
@@ -235,6 +256,17 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
     _reverse = reverse;
     _intraField = intraField;
     _overCorrect = overCorrect;
+    locker.unlock();
+
+    // Fetch the metadata for the fields (which doesn't need the lock, as the
+    // metadata isn't changed while threads are running)
+    for (qint32 sourceNo = 0; sourceNo < numberOfSources; sourceNo++) {
+        if (firstFieldNumber[sourceNo] != -1 && secondFieldNumber[sourceNo] != -1) {
+            firstFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(firstFieldNumber[sourceNo]);
+            secondFieldMetadata[sourceNo] = ldDecodeMetaData[sourceNo]->getField(secondFieldNumber[sourceNo]);
+            videoParameters[sourceNo] = ldDecodeMetaData[sourceNo]->getVideoParameters();
+        }
+    }
 
     return true;
 }
@@ -248,7 +280,7 @@ bool CorrectorPool::getInputFrame(qint32& frameNumber,
 //
 // Returns true on success, false on failure.
 bool CorrectorPool::setOutputFrame(qint32 frameNumber,
-                                   SourceVideo::Data firstTargetFieldData, SourceVideo::Data secondTargetFieldData,
+                                   SourceVideo::Data &&firstTargetFieldData, SourceVideo::Data &&secondTargetFieldData,
                                    qint32 firstFieldSeqNo, qint32 secondFieldSeqNo,
                                    qint32 sameSourceConcealment, qint32 multiSourceConcealment,
                                    qint32 multiSourceCorrection, qint32 totalReplacementDistance)
@@ -257,8 +289,8 @@ bool CorrectorPool::setOutputFrame(qint32 frameNumber,
 
     // Put the output frame into the map
     OutputFrame pendingFrame;
-    pendingFrame.firstTargetFieldData = firstTargetFieldData;
-    pendingFrame.secondTargetFieldData = secondTargetFieldData;
+    pendingFrame.firstTargetFieldData = std::move(firstTargetFieldData);
+    pendingFrame.secondTargetFieldData = std::move(secondTargetFieldData);
     pendingFrame.firstFieldSeqNo = firstFieldSeqNo;
     pendingFrame.secondFieldSeqNo = secondFieldSeqNo;
 
@@ -268,7 +300,7 @@ bool CorrectorPool::setOutputFrame(qint32 frameNumber,
     pendingFrame.multiSourceCorrection = multiSourceCorrection;
     pendingFrame.totalReplacementDistance = totalReplacementDistance;
 
-    pendingOutputFrames[frameNumber] = pendingFrame;
+    pendingOutputFrames[frameNumber] = std::move(pendingFrame);
 
     // Write out as many frames as possible
     while (pendingOutputFrames.contains(outputFrameNumber)) {
@@ -441,8 +473,8 @@ QVector<qint32> CorrectorPool::getAvailableSourcesForFrame(qint32 vbiFrameNumber
             qint32 secondFieldNumber = ldDecodeMetaData[sourceNo]->getSecondFieldNumber(convertVbiFrameNumberToSequential(vbiFrameNumber, sourceNo));
 
             // Ensure the frame is not a padded field (i.e. missing)
-            if (!(ldDecodeMetaData[sourceNo]->getField(firstFieldNumber).pad &&
-                  ldDecodeMetaData[sourceNo]->getField(secondFieldNumber).pad)) {
+            if (!(ldDecodeMetaData[sourceNo]->getFieldPad(firstFieldNumber) &&
+                  ldDecodeMetaData[sourceNo]->getFieldPad(secondFieldNumber))) {
                 availableSourcesForFrame.append(sourceNo);
             }
         }
@@ -32,6 +32,7 @@
 #include <QMutex>
 #include <QThread>
 
+#include "fieldprefetcher.h"
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
 #include "dropoutcorrect.h"
@@ -54,7 +55,7 @@ public:
                        bool& _reverse, bool& _intraField, bool& _overCorrect, QVector<qint32> &availableSourcesForFrame, QVector<qreal> &sourceFrameQuality);
 
     bool setOutputFrame(qint32 frameNumber,
-                        SourceVideo::Data firstTargetFieldData, SourceVideo::Data secondTargetFieldData,
+                        SourceVideo::Data &&firstTargetFieldData, SourceVideo::Data &&secondTargetFieldData,
                         qint32 firstFieldSeqNo, qint32 secondFieldSeqNo,
                         qint32 sameSourceReplacement, qint32 multiSourceReplacement, qint32 multiSourceCorrection, qint32 totalReplacementDistance);
 
@@ -82,6 +83,7 @@ private:
     qint32 lastFrameNumber;
     QVector<LdDecodeMetaData *> &ldDecodeMetaData;
     QVector<SourceVideo *> &sourceVideos;
+    QVector<FieldPrefetcher *> fieldPrefetchers;
 
     // Output stream information (all guarded by outputMutex while threads are running)
     QMutex outputMutex;
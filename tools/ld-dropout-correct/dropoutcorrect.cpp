@@ -72,6 +72,8 @@ void DropOutCorrect::run()
         // Copy the input frames' data to the target frames.
         // We'll use these both as source and target during correction, which
         // is OK because we're careful not to copy data from another dropout.
+        // (The samples are shared with the input until a field is corrected,
+        // so fields without dropouts are never actually copied.)
         QVector<SourceVideo::Data> firstFieldData = firstSourceField;
         QVector<SourceVideo::Data> secondFieldData = secondSourceField;
 
@@ -87,40 +89,47 @@ void DropOutCorrect::run()
                         firstFieldMetadata[0].dropOuts.size() + secondFieldMetadata[0].dropOuts.size() <<
                         " drop-outs";
 
-            // Analyse the drop out locations in the first field
+            // Analyse the drop out locations in the first field, and index them by line
             QVector<QVector<DropOutLocation>> firstFieldDropouts(totalAvailableSources);
+            QVector<DropOutIndex> firstFieldDropoutIndexes(totalAvailableSources);
             for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
                 qint32 currentSource = availableSourcesForFrame[i];
-                if (firstFieldMetadata[currentSource].dropOuts.size() > 0)
+                if (firstFieldMetadata[currentSource].dropOuts.size() > 0) {
                     firstFieldDropouts[currentSource] = setDropOutLocations(populateDropoutsVector(firstFieldMetadata[currentSource], overCorrect));
+                    firstFieldDropoutIndexes[currentSource] = indexDropOutLocations(firstFieldDropouts[currentSource]);
+                }
             }
 
-            // Analyse the drop out locations in the second field
+            // Analyse the drop out locations in the second field, and index them by line
             QVector<QVector<DropOutLocation>> secondFieldDropouts(totalAvailableSources);
+            QVector<DropOutIndex> secondFieldDropoutIndexes(totalAvailableSources);
             for (qint32 i = 0; i < availableSourcesForFrame.size(); i++) {
                 qint32 currentSource = availableSourcesForFrame[i];
-                if (secondFieldMetadata[currentSource].dropOuts.size() > 0)
+                if (secondFieldMetadata[currentSource].dropOuts.size() > 0) {
                     secondFieldDropouts[currentSource] = setDropOutLocations(populateDropoutsVector(secondFieldMetadata[currentSource], overCorrect));
+                    secondFieldDropoutIndexes[currentSource] = indexDropOutLocations(secondFieldDropouts[currentSource]);
+                }
             }
 
             // Correct the first field
-            correctField(firstFieldDropouts, secondFieldDropouts, firstFieldData, secondFieldData, true, intraField, availableSourcesForFrame, sourceFrameQuality,
-                         statistics);
+            correctField(firstFieldDropouts, firstFieldDropoutIndexes, secondFieldDropoutIndexes, firstFieldData, secondFieldData, true, intraField,
+                         availableSourcesForFrame, sourceFrameQuality, statistics);
 
             // Correct the second field
-            correctField(secondFieldDropouts, firstFieldDropouts, secondFieldData, firstFieldData, false, intraField, availableSourcesForFrame, sourceFrameQuality,
-                         statistics);
+            correctField(secondFieldDropouts, secondFieldDropoutIndexes, firstFieldDropoutIndexes, secondFieldData, firstFieldData, false, intraField,
+                         availableSourcesForFrame, sourceFrameQuality, statistics);
         }
 
         // Return the processed fields
-        correctorPool.setOutputFrame(frameNumber, firstFieldData[0], secondFieldData[0], firstFieldSeqNo[0], secondFieldSeqNo[0],
+        correctorPool.setOutputFrame(frameNumber, std::move(firstFieldData[0]), std::move(secondFieldData[0]), firstFieldSeqNo[0], secondFieldSeqNo[0],
                 statistics.sameSourceConcealment, statistics.multiSourceConcealment, statistics.multiSourceCorrection ,statistics.totalReplacementDistance);
     }
 }
 
 // Correct dropouts within one field
 void DropOutCorrect::correctField(const QVector<QVector<DropOutLocation>> &thisFieldDropouts,
-                                  const QVector<QVector<DropOutLocation>> &otherFieldDropouts,
+                                  const QVector<DropOutIndex> &thisFieldDropoutIndexes,
+                                  const QVector<DropOutIndex> &otherFieldDropoutIndexes,
                                   QVector<SourceVideo::Data> &thisFieldData, const QVector<SourceVideo::Data> &otherFieldData,
                                   bool thisFieldIsFirst, bool intraField, const QVector<qint32> &availableSourcesForFrame,
                                   const QVector<qreal> &sourceFrameQuality, Statistics &statistics)
@@ -130,7 +139,7 @@ void DropOutCorrect::correctField(const QVector<QVector<DropOutLocation>> &thisF
 
         // Is the current dropout in the colour burst?
         if (thisFieldDropouts[0][dropoutIndex].location == Location::colourBurst) {
-            replacement = findReplacementLine(thisFieldDropouts, otherFieldDropouts,
+            replacement = findReplacementLine(thisFieldDropouts, thisFieldDropoutIndexes, otherFieldDropoutIndexes,
                                               dropoutIndex, thisFieldIsFirst, true,
                                               true, intraField, availableSourcesForFrame,
                                               sourceFrameQuality);
@@ -139,11 +148,11 @@ void DropOutCorrect::correctField(const QVector<QVector<DropOutLocation>> &thisF
         // Is the current dropout in the visible video line?
         if (thisFieldDropouts[0][dropoutIndex].location == Location::visibleLine) {
             // Find separate replacements for luma and chroma
-            replacement = findReplacementLine(thisFieldDropouts, otherFieldDropouts,
+            replacement = findReplacementLine(thisFieldDropouts, thisFieldDropoutIndexes, otherFieldDropoutIndexes,
                                               dropoutIndex, thisFieldIsFirst, false,
                                               false, intraField, availableSourcesForFrame,
                                               sourceFrameQuality);
-            chromaReplacement = findReplacementLine(thisFieldDropouts, otherFieldDropouts,
+            chromaReplacement = findReplacementLine(thisFieldDropouts, thisFieldDropoutIndexes, otherFieldDropoutIndexes,
                                                     dropoutIndex, thisFieldIsFirst, true,
                                                     false, intraField, availableSourcesForFrame,
                                                     sourceFrameQuality);
@@ -155,7 +164,7 @@ void DropOutCorrect::correctField(const QVector<QVector<DropOutLocation>> &thisF
 }
 
 // Populate the dropouts vector
-QVector<DropOutCorrect::DropOutLocation> DropOutCorrect::populateDropoutsVector(LdDecodeMetaData::Field field, bool overCorrect)
+QVector<DropOutCorrect::DropOutLocation> DropOutCorrect::populateDropoutsVector(const LdDecodeMetaData::Field &field, bool overCorrect)
 {
     QVector<DropOutLocation> fieldDropOuts;
 
@@ -249,11 +258,24 @@ QVector<DropOutCorrect::DropOutLocation> DropOutCorrect::setDropOutLocations(QVe
     return dropOuts;
 }
 
+// Build an index of the drop-out locations by line, for checking whether
+// they overlap other drop-outs
+DropOutIndex DropOutCorrect::indexDropOutLocations(const QVector<DropOutLocation> &dropOuts)
+{
+    DropOuts lineDropOuts(dropOuts.size());
+    for (const DropOutLocation &dropOut : dropOuts) {
+        lineDropOuts.append(dropOut.startx, dropOut.endx, dropOut.fieldLine);
+    }
+
+    return DropOutIndex(lineDropOuts);
+}
+
 // Find a replacement line to take replacement data from.  This method looks both up and down the field
 // for the nearest replacement line that doesn't contain a drop-out itself (to prevent copying bad data
 // over bad data).
 DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QVector<DropOutLocation>> &thisFieldDropouts,
-                                                                const QVector<QVector<DropOutLocation>> &otherFieldDropouts,
+                                                                const QVector<DropOutIndex> &thisFieldDropoutIndexes,
+                                                                const QVector<DropOutIndex> &otherFieldDropoutIndexes,
                                                                 qint32 dropOutIndex, bool thisFieldIsFirst, bool matchChromaPhase,
                                                                 bool isColourBurst, bool intraField,
                                                                 const QVector<qint32> &availableSourcesForFrame,
@@ -320,13 +342,13 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
 
         // Look up the field for a replacement
         findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                     thisFieldDropouts, true, 0, -stepAmount,
+                                     thisFieldDropoutIndexes, true, 0, -stepAmount,
                                      currentSource, sourceFrameQuality,
                                      candidates);
 
         // Look down the field for a replacement
         findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                     thisFieldDropouts, true, stepAmount, stepAmount,
+                                     thisFieldDropoutIndexes, true, stepAmount, stepAmount,
                                      currentSource, sourceFrameQuality,
                                      candidates);
 
@@ -336,13 +358,13 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
 
             // Look up the field for a replacement
             findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                         otherFieldDropouts, false, otherFieldOffset, -stepAmount,
+                                         otherFieldDropoutIndexes, false, otherFieldOffset, -stepAmount,
                                          currentSource, sourceFrameQuality,
                                          candidates);
 
             // Look down the field for a replacement
             findPotentialReplacementLine(thisFieldDropouts, dropOutIndex,
-                                         otherFieldDropouts, false, otherFieldOffset + stepAmount, stepAmount,
+                                         otherFieldDropoutIndexes, false, otherFieldOffset + stepAmount, stepAmount,
                                          currentSource, sourceFrameQuality,
                                          candidates);
         }
@@ -404,7 +426,7 @@ DropOutCorrect::Replacement DropOutCorrect::findReplacementLine(const QVector<QV
 // Given a dropout, scan through a source field for the nearest replacement line that doesn't have overlapping dropouts.
 // Adds a Replacement to candidates if one was found.
 void DropOutCorrect::findPotentialReplacementLine(const QVector<QVector<DropOutLocation>> &targetDropouts, qint32 targetIndex,
-                                                  const QVector<QVector<DropOutLocation>> &sourceDropouts, bool isSameField,
+                                                  const QVector<DropOutIndex> &sourceDropoutIndexes, bool isSameField,
                                                   qint32 sourceOffset, qint32 stepAmount,
                                                   qint32 sourceNo, const QVector<qreal> &sourceFrameQuality,
                                                   QVector<Replacement> &candidates)
@@ -423,18 +445,10 @@ void DropOutCorrect::findPotentialReplacementLine(const QVector<QVector<DropOutL
     while ((sourceLine - 1) >= videoParameters[sourceNo].firstActiveFieldLine
            && (sourceLine - 1) < videoParameters[sourceNo].lastActiveFieldLine) {
         // Is there a dropout that overlaps the one we're trying to replace?
-        bool hasOverlap = false;
-        for (qint32 sourceIndex = 0; sourceIndex < sourceDropouts[sourceNo].size(); sourceIndex++) {
-            if (sourceDropouts[sourceNo][sourceIndex].fieldLine == sourceLine &&
-                (targetDropouts[0][targetIndex].endx - sourceDropouts[sourceNo][sourceIndex].startx) >= 0 &&
-                (sourceDropouts[sourceNo][sourceIndex].endx - targetDropouts[0][targetIndex].startx) >= 0) {
-                // Overlap -- can't use this line
-                sourceLine += stepAmount;
-                hasOverlap = true;
-                break;
-            }
-        }
-        if (!hasOverlap) {
+        if (sourceDropoutIndexes[sourceNo].overlaps(sourceLine, targetDropouts[0][targetIndex].startx, targetDropouts[0][targetIndex].endx)) {
+            // Overlap -- can't use this line
+            sourceLine += stepAmount;
+        } else {
             // No overlaps -- we can use this line
             Replacement replacement;
             replacement.isSameField = isSameField;
@@ -463,10 +477,12 @@ void DropOutCorrect::correctDropOut(const DropOutLocation &dropOut,
         return;
     }
 
-    const quint16 *sourceLine = (replacement.isSameField ? thisFieldData[replacement.sourceNumber].data()
-                                                         : otherFieldData[replacement.sourceNumber].data())
-                                + ((replacement.fieldLine - 1) * videoParameters[0].fieldWidth);
+    // Get the target first, as writing to it may give it a new buffer.
+    // The sources are only read, so use at() to avoid copying them.
     quint16 *targetLine = thisFieldData[0].data() + ((dropOut.fieldLine - 1) * videoParameters[0].fieldWidth);
+    const quint16 *sourceLine = (replacement.isSameField ? thisFieldData.at(replacement.sourceNumber).constData()
+                                                         : otherFieldData.at(replacement.sourceNumber).constData())
+                                + ((replacement.fieldLine - 1) * videoParameters[0].fieldWidth);
 
     // Choose whole signal or just chroma replacement
     // Don't use chroma if the source of the replacement is > 0 and coming from the same line in another source
@@ -505,8 +521,8 @@ void DropOutCorrect::correctDropOut(const DropOutLocation &dropOut,
         }
 
         // Extract HF from chromaReplacement (by extracting LF, then subtracting from the original)
-        const quint16 *chromaLine = (chromaReplacement.isSameField ? thisFieldData[replacement.sourceNumber].data()
-                                                                   : otherFieldData[replacement.sourceNumber].data())
+        const quint16 *chromaLine = (chromaReplacement.isSameField ? thisFieldData.at(replacement.sourceNumber).constData()
+                                                                   : otherFieldData.at(replacement.sourceNumber).constData())
                                     + ((chromaReplacement.fieldLine - 1) * videoParameters[0].fieldWidth);
         for (qint32 pixel = 0; pixel < videoParameters[0].fieldWidth; pixel++) {
             lineBuf[pixel] = chromaLine[pixel];
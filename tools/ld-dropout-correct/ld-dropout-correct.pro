@@ -19,22 +19,32 @@ SOURCES += \
     main.cpp \
     dropoutcorrect.cpp \
     ../library/tbc/filters.cpp \
+    ../library/tbc/fieldprefetcher.cpp \
+    ../library/tbc/jsonio.cpp \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/sourcevideo.cpp \
+    ../library/tbc/videobuffer.cpp \
+    ../library/tbc/videobufferpool.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp \
-    ../library/tbc/dropouts.cpp
+    ../library/tbc/dropouts.cpp \
+    ../library/tbc/dropoutindex.cpp
 
 HEADERS += \
     correctorpool.h \
     dropoutcorrect.h \
     ../library/filter/firfilter.h \
     ../library/tbc/filters.h \
+    ../library/tbc/fieldprefetcher.h \
+    ../library/tbc/jsonio.h \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/sourcevideo.h \
+    ../library/tbc/videobuffer.h \
+    ../library/tbc/videobufferpool.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h \
-    ../library/tbc/dropouts.h
+    ../library/tbc/dropouts.h \
+    ../library/tbc/dropoutindex.h
 
 # Add external includes to the include path
 INCLUDEPATH += ../library/filter
@@ -19,6 +19,7 @@ SOURCES += \
     csv.cpp \
     ffmetadata.cpp \
     main.cpp \
+    ../library/tbc/jsonio.cpp \
     ../library/tbc/lddecodemetadata.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp \
@@ -28,6 +29,7 @@ HEADERS += \
     closedcaptions.h \
     csv.h \
     ffmetadata.h \
+    ../library/tbc/jsonio.h \
     ../library/tbc/lddecodemetadata.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h \
@@ -24,6 +24,8 @@
 
 #include "f3frame.h"
 
+#include <cstring>
+
 // Note: Class for storing 'F3 frames' as defined by clause 18 of ECMA-130
 //
 // Each frame consists of 1 byte of subcode data and 32 bytes of payload
@@ -31,6 +33,35 @@
 // Data is represented as data symbols (the actual payload) and error symbols
 // that flag if a data symbol was detected as invalid during translation from EFM
 
+// Direct lookup table from every 14-bit EFM code to the symbol it represents,
+// generated from efm2numberLUT and the error-correction tables in f3frame.h.
+// This replaces searching the tables for every symbol.
+//
+// Each entry is the 8-bit value for a valid code; the 8-bit value with
+// correctedFlag set for an invalid code that the cosine similarity tables can
+// recover; or -1 for an invalid code that can't be recovered.
+struct EfmDecodeTable {
+    static constexpr qint16 correctedFlag = 0x100;
+
+    EfmDecodeTable() {
+        for (qint32 code = 0; code < 16384; code++) symbols[code] = -1;
+
+        // Where a code appears more than once in a table, the first match wins
+        // (as it did when the tables were searched), so fill in the entries
+        // from the end backwards
+        for (qint32 position = 16383; position >= 0; position--) {
+            symbols[efmerr2positionLUT[position] & 0x3FFF] = correctedFlag | efmerr2valueLUT[position];
+        }
+        for (qint32 value = 255; value >= 0; value--) {
+            symbols[efm2numberLUT[value]] = static_cast<qint16>(value);
+        }
+    }
+
+    qint16 symbols[16384];
+};
+
+static const EfmDecodeTable efmDecodeTable;
+
 F3Frame::F3Frame()
 {
     validEfmSymbols = 0;
@@ -74,39 +105,19 @@ void F3Frame::setTValues(uchar* tValuesIn, qint32 tLength)
 
     // Convert the T values into a bit stream
     // Should produce 588 channel bits which is 73.5 bytes of data
+    // Each T value is a 1 bit followed by T-1 0 bits, so only the 1 bits need
+    // to be set. Anything past 74 bytes (due to errors in the T values) is
+    // ignored to prevent crashes.
     uchar rawFrameData[75];
-    qint32 bitPosition = 7;
-    qint32 bytePosition = 0;
-    uchar byteData = 0;
-
-    bool finished = false;
-    for (qint32 tPosition = 0; tPosition < tLength; tPosition++) {
-        uchar tValuesIn_tPosition = tValuesIn[tPosition];
-        for (qint32 bitCount = 0; bitCount < tValuesIn_tPosition; bitCount++) {
-            if (bitCount == 0) byteData |= (1 << bitPosition);
-            bitPosition--;
-
-            if (bitPosition < 0) {
-                rawFrameData[bytePosition] = byteData;
-                byteData = 0;
-                bitPosition = 7;
-                bytePosition++;
-
-                // Check for overflow (due to errors in the T values) and stop processing to prevent crashes
-                if (bytePosition > 73) {
-                    finished = true;
-                    break;
-                }
-            }
-
-            if (finished) break;
-        }
+    memset(rawFrameData, 0, sizeof(rawFrameData));
 
-        if (finished) break;
-    }
+    qint32 bitPosition = 0;
+    for (qint32 tPosition = 0; tPosition < tLength && bitPosition < 74 * 8; tPosition++) {
+        if (tValuesIn[tPosition] == 0) continue;
 
-    // Add in the last nybble to get from 73.5 to 74 bytes
-    if (bytePosition < 74) rawFrameData[bytePosition] = byteData;
+        rawFrameData[bitPosition / 8] |= static_cast<uchar>(0x80 >> (bitPosition % 8));
+        bitPosition += tValuesIn[tPosition];
+    }
 
     // Step 2:
 
@@ -219,57 +230,32 @@ bool F3Frame::isSubcodeSync1()
 // Returns -1 if the EFM value is could not be converted
 qint16 F3Frame::translateEfm(qint16 efmValue)
 {
-    qint16 result = -1;
-    qint16 lutPos = 0;
-    while (result == -1 && lutPos < 256) {
-        if (efm2numberLUT[lutPos] == efmValue) result = lutPos;
-        lutPos++;
-    }
+    const qint16 entry = efmDecodeTable.symbols[efmValue & 0x3FFF];
 
-    // Was 14-bit EFM symbol invalid?
-    if (result == -1) {
-        // Symbol was invalid
+    if (entry == -1) {
+        // Symbol was invalid, and couldn't be recovered
         invalidEfmSymbols++;
-
-        // Attempt to recover symbol using cosine similarity lookup
-        result = -1;
-        lutPos = 0;
-        while (result == -1 && lutPos < 16384) {
-            if (efmerr2positionLUT[lutPos] == efmValue) result = lutPos;
-            lutPos++;
-        }
-
-        // Was lookup successful?
-        if (result != -1) {
-            // Get the translated value from the second LUT
-            result = efmerr2valueLUT[result];
-            correctedEfmSymbols++;
-        }
+        return -1;
+    } else if ((entry & EfmDecodeTable::correctedFlag) != 0) {
+        // Symbol was invalid, but was recovered using the cosine similarity lookup
+        invalidEfmSymbols++;
+        correctedEfmSymbols++;
+        return entry & 0xFF;
     } else {
         // Symbol was valid
         validEfmSymbols++;
+        return entry;
     }
-
-    return result;
 }
 
 // Method to get 'width' bits (max 15) from a byte array starting from bit 'bitIndex'
 inline qint16 F3Frame::getBits(uchar *rawData, qint16 bitIndex, qint16 width)
 {
+    // Load the three bytes containing the value, and extract it
     qint16 byteIndex = bitIndex / 8;
-    qint16 bitInByteIndex = 7 - (bitIndex % 8);
+    quint32 window = (static_cast<quint32>(rawData[byteIndex]) << 16)
+                     | (static_cast<quint32>(rawData[byteIndex + 1]) << 8)
+                     | static_cast<quint32>(rawData[byteIndex + 2]);
 
-    qint16 result = 0;
-    for (qint16 nBits = width - 1; nBits > -1; nBits--) {
-        if (rawData[byteIndex] & (1 << bitInByteIndex)) result += (1 << nBits);
-
-        bitInByteIndex--;
-        if (bitInByteIndex < 0) {
-            bitInByteIndex = 7;
-            byteIndex++;
-        }
-    }
-
-    return result;
+    return static_cast<qint16>((window >> (24 - (bitIndex % 8) - width)) & ((1u << width) - 1));
 }
-
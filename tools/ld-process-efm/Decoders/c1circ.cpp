@@ -158,28 +158,22 @@ void C1Circ::errorCorrect()
 {
     // The C1 error correction can correct, at most, 2 symbols
 
-    // Convert the data and errors into the form expected by the ezpwd library
-    std::vector<uint8_t> data;
-    std::vector<int> erasures;
-    data.resize(32);
+    // Copy the data and find the positions of the erasures
+    uchar data[32];
+    qint32 erasures[32];
+    qint32 numErasures = 0;
 
     for (qint32 byteC = 0; byteC < 32; byteC++) {
-        data[static_cast<size_t>(byteC)] = static_cast<uchar>(interleavedC1Data[byteC]);
-        if (interleavedC1Errors[byteC] == static_cast<char>(1)) erasures.push_back(byteC);
+        data[byteC] = interleavedC1Data[byteC];
+        if (interleavedC1Errors[byteC] == static_cast<char>(1)) erasures[numErasures++] = byteC;
     }
 
     // Perform error check and correction
-    int fixed = -1;
+    qint32 fixed = -1;
 
-    if (erasures.size() <= 2) {
-        // Perform error check and correction
-
-        // Initialise the error corrector
-        C1RS<255,255-4> rs; // Up to 251 symbols data load with 4 symbols parity RS(32,28)
-
-        // Perform decode
-        std::vector<int> position;
-        fixed = rs.decode(data, erasures, &position);
+    if (numErasures <= 2) {
+        // Perform decode (RS(32,28) with 4 symbols parity)
+        fixed = CircReedSolomon::decode(data, erasures, numErasures);
 
         // If there were more than 2 symbols in error, mark the C1 as an erasure
         if (fixed > 2) fixed = -1;
@@ -187,7 +181,7 @@ void C1Circ::errorCorrect()
         if (fixed >= 0) {
             // Copy the result back to the output byte array (removing the parity symbols)
             for (qint32 byteC = 0; byteC < 28; byteC++) {
-                outputC1Data[byteC] = static_cast<uchar>(data[static_cast<size_t>(byteC)]);
+                outputC1Data[byteC] = data[byteC];
                 if (fixed < 0) outputC1Errors[byteC] = 1; else outputC1Errors[byteC] = 0;
             }
         } else {
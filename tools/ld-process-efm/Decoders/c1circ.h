@@ -28,12 +28,7 @@
 #include <QCoreApplication>
 #include <QDebug>
 
-#include <ezpwd/rs_base>
-#include <ezpwd/rs>
-
-// CD-ROM specific CIRC configuration for Reed-Solomon forward error correction
-template < size_t SYMBOLS, size_t PAYLOAD > struct C1RS;
-template < size_t PAYLOAD > struct C1RS<255, PAYLOAD> : public __RS(C1RS, uint8_t, 255, PAYLOAD, 0x11d, 0,  1);
+#include "circreedsolomon.h"
 
 #include "Datatypes/f3frame.h"
 
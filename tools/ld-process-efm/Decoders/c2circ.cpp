@@ -134,28 +134,24 @@ void C2Circ::errorCorrect()
 {
     // The C2 error correction can correct, at most, 4 symbols
 
-    // Convert the data and errors into the form expected by the ezpwd library
-    std::vector<uint8_t> data;
-    std::vector<int> erasures;
-    data.resize(32);
+    // Copy the data (padded to 32 symbols with zeros) and find the positions
+    // of the erasures
+    uchar data[32];
+    qint32 erasures[28];
+    qint32 numErasures = 0;
 
     for (qint32 byteC = 0; byteC < 28; byteC++) {
-        data[static_cast<size_t>(byteC)] = static_cast<uchar>(interleavedC2Data[byteC]);
-        if (interleavedC2Errors[byteC] != static_cast<char>(0)) erasures.push_back(byteC);
+        data[byteC] = interleavedC2Data[byteC];
+        if (interleavedC2Errors[byteC] != static_cast<char>(0)) erasures[numErasures++] = byteC;
     }
+    for (qint32 byteC = 28; byteC < 32; byteC++) data[byteC] = 0;
 
     // Perform error check and correction
-    int fixed = -1;
+    qint32 fixed = -1;
 
-    if (erasures.size() <= 4 ) {
-        // Perform error check and correction
-
-        // Initialise the error corrector
-        C2RS<255,255-4> rs; // Up to 251 symbols data load with 4 symbols parity RS(32,28)
-
-        // Perform decode
-        std::vector<int> position;
-        fixed = rs.decode(data, erasures, &position);
+    if (numErasures <= 4) {
+        // Perform decode (RS(32,28) with 4 symbols parity)
+        fixed = CircReedSolomon::decode(data, erasures, numErasures);
 
         // If there were more than 3 symbols in error, mark the C2 as an erasure
         if (fixed > 3) fixed = -1;
@@ -163,7 +159,7 @@ void C2Circ::errorCorrect()
         if (fixed >= 0) {
             // Copy the result back to the output byte array (removing the parity symbols)
             for (qint32 byteC = 0; byteC < 28; byteC++) {
-                outputC2Data[byteC] = static_cast<uchar>(data[static_cast<size_t>(byteC)]);
+                outputC2Data[byteC] = data[byteC];
                 if (fixed < 0) outputC2Errors[byteC] = 1; else outputC2Errors[byteC] = 0;
             }
         } else {
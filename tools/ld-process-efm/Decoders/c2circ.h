@@ -28,12 +28,7 @@
 #include <QCoreApplication>
 #include <QDebug>
 
-#include <ezpwd/rs_base>
-#include <ezpwd/rs>
-
-// CD-ROM specific CIRC configuration for Reed-Solomon forward error correction
-template < size_t SYMBOLS, size_t PAYLOAD > struct C2RS;
-template < size_t PAYLOAD > struct C2RS<255, PAYLOAD> : public __RS(C2RS, uint8_t, 255, PAYLOAD, 0x11d, 0,  1);
+#include "circreedsolomon.h"
 
 class C2Circ
 {
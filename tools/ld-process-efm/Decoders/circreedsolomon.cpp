@@ -0,0 +1,240 @@
+/************************************************************************
+
+    circreedsolomon.cpp
+
+    ld-process-efm - EFM data decoder
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "circreedsolomon.h"
+
+#include <algorithm>
+
+// Code parameters
+static constexpr qint32 NN = 255;          // Symbols in a full-length codeword
+static constexpr qint32 NROOTS = 4;        // Parity symbols
+static constexpr qint32 WORD_LENGTH = 32;  // Symbols in a (shortened) CIRC word
+static constexpr qint32 PAD = NN - WORD_LENGTH; // Unused symbols before the word
+static constexpr qint32 A0 = NN;           // Log of zero
+
+// Galois field and syndrome lookup tables
+struct CircReedSolomonTables {
+    CircReedSolomonTables() {
+        // Generate the field from the polynomial x^8 + x^4 + x^3 + x^2 + 1
+        qint32 sr = 1;
+        for (qint32 i = 0; i < NN; i++) {
+            exp[i] = static_cast<uchar>(sr);
+            log[sr] = static_cast<uchar>(i);
+            sr <<= 1;
+            if (sr & 0x100) sr ^= 0x11D;
+        }
+        exp[A0] = 0;
+        log[0] = A0;
+
+        // For each position in the word and each symbol value, the
+        // contribution to the four syndromes, packed into one word. Syndrome i
+        // is the word evaluated at alpha^i.
+        for (qint32 position = 0; position < WORD_LENGTH; position++) {
+            syndromes[position][0] = 0;
+            for (qint32 value = 1; value < 256; value++) {
+                quint32 packed = 0;
+                for (qint32 i = 0; i < NROOTS; i++) {
+                    const qint32 power = i * (WORD_LENGTH - 1 - position);
+                    packed |= static_cast<quint32>(exp[modnn(log[value] + power)]) << (8 * i);
+                }
+                syndromes[position][value] = packed;
+            }
+        }
+    }
+
+    static qint32 modnn(qint32 x) {
+        return x % NN;
+    }
+
+    uchar exp[NN + 1];
+    uchar log[256];
+    quint32 syndromes[WORD_LENGTH][256];
+};
+
+static const CircReedSolomonTables tables;
+
+// Public methods -----------------------------------------------------------------------------------------------------
+
+qint32 CircReedSolomon::decode(uchar *word, const qint32 *erasures, qint32 numErasures)
+{
+    quint32 syndromes = 0;
+    for (qint32 position = 0; position < WORD_LENGTH; position++) {
+        syndromes ^= tables.syndromes[position][word[position]];
+    }
+
+    // If the syndromes are zero, word is a codeword and there are no errors
+    // to correct (even if some symbols were marked as erasures)
+    if (syndromes == 0) return 0;
+
+    return correct(word, syndromes, erasures, numErasures);
+}
+
+// Private methods ----------------------------------------------------------------------------------------------------
+
+// Find and correct the errors in a word with non-zero syndromes.
+//
+// This is the decoder from ezpwd's reed_solomon::decode (itself based on Phil
+// Karn's), specialised for this code; the structure and the edge cases are
+// kept the same, so that it reports exactly the same results.
+qint32 CircReedSolomon::correct(uchar *word, quint32 syndromes, const qint32 *erasures, qint32 numErasures)
+{
+    const uchar *exp = tables.exp;
+    const uchar *log = tables.log;
+    auto modnn = CircReedSolomonTables::modnn;
+
+    // Convert the syndromes to index form
+    uchar syn[NROOTS];
+    for (qint32 i = 0; i < NROOTS; i++) {
+        syn[i] = log[(syndromes >> (8 * i)) & 0xFF];
+    }
+
+    uchar lambda[NROOTS + 1] = {1, 0, 0, 0, 0};
+    uchar b[NROOTS + 1];
+    uchar t[NROOTS + 1];
+    uchar omega[NROOTS + 1];
+    uchar reg[NROOTS + 1];
+    qint32 root[NROOTS];
+    qint32 loc[NROOTS];
+
+    if (numErasures > 0) {
+        // Initialise lambda to be the erasure locator polynomial
+        lambda[1] = exp[modnn(NN - 1 - (erasures[0] + PAD))];
+        for (qint32 i = 1; i < numErasures; i++) {
+            const qint32 u = modnn(NN - 1 - (erasures[i] + PAD));
+            for (qint32 j = i + 1; j > 0; j--) {
+                const qint32 tmp = log[lambda[j - 1]];
+                if (tmp != A0) lambda[j] ^= exp[modnn(u + tmp)];
+            }
+        }
+    }
+
+    for (qint32 i = 0; i < NROOTS + 1; i++) b[i] = log[lambda[i]];
+
+    // Berlekamp-Massey algorithm to determine the error+erasure locator polynomial
+    qint32 r = numErasures;
+    qint32 el = numErasures;
+    while (++r <= NROOTS) {
+        // Compute the discrepancy at the r-th step in poly-form
+        uchar discrR = 0;
+        for (qint32 i = 0; i < r; i++) {
+            if (lambda[i] != 0 && syn[r - i - 1] != A0) {
+                discrR ^= exp[modnn(log[lambda[i]] + syn[r - i - 1])];
+            }
+        }
+        discrR = log[discrR];
+
+        if (discrR == A0) {
+            // B(x) <-- x*B(x)
+            std::rotate(b, b + NROOTS, b + NROOTS + 1);
+            b[0] = A0;
+        } else {
+            // T(x) <-- lambda(x) - discrR*x*B(x)
+            t[0] = lambda[0];
+            for (qint32 i = 0; i < NROOTS; i++) {
+                if (b[i] != A0) t[i + 1] = lambda[i + 1] ^ exp[modnn(discrR + b[i])];
+                else t[i + 1] = lambda[i + 1];
+            }
+
+            if (2 * el <= r + numErasures - 1) {
+                el = r + numErasures - el;
+
+                // B(x) <-- inv(discrR) * lambda(x)
+                for (qint32 i = 0; i <= NROOTS; i++) {
+                    b[i] = (lambda[i] == 0) ? A0 : static_cast<uchar>(modnn(log[lambda[i]] - discrR + NN));
+                }
+            } else {
+                // B(x) <-- x*B(x)
+                std::rotate(b, b + NROOTS, b + NROOTS + 1);
+                b[0] = A0;
+            }
+
+            std::copy(t, t + NROOTS + 1, lambda);
+        }
+    }
+
+    // Convert lambda to index form and compute deg(lambda(x))
+    qint32 degLambda = 0;
+    for (qint32 i = 0; i < NROOTS + 1; i++) {
+        lambda[i] = log[lambda[i]];
+        if (lambda[i] != A0) degLambda = i;
+    }
+
+    // Find the roots of the error+erasure locator polynomial by Chien search
+    std::copy(lambda, lambda + NROOTS + 1, reg);
+    qint32 count = 0;
+    for (qint32 i = 1; i <= NN; i++) {
+        uchar q = 1;
+        for (qint32 j = degLambda; j > 0; j--) {
+            if (reg[j] != A0) {
+                reg[j] = static_cast<uchar>(modnn(reg[j] + j));
+                q ^= exp[reg[j]];
+            }
+        }
+        if (q != 0) continue;
+
+        // Store the root (index-form) and error location number
+        root[count] = i;
+        loc[count] = i - 1;
+        if (++count == degLambda) break;
+    }
+
+    // If deg(lambda) is not equal to the number of roots, the errors can't be corrected
+    if (degLambda != count) return -1;
+
+    // Compute the error+erasure evaluator polynomial omega(x) = s(x)*lambda(x)
+    // (modulo x**NROOTS) in index form
+    const qint32 degOmega = degLambda - 1;
+    for (qint32 i = 0; i <= degOmega; i++) {
+        uchar tmp = 0;
+        for (qint32 j = i; j >= 0; j--) {
+            if (syn[i - j] != A0 && lambda[j] != A0) tmp ^= exp[modnn(syn[i - j] + lambda[j])];
+        }
+        omega[i] = log[tmp];
+    }
+
+    // Compute the error values in poly-form, and apply them to the word
+    for (qint32 j = count - 1; j >= 0; j--) {
+        uchar num1 = 0;
+        for (qint32 i = degOmega; i >= 0; i--) {
+            if (omega[i] != A0) num1 ^= exp[modnn(omega[i] + i * root[j])];
+        }
+        const uchar num2 = exp[modnn(NN - root[j])];
+        uchar den = 0;
+
+        // lambda[i+1] for i even is the formal derivative lambda_pr of lambda[i]
+        for (qint32 i = std::min(degLambda, NROOTS - 1) & ~1; i >= 0; i -= 2) {
+            if (lambda[i + 1] != A0) den ^= exp[modnn(lambda[i + 1] + i * root[j])];
+        }
+
+        if (num1 != 0) {
+            // An error location in the unused part of the codeword means the
+            // decode has failed
+            if (loc[j] < PAD) return -1;
+
+            word[loc[j] - PAD] ^= exp[modnn(log[num1] + log[num2] + NN - log[den])];
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,56 @@
+/************************************************************************
+
+    circreedsolomon.h
+
+    ld-process-efm - EFM data decoder
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef CIRCREEDSOLOMON_H
+#define CIRCREEDSOLOMON_H
+
+#include <QtGlobal>
+
+// Reed-Solomon decoder for the CIRC C1 and C2 codes.
+//
+// Both codes are handled as 32-symbol words (28 data symbols followed by 4
+// parity symbols) of the RS(255,251) code over GF(2^8) with polynomial 0x11D,
+// first consecutive root 0 and primitive element 1 -- the same code that
+// C1Circ and C2Circ previously decoded using ezpwd's C1RS/C2RS.
+//
+// The syndromes are computed using a lookup table for each symbol position.
+// Most words are valid, giving zero syndromes, so they need no further work;
+// only words with errors go through the full Berlekamp-Massey decode, which
+// follows ezpwd's implementation step for step so that the results are
+// identical.
+class CircReedSolomon
+{
+public:
+    // Check and correct word (32 symbols) in place. erasures gives the
+    // positions of numErasures symbols known to be invalid (at most 4).
+    //
+    // Returns the number of symbols corrected, or -1 if the word could not be
+    // corrected (in which case word may have been partly modified).
+    static qint32 decode(uchar *word, const qint32 *erasures, qint32 numErasures);
+
+private:
+    static qint32 correct(uchar *word, quint32 syndromes, const qint32 *erasures, qint32 numErasures);
+};
+
+#endif // CIRCREEDSOLOMON_H
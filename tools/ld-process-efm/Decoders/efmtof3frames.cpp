@@ -24,6 +24,8 @@
 
 #include "efmtof3frames.h"
 
+#include <cstring>
+
 EfmToF3Frames::EfmToF3Frames()
 {
     debugOn = false;    
@@ -40,7 +42,14 @@ QVector<F3Frame> EfmToF3Frames::process(QByteArray efmDataIn, bool debugState)
     // Clear the output buffer
     f3FramesOut.clear();
 
-    // Append input data to the processing buffer
+    // Discard the T-values consumed by the previous call, and append the input
+    // data to the processing buffer. The state machine consumes T-values by
+    // advancing efmDataPosition, so the unused remainder of the buffer is only
+    // moved once per call rather than once per frame.
+    if (efmDataPosition > 0) {
+        efmDataBuffer.remove(0, efmDataPosition);
+        efmDataPosition = 0;
+    }
     efmDataBuffer.append(efmDataIn);
 
     waitingForData = false;
@@ -114,6 +123,7 @@ void EfmToF3Frames::reset(void)
 
     // Initialise the state-machine
     efmDataBuffer.clear();
+    efmDataPosition = 0;
     currentState = state_initial;
     nextState = currentState;
     waitingForData = false;
@@ -143,6 +153,26 @@ void EfmToF3Frames::clearStatistics()
     statistics.outOfRangeTValues = 0;
 }
 
+// Find the next T11+T11 sync pattern in the unconsumed EFM data, starting at
+// the given offset. Returns the offset of the first T11, or -1 if not found.
+qint32 EfmToF3Frames::findSync(qint32 from) const
+{
+    const char *efmData = efmDataBuffer.constData() + efmDataPosition;
+    const char *last = efmDataBuffer.constData() + efmDataBuffer.size() - 1;
+
+    // Use memchr to skip quickly over values that can't start a sync, then
+    // check the value following each T11 found
+    const char *candidate = efmData + from;
+    while (candidate < last) {
+        candidate = static_cast<const char *>(memchr(candidate, 11, static_cast<size_t>(last - candidate)));
+        if (candidate == nullptr) break;
+        if (candidate[1] == static_cast<char>(11)) return static_cast<qint32>(candidate - efmData);
+        candidate++;
+    }
+
+    return -1;
+}
+
 // Processing state machine methods -----------------------------------------------------------------------------------
 
 // Initial state machine state
@@ -158,20 +188,14 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findInitialSyncStage1()
     if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findInitialSyncStage1(): Called";
 
     // Find the first T11+T11 sync pattern in the EFM buffer
-    qint32 startSyncTransition = -1;
-
-    for (qint32 i = 0; i < efmDataBuffer.size() - 1; i++) {
-        if (efmDataBuffer[i] == static_cast<char>(11) && efmDataBuffer[i + 1] == static_cast<char>(11)) {
-            startSyncTransition = i;
-            break;
-        }
-    }
+    const qint32 efmDataSize = efmDataBuffer.size() - efmDataPosition;
+    qint32 startSyncTransition = findSync(0);
 
     if (startSyncTransition == -1) {
-        if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findInitialSyncStage1(): No initial F3 sync found in EFM buffer - discarding" << efmDataBuffer.size() - 1 << "EFM values";
+        if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findInitialSyncStage1(): No initial F3 sync found in EFM buffer - discarding" << efmDataSize - 1 << "EFM values";
 
         // Discard the EFM already tested and try again
-        efmDataBuffer.remove(0, efmDataBuffer.size() - 1);
+        if (efmDataSize > 1) efmDataPosition += efmDataSize - 1;
 
         waitingForData = true;
         return state_findInitialSyncStage1;
@@ -180,7 +204,7 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findInitialSyncStage1()
     if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findInitialSyncStage1(): Initial F3 sync found at buffer position" << startSyncTransition << "- discarding" << startSyncTransition << "EFM values";
 
     // Discard all EFM data up to the sync start
-    efmDataBuffer.remove(0, startSyncTransition);
+    efmDataPosition += startSyncTransition;
 
     // Move to find initial sync stage 2
     return state_findInitialSyncStage2;
@@ -197,12 +221,14 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findInitialSyncStage2()
 
     qint32 searchLength = 588 * 4;
 
-    for (qint32 i = 1; i < efmDataBuffer.size() - 1; i++) {
-        if (efmDataBuffer[i] == static_cast<char>(11) && efmDataBuffer[i + 1] == static_cast<char>(11)) {
+    const char *efmData = efmDataBuffer.constData() + efmDataPosition;
+    const qint32 efmDataSize = efmDataBuffer.size() - efmDataPosition;
+    for (qint32 i = 1; i < efmDataSize - 1; i++) {
+        if (efmData[i] == static_cast<char>(11) && efmData[i + 1] == static_cast<char>(11)) {
             endSyncTransition = i;
             break;
         }
-        tTotal += efmDataBuffer[i];
+        tTotal += efmData[i];
 
         // If we are more than a few F3 frame lengths out, give up
         if (tTotal > searchLength) {
@@ -214,7 +240,7 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findInitialSyncStage2()
     if (tTotal > searchLength) {
         if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findInitialSyncStage2(): No second F3 sync found within a reasonable length, going back to look for new initial sync.  T =" << tTotal;
         if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findInitialSyncStage2(): Discarding" << endSyncTransition << "EFM values";
-        efmDataBuffer.remove(0, endSyncTransition);
+        efmDataPosition += endSyncTransition;
         return state_findInitialSyncStage1;
     }
 
@@ -227,7 +253,7 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findInitialSyncStage2()
     if (tTotal < 587 || tTotal > 589) {
         // Discard the transitions already tested and try again
         if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findInitialSyncStage2(): Discarding" << endSyncTransition << "EFM values";
-        efmDataBuffer.remove(0, endSyncTransition);
+        efmDataPosition += endSyncTransition;
         return state_findInitialSyncStage2;
     }
 
@@ -243,10 +269,12 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findSecondSync()
     //if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findSecondSync(): Called";
 
     // Get at least 588 bits of data
+    const char *efmData = efmDataBuffer.constData() + efmDataPosition;
+    const qint32 efmDataSize = efmDataBuffer.size() - efmDataPosition;
     qint32 i = 0;
     qint32 tTotal = 0;
-    while (i < efmDataBuffer.size() && tTotal < 588) {
-        tTotal += efmDataBuffer[i];
+    while (i < efmDataSize && tTotal < 588) {
+        tTotal += efmData[i];
         i++;
     }
 
@@ -258,7 +286,7 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findSecondSync()
     }
 
     // Do we have enough data to verify the sync position?
-    if ((efmDataBuffer.size() - i) < 2) {
+    if ((efmDataSize - i) < 2) {
         // Indicate that more deltas are required and stay in this state
         waitingForData = true;
         return state_findSecondSync;
@@ -273,15 +301,15 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findSecondSync()
         sequentialGoodSyncCounter++;
     } else {
         // Handle various possible sync issues in a (hopefully) smart way
-        if (efmDataBuffer[i] == static_cast<char>(11) && efmDataBuffer[i + 1] == static_cast<char>(11)) {
+        if (efmData[i] == static_cast<char>(11) && efmData[i + 1] == static_cast<char>(11)) {
             if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findSecondSync(): F3 Sync is in the right position and is valid - frame contains invalid T value";
             endSyncTransition = i;
             statistics.validSyncs++;
-        } else if (efmDataBuffer[i - 1] == static_cast<char>(11) && efmDataBuffer[i] == static_cast<char>(11)) {
+        } else if (efmData[i - 1] == static_cast<char>(11) && efmData[i] == static_cast<char>(11)) {
             if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findSecondSync(): F3 Sync valid, but off by one transition backwards";
             endSyncTransition = i - 1;
             statistics.undershootSyncs++;
-        } else if (efmDataBuffer[i - 1] >= static_cast<char>(10) && efmDataBuffer[i] >= static_cast<char>(10)) {
+        } else if (efmData[i - 1] >= static_cast<char>(10) && efmData[i] >= static_cast<char>(10)) {
             if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findSecondSync(): F3 Sync value low and off by one transition backwards";
             endSyncTransition = i - 1;
             statistics.undershootSyncs++;
@@ -298,11 +326,11 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_findSecondSync()
                     if (tTotal > 588) endSyncTransition = i - 1; else endSyncTransition = i;
                     sequentialBadSyncCounter++;
                     if (tTotal > 588) statistics.overshootSyncs++; else statistics.undershootSyncs++;
-            } else if (efmDataBuffer[i] == static_cast<char>(11) && efmDataBuffer[i + 1] == static_cast<char>(11)) {
+            } else if (efmData[i] == static_cast<char>(11) && efmData[i + 1] == static_cast<char>(11)) {
                 if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findSecondSync(): F3 Sync valid, but off by one transition forward";
                 endSyncTransition = i;
                 statistics.overshootSyncs++;
-            } else if (efmDataBuffer[i] >= static_cast<char>(10) && efmDataBuffer[i + 1] >= static_cast<char>(10)) {
+            } else if (efmData[i] >= static_cast<char>(10) && efmData[i + 1] >= static_cast<char>(10)) {
                 if (debugOn) qDebug() << "EfmToF3Frames::sm_state_findSecondSync(): F3 Sync value low and off by one transition forward";
                 endSyncTransition = i;
                 statistics.overshootSyncs++;
@@ -363,8 +391,9 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_processFrame()
         tLength = 189;
         qDebug() << "EfmToF3Frames::sm_state_processFrame(): Number of T-values in frame exceeded 189!";
     }
+    const char *efmData = efmDataBuffer.constData() + efmDataPosition;
     for (qint32 delta = 0; delta < tLength; delta++) {
-        uchar value = static_cast<uchar>(efmDataBuffer[delta]);
+        uchar value = static_cast<uchar>(efmData[delta]);
 
         if (value < 3 || value > 11) statistics.outOfRangeTValues++;
         else statistics.inRangeTValues++;
@@ -389,7 +418,7 @@ EfmToF3Frames::StateMachine EfmToF3Frames::sm_state_processFrame()
     statistics.correctedEfmSymbols += f3FramesOut.last().getNumberOfCorrectedEfmSymbols();
 
     // Discard all transitions up to the sync end
-    efmDataBuffer.remove(0, endSyncTransition);
+    efmDataPosition += endSyncTransition;
 
     // Find the next sync position
     return state_findSecondSync;
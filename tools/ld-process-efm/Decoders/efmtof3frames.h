@@ -63,6 +63,7 @@ private:
     bool debugOn;
     Statistics statistics;
     QByteArray efmDataBuffer;
+    qint32 efmDataPosition;
     QVector<F3Frame> f3FramesOut;
 
     // State machine state definitions
@@ -84,6 +85,7 @@ private:
     qint32 endSyncTransition;
 
     void clearStatistics();
+    qint32 findSync(qint32 from) const;
 
     StateMachine sm_state_initial();
     StateMachine sm_state_findInitialSyncStage1();
@@ -0,0 +1,259 @@
+/************************************************************************
+
+    efmpipeline.cpp
+
+    ld-process-efm-cli - EFM data decoder (command-line version)
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "efmpipeline.h"
+
+#include <QElapsedTimer>
+
+EfmPipeline::EfmPipeline(const Configuration &_config)
+    : config(_config), inputFile(nullptr), audioOutputFile(nullptr), dataOutputFile(nullptr), abort(false),
+      initialF3Queue(_config.queueSize), syncedF3Queue(_config.queueSize),
+      f2Queue(_config.queueSize), f1Queue(_config.queueSize), totalMilliseconds(0)
+{
+}
+
+bool EfmPipeline::process(QFile *_inputFile, QFile *_audioOutputFile, QFile *_dataOutputFile)
+{
+    inputFile = _inputFile;
+    audioOutputFile = _audioOutputFile;
+    dataOutputFile = _dataOutputFile;
+    abort = false;
+
+    QElapsedTimer totalTimer;
+    totalTimer.start();
+
+    // Start one thread per stage, and wait for them all to finish
+    QVector<StageThread *> threads;
+    threads.append(new StageThread(*this, &EfmPipeline::runEfmToF3Frames));
+    threads.append(new StageThread(*this, &EfmPipeline::runSyncF3Frames));
+    threads.append(new StageThread(*this, &EfmPipeline::runF3ToF2Frames));
+    threads.append(new StageThread(*this, &EfmPipeline::runF2ToF1Frames));
+    threads.append(new StageThread(*this, &EfmPipeline::runOutput));
+
+    for (StageThread *thread : threads) {
+        thread->start();
+    }
+    for (StageThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    totalMilliseconds = totalTimer.elapsed();
+
+    return !abort;
+}
+
+// Method to report decoding statistics to qInfo
+void EfmPipeline::reportStatistics()
+{
+    efmToF3Frames.reportStatistics();
+    syncF3Frames.reportStatistics();
+    f3ToF2Frames.reportStatistics();
+    f2ToF1Frames.reportStatistics();
+    if (audioOutputFile != nullptr) f1ToAudio.reportStatistics();
+    if (dataOutputFile != nullptr) f1ToData.reportStatistics();
+
+    qInfo() << "";
+    qInfo() << "Pipeline stages:";
+    reportStage("EFM to F3 frames", efmToF3Stats, "T-values", "F3 frames");
+    reportStage("Sync F3 frames", syncF3Stats, "F3 frames", "F3 frames");
+    reportStage("F3 to F2 frames", f3ToF2Stats, "F3 frames", "F2 frames");
+    reportStage("F2 to F1 frames", f2ToF1Stats, "F2 frames", "F1 frames");
+    reportStage("F1 to output", outputStats, "F1 frames", "bytes");
+
+    qInfo() << "";
+    qInfo() << "Pipeline queues (batches):";
+    reportQueue("EFM to F3 -> Sync F3", initialF3Queue);
+    reportQueue("Sync F3 -> F3 to F2", syncedF3Queue);
+    reportQueue("F3 to F2 -> F2 to F1", f2Queue);
+    reportQueue("F2 to F1 -> F1 to output", f1Queue);
+
+    qInfo() << "";
+    qInfo().nospace() << "Total decoding time: " << totalMilliseconds << " ms";
+}
+
+// Stage methods ------------------------------------------------------------------------------------------------------
+
+// Read the input file, and convert the T-values into F3 frames
+void EfmPipeline::runEfmToF3Frames()
+{
+    const qint64 inputFileSize = inputFile->size();
+    qint32 lastPercent = 0;
+
+    // Read EFM data in 256K blocks
+    QByteArray inputEfmBuffer;
+    inputEfmBuffer.resize(1024 * 256);
+
+    QElapsedTimer timer;
+    while (!abort) {
+        const qint64 bytesRead = inputFile->read(inputEfmBuffer.data(), inputEfmBuffer.size());
+        if (bytesRead < 0) {
+            qCritical() << "Could not read from input EFM file:" << inputFile->errorString();
+            abortPipeline();
+            break;
+        }
+        if (bytesRead == 0) break;
+        if (bytesRead != inputEfmBuffer.size()) inputEfmBuffer.resize(static_cast<qint32>(bytesRead));
+
+        timer.start();
+        const QVector<F3Frame> f3Frames = efmToF3Frames.process(inputEfmBuffer, false);
+        efmToF3Stats.busyNanoseconds += timer.nsecsElapsed();
+        efmToF3Stats.batches++;
+        efmToF3Stats.inputItems += bytesRead;
+        efmToF3Stats.outputItems += f3Frames.size();
+
+        if (!initialF3Queue.push(f3Frames)) break;
+
+        // Report progress
+        if (inputFileSize > 0) {
+            const qint32 percent = static_cast<qint32>((100 * inputFile->pos()) / inputFileSize);
+            if (percent > lastPercent) {
+                qInfo().nospace() << "Processing at " << percent << "%";
+                lastPercent = percent;
+            }
+        }
+    }
+
+    initialF3Queue.close();
+}
+
+// Synchronise the F3 frames with the subcode sections
+void EfmPipeline::runSyncF3Frames()
+{
+    QVector<F3Frame> initialF3Frames;
+    QElapsedTimer timer;
+    while (initialF3Queue.pop(initialF3Frames)) {
+        timer.start();
+        const QVector<F3Frame> syncedF3Frames = syncF3Frames.process(initialF3Frames, false);
+        syncF3Stats.busyNanoseconds += timer.nsecsElapsed();
+        syncF3Stats.batches++;
+        syncF3Stats.inputItems += initialF3Frames.size();
+        syncF3Stats.outputItems += syncedF3Frames.size();
+
+        if (!syncedF3Queue.push(syncedF3Frames)) break;
+    }
+
+    syncedF3Queue.close();
+}
+
+// Error-correct and deinterleave the F3 frames into F2 frames
+void EfmPipeline::runF3ToF2Frames()
+{
+    QVector<F3Frame> syncedF3Frames;
+    QElapsedTimer timer;
+    while (syncedF3Queue.pop(syncedF3Frames)) {
+        timer.start();
+        const QVector<F2Frame> f2Frames = f3ToF2Frames.process(syncedF3Frames, false, config.noTimeStamp);
+        f3ToF2Stats.busyNanoseconds += timer.nsecsElapsed();
+        f3ToF2Stats.batches++;
+        f3ToF2Stats.inputItems += syncedF3Frames.size();
+        f3ToF2Stats.outputItems += f2Frames.size();
+
+        if (!f2Queue.push(f2Frames)) break;
+    }
+
+    f2Queue.close();
+}
+
+// Convert the F2 frames into F1 frames
+void EfmPipeline::runF2ToF1Frames()
+{
+    QVector<F2Frame> f2Frames;
+    QElapsedTimer timer;
+    while (f2Queue.pop(f2Frames)) {
+        timer.start();
+        const QVector<F1Frame> f1Frames = f2ToF1Frames.process(f2Frames, false, config.noTimeStamp);
+        f2ToF1Stats.busyNanoseconds += timer.nsecsElapsed();
+        f2ToF1Stats.batches++;
+        f2ToF1Stats.inputItems += f2Frames.size();
+        f2ToF1Stats.outputItems += f1Frames.size();
+
+        if (!f1Queue.push(f1Frames)) break;
+    }
+
+    f1Queue.close();
+}
+
+// Decode the F1 frames as audio and/or data, and write them to the output files
+void EfmPipeline::runOutput()
+{
+    QVector<F1Frame> f1Frames;
+    QElapsedTimer timer;
+    while (f1Queue.pop(f1Frames)) {
+        timer.start();
+        QByteArray audioData, sectorData;
+        if (audioOutputFile != nullptr) {
+            audioData = f1ToAudio.process(f1Frames, config.padInitialDiscTime, config.errorTreatment, config.concealType, false);
+        }
+        if (dataOutputFile != nullptr) {
+            sectorData = f1ToData.process(f1Frames, false);
+        }
+        outputStats.busyNanoseconds += timer.nsecsElapsed();
+        outputStats.batches++;
+        outputStats.inputItems += f1Frames.size();
+        outputStats.outputItems += audioData.size() + sectorData.size();
+
+        if (audioOutputFile != nullptr && audioOutputFile->write(audioData) != audioData.size()) {
+            qCritical() << "Could not write to output audio file:" << audioOutputFile->errorString();
+            abortPipeline();
+            break;
+        }
+        if (dataOutputFile != nullptr && dataOutputFile->write(sectorData) != sectorData.size()) {
+            qCritical() << "Could not write to output data file:" << dataOutputFile->errorString();
+            abortPipeline();
+            break;
+        }
+    }
+}
+
+// Utility methods ----------------------------------------------------------------------------------------------------
+
+// Stop all the stages as soon as possible
+void EfmPipeline::abortPipeline()
+{
+    abort = true;
+    initialF3Queue.abort();
+    syncedF3Queue.abort();
+    f2Queue.abort();
+    f1Queue.abort();
+}
+
+// Report the throughput of one stage
+void EfmPipeline::reportStage(const char *name, const StageStatistics &stats, const char *inputUnit, const char *outputUnit)
+{
+    const double busySeconds = static_cast<double>(stats.busyNanoseconds) / 1e9;
+    const double inputRate = busySeconds > 0.0 ? static_cast<double>(stats.inputItems) / busySeconds : 0.0;
+
+    qInfo().nospace() << "  " << name << ": " << stats.inputItems << " " << inputUnit << " -> "
+                      << stats.outputItems << " " << outputUnit << " in " << stats.batches << " batches, busy for "
+                      << qRound64(busySeconds * 1000.0) << " ms (" << qRound64(inputRate) << " " << inputUnit << "/s)";
+}
+
+// Report the occupancy of one queue
+template <typename T>
+void EfmPipeline::reportQueue(const char *name, const PipelineQueue<T> &queue)
+{
+    qInfo().nospace() << "  " << name << ": mean occupancy " << queue.getMeanOccupancy()
+                      << ", maximum " << queue.getMaxOccupancy() << " of " << queue.getCapacity();
+}
@@ -0,0 +1,217 @@
+/************************************************************************
+
+    efmpipeline.h
+
+    ld-process-efm-cli - EFM data decoder (command-line version)
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef EFMPIPELINE_H
+#define EFMPIPELINE_H
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "Decoders/efmtof3frames.h"
+#include "Decoders/syncf3frames.h"
+#include "Decoders/f3tof2frames.h"
+#include "Decoders/f2tof1frames.h"
+#include "Decoders/f1toaudio.h"
+#include "Decoders/f1todata.h"
+
+// A bounded queue of batches passed from one pipeline stage to the next.
+// push() blocks while the queue is full, and pop() blocks while it is empty.
+template <typename T>
+class PipelineQueue
+{
+public:
+    explicit PipelineQueue(qint32 _capacity)
+        : capacity(_capacity), closed(false), aborted(false),
+          pushCount(0), occupancyTotal(0), maxOccupancy(0) {}
+
+    // Add a batch to the queue. Returns false if the pipeline has been aborted.
+    bool push(const T &batch) {
+        QMutexLocker locker(&mutex);
+        while (queue.size() >= capacity && !aborted) spaceAvailable.wait(&mutex);
+        if (aborted) return false;
+
+        queue.enqueue(batch);
+
+        // Sample the occupancy each time a batch is added
+        pushCount++;
+        occupancyTotal += queue.size();
+        maxOccupancy = qMax(maxOccupancy, queue.size());
+
+        itemAvailable.wakeOne();
+        return true;
+    }
+
+    // Remove a batch from the queue. Returns false once the queue has been
+    // closed and emptied, or if the pipeline has been aborted.
+    bool pop(T &batch) {
+        QMutexLocker locker(&mutex);
+        while (queue.isEmpty() && !closed && !aborted) itemAvailable.wait(&mutex);
+        if (aborted || queue.isEmpty()) return false;
+
+        batch = queue.dequeue();
+
+        spaceAvailable.wakeOne();
+        return true;
+    }
+
+    // Indicate that no more batches will be pushed
+    void close() {
+        QMutexLocker locker(&mutex);
+        closed = true;
+        itemAvailable.wakeAll();
+    }
+
+    // Wake up and stop both ends of the queue
+    void abort() {
+        QMutexLocker locker(&mutex);
+        aborted = true;
+        itemAvailable.wakeAll();
+        spaceAvailable.wakeAll();
+    }
+
+    // Occupancy statistics (only valid once the pipeline has stopped)
+    qint32 getCapacity() const {
+        return capacity;
+    }
+    double getMeanOccupancy() const {
+        return pushCount == 0 ? 0.0 : static_cast<double>(occupancyTotal) / static_cast<double>(pushCount);
+    }
+    qint32 getMaxOccupancy() const {
+        return maxOccupancy;
+    }
+
+private:
+    const qint32 capacity;
+    QMutex mutex;
+    QWaitCondition itemAvailable;
+    QWaitCondition spaceAvailable;
+    QQueue<T> queue;
+    bool closed;
+    bool aborted;
+
+    qint64 pushCount;
+    qint64 occupancyTotal;
+    qint32 maxOccupancy;
+};
+
+// Decode an EFM file by running each decoding stage in its own thread, with
+// bounded queues of frame batches between the stages
+class EfmPipeline
+{
+public:
+    struct Configuration {
+        F1ToAudio::ErrorTreatment errorTreatment = F1ToAudio::ErrorTreatment::conceal;
+        F1ToAudio::ConcealType concealType = F1ToAudio::ConcealType::linear;
+        bool padInitialDiscTime = false;
+        bool noTimeStamp = false;
+
+        // Maximum number of batches waiting between each pair of stages
+        qint32 queueSize = 8;
+    };
+
+    explicit EfmPipeline(const Configuration &config);
+
+    // Decode inputFile, writing audio to audioOutputFile and sector data to
+    // dataOutputFile. Either output may be nullptr to skip that decoding.
+    // Returns true on success; on failure, prints a message and returns false.
+    bool process(QFile *inputFile, QFile *audioOutputFile, QFile *dataOutputFile);
+
+    // Report decoding statistics, and the throughput of each stage, to qInfo
+    void reportStatistics();
+
+private:
+    // Thread that runs one stage of the pipeline
+    class StageThread : public QThread {
+    public:
+        StageThread(EfmPipeline &_efmPipeline, void (EfmPipeline::*_stage)())
+            : efmPipeline(_efmPipeline), stage(_stage) {}
+
+    protected:
+        void run() override {
+            (efmPipeline.*stage)();
+        }
+
+    private:
+        EfmPipeline &efmPipeline;
+        void (EfmPipeline::*stage)();
+    };
+
+    // Timing information for one stage
+    struct StageStatistics {
+        qint64 batches = 0;
+        qint64 inputItems = 0;
+        qint64 outputItems = 0;
+        qint64 busyNanoseconds = 0;
+    };
+
+    // Stage methods, each run by a StageThread
+    void runEfmToF3Frames();
+    void runSyncF3Frames();
+    void runF3ToF2Frames();
+    void runF2ToF1Frames();
+    void runOutput();
+
+    void abortPipeline();
+    void reportStage(const char *name, const StageStatistics &stats, const char *inputUnit, const char *outputUnit);
+    template <typename T>
+    void reportQueue(const char *name, const PipelineQueue<T> &queue);
+
+    // Parameters
+    Configuration config;
+    QFile *inputFile;
+    QFile *audioOutputFile;
+    QFile *dataOutputFile;
+
+    // Atomic abort flag; set if any stage fails
+    QAtomicInt abort;
+
+    // Decoding stages, each only used by its own thread while running
+    EfmToF3Frames efmToF3Frames;
+    SyncF3Frames syncF3Frames;
+    F3ToF2Frames f3ToF2Frames;
+    F2ToF1Frames f2ToF1Frames;
+    F1ToAudio f1ToAudio;
+    F1ToData f1ToData;
+
+    // Queues between the stages
+    PipelineQueue<QVector<F3Frame>> initialF3Queue;
+    PipelineQueue<QVector<F3Frame>> syncedF3Queue;
+    PipelineQueue<QVector<F2Frame>> f2Queue;
+    PipelineQueue<QVector<F1Frame>> f1Queue;
+
+    // Per-stage statistics, each only updated by its own thread while running
+    StageStatistics efmToF3Stats;
+    StageStatistics syncF3Stats;
+    StageStatistics f3ToF2Stats;
+    StageStatistics f2ToF1Stats;
+    StageStatistics outputStats;
+    qint64 totalMilliseconds;
+};
+
+#endif // EFMPIPELINE_H
@@ -0,0 +1,181 @@
+/************************************************************************
+
+    main.cpp
+
+    ld-process-efm-cli - EFM data decoder (command-line version)
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QtGlobal>
+#include <QCommandLineParser>
+
+#include "logging.h"
+
+#include "efmpipeline.h"
+
+int main(int argc, char *argv[])
+{
+    // Install the local debug message handler
+    setDebug(true);
+    qInstallMessageHandler(debugOutputHandler);
+
+    QCoreApplication a(argc, argv);
+
+    // Set application name and version
+    QCoreApplication::setApplicationName("ld-process-efm-cli");
+    QCoreApplication::setApplicationVersion(QString("Branch: %1 / Commit: %2").arg(APP_BRANCH, APP_COMMIT));
+    QCoreApplication::setOrganizationDomain("domesday86.com");
+
+    // Set up the command line parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "ld-process-efm-cli - EFM data decoder (command-line version)\n"
+                "\n"
+                "(c)2019-2020 Simon Inns\n"
+                "(c)2021 Adam Sampson\n"
+                "GPLv3 Open-Source - github: https://github.com/happycube/ld-decode");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    // -- General options --
+
+    // Add the standard debug options --debug and --quiet
+    addStandardDebugOptions(parser);
+
+    // Option to also decode sector data (--data)
+    QCommandLineOption dataOption(QStringList() << "data",
+                                  QCoreApplication::translate("main", "Also decode sector data, and write it to the specified file"),
+                                  QCoreApplication::translate("main", "filename"));
+    parser.addOption(dataOption);
+
+    // Option to pad the start of the audio to the initial disc time (--pad)
+    QCommandLineOption padOption(QStringList() << "pad",
+                                 QCoreApplication::translate("main", "Pad the start of the audio to the initial disc time"));
+    parser.addOption(padOption);
+
+    // Option to replace audio errors with silence (--silence)
+    QCommandLineOption silenceOption(QStringList() << "silence",
+                                     QCoreApplication::translate("main", "Replace audio errors with silence (default: conceal)"));
+    parser.addOption(silenceOption);
+
+    // Option to pass audio errors through unchanged (--passthrough)
+    QCommandLineOption passThroughOption(QStringList() << "passthrough",
+                                         QCoreApplication::translate("main", "Pass audio errors through unchanged (default: conceal)"));
+    parser.addOption(passThroughOption);
+
+    // Option to conceal audio errors using interpolated error prediction (--prediction)
+    QCommandLineOption predictionOption(QStringList() << "prediction",
+                                        QCoreApplication::translate("main", "Conceal audio errors using interpolated error prediction (experimental; default: linear)"));
+    parser.addOption(predictionOption);
+
+    // Option to decode without time-stamp information (--notimestamp)
+    QCommandLineOption noTimeStampOption(QStringList() << "notimestamp",
+                                         QCoreApplication::translate("main", "Decode without using time-stamp information"));
+    parser.addOption(noTimeStampOption);
+
+    // Option to set the pipeline queue size (--queue)
+    QCommandLineOption queueOption(QStringList() << "queue",
+                                   QCoreApplication::translate("main", "Maximum number of batches waiting between pipeline stages (default: 8)"),
+                                   QCoreApplication::translate("main", "number"));
+    parser.addOption(queueOption);
+
+    // -- Positional arguments --
+
+    // Positional argument to specify input EFM file
+    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input EFM file"));
+
+    // Positional argument to specify output audio file
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output audio file"));
+
+    // Process the command line options and arguments given by the user
+    parser.process(a);
+
+    // Standard logging options
+    processStandardDebugOptions(parser);
+
+    // Get the options from the parser
+    EfmPipeline::Configuration config;
+    config.padInitialDiscTime = parser.isSet(padOption);
+    config.noTimeStamp = parser.isSet(noTimeStampOption);
+
+    if (parser.isSet(silenceOption) && parser.isSet(passThroughOption)) {
+        // Quit with error
+        qCritical("The --silence and --passthrough options cannot be used together");
+        return -1;
+    }
+    if (parser.isSet(silenceOption)) config.errorTreatment = F1ToAudio::ErrorTreatment::silence;
+    if (parser.isSet(passThroughOption)) config.errorTreatment = F1ToAudio::ErrorTreatment::passThrough;
+    if (parser.isSet(predictionOption)) config.concealType = F1ToAudio::ConcealType::prediction;
+
+    if (parser.isSet(queueOption)) {
+        config.queueSize = parser.value(queueOption).toInt();
+
+        if (config.queueSize < 1) {
+            // Quit with error
+            qCritical("Specified queue size must be at least 1");
+            return -1;
+        }
+    }
+
+    // Get the arguments from the parser
+    QString inputFileName;
+    QString outputFileName;
+    QStringList positionalArguments = parser.positionalArguments();
+    if (positionalArguments.count() == 2) {
+        inputFileName = positionalArguments.at(0);
+        outputFileName = positionalArguments.at(1);
+    } else {
+        // Quit with error
+        qCritical("You must specify the input EFM and output audio files");
+        return -1;
+    }
+
+    // Open the input file
+    QFile inputFile(inputFileName);
+    if (!inputFile.open(QFile::ReadOnly)) {
+        qCritical() << "Cannot open input file:" << inputFileName;
+        return -1;
+    }
+
+    // Open the output files
+    QFile audioOutputFile(outputFileName);
+    if (!audioOutputFile.open(QFile::WriteOnly)) {
+        qCritical() << "Cannot open output audio file:" << outputFileName;
+        return -1;
+    }
+
+    QFile dataOutputFile(parser.value(dataOption));
+    if (parser.isSet(dataOption) && !dataOutputFile.open(QFile::WriteOnly)) {
+        qCritical() << "Cannot open output data file:" << parser.value(dataOption);
+        return -1;
+    }
+
+    // Decode the EFM
+    EfmPipeline efmPipeline(config);
+    if (!efmPipeline.process(&inputFile, &audioOutputFile, parser.isSet(dataOption) ? &dataOutputFile : nullptr)) {
+        return -1;
+    }
+    efmPipeline.reportStatistics();
+
+    // Quit with success
+    return 0;
+}
@@ -35,6 +35,7 @@ SOURCES += \
         Decoders/c1circ.cpp \
         Decoders/c2circ.cpp \
         Decoders/c2deinterleave.cpp \
+        Decoders/circreedsolomon.cpp \
         Decoders/efmtof3frames.cpp \
         Decoders/f1toaudio.cpp \
         Decoders/f1todata.cpp \
@@ -59,6 +60,7 @@ HEADERS += \
         Decoders/c1circ.h \
         Decoders/c2circ.h \
         Decoders/c2deinterleave.h \
+        Decoders/circreedsolomon.h \
         Decoders/efmtof3frames.h \
         Decoders/f1toaudio.h \
         Decoders/f1todata.h \
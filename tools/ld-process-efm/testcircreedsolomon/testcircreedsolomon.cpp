@@ -0,0 +1,193 @@
+/************************************************************************
+
+    testcircreedsolomon.cpp
+
+    Unit tests and benchmark for CircReedSolomon
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <ezpwd/rs_base>
+#include <ezpwd/rs>
+
+using std::cerr;
+using std::vector;
+
+#include "circreedsolomon.h"
+
+// The ezpwd configuration that C1Circ and C2Circ originally used
+template < size_t SYMBOLS, size_t PAYLOAD > struct CircRS;
+template < size_t PAYLOAD > struct CircRS<255, PAYLOAD> : public __RS(CircRS, uint8_t, 255, PAYLOAD, 0x11d, 0,  1);
+
+// Decode a word using ezpwd, in the same way as the original C1Circ/C2Circ
+qint32 referenceDecode(uchar *word, const qint32 *erasurePositions, qint32 numErasures)
+{
+    std::vector<uint8_t> data(word, word + 32);
+    std::vector<int> erasures(erasurePositions, erasurePositions + numErasures);
+
+    CircRS<255,255-4> rs;
+    std::vector<int> position;
+    const qint32 fixed = rs.decode(data, erasures, &position);
+
+    std::copy(data.begin(), data.end(), word);
+    return fixed;
+}
+
+// Make a random valid 32-symbol word
+void makeCodeword(uchar *word, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<qint32> valueDist(0, 255);
+    std::vector<uint8_t> data(28);
+    for (auto &value : data) value = static_cast<uint8_t>(valueDist(rng));
+
+    CircRS<255,255-4> rs;
+    rs.encode(data);
+    assert(data.size() == 32);
+    std::copy(data.begin(), data.end(), word);
+}
+
+// Decode a word with both decoders, and check they agree exactly
+void checkDecode(const uchar *input, const qint32 *erasures, qint32 numErasures, qint64 results[])
+{
+    uchar expected[32], actual[32];
+    memcpy(expected, input, 32);
+    memcpy(actual, input, 32);
+
+    const qint32 expectedFixed = referenceDecode(expected, erasures, numErasures);
+    const qint32 actualFixed = CircReedSolomon::decode(actual, erasures, numErasures);
+
+    if (actualFixed != expectedFixed || memcmp(actual, expected, 32) != 0) {
+        cerr << "Mismatch: expected " << expectedFixed << ", got " << actualFixed << " for input";
+        for (qint32 i = 0; i < 32; i++) cerr << " " << static_cast<qint32>(input[i]);
+        cerr << " with erasures";
+        for (qint32 i = 0; i < numErasures; i++) cerr << " " << erasures[i];
+        cerr << "\n";
+        assert(false);
+    }
+
+    results[expectedFixed + 1]++;
+}
+
+// Compare against ezpwd for words with various numbers of errors and erasures
+void testDecode()
+{
+    cerr << "Testing decode against ezpwd\n";
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint32> valueDist(1, 255);
+    std::uniform_int_distribution<qint32> countDist(0, 6);
+    qint64 results[6] = {0};
+
+    for (qint32 test = 0; test < 200000; test++) {
+        uchar word[32];
+        makeCodeword(word, rng);
+
+        // For C2, the last 4 symbols are always zero (and not a valid codeword)
+        const bool c2Style = (test % 4) == 3;
+        if (c2Style) memset(word + 28, 0, 4);
+        const qint32 length = c2Style ? 28 : 32;
+
+        // Pick some distinct positions
+        qint32 positions[32];
+        for (qint32 i = 0; i < 32; i++) positions[i] = i;
+        std::shuffle(positions, positions + length, rng);
+
+        // Corrupt some of them...
+        const qint32 numErrors = countDist(rng);
+        for (qint32 i = 0; i < numErrors; i++) word[positions[i]] ^= static_cast<uchar>(valueDist(rng));
+
+        // ... and mark some as erasures, mostly (but not always) ones that were corrupted
+        std::uniform_int_distribution<qint32> erasureDist(0, std::min(4, length));
+        const qint32 numErasures = erasureDist(rng);
+        qint32 erasures[4];
+        const qint32 offset = (test % 3 == 0) ? 2 : 0;
+        for (qint32 i = 0; i < numErasures; i++) erasures[i] = positions[i + offset];
+
+        checkDecode(word, erasures, numErasures, results);
+    }
+
+    // Entirely random words
+    std::uniform_int_distribution<qint32> byteDist(0, 255);
+    for (qint32 test = 0; test < 100000; test++) {
+        uchar word[32];
+        for (qint32 i = 0; i < 32; i++) word[i] = static_cast<uchar>(byteDist(rng));
+        checkDecode(word, nullptr, 0, results);
+    }
+
+    cerr << "Results: " << results[0] << " failed";
+    for (qint32 i = 1; i < 6; i++) cerr << ", " << results[i] << " with " << (i - 1) << " fixed";
+    cerr << "\n";
+}
+
+// Compare the speed of decoding against the original ezpwd path
+void benchmarkDecode()
+{
+    // One minute of disc; one word in a hundred has an error
+    const qint32 numWords = 7350 * 60;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint32> errorDist(0, 99);
+    std::uniform_int_distribution<qint32> positionDist(0, 31);
+    std::uniform_int_distribution<qint32> valueDist(1, 255);
+
+    vector<uchar> words(static_cast<size_t>(numWords) * 32);
+    for (qint32 i = 0; i < numWords; i++) {
+        uchar *word = &words[static_cast<size_t>(i) * 32];
+        makeCodeword(word, rng);
+        if (errorDist(rng) == 0) word[positionDist(rng)] ^= static_cast<uchar>(valueDist(rng));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 total = 0;
+    for (qint32 i = 0; i < numWords; i++) {
+        uchar word[32];
+        memcpy(word, &words[static_cast<size_t>(i) * 32], 32);
+        total += CircReedSolomon::decode(word, nullptr, 0);
+    }
+    const qint64 decodeTime = timer.elapsed();
+
+    timer.restart();
+    qint64 referenceTotal = 0;
+    for (qint32 i = 0; i < numWords; i++) {
+        uchar word[32];
+        memcpy(word, &words[static_cast<size_t>(i) * 32], 32);
+        referenceTotal += referenceDecode(word, nullptr, 0);
+    }
+    const qint64 referenceTime = timer.elapsed();
+
+    assert(total == referenceTotal);
+    cerr << "Decoding " << numWords << " words took " << decodeTime << " ms; "
+         << "with ezpwd it took " << referenceTime << " ms\n";
+}
+
+int main()
+{
+    testDecode();
+    benchmarkDecode();
+
+    return 0;
+}
@@ -0,0 +1,15 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testcircreedsolomon.cpp \
+    ../Decoders/circreedsolomon.cpp
+
+HEADERS += \
+    ../Decoders/circreedsolomon.h
+
+INCLUDEPATH += \
+    .. \
+    ../Decoders
+
+target.CONFIG += no_default_install
@@ -0,0 +1,229 @@
+/************************************************************************
+
+    testefmtof3frames.cpp
+
+    Unit tests and benchmark for EfmToF3Frames
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using std::cerr;
+using std::vector;
+
+#include "efmtof3frames.h"
+
+// Build the T-values for an F3 frame containing the given 32 data EFM codes.
+// The subcode symbol is always a valid code.
+vector<uchar> makeTValues(const qint16 *efmCodes)
+{
+    // Build the 588-bit channel bit stream: the sync pattern and its merging
+    // bits, then 33 14-bit codes each followed by 3 (zero) merging bits
+    vector<bool> bits;
+    auto appendBits = [&](qint32 value, qint32 width) {
+        for (qint32 i = width - 1; i >= 0; i--) bits.push_back(((value >> i) & 1) != 0);
+    };
+
+    appendBits(0x801002, 24);
+    appendBits(0, 3);
+    appendBits(efm2numberLUT[0x42], 14);
+    appendBits(0, 3);
+    for (qint32 i = 0; i < 32; i++) {
+        appendBits(efmCodes[i], 14);
+        appendBits(0, 3);
+    }
+    assert(bits.size() == 588);
+
+    // Each T-value is the distance from a 1 bit to the next one (or to the
+    // end of the stream)
+    vector<uchar> tValues;
+    qint32 lastOne = 0;
+    assert(bits[0]);
+    for (qint32 i = 1; i < static_cast<qint32>(bits.size()); i++) {
+        if (bits[i]) {
+            tValues.push_back(static_cast<uchar>(i - lastOne));
+            lastOne = i;
+        }
+    }
+    tValues.push_back(static_cast<uchar>(bits.size() - lastOne));
+
+    return tValues;
+}
+
+// A synthetic EFM stream: some noise, followed by a sequence of F3 frames
+// containing random valid symbols
+struct TestStream {
+    vector<uchar> tValues;
+    vector<vector<uchar>> symbols;
+};
+
+TestStream makeStream(qint32 numFrames, qint32 noiseLength, std::mt19937 &rng)
+{
+    TestStream stream;
+
+    // Values between T3 and T10 can never look like a T11+T11 sync
+    std::uniform_int_distribution<qint32> noiseDist(3, 10);
+    for (qint32 i = 0; i < noiseLength; i++) {
+        stream.tValues.push_back(static_cast<uchar>(noiseDist(rng)));
+    }
+
+    std::uniform_int_distribution<qint32> valueDist(0, 255);
+    for (qint32 frame = 0; frame < numFrames; frame++) {
+        qint16 efmCodes[32];
+        vector<uchar> frameSymbols;
+        for (qint32 i = 0; i < 32; i++) {
+            const qint32 value = valueDist(rng);
+            efmCodes[i] = efm2numberLUT[value];
+            frameSymbols.push_back(static_cast<uchar>(value));
+        }
+
+        const vector<uchar> frameTValues = makeTValues(efmCodes);
+        stream.tValues.insert(stream.tValues.end(), frameTValues.begin(), frameTValues.end());
+        stream.symbols.push_back(frameSymbols);
+    }
+
+    return stream;
+}
+
+// Feed a stream to the decoder in randomly-sized chunks
+vector<F3Frame> decodeStream(EfmToF3Frames &efmToF3Frames, const vector<uchar> &tValues, qint32 maxChunk, std::mt19937 &rng)
+{
+    std::uniform_int_distribution<qint32> chunkDist(1, maxChunk);
+
+    vector<F3Frame> frames;
+    size_t position = 0;
+    while (position < tValues.size()) {
+        const size_t chunkSize = std::min(static_cast<size_t>(chunkDist(rng)), tValues.size() - position);
+        QByteArray chunk(reinterpret_cast<const char *>(tValues.data() + position), static_cast<qint32>(chunkSize));
+        position += chunkSize;
+
+        for (const F3Frame &frame : efmToF3Frames.process(chunk, false)) {
+            frames.push_back(frame);
+        }
+    }
+
+    return frames;
+}
+
+// Check that all the frames in a clean stream are found, however the input is split up
+void testCleanStream()
+{
+    cerr << "Testing clean stream\n";
+
+    std::mt19937 rng(42);
+    const qint32 numFrames = 1000;
+
+    for (qint32 maxChunk : {1, 7, 600, 100000}) {
+        TestStream stream = makeStream(numFrames, 1000, rng);
+
+        EfmToF3Frames efmToF3Frames;
+        vector<F3Frame> frames = decodeStream(efmToF3Frames, stream.tValues, maxChunk, rng);
+
+        // The last frame is held back until the following sync arrives
+        assert(frames.size() == static_cast<size_t>(numFrames - 1));
+
+        for (size_t i = 0; i < frames.size(); i++) {
+            assert(frames[i].getSubcodeSymbol() == 0x42);
+            for (qint32 j = 0; j < 32; j++) {
+                assert(frames[i].getDataSymbols()[j] == stream.symbols[i][j]);
+                assert(frames[i].getErrorSymbols()[j] == 0);
+            }
+        }
+
+        const EfmToF3Frames::Statistics statistics = efmToF3Frames.getStatistics();
+        assert(statistics.validFrames == numFrames - 1);
+        assert(statistics.undershootFrames == 0);
+        assert(statistics.overshootFrames == 0);
+        assert(statistics.invalidEfmSymbols == 0);
+    }
+}
+
+// Check that damage within a frame doesn't disturb the frames around it
+void testDamagedFrame()
+{
+    cerr << "Testing damaged frame\n";
+
+    std::mt19937 rng(42);
+    const qint32 numFrames = 100;
+    TestStream stream = makeStream(numFrames, 0, rng);
+
+    // Merge two T-values in the middle of frame 50, leaving its length unchanged
+    const qint32 frameLength = 588;
+    qint32 position = 0;
+    qint32 tTotal = 0;
+    while (tTotal < (50 * frameLength) + 300) tTotal += stream.tValues[position++];
+    stream.tValues[position] = static_cast<uchar>(stream.tValues[position] + stream.tValues[position + 1]);
+    stream.tValues.erase(stream.tValues.begin() + position + 1);
+
+    EfmToF3Frames efmToF3Frames;
+    vector<F3Frame> frames = decodeStream(efmToF3Frames, stream.tValues, 600, rng);
+    assert(frames.size() == static_cast<size_t>(numFrames - 1));
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (i == 50) continue;
+        for (qint32 j = 0; j < 32; j++) {
+            assert(frames[i].getDataSymbols()[j] == stream.symbols[i][j]);
+        }
+    }
+}
+
+// Measure decoding throughput, with the input split into blocks of the same
+// size that ld-process-efm reads
+void benchmarkDecoding()
+{
+    // One minute of disc
+    const qint32 numFrames = 7350 * 60;
+    const qint32 blockSize = 1024 * 256;
+
+    std::mt19937 rng(42);
+    TestStream stream = makeStream(numFrames, 0, rng);
+    stream.symbols.clear();
+
+    EfmToF3Frames efmToF3Frames;
+    QElapsedTimer timer;
+    timer.start();
+
+    qint64 totalFrames = 0;
+    for (size_t position = 0; position < stream.tValues.size(); position += blockSize) {
+        const size_t chunkSize = std::min(static_cast<size_t>(blockSize), stream.tValues.size() - position);
+        QByteArray chunk(reinterpret_cast<const char *>(stream.tValues.data() + position), static_cast<qint32>(chunkSize));
+        totalFrames += efmToF3Frames.process(chunk, false).size();
+    }
+
+    const qint64 elapsed = std::max(timer.elapsed(), static_cast<qint64>(1));
+    assert(totalFrames == numFrames - 1);
+
+    cerr << "Decoding " << stream.tValues.size() << " T-values into " << totalFrames << " F3 frames took "
+         << elapsed << " ms (" << (static_cast<qint64>(stream.tValues.size()) * 1000 / elapsed) << " T-values/s)\n";
+}
+
+int main()
+{
+    testCleanStream();
+    testDamagedFrame();
+    benchmarkDecoding();
+
+    return 0;
+}
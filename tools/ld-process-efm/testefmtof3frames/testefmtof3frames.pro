@@ -0,0 +1,18 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testefmtof3frames.cpp \
+    ../Datatypes/f3frame.cpp \
+    ../Decoders/efmtof3frames.cpp
+
+HEADERS += \
+    ../Datatypes/f3frame.h \
+    ../Decoders/efmtof3frames.h
+
+INCLUDEPATH += \
+    .. \
+    ../Datatypes \
+    ../Decoders
+
+target.CONFIG += no_default_install
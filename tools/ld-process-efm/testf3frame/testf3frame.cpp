@@ -0,0 +1,199 @@
+/************************************************************************
+
+    testf3frame.cpp
+
+    Unit tests and benchmark for F3Frame
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-process-efm is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using std::cerr;
+using std::vector;
+
+#include "f3frame.h"
+
+// This is the original EFM translation from F3Frame, which searched the
+// tables linearly. It returns the symbol value, or -1 if invalid; corrected
+// is set if the symbol was recovered using the error-correction tables.
+qint16 referenceTranslateEfm(qint16 efmValue, bool &corrected)
+{
+    corrected = false;
+
+    qint16 result = -1;
+    qint16 lutPos = 0;
+    while (result == -1 && lutPos < 256) {
+        if (efm2numberLUT[lutPos] == efmValue) result = lutPos;
+        lutPos++;
+    }
+
+    if (result == -1) {
+        lutPos = 0;
+        while (result == -1 && lutPos < 16384) {
+            if (efmerr2positionLUT[lutPos] == efmValue) result = lutPos;
+            lutPos++;
+        }
+
+        if (result != -1) {
+            result = efmerr2valueLUT[result];
+            corrected = true;
+        }
+    }
+
+    return result;
+}
+
+// Build the T-values for an F3 frame containing the given 32 data EFM codes.
+// The subcode symbol is always a valid code.
+vector<uchar> makeTValues(const qint16 *efmCodes)
+{
+    // Build the 588-bit channel bit stream: the sync pattern and its merging
+    // bits, then 33 14-bit codes each followed by 3 (zero) merging bits
+    vector<bool> bits;
+    auto appendBits = [&](qint32 value, qint32 width) {
+        for (qint32 i = width - 1; i >= 0; i--) bits.push_back(((value >> i) & 1) != 0);
+    };
+
+    appendBits(0x801002, 24);
+    appendBits(0, 3);
+    appendBits(efm2numberLUT[0x42], 14);
+    appendBits(0, 3);
+    for (qint32 i = 0; i < 32; i++) {
+        appendBits(efmCodes[i], 14);
+        appendBits(0, 3);
+    }
+    assert(bits.size() == 588);
+
+    // Each T-value is the distance from a 1 bit to the next one (or to the
+    // end of the stream)
+    vector<uchar> tValues;
+    qint32 lastOne = 0;
+    assert(bits[0]);
+    for (qint32 i = 1; i < static_cast<qint32>(bits.size()); i++) {
+        if (bits[i]) {
+            tValues.push_back(static_cast<uchar>(i - lastOne));
+            lastOne = i;
+        }
+    }
+    tValues.push_back(static_cast<uchar>(bits.size() - lastOne));
+
+    return tValues;
+}
+
+// Check that every 14-bit code translates the same way as before
+void testTranslation()
+{
+    cerr << "Testing EFM translation\n";
+
+    for (qint32 firstCode = 0; firstCode < 16384; firstCode += 32) {
+        qint16 efmCodes[32];
+        for (qint32 i = 0; i < 32; i++) efmCodes[i] = static_cast<qint16>(firstCode + i);
+
+        vector<uchar> tValues = makeTValues(efmCodes);
+        F3Frame frame(tValues.data(), static_cast<qint32>(tValues.size()));
+
+        assert(frame.getSubcodeSymbol() == 0x42);
+
+        qint64 expectedValid = 1;
+        qint64 expectedInvalid = 0;
+        qint64 expectedCorrected = 0;
+        for (qint32 i = 0; i < 32; i++) {
+            bool corrected;
+            const qint16 expected = referenceTranslateEfm(efmCodes[i], corrected);
+
+            if (expected == -1) {
+                assert(frame.getErrorSymbols()[i] == 1);
+                assert(frame.getDataSymbols()[i] == 0);
+                expectedInvalid++;
+            } else {
+                assert(frame.getErrorSymbols()[i] == 0);
+                assert(frame.getDataSymbols()[i] == expected);
+                if (corrected) {
+                    expectedInvalid++;
+                    expectedCorrected++;
+                } else {
+                    expectedValid++;
+                }
+            }
+        }
+
+        assert(frame.getNumberOfValidEfmSymbols() == expectedValid);
+        assert(frame.getNumberOfInvalidEfmSymbols() == expectedInvalid);
+        assert(frame.getNumberOfCorrectedEfmSymbols() == expectedCorrected);
+    }
+}
+
+// Compare the speed of decoding frames against the original table search
+void benchmarkTranslation()
+{
+    // One minute of disc, of mostly-valid symbols
+    const qint32 numFrames = 7350 * 60;
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint32> valueDist(0, 255);
+    std::uniform_int_distribution<qint32> codeDist(0, 16383);
+    std::uniform_int_distribution<qint32> errorDist(0, 99);
+
+    vector<vector<uchar>> frames(1000);
+    vector<qint16> codes;
+    for (auto &tValues : frames) {
+        qint16 efmCodes[32];
+        for (qint32 i = 0; i < 32; i++) {
+            efmCodes[i] = (errorDist(rng) == 0) ? static_cast<qint16>(codeDist(rng)) : efm2numberLUT[valueDist(rng)];
+            codes.push_back(efmCodes[i]);
+        }
+        tValues = makeTValues(efmCodes);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 total = 0;
+    for (qint32 i = 0; i < numFrames; i++) {
+        const vector<uchar> &tValues = frames[i % frames.size()];
+        F3Frame frame(const_cast<uchar *>(tValues.data()), static_cast<qint32>(tValues.size()));
+        total += frame.getDataSymbols()[i % 32];
+    }
+    const qint64 frameTime = timer.elapsed();
+
+    timer.restart();
+    qint64 referenceTotal = 0;
+    for (qint32 i = 0; i < numFrames; i++) {
+        for (qint32 j = 0; j < 32; j++) {
+            bool corrected;
+            referenceTotal += referenceTranslateEfm(codes[((i % frames.size()) * 32) + j], corrected);
+        }
+    }
+    const qint64 referenceTime = timer.elapsed();
+
+    cerr << "Decoding " << numFrames << " F3 frames took " << frameTime << " ms; "
+         << "the original table search alone took " << referenceTime << " ms"
+         << " (" << total << ", " << referenceTotal << ")\n";
+}
+
+int main()
+{
+    testTranslation();
+    benchmarkTranslation();
+
+    return 0;
+}
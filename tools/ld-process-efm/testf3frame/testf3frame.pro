@@ -0,0 +1,14 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testf3frame.cpp \
+    ../Datatypes/f3frame.cpp
+
+HEADERS += \
+    ../Datatypes/f3frame.h
+
+INCLUDEPATH += \
+    ../Datatypes
+
+target.CONFIG += no_default_install
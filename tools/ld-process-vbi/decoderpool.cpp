@@ -24,10 +24,12 @@
 
 #include "decoderpool.h"
 
+#include <QFileInfo>
+
 DecoderPool::DecoderPool(QString _inputFilename, QString _outputJsonFilename,
-                         qint32 _maxThreads, LdDecodeMetaData &_ldDecodeMetaData)
+                         qint32 _maxThreads, bool _resume, LdDecodeMetaData &_ldDecodeMetaData)
     : inputFilename(_inputFilename), outputJsonFilename(_outputJsonFilename),
-      maxThreads(_maxThreads), ldDecodeMetaData(_ldDecodeMetaData)
+      maxThreads(_maxThreads), resume(_resume), fieldPrefetcher(nullptr), ldDecodeMetaData(_ldDecodeMetaData)
 {
 }
 
@@ -58,13 +60,24 @@ bool DecoderPool::process()
     // Initialise processing state
     inputFieldNumber = 1;
     lastFieldNumber = ldDecodeMetaData.getNumberOfFields();
+    if (!openJournal()) {
+        sourceVideo.close();
+        return false;
+    }
     totalTimer.start();
 
+    // Start reading fields ahead of the workers
+    fieldPrefetcher = new FieldPrefetcher(sourceVideo, FieldPrefetcher::DEFAULT_DEPTH_FRAMES, 1,
+                                          VbiLineDecoder::startFieldLine, VbiLineDecoder::endFieldLine);
+    fieldPrefetcher->startPrefetch(inputFieldNumber, lastFieldNumber);
+
     // Start a vector of decoding threads to process the video
+    threadUpdates.clear();
+    threadUpdates.resize(maxThreads);
     QVector<QThread *> threads;
     threads.resize(maxThreads);
     for (qint32 i = 0; i < maxThreads; i++) {
-        threads[i] = new VbiLineDecoder(abort, *this);
+        threads[i] = new VbiLineDecoder(abort, *this, threadUpdates[i]);
         threads[i]->start(QThread::LowPriority);
     }
 
@@ -74,6 +87,12 @@ bool DecoderPool::process()
         delete threads[i];
     }
 
+    // Stop the prefetcher
+    fieldPrefetcher->stopPrefetch();
+    const qint64 prefetchStalls = fieldPrefetcher->getStallCount();
+    delete fieldPrefetcher;
+    fieldPrefetcher = nullptr;
+
     // Did any of the threads abort?
     if (abort) {
         sourceVideo.close();
@@ -84,10 +103,25 @@ bool DecoderPool::process()
     qreal totalSecs = (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
     qInfo() << "VBI Processing complete -" << lastFieldNumber << "fields in" << totalSecs << "seconds (" <<
                lastFieldNumber / totalSecs << "FPS )";
+    qInfo() << "Input prefetcher stalled" << prefetchStalls << "times";
+
+    // Save the threads' results to the metadata
+    for (const LdDecodeMetaData::FieldUpdates &updates : threadUpdates) {
+        ldDecodeMetaData.applyFieldUpdates(updates);
+    }
+    threadUpdates.clear();
 
     // Write the JSON metadata file
     qInfo() << "Writing JSON metadata file...";
-    ldDecodeMetaData.write(outputJsonFilename);
+    if (!ldDecodeMetaData.write(outputJsonFilename)) {
+        qCritical() << "Unable to write the JSON metadata file - use --resume to try again";
+        return false;
+    }
+
+    // write() only succeeds once the new JSON file has replaced the old one,
+    // so all the results are in the JSON metadata now and the journal isn't
+    // needed
+    journal.remove();
     qInfo() << "VBI processing complete";
 
     // Close the source video
@@ -105,6 +139,9 @@ bool DecoderPool::getInputField(qint32 &fieldNumber, SourceVideo::Data &fieldVid
 {
     QMutexLocker locker(&inputMutex);
 
+    // Skip fields whose results came from the journal
+    while (inputFieldNumber <= lastFieldNumber && skipFields[inputFieldNumber]) inputFieldNumber++;
+
     if (inputFieldNumber > lastFieldNumber) {
         // No more input fields
         return false;
@@ -117,25 +154,52 @@ bool DecoderPool::getInputField(qint32 &fieldNumber, SourceVideo::Data &fieldVid
     qDebug() << "DecoderPool::process(): Processing field number" << fieldNumber;
 
     // Fetch the input data
-    fieldVideoData = sourceVideo.getVideoField(fieldNumber, VbiLineDecoder::startFieldLine, VbiLineDecoder::endFieldLine);
+    fieldVideoData = fieldPrefetcher->getVideoField(fieldNumber);
+    locker.unlock();
+
+    // Fetch the metadata (which doesn't need the lock)
     fieldMetadata = ldDecodeMetaData.getField(fieldNumber);
     videoParameters = ldDecodeMetaData.getVideoParameters();
 
     return true;
 }
 
-// Put a decoded frame into the output stream.
+// Record a worker's results in the journal
+void DecoderPool::writeJournal(const LdDecodeMetaData::FieldUpdates &updates)
+{
+    journal.write(updates);
+}
+
+// Open the journal. If resuming, apply the results of the interrupted run to
+// the metadata, and mark those fields to be skipped.
 //
-// Returns true on success, false on failure.
-bool DecoderPool::setOutputField(qint32 fieldNumber, LdDecodeMetaData::Field fieldMetadata)
+// Returns true on success.
+bool DecoderPool::openJournal()
 {
-    QMutexLocker locker(&outputMutex);
+    const QString journalFilename = MetadataJournal::getJournalFileName(outputJsonFilename);
+    if (!resume && QFileInfo::exists(journalFilename)) {
+        qInfo() << "Replacing the metadata journal from a previous run (use --resume to continue that run instead)";
+    }
 
-    // Save the field data to the metadata (only VBI and NTSC metadata is affected)
-    ldDecodeMetaData.updateFieldVbi(fieldMetadata.vbi, fieldNumber);
-    ldDecodeMetaData.updateFieldNtsc(fieldMetadata.ntsc, fieldNumber);
+    LdDecodeMetaData::FieldUpdates journalUpdates;
+    if (!journal.open(journalFilename, resume, journalUpdates)) {
+        qCritical() << "Unable to open the metadata journal";
+        return false;
+    }
+    ldDecodeMetaData.applyFieldUpdates(journalUpdates);
+
+    skipFields.fill(false, lastFieldNumber + 1);
+    qint32 skipCount = 0;
+    for (qint32 fieldNumber : journalUpdates.getFieldNumbers()) {
+        if (fieldNumber > lastFieldNumber) continue;
+        skipFields[fieldNumber] = true;
+        skipCount++;
+    }
+    if (resume) qInfo() << "Resuming -" << skipCount << "fields have already been processed";
+
+    // Skip the leading fields that have already been processed, so
+    // prefetching starts from the right place
+    while (inputFieldNumber <= lastFieldNumber && skipFields[inputFieldNumber]) inputFieldNumber++;
 
     return true;
 }
-
-
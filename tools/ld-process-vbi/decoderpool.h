@@ -30,8 +30,10 @@
 #include <QMutex>
 #include <QThread>
 
+#include "fieldprefetcher.h"
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "metadatajournal.h"
 #include "vbilinedecoder.h"
 
 class DecoderPool
@@ -39,17 +41,18 @@ class DecoderPool
 public:
     // Public methods
     explicit DecoderPool(QString _inputFilename, QString _outputJsonFilename,
-                        qint32 _maxThreads, LdDecodeMetaData &_ldDecodeMetaData);
+                        qint32 _maxThreads, bool _resume, LdDecodeMetaData &_ldDecodeMetaData);
     bool process();
 
     // Member functions used by worker threads
     bool getInputField(qint32 &fieldNumber, SourceVideo::Data &fieldVideoData, LdDecodeMetaData::Field &fieldMetadata, LdDecodeMetaData::VideoParameters &videoParameters);
-    bool setOutputField(qint32 fieldNumber, LdDecodeMetaData::Field fieldMetadata);
+    void writeJournal(const LdDecodeMetaData::FieldUpdates &updates);
 
 private:
     QString inputFilename;
     QString outputJsonFilename;
     qint32 maxThreads;
+    bool resume;
     QElapsedTimer totalTimer;
 
     // Atomic abort flag shared by worker threads; workers watch this, and shut
@@ -60,12 +63,21 @@ private:
     QMutex inputMutex;
     qint32 inputFieldNumber;
     qint32 lastFieldNumber;
-    LdDecodeMetaData &ldDecodeMetaData;
+    QVector<bool> skipFields;
     SourceVideo sourceVideo;
+    FieldPrefetcher *fieldPrefetcher;
+
+    // The metadata isn't changed while threads are running, so they can read
+    // it without holding inputMutex. Each thread collects its results in its
+    // own entry in threadUpdates, which are applied once they have finished.
+    LdDecodeMetaData &ldDecodeMetaData;
+    QVector<LdDecodeMetaData::FieldUpdates> threadUpdates;
+
+    // Results are also written to the journal as they're produced, so an
+    // interrupted run can be resumed
+    MetadataJournal journal;
 
-    // Output stream information (all guarded by outputMutex while threads are running)
-    QMutex outputMutex;
-    QFile targetJson;
+    bool openJournal();
 };
 
 #endif // DECODERPOOL_H
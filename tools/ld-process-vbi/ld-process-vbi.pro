@@ -21,8 +21,13 @@ SOURCES += \
     fmcode.cpp \
     vbilinedecoder.cpp \
     whiteflag.cpp \
+    ../library/tbc/fieldprefetcher.cpp \
+    ../library/tbc/jsonio.cpp \
     ../library/tbc/lddecodemetadata.cpp \
+    ../library/tbc/metadatajournal.cpp \
     ../library/tbc/sourcevideo.cpp \
+    ../library/tbc/videobuffer.cpp \
+    ../library/tbc/videobufferpool.cpp \
     ../library/tbc/vbidecoder.cpp \
     ../library/tbc/logging.cpp \
     ../library/tbc/dropouts.cpp
@@ -33,8 +38,13 @@ HEADERS += \
     fmcode.h \
     vbilinedecoder.h \
     whiteflag.h \
+    ../library/tbc/fieldprefetcher.h \
+    ../library/tbc/jsonio.h \
     ../library/tbc/lddecodemetadata.h \
+    ../library/tbc/metadatajournal.h \
     ../library/tbc/sourcevideo.h \
+    ../library/tbc/videobuffer.h \
+    ../library/tbc/videobufferpool.h \
     ../library/tbc/vbidecoder.h \
     ../library/tbc/logging.h \
     ../library/tbc/dropouts.h
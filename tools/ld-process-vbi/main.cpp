@@ -80,6 +80,11 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number"));
     parser.addOption(threadsOption);
 
+    // Option to resume an interrupted run (--resume)
+    QCommandLineOption resumeOption(QStringList() << "resume",
+                                    QCoreApplication::translate("main", "Resume an interrupted run, skipping the fields already processed"));
+    parser.addOption(resumeOption);
+
     // Positional argument to specify input TBC file
     parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
 
@@ -91,6 +96,7 @@ int main(int argc, char *argv[])
 
     // Get the options from the parser
     bool noBackup = parser.isSet(showNoBackupOption);
+    bool resume = parser.isSet(resumeOption);
 
     qint32 maxThreads = QThread::idealThreadCount();
     if (parser.isSet(threadsOption)) {
@@ -132,8 +138,10 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    // If we're overwriting the input JSON file, back it up first
-    if (inputJsonFilename == outputJsonFilename && !noBackup) {
+    // If we're overwriting the input JSON file, back it up first (unless the
+    // interrupted run we're resuming already did)
+    if (inputJsonFilename == outputJsonFilename && !noBackup
+        && !(resume && QFile::exists(inputJsonFilename + ".bup"))) {
         qInfo().nospace().noquote() << "Backing up JSON metadata to " << inputJsonFilename << ".bup";
         if (!QFile::copy(inputJsonFilename, inputJsonFilename + ".bup")) {
             qCritical() << "Unable to back-up input JSON metadata file - back-up already exists?";
@@ -143,7 +151,7 @@ int main(int argc, char *argv[])
 
     // Perform the processing
     qInfo() << "Beginning VBI processing...";
-    DecoderPool decoderPool(inputFilename, outputJsonFilename, maxThreads, metaData);
+    DecoderPool decoderPool(inputFilename, outputJsonFilename, maxThreads, resume, metaData);
     if (!decoderPool.process()) return 1;
 
     // Quit with success
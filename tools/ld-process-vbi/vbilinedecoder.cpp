@@ -30,8 +30,9 @@
 constexpr qint32 VbiLineDecoder::startFieldLine;
 constexpr qint32 VbiLineDecoder::endFieldLine;
 
-VbiLineDecoder::VbiLineDecoder(QAtomicInt& _abort, DecoderPool& _decoderPool, QObject *parent)
-    : QThread(parent), abort(_abort), decoderPool(_decoderPool)
+VbiLineDecoder::VbiLineDecoder(QAtomicInt& _abort, DecoderPool& _decoderPool, LdDecodeMetaData::FieldUpdates& _fieldUpdates,
+                               QObject *parent)
+    : QThread(parent), abort(_abort), decoderPool(_decoderPool), fieldUpdates(_fieldUpdates)
 {
 
 }
@@ -119,11 +120,12 @@ void VbiLineDecoder::run()
         // Update the metadata for the field
         fieldMetadata.vbi.inUse = true;
 
-        // Write the result to the output metadata
-        if (!decoderPool.setOutputField(fieldNumber, fieldMetadata)) {
-            abort = true;
-            break;
-        }
+        // Save the result for the output metadata (only VBI and NTSC metadata is affected)
+        LdDecodeMetaData::FieldUpdates updates;
+        updates.updateFieldVbi(fieldMetadata.vbi, fieldNumber);
+        updates.updateFieldNtsc(fieldMetadata.ntsc, fieldNumber);
+        decoderPool.writeJournal(updates);
+        fieldUpdates.append(updates);
     }
 }
 
@@ -42,7 +42,8 @@ class VbiLineDecoder : public QThread {
     Q_OBJECT
 
 public:
-    explicit VbiLineDecoder(QAtomicInt& _abort, DecoderPool& _decoderPool, QObject *parent = nullptr);
+    explicit VbiLineDecoder(QAtomicInt& _abort, DecoderPool& _decoderPool, LdDecodeMetaData::FieldUpdates& _fieldUpdates,
+                            QObject *parent = nullptr);
 
     // The range of field lines needed from the input file (inclusive)
     static constexpr qint32 startFieldLine = 10;
@@ -56,6 +57,9 @@ private:
     QAtomicInt& abort;
     DecoderPool& decoderPool;
 
+    // Output metadata changes
+    LdDecodeMetaData::FieldUpdates& fieldUpdates;
+
     // Temporary output buffer
     LdDecodeMetaData::Field outputData;
 
@@ -84,6 +84,11 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number"));
     parser.addOption(threadsOption);
 
+    // Option to resume an interrupted run (--resume)
+    QCommandLineOption resumeOption(QStringList() << "resume",
+                                    QCoreApplication::translate("main", "Resume an interrupted run, skipping the fields already processed"));
+    parser.addOption(resumeOption);
+
     // Positional argument to specify input TBC file
     parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
 
@@ -95,6 +100,7 @@ int main(int argc, char *argv[])
 
     // Get the options from the parser
     bool noBackup = parser.isSet(showNoBackupOption);
+    bool resume = parser.isSet(resumeOption);
 
     qint32 maxThreads = QThread::idealThreadCount();
     if (parser.isSet(threadsOption)) {
@@ -136,8 +142,10 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    // If we're overwriting the input JSON file, back it up first
-    if (inputJsonFilename == outputJsonFilename && !noBackup) {
+    // If we're overwriting the input JSON file, back it up first (unless the
+    // interrupted run we're resuming already did)
+    if (inputJsonFilename == outputJsonFilename && !noBackup
+        && !(resume && QFile::exists(inputJsonFilename + ".vbup"))) {
         qInfo().nospace().noquote() << "Backing up JSON metadata to " << inputJsonFilename << ".vbup";
         if (!QFile::copy(inputJsonFilename, inputJsonFilename + ".vbup")) {
             qCritical() << "Unable to back-up input JSON metadata file - back-up already exists?";
@@ -147,7 +155,7 @@ int main(int argc, char *argv[])
 
     // Perform the processing
     qInfo() << "Beginning VITS processing...";
-    ProcessingPool processingPool(inputFilename, outputJsonFilename, maxThreads, metaData);
+    ProcessingPool processingPool(inputFilename, outputJsonFilename, maxThreads, resume, metaData);
     if (!processingPool.process()) return 1;
 
     // Quit with success
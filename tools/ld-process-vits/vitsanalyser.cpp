@@ -25,8 +25,9 @@
 #include "vitsanalyser.h"
 #include "processingpool.h"
 
-VitsAnalyser::VitsAnalyser(QAtomicInt& _abort, ProcessingPool& _processingPool, QObject *parent)
-    : QThread(parent), abort(_abort), processingPool(_processingPool)
+VitsAnalyser::VitsAnalyser(QAtomicInt& _abort, ProcessingPool& _processingPool, LdDecodeMetaData::FieldUpdates& _fieldUpdates,
+                           QObject *parent)
+    : QThread(parent), abort(_abort), processingPool(_processingPool), fieldUpdates(_fieldUpdates)
 {
 
 }
@@ -100,11 +101,11 @@ void VitsAnalyser::run()
         qDebug().nospace() << "Field #" << fieldNumber << " has wSNR of " << fieldMetadata.vitsMetrics.wSNR << " (" << old_wSNR << ")"
                  << " and bPSNR of " << fieldMetadata.vitsMetrics.bPSNR << " (" << old_bPSNR << ")";
 
-        // Write the result to the output metadata
-        if (!processingPool.setOutputField(fieldNumber, fieldMetadata)) {
-            abort = true;
-            break;
-        }
+        // Save the result for the output metadata (only VITS metrics metadata is affected)
+        LdDecodeMetaData::FieldUpdates updates;
+        updates.updateFieldVitsMetrics(fieldMetadata.vitsMetrics, fieldNumber);
+        processingPool.writeJournal(updates);
+        fieldUpdates.append(updates);
     }
 }
 
@@ -41,7 +41,8 @@ class VitsAnalyser : public QThread {
     Q_OBJECT
 
 public:
-    explicit VitsAnalyser(QAtomicInt& _abort, ProcessingPool& _processingPool, QObject *parent = nullptr);
+    explicit VitsAnalyser(QAtomicInt& _abort, ProcessingPool& _processingPool, LdDecodeMetaData::FieldUpdates& _fieldUpdates,
+                          QObject *parent = nullptr);
 
 protected:
     void run() override;
@@ -51,6 +52,9 @@ private:
     QAtomicInt& abort;
     ProcessingPool& processingPool;
 
+    // Output metadata changes
+    LdDecodeMetaData::FieldUpdates& fieldUpdates;
+
     // Temporary output buffer
     LdDecodeMetaData::Field outputData;
 
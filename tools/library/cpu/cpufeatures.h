@@ -0,0 +1,73 @@
+/************************************************************************
+
+    cpufeatures.h
+
+    ld-decode-tools CPU feature library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+// Runtime detection of the x86 vector instruction sets that the tools' SIMD
+// kernels are written for.
+//
+// CPUFEATURES_X86 is defined when the compiler can build code for these
+// instruction sets using __attribute__((target)) on individual functions.
+// Code inside #ifdef CPUFEATURES_X86 may include <immintrin.h> and define
+// such functions, but must only call them if isSupported says the CPU running
+// the program has the instruction set.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CPUFEATURES_X86
+#endif
+
+class CpuFeatures
+{
+public:
+    enum Feature {
+        sse41,
+        sse42,
+        avx2
+    };
+
+    // Return true if this CPU (and this build) supports the given feature
+    static bool isSupported(Feature feature)
+    {
+#ifdef CPUFEATURES_X86
+        // The CPU model data that __builtin_cpu_supports uses is only set up
+        // automatically once static constructors have run, so make sure it's
+        // ready in case this is called from one
+        __builtin_cpu_init();
+
+        switch (feature) {
+        case sse41:
+            return __builtin_cpu_supports("sse4.1");
+        case sse42:
+            return __builtin_cpu_supports("sse4.2");
+        case avx2:
+            return __builtin_cpu_supports("avx2");
+        }
+#else
+        (void) feature;
+#endif
+        return false;
+    }
+};
+
+#endif // CPUFEATURES_H
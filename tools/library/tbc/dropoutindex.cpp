@@ -0,0 +1,133 @@
+/************************************************************************
+
+    dropoutindex.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "dropoutindex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+DropOutIndex::DropOutIndex(const DropOuts &dropOuts)
+{
+    // Find the valid dropouts, and sort them by line and start position.
+    // (Lines below 0 can't be indexed, and can't be queried meaningfully.)
+    QVector<qint32> order;
+    order.reserve(dropOuts.size());
+    qint32 maxLine = -1;
+    for (qint32 i = 0; i < dropOuts.size(); i++) {
+        if (dropOuts.fieldLine(i) < 0 || dropOuts.endx(i) < dropOuts.startx(i)) continue;
+
+        order.append(i);
+        maxLine = std::max(maxLine, dropOuts.fieldLine(i));
+    }
+    if (order.empty()) return;
+
+    std::sort(order.begin(), order.end(), [&](qint32 a, qint32 b) {
+        if (dropOuts.fieldLine(a) != dropOuts.fieldLine(b)) return dropOuts.fieldLine(a) < dropOuts.fieldLine(b);
+        return dropOuts.startx(a) < dropOuts.startx(b);
+    });
+
+    // Merge the intervals on each line, and record where each line starts
+    m_lineOffsets.fill(0, maxLine + 2);
+    m_startx.reserve(order.size());
+    m_endx.reserve(order.size());
+    qint32 currentLine = -1;
+    for (qint32 i : order) {
+        const qint32 fieldLine = dropOuts.fieldLine(i);
+
+        if (fieldLine == currentLine && dropOuts.startx(i) <= m_endx.last() + 1) {
+            // Overlaps or touches the previous interval - extend it
+            m_endx.last() = std::max(m_endx.last(), dropOuts.endx(i));
+        } else {
+            m_startx.append(dropOuts.startx(i));
+            m_endx.append(dropOuts.endx(i));
+            m_lineOffsets[fieldLine + 1]++;
+            currentLine = fieldLine;
+        }
+    }
+
+    // Convert the per-line counts into offsets
+    std::partial_sum(m_lineOffsets.begin(), m_lineOffsets.end(), m_lineOffsets.begin());
+}
+
+// Return true if pixel x of fieldLine is in a dropout
+bool DropOutIndex::isDropout(qint32 fieldLine, qint32 x) const
+{
+    return overlaps(fieldLine, x, x);
+}
+
+// Return true if any pixel from startx to endx (inclusive) of fieldLine is in a dropout
+bool DropOutIndex::overlaps(qint32 fieldLine, qint32 startx, qint32 endx) const
+{
+    if (endx < startx) return false;
+
+    qint32 lineEnd;
+    const qint32 index = findInterval(fieldLine, startx, lineEnd);
+
+    return index != lineEnd && m_startx[index] <= endx;
+}
+
+// Return true if fieldLine has any dropouts
+bool DropOutIndex::lineHasDropouts(qint32 fieldLine) const
+{
+    if (fieldLine < 0 || fieldLine + 1 >= m_lineOffsets.size()) return false;
+
+    return m_lineOffsets[fieldLine] != m_lineOffsets[fieldLine + 1];
+}
+
+// Fill in a map of which pixels in part of a line are dropouts
+void DropOutIndex::fillLine(qint32 fieldLine, qint32 startx, qint32 length, quint8 *isDropout) const
+{
+    memset(isDropout, 0, length);
+
+    const qint32 endx = startx + length - 1;
+    qint32 lineEnd;
+    for (qint32 index = findInterval(fieldLine, startx, lineEnd); index != lineEnd && m_startx[index] <= endx; index++) {
+        const qint32 first = std::max(m_startx[index], startx);
+        const qint32 last = std::min(m_endx[index], endx);
+        memset(isDropout + (first - startx), 1, last - first + 1);
+    }
+}
+
+// Return true if the index contains no dropouts
+bool DropOutIndex::empty() const
+{
+    return m_startx.empty();
+}
+
+// Find the first interval on fieldLine whose end is at or after x, setting
+// lineEnd to the index after the line's last interval. If there is no such
+// interval, returns lineEnd.
+qint32 DropOutIndex::findInterval(qint32 fieldLine, qint32 x, qint32 &lineEnd) const
+{
+    if (fieldLine < 0 || fieldLine + 1 >= m_lineOffsets.size()) {
+        lineEnd = 0;
+        return 0;
+    }
+
+    // The intervals on a line are disjoint and sorted, so their ends are sorted too
+    lineEnd = m_lineOffsets[fieldLine + 1];
+    const qint32 *ends = m_endx.constData();
+    return static_cast<qint32>(std::lower_bound(ends + m_lineOffsets[fieldLine], ends + lineEnd, x) - ends);
+}
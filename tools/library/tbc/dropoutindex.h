@@ -0,0 +1,77 @@
+/************************************************************************
+
+    dropoutindex.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef DROPOUTINDEX_H
+#define DROPOUTINDEX_H
+
+#include <QtGlobal>
+#include <QVector>
+
+#include "dropouts.h"
+
+// An index of a field's dropouts by field line, for answering "is this
+// pixel/range a dropout?" without scanning the whole DropOuts list.
+//
+// The index is built once for a field's DropOuts. For each line, it holds
+// the dropouts as a sorted list of disjoint intervals (overlapping and
+// adjacent dropouts are merged), so point and range queries are a binary
+// search within the line.
+//
+// As in DropOuts, field lines are numbered from 1, and the startx and endx
+// of an interval are both inclusive. Dropouts with endx < startx are ignored.
+class DropOutIndex
+{
+public:
+    DropOutIndex() = default;
+    explicit DropOutIndex(const DropOuts &dropOuts);
+
+    // Return true if pixel x of fieldLine is in a dropout
+    bool isDropout(qint32 fieldLine, qint32 x) const;
+
+    // Return true if any pixel from startx to endx (inclusive) of fieldLine
+    // is in a dropout (or false if endx < startx)
+    bool overlaps(qint32 fieldLine, qint32 startx, qint32 endx) const;
+
+    // Return true if fieldLine has any dropouts
+    bool lineHasDropouts(qint32 fieldLine) const;
+
+    // For the length pixels of fieldLine starting at startx, set isDropout[i]
+    // to 1 if the pixel is in a dropout, and 0 otherwise
+    void fillLine(qint32 fieldLine, qint32 startx, qint32 length, quint8 *isDropout) const;
+
+    // Return true if the index contains no dropouts
+    bool empty() const;
+
+private:
+    // Index of the first interval for each line; the intervals for line L
+    // are [m_lineOffsets[L], m_lineOffsets[L + 1])
+    QVector<qint32> m_lineOffsets;
+    QVector<qint32> m_startx;
+    QVector<qint32> m_endx;
+
+    // Return the first interval on fieldLine that ends at or after x
+    qint32 findInterval(qint32 fieldLine, qint32 x, qint32 &lineEnd) const;
+};
+
+#endif // DROPOUTINDEX_H
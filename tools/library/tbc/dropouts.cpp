@@ -93,17 +93,17 @@ bool DropOuts::empty() const
 }
 
 // Get methods
-qint32 DropOuts::startx(qint32 index)
+qint32 DropOuts::startx(qint32 index) const
 {
     return m_startx[index];
 }
 
-qint32 DropOuts::endx(qint32 index)
+qint32 DropOuts::endx(qint32 index) const
 {
     return m_endx[index];
 }
 
-qint32 DropOuts::fieldLine(qint32 index)
+qint32 DropOuts::fieldLine(qint32 index) const
 {
     return m_fieldLine[index];
 }
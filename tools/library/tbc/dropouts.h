@@ -48,9 +48,9 @@ public:
     void concatenate();
     bool empty() const;
 
-    qint32 startx(qint32 index);
-    qint32 endx(qint32 index);
-    qint32 fieldLine(qint32 index);
+    qint32 startx(qint32 index) const;
+    qint32 endx(qint32 index) const;
+    qint32 fieldLine(qint32 index) const;
 
 private:
     QVector<qint32> m_startx;
@@ -0,0 +1,199 @@
+/************************************************************************
+
+    fieldprefetcher.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "fieldprefetcher.h"
+
+// Definitions of static constexpr data members, for compatibility with
+// pre-C++17 compilers
+constexpr qint32 FieldPrefetcher::DEFAULT_DEPTH_FRAMES;
+
+FieldPrefetcher::FieldPrefetcher(SourceVideo &_sourceVideo, qint32 _depthFrames, qint32 retainFrames,
+                                 qint32 _startFieldLine, qint32 _endFieldLine, QObject *parent)
+    : QThread(parent), sourceVideo(_sourceVideo), depthFrames(qMax(1, _depthFrames)),
+      startFieldLine(_startFieldLine), endFieldLine(_endFieldLine),
+      fieldLength(_sourceVideo.getFieldLength()),
+      retainFields(2 * qMax(1, retainFrames)), capacity(retainFields + (2 * depthFrames)),
+      isPrefetching(false), stopRequested(false), windowStart(1), nextReadField(1), lastReadField(0),
+      highestRequestedField(0), stallCount(0)
+{
+    slotFieldNumbers.fill(-1, capacity);
+    slotData.resize(capacity);
+}
+
+FieldPrefetcher::~FieldPrefetcher()
+{
+    stopPrefetch();
+}
+
+void FieldPrefetcher::startPrefetch(qint32 firstFieldNumber, qint32 lastFieldNumber)
+{
+    stopPrefetch();
+
+    // Don't read past the end of the source, if we know where it is
+    const qint32 availableFields = sourceVideo.getNumberOfAvailableFields();
+    if (availableFields != -1) lastFieldNumber = qMin(lastFieldNumber, availableFields);
+
+    QMutexLocker locker(&ringMutex);
+    windowStart = qMax(1, firstFieldNumber);
+    nextReadField = windowStart;
+    lastReadField = lastFieldNumber;
+    highestRequestedField = 0;
+    stallCount = 0;
+    stopRequested = false;
+    isPrefetching = true;
+    locker.unlock();
+
+    start();
+}
+
+void FieldPrefetcher::stopPrefetch()
+{
+    QMutexLocker locker(&ringMutex);
+    if (!isPrefetching) return;
+
+    stopRequested = true;
+    spaceAvailable.wakeAll();
+    fieldAvailable.wakeAll();
+    locker.unlock();
+
+    wait();
+
+    locker.relock();
+    isPrefetching = false;
+    slotFieldNumbers.fill(-1);
+    for (qint32 i = 0; i < capacity; i++) slotData[i].clear();
+}
+
+// Get a field; if it's in the ring, this waits for the I/O thread to read it
+// if necessary, otherwise it's read synchronously.
+SourceVideo::Data FieldPrefetcher::getVideoField(qint32 fieldNumber)
+{
+    QMutexLocker locker(&ringMutex);
+
+    if (isPrefetching && !stopRequested) {
+        // Requesting a new field moves the window forwards, keeping
+        // retainFields fields (including this one) behind the read position
+        if (fieldNumber > highestRequestedField) {
+            highestRequestedField = fieldNumber;
+            advanceWindow(fieldNumber - retainFields + 1);
+        }
+
+        if (fieldNumber >= windowStart && fieldNumber < windowStart + capacity && fieldNumber <= lastReadField) {
+            const qint32 slot = fieldNumber % capacity;
+            if (slotFieldNumbers[slot] == fieldNumber) return slotData[slot];
+
+            // Not read yet -- wait for the I/O thread to catch up
+            stallCount++;
+            while (slotFieldNumbers[slot] != fieldNumber && fieldNumber >= windowStart && !stopRequested) {
+                fieldAvailable.wait(&ringMutex);
+            }
+
+            if (slotFieldNumbers[slot] == fieldNumber) return slotData[slot];
+        } else {
+            // Outside the ring, so the I/O thread won't read it for us
+            stallCount++;
+        }
+    }
+
+    // Read the field directly
+    locker.unlock();
+
+    return readField(fieldNumber);
+}
+
+qint32 FieldPrefetcher::getDepthFrames() const
+{
+    return depthFrames;
+}
+
+qint32 FieldPrefetcher::getFieldLength() const
+{
+    return fieldLength;
+}
+
+// Return the number of times a caller has had to wait for a field to be read
+qint64 FieldPrefetcher::getStallCount()
+{
+    QMutexLocker locker(&ringMutex);
+    return stallCount;
+}
+
+// I/O thread: read fields into the ring in field number order, sleeping
+// while the ring is full
+void FieldPrefetcher::run()
+{
+    QMutexLocker locker(&ringMutex);
+
+    while (true) {
+        while (!stopRequested && (nextReadField > lastReadField || nextReadField >= windowStart + capacity)) {
+            spaceAvailable.wait(&ringMutex);
+        }
+        if (stopRequested) break;
+
+        const qint32 fieldNumber = nextReadField++;
+        locker.unlock();
+
+        SourceVideo::Data fieldData = readField(fieldNumber);
+
+        locker.relock();
+
+        // The window may have moved past this field while it was being read
+        if (fieldNumber >= windowStart) {
+            const qint32 slot = fieldNumber % capacity;
+            slotFieldNumbers[slot] = fieldNumber;
+            slotData[slot] = std::move(fieldData);
+            fieldAvailable.wakeAll();
+        }
+    }
+}
+
+SourceVideo::Data FieldPrefetcher::readField(qint32 fieldNumber)
+{
+    QMutexLocker locker(&sourceMutex);
+    return sourceVideo.getVideoField(fieldNumber, startFieldLine, endFieldLine);
+}
+
+// Discard fields before newWindowStart, freeing space in the ring. You must
+// hold ringMutex to call this.
+void FieldPrefetcher::advanceWindow(qint32 newWindowStart)
+{
+    if (newWindowStart <= windowStart) return;
+
+    const qint32 firstKept = qMin(newWindowStart, windowStart + capacity);
+    for (qint32 fieldNumber = windowStart; fieldNumber < firstKept; fieldNumber++) {
+        const qint32 slot = fieldNumber % capacity;
+        if (slotFieldNumbers[slot] == fieldNumber) {
+            slotFieldNumbers[slot] = -1;
+            slotData[slot].clear();
+        }
+    }
+
+    windowStart = newWindowStart;
+
+    // Skip over anything that's no longer wanted
+    if (nextReadField < windowStart) nextReadField = windowStart;
+
+    spaceAvailable.wakeAll();
+    fieldAvailable.wakeAll();
+}
@@ -0,0 +1,118 @@
+/************************************************************************
+
+    fieldprefetcher.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FIELDPREFETCHER_H
+#define FIELDPREFETCHER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "sourcevideo.h"
+
+// Reads fields from a SourceVideo ahead of the worker threads that consume
+// them.
+//
+// A dedicated I/O thread fills a bounded ring of upcoming fields, in field
+// number order, so that a worker asking for the next field normally gets a
+// buffer that is already in memory. Fields behind the most recently requested
+// one are retained for a configurable number of frames (for decoders that need
+// lookbehind, or fields stored out of order within a frame); anything outside
+// the ring is read synchronously, exactly as SourceVideo would.
+//
+// Once prefetching has started, the SourceVideo must only be accessed through
+// this object until stopPrefetch() has been called.
+class FieldPrefetcher : public QThread
+{
+    Q_OBJECT
+public:
+    // Default read-ahead depth, in frames
+    static constexpr qint32 DEFAULT_DEPTH_FRAMES = 32;
+
+    explicit FieldPrefetcher(SourceVideo &sourceVideo, qint32 depthFrames = DEFAULT_DEPTH_FRAMES,
+                             qint32 retainFrames = 1, qint32 startFieldLine = -1, qint32 endFieldLine = -1,
+                             QObject *parent = nullptr);
+    ~FieldPrefetcher() override;
+
+    // Prevent copying or assignment
+    FieldPrefetcher(const FieldPrefetcher &) = delete;
+    FieldPrefetcher& operator=(const FieldPrefetcher &) = delete;
+
+    // Start reading ahead from firstFieldNumber; nothing beyond lastFieldNumber
+    // (or the end of the source, if that's known) will be prefetched.
+    void startPrefetch(qint32 firstFieldNumber, qint32 lastFieldNumber);
+
+    // Stop the I/O thread and discard any prefetched fields
+    void stopPrefetch();
+
+    // Get a field, using the line range given to the constructor.
+    // This is safe to call from any thread.
+    SourceVideo::Data getVideoField(qint32 fieldNumber);
+
+    // Get and set methods
+    qint32 getDepthFrames() const;
+    qint32 getFieldLength() const;
+    qint64 getStallCount();
+
+protected:
+    void run() override;
+
+private:
+    SourceVideo &sourceVideo;
+    const qint32 depthFrames;
+    const qint32 startFieldLine;
+    const qint32 endFieldLine;
+    const qint32 fieldLength;
+
+    // Number of fields kept behind the most recently requested field, and the
+    // total size of the ring
+    const qint32 retainFields;
+    const qint32 capacity;
+
+    // Serialises access to sourceVideo between the I/O thread and synchronous reads
+    QMutex sourceMutex;
+
+    // Ring state (all guarded by ringMutex)
+    QMutex ringMutex;
+    QWaitCondition spaceAvailable;
+    QWaitCondition fieldAvailable;
+    bool isPrefetching;
+    bool stopRequested;
+    qint32 windowStart;
+    qint32 nextReadField;
+    qint32 lastReadField;
+    qint32 highestRequestedField;
+    QVector<qint32> slotFieldNumbers;
+    QVector<SourceVideo::Data> slotData;
+
+    // Number of times a caller had to wait for I/O
+    qint64 stallCount;
+
+    SourceVideo::Data readField(qint32 fieldNumber);
+    void advanceWindow(qint32 newWindowStart);
+};
+
+#endif // FIELDPREFETCHER_H
@@ -0,0 +1,655 @@
+/************************************************************************
+
+    jsonio.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "jsonio.h"
+
+#include <QLocale>
+#include <cmath>
+#include <limits>
+
+// Return a string as a quoted JSON string, escaping characters as needed
+static QByteArray quoteString(const char *data, qint32 size)
+{
+    QByteArray quoted;
+    quoted.reserve(size + 2);
+
+    quoted.append('"');
+    for (qint32 i = 0; i < size; i++) {
+        const char c = data[i];
+        switch (c) {
+        case '"':
+            quoted.append("\\\"");
+            break;
+        case '\\':
+            quoted.append("\\\\");
+            break;
+        case '\n':
+            quoted.append("\\n");
+            break;
+        case '\r':
+            quoted.append("\\r");
+            break;
+        case '\t':
+            quoted.append("\\t");
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                static const char hexDigits[] = "0123456789abcdef";
+                quoted.append("\\u00");
+                quoted.append(hexDigits[(c >> 4) & 0xF]);
+                quoted.append(hexDigits[c & 0xF]);
+            } else {
+                quoted.append(c);
+            }
+            break;
+        }
+    }
+    quoted.append('"');
+
+    return quoted;
+}
+
+// JsonReader ---------------------------------------------------------------------------------------------------------
+
+JsonReader::JsonReader(std::istream &_input)
+    : input(_input), lineNumber(1), error(false), capture(nullptr)
+{
+}
+
+void JsonReader::beginObject()
+{
+    if (error || !expect('{')) return;
+    firstItem.append(true);
+}
+
+// Read the name of the next member of an object, leaving the reader
+// positioned at its value. Returns false at the end of the object.
+bool JsonReader::readMember(std::string &member)
+{
+    if (error) return false;
+    if (firstItem.isEmpty()) {
+        raiseError("readMember called outside an object");
+        return false;
+    }
+
+    if (peekToken() == '}') return false;
+    if (!firstItem.last() && !expect(',')) return false;
+    firstItem.last() = false;
+
+    if (!readString(member)) return false;
+    return expect(':');
+}
+
+void JsonReader::endObject()
+{
+    if (error || !expect('}')) return;
+    firstItem.removeLast();
+}
+
+void JsonReader::beginArray()
+{
+    if (error || !expect('[')) return;
+    firstItem.append(true);
+}
+
+// Move on to the next element of an array. Returns false at the end of the
+// array.
+bool JsonReader::readElement()
+{
+    if (error) return false;
+    if (firstItem.isEmpty()) {
+        raiseError("readElement called outside an array");
+        return false;
+    }
+
+    if (peekToken() == ']') return false;
+    if (!firstItem.last() && !expect(',')) return false;
+    firstItem.last() = false;
+
+    return true;
+}
+
+void JsonReader::endArray()
+{
+    if (error || !expect(']')) return;
+    firstItem.removeLast();
+}
+
+void JsonReader::read(qint32 &value)
+{
+    if (error) return;
+    if (peekToken() == 'n') {
+        if (readNull()) value = 0;
+        return;
+    }
+
+    double doubleValue;
+    bool isInteger;
+    qint64 integerValue;
+    if (!readNumber(doubleValue, isInteger, integerValue)) return;
+
+    if (isInteger) {
+        value = static_cast<qint32>(integerValue);
+    } else if (std::isfinite(doubleValue)) {
+        value = static_cast<qint32>(qRound64(doubleValue));
+    } else {
+        value = 0;
+    }
+}
+
+void JsonReader::read(qint64 &value)
+{
+    if (error) return;
+    if (peekToken() == 'n') {
+        if (readNull()) value = 0;
+        return;
+    }
+
+    double doubleValue;
+    bool isInteger;
+    qint64 integerValue;
+    if (!readNumber(doubleValue, isInteger, integerValue)) return;
+
+    if (isInteger) {
+        value = integerValue;
+    } else if (std::isfinite(doubleValue)) {
+        value = qRound64(doubleValue);
+    } else {
+        value = 0;
+    }
+}
+
+void JsonReader::read(double &value)
+{
+    if (error) return;
+    if (peekToken() == 'n') {
+        if (readNull()) value = 0.0;
+        return;
+    }
+
+    bool isInteger;
+    qint64 integerValue;
+    readNumber(value, isInteger, integerValue);
+}
+
+void JsonReader::read(bool &value)
+{
+    if (error) return;
+
+    switch (peekToken()) {
+    case 't':
+        if (readLiteral("true")) value = true;
+        break;
+    case 'f':
+        if (readLiteral("false")) value = false;
+        break;
+    case 'n':
+        if (readNull()) value = false;
+        break;
+    default:
+        // Accept a number, treating non-zero as true
+        double doubleValue;
+        bool isInteger;
+        qint64 integerValue;
+        if (readNumber(doubleValue, isInteger, integerValue)) value = (doubleValue != 0.0);
+        break;
+    }
+}
+
+void JsonReader::read(QString &value)
+{
+    if (error) return;
+    if (peekToken() == 'n') {
+        if (readNull()) value.clear();
+        return;
+    }
+
+    if (readString(stringBuffer)) {
+        value = QString::fromUtf8(stringBuffer.data(), static_cast<int>(stringBuffer.size()));
+    }
+}
+
+void JsonReader::discard()
+{
+    if (error) return;
+
+    switch (peekToken()) {
+    case '{': {
+        std::string member;
+        beginObject();
+        while (readMember(member)) discard();
+        endObject();
+        break;
+    }
+    case '[':
+        beginArray();
+        while (readElement()) discard();
+        endArray();
+        break;
+    case '"':
+        readString(stringBuffer);
+        break;
+    case 't':
+        readLiteral("true");
+        break;
+    case 'f':
+        readLiteral("false");
+        break;
+    case 'n':
+        readNull();
+        break;
+    default:
+        double doubleValue;
+        bool isInteger;
+        qint64 integerValue;
+        readNumber(doubleValue, isInteger, integerValue);
+        break;
+    }
+}
+
+void JsonReader::readUnknown(const std::string &member, QByteArray &unknownMembers)
+{
+    if (error) return;
+
+    if (!unknownMembers.isEmpty()) unknownMembers.append(',');
+    unknownMembers.append(quoteString(member.data(), static_cast<qint32>(member.size())));
+    unknownMembers.append(':');
+
+    // Skip over the value, collecting the input as we go. Whitespace between
+    // tokens isn't collected, so the result is compact.
+    capture = &unknownMembers;
+    discard();
+    capture = nullptr;
+}
+
+// Return true if there is nothing but whitespace left in the input (or an
+// error has occurred). This allows a sequence of values to be read from the
+// same input.
+bool JsonReader::atEnd()
+{
+    if (error) return true;
+    return peekToken() == std::char_traits<char>::eof();
+}
+
+bool JsonReader::hasError() const
+{
+    return error;
+}
+
+QString JsonReader::errorString() const
+{
+    return errorMessage;
+}
+
+// Flag an error. Only the first error is recorded.
+void JsonReader::raiseError(const QString &message)
+{
+    if (error) return;
+
+    error = true;
+    errorMessage = QString("line %1: %2").arg(lineNumber).arg(message);
+}
+
+// Consume and return the next character
+int JsonReader::get()
+{
+    const int c = input.get();
+    if (capture != nullptr && c != std::char_traits<char>::eof()) capture->append(static_cast<char>(c));
+    return c;
+}
+
+// Skip whitespace, and return the next character without consuming it (or
+// EOF at the end of the input)
+int JsonReader::peekToken()
+{
+    while (true) {
+        const int c = input.peek();
+        switch (c) {
+        case '\n':
+            lineNumber++;
+            input.get();
+            break;
+        case ' ':
+        case '\t':
+        case '\r':
+            input.get();
+            break;
+        default:
+            return c;
+        }
+    }
+}
+
+// Consume the character c, or flag an error if the next token is something else
+bool JsonReader::expect(char c)
+{
+    if (peekToken() != c) {
+        raiseError(QString("expected '%1'").arg(c));
+        return false;
+    }
+
+    get();
+    return true;
+}
+
+bool JsonReader::readNull()
+{
+    return readLiteral("null");
+}
+
+// Consume a literal word, or flag an error if the input doesn't match
+bool JsonReader::readLiteral(const char *literal)
+{
+    for (const char *p = literal; *p != '\0'; p++) {
+        if (get() != *p) {
+            raiseError(QString("expected '%1'").arg(literal));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Read a number. If it doesn't have a fractional part or exponent, it's also
+// returned as an integer, which avoids the cost of converting it to double.
+//
+// For compatibility with Python's json module, this also accepts NaN and
+// (-)Infinity.
+bool JsonReader::readNumber(double &value, bool &isInteger, qint64 &integerValue)
+{
+    isInteger = false;
+
+    int c = peekToken();
+    bool negative = false;
+    if (c == '-') {
+        negative = true;
+        get();
+        c = input.peek();
+    }
+
+    if (c == 'N' && !negative) {
+        if (!readLiteral("NaN")) return false;
+        value = std::numeric_limits<double>::quiet_NaN();
+        return true;
+    }
+    if (c == 'I') {
+        if (!readLiteral("Infinity")) return false;
+        value = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+        return true;
+    }
+
+    // Collect the characters making up the number
+    numberBuffer.clear();
+    if (negative) numberBuffer.push_back('-');
+    bool hasDigits = false;
+    bool hasFraction = false;
+    while (true) {
+        c = input.peek();
+        if (c >= '0' && c <= '9') {
+            hasDigits = true;
+        } else if (c == '.' || c == 'e' || c == 'E') {
+            hasFraction = true;
+        } else if (c != '+' && c != '-') {
+            break;
+        }
+        numberBuffer.push_back(static_cast<char>(c));
+        get();
+    }
+
+    if (!hasDigits) {
+        raiseError("expected a value");
+        return false;
+    }
+
+    // Integers that fit into 64 bits are converted directly
+    const qint32 numDigits = static_cast<qint32>(numberBuffer.size()) - (negative ? 1 : 0);
+    if (!hasFraction && numDigits <= 18) {
+        qint64 result = 0;
+        for (std::string::size_type i = (negative ? 1 : 0); i < numberBuffer.size(); i++) {
+            if (numberBuffer[i] < '0' || numberBuffer[i] > '9') {
+                raiseError("invalid number");
+                return false;
+            }
+            result = (result * 10) + (numberBuffer[i] - '0');
+        }
+
+        isInteger = true;
+        integerValue = negative ? -result : result;
+        value = static_cast<double>(integerValue);
+        return true;
+    }
+
+    // Otherwise, use Qt's conversion, which doesn't depend on the C locale
+    bool ok;
+    value = QByteArray::fromRawData(numberBuffer.data(), static_cast<int>(numberBuffer.size())).toDouble(&ok);
+    if (!ok) {
+        raiseError("invalid number");
+        return false;
+    }
+
+    return true;
+}
+
+// Read a string, decoding escapes into UTF-8
+bool JsonReader::readString(std::string &value)
+{
+    if (!expect('"')) return false;
+
+    value.clear();
+    while (true) {
+        int c = get();
+        if (c == std::char_traits<char>::eof()) {
+            raiseError("unterminated string");
+            return false;
+        }
+        if (c == '"') break;
+        if (c == '\n') lineNumber++;
+
+        if (c != '\\') {
+            value.push_back(static_cast<char>(c));
+            continue;
+        }
+
+        c = get();
+        switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            value.push_back(static_cast<char>(c));
+            break;
+        case 'b':
+            value.push_back('\b');
+            break;
+        case 'f':
+            value.push_back('\f');
+            break;
+        case 'n':
+            value.push_back('\n');
+            break;
+        case 'r':
+            value.push_back('\r');
+            break;
+        case 't':
+            value.push_back('\t');
+            break;
+        case 'u': {
+            quint32 codePoint;
+            if (!readHexDigits(codePoint)) return false;
+
+            // Combine a UTF-16 surrogate pair
+            if (codePoint >= 0xD800 && codePoint < 0xDC00 && input.peek() == '\\') {
+                get();
+                quint32 lowSurrogate;
+                if (get() != 'u' || !readHexDigits(lowSurrogate)) {
+                    raiseError("invalid surrogate pair in string");
+                    return false;
+                }
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+            }
+
+            // Encode as UTF-8
+            if (codePoint < 0x80) {
+                value.push_back(static_cast<char>(codePoint));
+            } else if (codePoint < 0x800) {
+                value.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            } else if (codePoint < 0x10000) {
+                value.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            } else {
+                value.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                value.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            break;
+        }
+        default:
+            raiseError("invalid escape in string");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Read the four hex digits of a \u escape
+bool JsonReader::readHexDigits(quint32 &value)
+{
+    value = 0;
+    for (qint32 i = 0; i < 4; i++) {
+        const int c = get();
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= (c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value |= (c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            value |= (c - 'A' + 10);
+        } else {
+            raiseError("invalid \\u escape in string");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// JsonWriter ---------------------------------------------------------------------------------------------------------
+
+JsonWriter::JsonWriter(std::ostream &_output)
+    : output(_output)
+{
+}
+
+void JsonWriter::beginObject()
+{
+    output << '{';
+    firstItem.append(true);
+}
+
+// Write the name of the next member of an object. Member names are written
+// as given, so they must not need escaping.
+void JsonWriter::writeMember(const char *member)
+{
+    writeSeparator();
+    output << '"' << member << "\":";
+}
+
+void JsonWriter::endObject()
+{
+    output << '}';
+    firstItem.removeLast();
+}
+
+void JsonWriter::beginArray()
+{
+    output << '[';
+    firstItem.append(true);
+}
+
+void JsonWriter::writeElement()
+{
+    writeSeparator();
+}
+
+void JsonWriter::endArray()
+{
+    output << ']';
+    firstItem.removeLast();
+}
+
+void JsonWriter::write(qint32 value)
+{
+    output << value;
+}
+
+void JsonWriter::write(qint64 value)
+{
+    output << value;
+}
+
+// Write a number, using the shortest representation that reads back as the
+// same value. Like Python's json module, non-finite values are written as
+// NaN/Infinity, which JsonReader accepts.
+void JsonWriter::write(double value)
+{
+    if (std::isnan(value)) {
+        output << "NaN";
+    } else if (std::isinf(value)) {
+        output << (value < 0 ? "-Infinity" : "Infinity");
+    } else {
+        output << QString::number(value, 'g', QLocale::FloatingPointShortest).toLatin1().constData();
+    }
+}
+
+void JsonWriter::write(bool value)
+{
+    output << (value ? "true" : "false");
+}
+
+void JsonWriter::write(const QString &value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    const QByteArray quoted = quoteString(utf8.constData(), utf8.size());
+    output.write(quoted.constData(), quoted.size());
+}
+
+void JsonWriter::writeUnknown(const QByteArray &unknownMembers)
+{
+    if (unknownMembers.isEmpty()) return;
+
+    writeSeparator();
+    output.write(unknownMembers.constData(), unknownMembers.size());
+}
+
+// Write a comma if this isn't the first item in the current object/array
+void JsonWriter::writeSeparator()
+{
+    if (firstItem.isEmpty()) return;
+
+    if (!firstItem.last()) output << ',';
+    firstItem.last() = false;
+}
@@ -0,0 +1,177 @@
+/************************************************************************
+
+    jsonio.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef JSONIO_H
+#define JSONIO_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <istream>
+#include <ostream>
+#include <string>
+
+// Streaming JSON reader.
+//
+// Rather than building a document tree, the caller walks through the input
+// in order, saying what structure it expects to see next, and reads values
+// directly into its own variables. For example, to read {"a": 1, "b": [2, 3]}:
+//
+//     reader.beginObject();
+//     std::string member;
+//     while (reader.readMember(member)) {
+//         if (member == "a") {
+//             reader.read(a);
+//         } else if (member == "b") {
+//             reader.beginArray();
+//             while (reader.readElement()) reader.read(value);
+//             reader.endArray();
+//         } else {
+//             reader.discard();
+//         }
+//     }
+//     reader.endObject();
+//
+// Instead of discarding members it doesn't recognise, the caller can keep
+// them with readUnknown, and write them back out with
+// JsonWriter::writeUnknown. This lets a tool rewrite a file without losing
+// members that were added by ld-decode or another tool.
+//
+// As with QXmlStreamReader, errors are sticky: once the input doesn't match
+// what's expected, hasError() becomes true, and all further calls do nothing
+// (readMember/readElement return false, so loops finish). The caller only
+// needs to check hasError() at the end.
+class JsonReader
+{
+public:
+    explicit JsonReader(std::istream &input);
+
+    // Prevent copying or assignment
+    JsonReader(const JsonReader &) = delete;
+    JsonReader& operator=(const JsonReader &) = delete;
+
+    // Objects. readMember returns false at the end of the object.
+    void beginObject();
+    bool readMember(std::string &member);
+    void endObject();
+
+    // Arrays. readElement returns false at the end of the array.
+    void beginArray();
+    bool readElement();
+    void endArray();
+
+    // Read a value. Numbers are converted to the requested type (rounding
+    // to the nearest integer if necessary), and null reads as zero/false/empty.
+    void read(qint32 &value);
+    void read(qint64 &value);
+    void read(double &value);
+    void read(bool &value);
+    void read(QString &value);
+
+    // Skip over a value of any type
+    void discard();
+
+    // Read a value of any type as JSON text, and append it to unknownMembers
+    // as the member called member (in the form "a":1,"b":[2])
+    void readUnknown(const std::string &member, QByteArray &unknownMembers);
+
+    // Check for the end of the input
+    bool atEnd();
+
+    // Error handling
+    bool hasError() const;
+    QString errorString() const;
+    void raiseError(const QString &message);
+
+private:
+    std::istream &input;
+    qint64 lineNumber;
+    bool error;
+    QString errorMessage;
+
+    // For each open object/array, whether we're still at the first item
+    QVector<bool> firstItem;
+
+    // Reused buffers for parsing
+    std::string numberBuffer;
+    std::string stringBuffer;
+
+    // If not null, the input consumed by get is appended to this
+    QByteArray *capture;
+
+    int get();
+    int peekToken();
+    bool expect(char c);
+    bool readNull();
+    bool readLiteral(const char *literal);
+    bool readNumber(double &value, bool &isInteger, qint64 &integerValue);
+    bool readString(std::string &value);
+    bool readHexDigits(quint32 &value);
+};
+
+// Streaming JSON writer.
+//
+// The counterpart of JsonReader: the caller writes the structure in order,
+// and the writer takes care of separators. The output is compact, with no
+// whitespace.
+class JsonWriter
+{
+public:
+    explicit JsonWriter(std::ostream &output);
+
+    // Prevent copying or assignment
+    JsonWriter(const JsonWriter &) = delete;
+    JsonWriter& operator=(const JsonWriter &) = delete;
+
+    // Objects. Call writeMember before writing each member's value.
+    void beginObject();
+    void writeMember(const char *member);
+    void endObject();
+
+    // Arrays. Call writeElement before writing each element.
+    void beginArray();
+    void writeElement();
+    void endArray();
+
+    // Write a value
+    void write(qint32 value);
+    void write(qint64 value);
+    void write(double value);
+    void write(bool value);
+    void write(const QString &value);
+
+    // Write the members collected by JsonReader::readUnknown into the
+    // current object
+    void writeUnknown(const QByteArray &unknownMembers);
+
+private:
+    std::ostream &output;
+
+    // For each open object/array, whether we're still at the first item
+    QVector<bool> firstItem;
+
+    void writeSeparator();
+};
+
+#endif // JSONIO_H
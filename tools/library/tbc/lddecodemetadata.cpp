@@ -24,6 +24,15 @@
 
 #include "lddecodemetadata.h"
 
+#include "jsonio.h"
+
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+
 // Default line parameters for PAL decoding
 const qint32 LdDecodeMetaData::LineParameters::sMinPALFirstActiveFrameLine = 2;
 const qint32 LdDecodeMetaData::LineParameters::sDefaultPALFirstActiveFieldLine = 22;
@@ -53,17 +62,419 @@ LdDecodeMetaData::LdDecodeMetaData()
     isFirstFieldFirst = false;
 }
 
+// Each of the metadata structures knows how to read and write its own JSON
+// representation. The read methods expect the reader to be positioned at
+// the start of the structure's object; members that aren't recognised are
+// kept in unknownMembers, and members that are missing keep their default
+// values. The write methods write the known members followed by the unknown
+// ones.
+
+void LdDecodeMetaData::VideoParameters::read(JsonReader &reader)
+{
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "numberOfSequentialFields") reader.read(numberOfSequentialFields);
+        else if (member == "isSourcePal") reader.read(isSourcePal);
+        else if (member == "isSubcarrierLocked") reader.read(isSubcarrierLocked);
+        else if (member == "isWidescreen") reader.read(isWidescreen);
+        else if (member == "colourBurstStart") reader.read(colourBurstStart);
+        else if (member == "colourBurstEnd") reader.read(colourBurstEnd);
+        else if (member == "activeVideoStart") reader.read(activeVideoStart);
+        else if (member == "activeVideoEnd") reader.read(activeVideoEnd);
+        else if (member == "white16bIre") reader.read(white16bIre);
+        else if (member == "black16bIre") reader.read(black16bIre);
+        else if (member == "fieldWidth") reader.read(fieldWidth);
+        else if (member == "fieldHeight") reader.read(fieldHeight);
+        else if (member == "sampleRate") reader.read(sampleRate);
+        else if (member == "fsc") reader.read(fsc);
+        else if (member == "isMapped") reader.read(isMapped);
+        else if (member == "gitBranch") reader.read(gitBranch);
+        else if (member == "gitCommit") reader.read(gitCommit);
+        else reader.readUnknown(member, unknownMembers);
+    }
+    reader.endObject();
+
+    isValid = true;
+}
+
+void LdDecodeMetaData::VideoParameters::write(JsonWriter &writer) const
+{
+    writer.beginObject();
+    writer.writeMember("numberOfSequentialFields");
+    writer.write(numberOfSequentialFields);
+    writer.writeMember("isSourcePal");
+    writer.write(isSourcePal);
+    writer.writeMember("isSubcarrierLocked");
+    writer.write(isSubcarrierLocked);
+    writer.writeMember("isWidescreen");
+    writer.write(isWidescreen);
+
+    writer.writeMember("colourBurstStart");
+    writer.write(colourBurstStart);
+    writer.writeMember("colourBurstEnd");
+    writer.write(colourBurstEnd);
+    writer.writeMember("activeVideoStart");
+    writer.write(activeVideoStart);
+    writer.writeMember("activeVideoEnd");
+    writer.write(activeVideoEnd);
+
+    writer.writeMember("white16bIre");
+    writer.write(white16bIre);
+    writer.writeMember("black16bIre");
+    writer.write(black16bIre);
+
+    writer.writeMember("fieldWidth");
+    writer.write(fieldWidth);
+    writer.writeMember("fieldHeight");
+    writer.write(fieldHeight);
+    writer.writeMember("sampleRate");
+    writer.write(sampleRate);
+    writer.writeMember("fsc");
+    writer.write(fsc);
+
+    writer.writeMember("isMapped");
+    writer.write(isMapped);
+
+    writer.writeMember("gitBranch");
+    writer.write(gitBranch);
+    writer.writeMember("gitCommit");
+    writer.write(gitCommit);
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+}
+
+void LdDecodeMetaData::PcmAudioParameters::read(JsonReader &reader)
+{
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "sampleRate") reader.read(sampleRate);
+        else if (member == "isLittleEndian") reader.read(isLittleEndian);
+        else if (member == "isSigned") reader.read(isSigned);
+        else if (member == "bits") reader.read(bits);
+        else reader.readUnknown(member, unknownMembers);
+    }
+    reader.endObject();
+
+    isValid = true;
+}
+
+void LdDecodeMetaData::PcmAudioParameters::write(JsonWriter &writer) const
+{
+    writer.beginObject();
+    writer.writeMember("sampleRate");
+    writer.write(sampleRate);
+    writer.writeMember("isLittleEndian");
+    writer.write(isLittleEndian);
+    writer.writeMember("isSigned");
+    writer.write(isSigned);
+    writer.writeMember("bits");
+    writer.write(bits);
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+}
+
+void LdDecodeMetaData::VitsMetrics::read(JsonReader &reader)
+{
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "wSNR") reader.read(wSNR);
+        else if (member == "bPSNR") reader.read(bPSNR);
+        else reader.readUnknown(member, unknownMembers);
+    }
+    reader.endObject();
+
+    inUse = true;
+}
+
+void LdDecodeMetaData::VitsMetrics::write(JsonWriter &writer) const
+{
+    writer.beginObject();
+    writer.writeMember("wSNR");
+    writer.write(wSNR);
+    writer.writeMember("bPSNR");
+    writer.write(bPSNR);
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+}
+
+void LdDecodeMetaData::Vbi::read(JsonReader &reader)
+{
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "vbiData") {
+            // Lines 16, 17 and 18. Consumers index vbiData directly, so
+            // always keep exactly three entries; there's nowhere to keep any
+            // more, so reject them rather than losing them on the next write.
+            vbiData.fill(0, 3);
+            qint32 line = 0;
+
+            reader.beginArray();
+            while (reader.readElement()) {
+                if (line == 3) {
+                    reader.raiseError("vbiData has more than three elements");
+                    break;
+                }
+                reader.read(vbiData[line]);
+                line++;
+            }
+            reader.endArray();
+        } else {
+            reader.readUnknown(member, unknownMembers);
+        }
+    }
+    reader.endObject();
+
+    inUse = true;
+}
+
+void LdDecodeMetaData::Vbi::write(JsonWriter &writer) const
+{
+    writer.beginObject();
+    writer.writeMember("vbiData");
+    writer.beginArray();
+    for (qint32 value : vbiData) {
+        writer.writeElement();
+        writer.write(value);
+    }
+    writer.endArray();
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+}
+
+void LdDecodeMetaData::Ntsc::read(JsonReader &reader)
+{
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "isFmCodeDataValid") reader.read(isFmCodeDataValid);
+        else if (member == "fmCodeData") reader.read(fmCodeData);
+        else if (member == "fieldFlag") reader.read(fieldFlag);
+        else if (member == "whiteFlag") reader.read(whiteFlag);
+        else if (member == "ccData0") reader.read(ccData0);
+        else if (member == "ccData1") reader.read(ccData1);
+        else reader.readUnknown(member, unknownMembers);
+    }
+    reader.endObject();
+
+    inUse = true;
+}
+
+void LdDecodeMetaData::Ntsc::write(JsonWriter &writer) const
+{
+    writer.beginObject();
+    writer.writeMember("isFmCodeDataValid");
+    writer.write(isFmCodeDataValid);
+    writer.writeMember("fmCodeData");
+    writer.write(isFmCodeDataValid ? fmCodeData : -1);
+    writer.writeMember("fieldFlag");
+    writer.write(fieldFlag);
+    writer.writeMember("whiteFlag");
+    writer.write(whiteFlag);
+    writer.writeMember("ccData0");
+    writer.write(ccData0);
+    writer.writeMember("ccData1");
+    writer.write(ccData1);
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+}
+
+// Read an array of integers into a vector
+static void readIntArray(JsonReader &reader, QVector<qint32> &values)
+{
+    values.clear();
+
+    reader.beginArray();
+    while (reader.readElement()) {
+        qint32 value;
+        reader.read(value);
+        values.append(value);
+    }
+    reader.endArray();
+}
+
+// Write a sequence of integers as an array
+template <typename Getter>
+static void writeIntArray(JsonWriter &writer, qint32 size, Getter getter)
+{
+    writer.beginArray();
+    for (qint32 i = 0; i < size; i++) {
+        writer.writeElement();
+        writer.write(getter(i));
+    }
+    writer.endArray();
+}
+
+// Read a dropouts object
+static void readDropOuts(JsonReader &reader, DropOuts &dropOuts, QByteArray &unknownMembers)
+{
+    QVector<qint32> startx, endx, fieldLine;
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "startx") readIntArray(reader, startx);
+        else if (member == "endx") readIntArray(reader, endx);
+        else if (member == "fieldLine") readIntArray(reader, fieldLine);
+        else reader.readUnknown(member, unknownMembers);
+    }
+    reader.endObject();
+
+    // Ensure that all three arrays are the same size
+    if (startx.size() != endx.size() || startx.size() != fieldLine.size()) {
+        reader.raiseError("Dropouts object is illegal");
+    }
+
+    dropOuts = DropOuts(startx, endx, fieldLine);
+}
+
+// Write a dropouts object
+static void writeDropOuts(JsonWriter &writer, const DropOuts &dropOuts, const QByteArray &unknownMembers)
+{
+    writer.beginObject();
+    writer.writeMember("startx");
+    writeIntArray(writer, dropOuts.size(), [&](qint32 i) { return dropOuts.startx(i); });
+    writer.writeMember("endx");
+    writeIntArray(writer, dropOuts.size(), [&](qint32 i) { return dropOuts.endx(i); });
+    writer.writeMember("fieldLine");
+    writeIntArray(writer, dropOuts.size(), [&](qint32 i) { return dropOuts.fieldLine(i); });
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+}
+
+void LdDecodeMetaData::Field::read(JsonReader &reader)
+{
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "seqNo") reader.read(seqNo);
+        else if (member == "isFirstField") reader.read(isFirstField);
+        else if (member == "syncConf") reader.read(syncConf);
+        else if (member == "medianBurstIRE") reader.read(medianBurstIRE);
+        else if (member == "fieldPhaseID") reader.read(fieldPhaseID);
+        else if (member == "audioSamples") reader.read(audioSamples);
+        else if (member == "diskLoc") reader.read(diskLoc);
+        else if (member == "fileLoc") reader.read(fileLoc);
+        else if (member == "decodeFaults") reader.read(decodeFaults);
+        else if (member == "efmTValues") reader.read(efmTValues);
+        else if (member == "vitsMetrics") vitsMetrics.read(reader);
+        else if (member == "vbi") vbi.read(reader);
+        else if (member == "ntsc") ntsc.read(reader);
+        else if (member == "dropOuts") readDropOuts(reader, dropOuts, dropOutsUnknownMembers);
+        else if (member == "pad") reader.read(pad);
+        else reader.readUnknown(member, unknownMembers);
+    }
+    reader.endObject();
+}
+
+void LdDecodeMetaData::Field::write(JsonWriter &writer) const
+{
+    writer.beginObject();
+    writer.writeMember("seqNo");
+    writer.write(seqNo);
+    writer.writeMember("isFirstField");
+    writer.write(isFirstField);
+    writer.writeMember("syncConf");
+    writer.write(syncConf);
+    writer.writeMember("medianBurstIRE");
+    writer.write(medianBurstIRE);
+    writer.writeMember("fieldPhaseID");
+    writer.write(fieldPhaseID);
+    writer.writeMember("audioSamples");
+    writer.write(audioSamples);
+
+    writer.writeMember("diskLoc");
+    writer.write(diskLoc);
+    writer.writeMember("fileLoc");
+    writer.write(fileLoc);
+    writer.writeMember("decodeFaults");
+    writer.write(decodeFaults);
+    writer.writeMember("efmTValues");
+    writer.write(efmTValues);
+
+    if (vitsMetrics.inUse) {
+        writer.writeMember("vitsMetrics");
+        vitsMetrics.write(writer);
+    }
+
+    if (vbi.inUse) {
+        writer.writeMember("vbi");
+        vbi.write(writer);
+    }
+
+    if (ntsc.inUse) {
+        writer.writeMember("ntsc");
+        ntsc.write(writer);
+    }
+
+    if (dropOuts.size() != 0 || !dropOutsUnknownMembers.isEmpty()) {
+        writer.writeMember("dropOuts");
+        writeDropOuts(writer, dropOuts, dropOutsUnknownMembers);
+    }
+
+    writer.writeMember("pad");
+    writer.write(pad);
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+}
+
 // This method opens the JSON metadata file and reads the content into the
 // metadata structure read for use
 bool LdDecodeMetaData::read(QString fileName)
 {
-    // Open the JSON file
-    qDebug() << "LdDecodeMetaData::read(): Loading JSON file" << fileName;
-    if (!json.loadFile(fileName)) {
-        qCritical() << "JSON wax library error:" << json.errorMsg();
-        qCritical("Opening JSON file failed: JSON file cannot be opened/does not exist");
+    // Discard any existing metadata
+    videoParameters = VideoParameters();
+    pcmAudioParameters = PcmAudioParameters();
+    fields.clear();
+    unknownMembers.clear();
+
+    // Use the binary sidecar if it's up to date; otherwise parse the JSON
+    const QString binaryFileName = getBinaryFileName(fileName);
+    if (readBinary(binaryFileName, QFileInfo(fileName))) {
+        qDebug() << "LdDecodeMetaData::read(): Using binary metadata file" << binaryFileName;
+    } else {
+        qDebug() << "LdDecodeMetaData::read(): Loading JSON file" << fileName;
+        std::ifstream jsonFile(QFile::encodeName(fileName).constData());
+        if (jsonFile.fail()) {
+            qCritical("Opening JSON file failed: JSON file cannot be opened/does not exist");
+            return false;
+        }
 
-        return false;
+        // Parse the file in a single pass, filling in the metadata structures
+        // directly as we go
+        JsonReader reader(jsonFile);
+        std::string member;
+
+        reader.beginObject();
+        while (reader.readMember(member)) {
+            if (member == "videoParameters") {
+                videoParameters.read(reader);
+
+                // Avoid reallocating the field vector as it grows
+                if (videoParameters.numberOfSequentialFields > 0) {
+                    fields.reserve(videoParameters.numberOfSequentialFields);
+                }
+            }
+            else if (member == "pcmAudioParameters") pcmAudioParameters.read(reader);
+            else if (member == "fields") readFields(reader);
+            else reader.readUnknown(member, unknownMembers);
+        }
+        reader.endObject();
+
+        if (reader.hasError()) {
+            qCritical() << "JSON parser error:" << reader.errorString();
+            qCritical("Opening JSON file failed: JSON file is invalid");
+            return false;
+        }
     }
 
     // Default to the standard still-frame field order (of first field first)
@@ -75,107 +486,764 @@ bool LdDecodeMetaData::read(QString fileName)
     return true;
 }
 
+// Read the array of field records
+void LdDecodeMetaData::readFields(JsonReader &reader)
+{
+    Field field;
+
+    reader.beginArray();
+    while (reader.readElement()) {
+        field = Field();
+        field.read(reader);
+        fields.append(field);
+    }
+    reader.endArray();
+}
+
+// A stream buffer that writes to a QIODevice, so that JsonWriter can write
+// into a QSaveFile
+class DeviceStreamBuf : public std::streambuf
+{
+public:
+    explicit DeviceStreamBuf(QIODevice &_device)
+        : device(_device), buffer(65536, '\0')
+    {
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!writeBuffer()) return traits_type::eof();
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        return writeBuffer() ? 0 : -1;
+    }
+
+private:
+    QIODevice &device;
+    QByteArray buffer;
+
+    // Write out the buffered data, and empty the buffer
+    bool writeBuffer()
+    {
+        const qint64 size = pptr() - pbase();
+        if (size > 0 && device.write(pbase(), size) != size) return false;
+        setp(buffer.data(), buffer.data() + buffer.size());
+        return true;
+    }
+};
+
 // This method copies the metadata structure into a JSON metadata file
 bool LdDecodeMetaData::write(QString fileName)
 {
-    // Write the JSON object
+    // Write the JSON object. This is often replacing the file the metadata
+    // was read from, so it's written with QSaveFile: the existing file is
+    // only replaced once the new one is complete, and is left intact if
+    // writing fails or the program is interrupted.
     qDebug() << "LdDecodeMetaData::write(): Writing JSON metadata to:" << fileName;
-    if (!json.saveAs(fileName, JsonWax::Compact)) {
+    QSaveFile jsonFile(fileName);
+    if (!jsonFile.open(QIODevice::WriteOnly)) {
+        qCritical("Writing JSON metadata file failed!");
+        return false;
+    }
+
+    DeviceStreamBuf jsonBuffer(jsonFile);
+    std::ostream jsonStream(&jsonBuffer);
+    JsonWriter writer(jsonStream);
+
+    writer.beginObject();
+
+    if (pcmAudioParameters.isValid) {
+        writer.writeMember("pcmAudioParameters");
+        pcmAudioParameters.write(writer);
+    }
+
+    if (videoParameters.isValid) {
+        writer.writeMember("videoParameters");
+        videoParameters.write(writer);
+    }
+
+    writer.writeMember("fields");
+    writeFields(writer);
+
+    writer.writeUnknown(unknownMembers);
+    writer.endObject();
+
+    jsonStream.flush();
+    if (jsonStream.fail() || !jsonFile.commit()) {
         qCritical("Writing JSON metadata file failed!");
         return false;
     }
 
+    // Now the new JSON is in place, write the binary sidecar to match. This
+    // is only a cache, so failing to write it isn't an error.
+    if (!writeBinary(getBinaryFileName(fileName), QFileInfo(fileName))) {
+        qWarning() << "Could not write binary metadata file" << getBinaryFileName(fileName);
+    }
+
     return true;
 }
 
-// This method returns the videoParameters metadata
-LdDecodeMetaData::VideoParameters LdDecodeMetaData::getVideoParameters()
+// Write the array of field records
+void LdDecodeMetaData::writeFields(JsonWriter &writer) const
 {
-    if (videoParameters.isValid) {
-        // Return our existing video parameters
-        return videoParameters;
-    } else if (json.size({"videoParameters"}) > 0) {
-        // Read the video paramters
-        videoParameters.numberOfSequentialFields = json.value({"videoParameters", "numberOfSequentialFields"}).toInt();
-        videoParameters.isSourcePal = json.value({"videoParameters", "isSourcePal"}).toBool();
-        videoParameters.isSubcarrierLocked = json.value({"videoParameters", "isSubcarrierLocked"}).toBool();
-        videoParameters.isWidescreen = json.value({"videoParameters", "isWidescreen"}).toBool();
-
-        videoParameters.colourBurstStart = json.value({"videoParameters", "colourBurstStart"}).toInt();
-        videoParameters.colourBurstEnd = json.value({"videoParameters", "colourBurstEnd"}).toInt();
-        videoParameters.activeVideoStart = json.value({"videoParameters", "activeVideoStart"}).toInt();
-        videoParameters.activeVideoEnd = json.value({"videoParameters", "activeVideoEnd"}).toInt();
-
-        videoParameters.white16bIre = json.value({"videoParameters", "white16bIre"}).toInt();
-        videoParameters.black16bIre = json.value({"videoParameters", "black16bIre"}).toInt();
-
-        videoParameters.fieldWidth = json.value({"videoParameters", "fieldWidth"}).toInt();
-        videoParameters.fieldHeight = json.value({"videoParameters", "fieldHeight"}).toInt();
-        videoParameters.sampleRate = json.value({"videoParameters", "sampleRate"}).toInt();
-        videoParameters.fsc = json.value({"videoParameters", "fsc"}).toInt();
-
-        videoParameters.isMapped = json.value({"videoParameters", "isMapped"}).toBool();
-
-        videoParameters.gitBranch = json.value({"videoParameters", "gitBranch"}).toString();
-        videoParameters.gitCommit = json.value({"videoParameters", "gitCommit"}).toString();
-        
+    writer.beginArray();
+    for (qint32 i = 0; i < fields.size(); i++) {
+        writer.writeElement();
+        fields.get(i).write(writer);
+    }
+    writer.endArray();
+}
+
+// Field columns ---------------------------------------------------------------------------------------------------
+
+// Boolean members of a field, packed into the flags column. The binary
+// sidecar uses the same bits.
+enum FieldFlags : quint32 {
+    fieldIsFirstField = 1 << 0,
+    fieldPad = 1 << 1,
+    fieldVitsMetricsInUse = 1 << 2,
+    fieldVbiInUse = 1 << 3,
+    fieldNtscInUse = 1 << 4,
+    fieldIsFmCodeDataValid = 1 << 5,
+    fieldFieldFlag = 1 << 6,
+    fieldWhiteFlag = 1 << 7,
+};
+
+void LdDecodeMetaData::FieldColumns::clear()
+{
+    resize(0);
+    reserve(0);
+}
+
+void LdDecodeMetaData::FieldColumns::reserve(qint32 size)
+{
+    seqNo.reserve(size);
+    flags.reserve(size);
+    syncConf.reserve(size);
+    medianBurstIRE.reserve(size);
+    fieldPhaseID.reserve(size);
+    audioSamples.reserve(size);
+    diskLoc.reserve(size);
+    fileLoc.reserve(size);
+    decodeFaults.reserve(size);
+    efmTValues.reserve(size);
+    wSNR.reserve(size);
+    bPSNR.reserve(size);
+    vbiData.reserve(size * 3);
+    fmCodeData.reserve(size);
+    ccData0.reserve(size);
+    ccData1.reserve(size);
+    dropOuts.reserve(size);
+    unknownMembers.reserve(size);
+    vitsUnknownMembers.reserve(size);
+    vbiUnknownMembers.reserve(size);
+    ntscUnknownMembers.reserve(size);
+    dropOutsUnknownMembers.reserve(size);
+}
+
+// Resize the columns; new fields have the same values as a default Field
+void LdDecodeMetaData::FieldColumns::resize(qint32 size)
+{
+    seqNo.resize(size);
+    flags.resize(size);
+    syncConf.resize(size);
+    medianBurstIRE.resize(size);
+    fieldPhaseID.resize(size);
+    audioSamples.resize(size);
+    diskLoc.resize(size);
+    fileLoc.resize(size);
+    decodeFaults.resize(size);
+    efmTValues.resize(size);
+    wSNR.resize(size);
+    bPSNR.resize(size);
+    vbiData.resize(size * 3);
+    fmCodeData.resize(size);
+    ccData0.resize(size);
+    ccData1.resize(size);
+    dropOuts.resize(size);
+    unknownMembers.resize(size);
+    vitsUnknownMembers.resize(size);
+    vbiUnknownMembers.resize(size);
+    ntscUnknownMembers.resize(size);
+    dropOutsUnknownMembers.resize(size);
+}
+
+void LdDecodeMetaData::FieldColumns::append(const Field &field)
+{
+    const qint32 fieldNumber = size();
+    resize(fieldNumber + 1);
+    set(fieldNumber, field);
+}
+
+// Build a Field from the columns
+LdDecodeMetaData::Field LdDecodeMetaData::FieldColumns::get(qint32 fieldNumber) const
+{
+    const quint32 fieldFlags = flags[fieldNumber];
+
+    Field field;
+    field.seqNo = seqNo[fieldNumber];
+    field.isFirstField = (fieldFlags & fieldIsFirstField) != 0;
+    field.syncConf = syncConf[fieldNumber];
+    field.medianBurstIRE = medianBurstIRE[fieldNumber];
+    field.fieldPhaseID = fieldPhaseID[fieldNumber];
+    field.audioSamples = audioSamples[fieldNumber];
+    field.vitsMetrics = getVitsMetrics(fieldNumber);
+    field.vbi = getVbi(fieldNumber);
+    field.ntsc = getNtsc(fieldNumber);
+    field.dropOuts = dropOuts[fieldNumber];
+    field.dropOutsUnknownMembers = dropOutsUnknownMembers[fieldNumber];
+    field.pad = (fieldFlags & fieldPad) != 0;
+    field.diskLoc = diskLoc[fieldNumber];
+    field.fileLoc = fileLoc[fieldNumber];
+    field.decodeFaults = decodeFaults[fieldNumber];
+    field.efmTValues = efmTValues[fieldNumber];
+    field.unknownMembers = unknownMembers[fieldNumber];
+
+    return field;
+}
+
+LdDecodeMetaData::VitsMetrics LdDecodeMetaData::FieldColumns::getVitsMetrics(qint32 fieldNumber) const
+{
+    VitsMetrics vitsMetrics;
+    vitsMetrics.inUse = (flags[fieldNumber] & fieldVitsMetricsInUse) != 0;
+    vitsMetrics.wSNR = wSNR[fieldNumber];
+    vitsMetrics.bPSNR = bPSNR[fieldNumber];
+    vitsMetrics.unknownMembers = vitsUnknownMembers[fieldNumber];
+
+    return vitsMetrics;
+}
+
+LdDecodeMetaData::Vbi LdDecodeMetaData::FieldColumns::getVbi(qint32 fieldNumber) const
+{
+    Vbi vbi;
+    vbi.inUse = (flags[fieldNumber] & fieldVbiInUse) != 0;
+    for (qint32 line = 0; line < 3; line++) {
+        vbi.vbiData[line] = vbiData[(fieldNumber * 3) + line];
+    }
+    vbi.unknownMembers = vbiUnknownMembers[fieldNumber];
+
+    return vbi;
+}
+
+LdDecodeMetaData::Ntsc LdDecodeMetaData::FieldColumns::getNtsc(qint32 fieldNumber) const
+{
+    const quint32 fieldFlags = flags[fieldNumber];
+
+    Ntsc ntsc;
+    ntsc.inUse = (fieldFlags & fieldNtscInUse) != 0;
+    ntsc.isFmCodeDataValid = (fieldFlags & fieldIsFmCodeDataValid) != 0;
+    ntsc.fmCodeData = fmCodeData[fieldNumber];
+    ntsc.fieldFlag = (fieldFlags & fieldFieldFlag) != 0;
+    ntsc.whiteFlag = (fieldFlags & fieldWhiteFlag) != 0;
+    ntsc.ccData0 = ccData0[fieldNumber];
+    ntsc.ccData1 = ccData1[fieldNumber];
+    ntsc.unknownMembers = ntscUnknownMembers[fieldNumber];
+
+    return ntsc;
+}
+
+// Store a Field into the columns. The VBI data is truncated or zero-padded to
+// three entries.
+void LdDecodeMetaData::FieldColumns::set(qint32 fieldNumber, const Field &field)
+{
+    seqNo[fieldNumber] = field.seqNo;
+    syncConf[fieldNumber] = field.syncConf;
+    medianBurstIRE[fieldNumber] = field.medianBurstIRE;
+    fieldPhaseID[fieldNumber] = field.fieldPhaseID;
+    audioSamples[fieldNumber] = field.audioSamples;
+    diskLoc[fieldNumber] = field.diskLoc;
+    fileLoc[fieldNumber] = field.fileLoc;
+    decodeFaults[fieldNumber] = field.decodeFaults;
+    efmTValues[fieldNumber] = field.efmTValues;
+    wSNR[fieldNumber] = field.vitsMetrics.wSNR;
+    bPSNR[fieldNumber] = field.vitsMetrics.bPSNR;
+    for (qint32 line = 0; line < 3; line++) {
+        vbiData[(fieldNumber * 3) + line] = line < field.vbi.vbiData.size() ? field.vbi.vbiData[line] : 0;
+    }
+    fmCodeData[fieldNumber] = field.ntsc.fmCodeData;
+    ccData0[fieldNumber] = field.ntsc.ccData0;
+    ccData1[fieldNumber] = field.ntsc.ccData1;
+    dropOuts[fieldNumber] = field.dropOuts;
+    unknownMembers[fieldNumber] = field.unknownMembers;
+    vitsUnknownMembers[fieldNumber] = field.vitsMetrics.unknownMembers;
+    vbiUnknownMembers[fieldNumber] = field.vbi.unknownMembers;
+    ntscUnknownMembers[fieldNumber] = field.ntsc.unknownMembers;
+    dropOutsUnknownMembers[fieldNumber] = field.dropOutsUnknownMembers;
+
+    quint32 fieldFlags = 0;
+    if (field.isFirstField) fieldFlags |= fieldIsFirstField;
+    if (field.pad) fieldFlags |= fieldPad;
+    if (field.vitsMetrics.inUse) fieldFlags |= fieldVitsMetricsInUse;
+    if (field.vbi.inUse) fieldFlags |= fieldVbiInUse;
+    if (field.ntsc.inUse) fieldFlags |= fieldNtscInUse;
+    if (field.ntsc.isFmCodeDataValid) fieldFlags |= fieldIsFmCodeDataValid;
+    if (field.ntsc.fieldFlag) fieldFlags |= fieldFieldFlag;
+    if (field.ntsc.whiteFlag) fieldFlags |= fieldWhiteFlag;
+    flags[fieldNumber] = fieldFlags;
+}
+
+void LdDecodeMetaData::FieldColumns::setFlag(qint32 fieldNumber, quint32 flag, bool value)
+{
+    if (value) flags[fieldNumber] |= flag;
+    else flags[fieldNumber] &= ~flag;
+}
+
+// Binary sidecar --------------------------------------------------------------------------------------------------
+
+// Alongside the JSON file, write() also writes a binary copy of the metadata
+// (with the .json extension replaced by .bin), which read() uses in
+// preference to the JSON when it's up to date. The field table has the same
+// encoding as the field columns, so loading the sidecar doesn't need any
+// parsing.
+//
+// The layout, in host byte order (little-endian only), is:
+//   BinaryHeader
+//   BinaryField[numberOfFields]
+//   BinaryDropOut[numberOfDropOuts] - referenced by ranges in BinaryField
+//   string table - gitBranch and gitCommit in UTF-8, then the unknown
+//                  JSON members of the metadata, parameters and each field
+//
+// The sidecar records the size and modification time of the JSON file it was
+// written with; if the JSON has been changed since (e.g. by ld-decode or a
+// tool that doesn't know about the sidecar), the sidecar is ignored.
+//
+// If the layout changes, increase binaryVersion.
+
+static const char binaryMagic[8] = {'L', 'D', 'T', 'B', 'C', 'M', 'D', '\0'};
+static const quint32 binaryVersion = 3;
+
+struct BinaryHeader {
+    char magic[8];
+    quint32 version;
+    quint32 headerSize;
+    qint64 jsonSize;
+    qint64 jsonModified;
+    quint64 fieldTableOffset;
+    quint64 dropOutTableOffset;
+    quint64 stringTableOffset;
+    quint32 numberOfFields;
+    quint32 fieldSize;
+    quint64 numberOfDropOuts;
+    quint32 stringTableSize;
+    quint32 flags;
+
+    qint32 numberOfSequentialFields;
+    qint32 colourBurstStart;
+    qint32 colourBurstEnd;
+    qint32 activeVideoStart;
+    qint32 activeVideoEnd;
+    qint32 white16bIre;
+    qint32 black16bIre;
+    qint32 fieldWidth;
+    qint32 fieldHeight;
+    qint32 sampleRate;
+    qint32 fsc;
+
+    qint32 pcmSampleRate;
+    qint32 pcmBits;
+
+    quint32 gitBranchSize;
+    quint32 gitCommitSize;
+    quint32 unknownMembersSize;
+    quint32 videoUnknownMembersSize;
+    quint32 pcmUnknownMembersSize;
+};
+static_assert(sizeof(BinaryHeader) == 152, "BinaryHeader layout has changed");
+
+// Flags in BinaryHeader
+enum BinaryHeaderFlags : quint32 {
+    headerVideoParametersValid = 1 << 0,
+    headerIsSourcePal = 1 << 1,
+    headerIsSubcarrierLocked = 1 << 2,
+    headerIsWidescreen = 1 << 3,
+    headerIsMapped = 1 << 4,
+    headerPcmAudioParametersValid = 1 << 5,
+    headerPcmIsLittleEndian = 1 << 6,
+    headerPcmIsSigned = 1 << 7,
+};
+
+struct BinaryField {
+    qint32 seqNo;
+    qint32 syncConf;
+    qint32 fieldPhaseID;
+    qint32 audioSamples;
+    qint32 decodeFaults;
+    qint32 efmTValues;
+    qint64 fileLoc;
+
+    double diskLoc;
+    double medianBurstIRE;
+    double wSNR;
+    double bPSNR;
+
+    qint32 vbiData[3];
+
+    qint32 fmCodeData;
+    qint32 ccData0;
+    qint32 ccData1;
+
+    quint32 flags;              // FieldFlags
+
+    // Range of entries in the dropout table
+    quint32 numberOfDropOuts;
+    quint64 firstDropOut;
+
+    // Unknown members of the field, then its vitsMetrics, vbi, ntsc and
+    // dropOuts objects, stored consecutively from this offset in the string
+    // table
+    quint64 firstUnknownMember;
+    quint32 unknownMembersSize[5];
+    quint32 reserved;
+};
+static_assert(sizeof(BinaryField) == 136, "BinaryField layout has changed");
+
+struct BinaryDropOut {
+    qint32 startx;
+    qint32 endx;
+    qint32 fieldLine;
+};
+static_assert(sizeof(BinaryDropOut) == 12, "BinaryDropOut layout has changed");
+
+// Copy size bytes from the string table, and advance data past them
+static QByteArray takeString(const char *&data, quint32 size)
+{
+    const char *start = data;
+    data += size;
+    if (size == 0) return QByteArray();
+    return QByteArray(start, static_cast<int>(size));
+}
+
+// Return the name of the binary sidecar for a JSON file
+QString LdDecodeMetaData::getBinaryFileName(const QString &jsonFileName)
+{
+    if (jsonFileName.endsWith(".json")) return jsonFileName.left(jsonFileName.size() - 5) + ".bin";
+    return jsonFileName + ".bin";
+}
+
+// Load the binary sidecar into the field columns, if it's valid and matches
+// the JSON file. Returns true on success; on failure, the caller should read
+// the JSON instead.
+bool LdDecodeMetaData::readBinary(const QString &binaryFileName, const QFileInfo &jsonFileInfo)
+{
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    // The sidecar is only supported on little-endian machines
+    return false;
+#endif
+
+    if (!QFileInfo::exists(binaryFileName)) return false;
+
+    QFile binaryFile(binaryFileName);
+    if (!binaryFile.open(QIODevice::ReadOnly)) {
+        qDebug() << "LdDecodeMetaData::readBinary(): Cannot open binary metadata -" << binaryFile.errorString();
+        return false;
+    }
+
+    // Check the header matches this version and the JSON file
+    const quint64 fileSize = static_cast<quint64>(binaryFile.size());
+    BinaryHeader header;
+    if (fileSize < sizeof(header)
+        || binaryFile.read(reinterpret_cast<char *>(&header), sizeof(header)) != sizeof(header)
+        || memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0
+        || header.version != binaryVersion
+        || header.headerSize != sizeof(BinaryHeader)
+        || header.fieldSize != sizeof(BinaryField)) {
+        qDebug() << "LdDecodeMetaData::readBinary(): Binary metadata is not in a supported format";
+        binaryFile.close();
+        return false;
+    }
+    if (header.jsonSize != jsonFileInfo.size()
+        || header.jsonModified != jsonFileInfo.lastModified().toMSecsSinceEpoch()) {
+        qDebug() << "LdDecodeMetaData::readBinary(): Binary metadata is out of date, ignoring it";
+        binaryFile.close();
+        return false;
+    }
+
+    // Check the tables are within the file
+    if (header.fieldTableOffset > fileSize
+        || header.numberOfFields > (fileSize - header.fieldTableOffset) / sizeof(BinaryField)
+        || header.dropOutTableOffset > fileSize
+        || header.numberOfDropOuts > (fileSize - header.dropOutTableOffset) / sizeof(BinaryDropOut)
+        || header.stringTableOffset > fileSize
+        || header.stringTableSize > fileSize - header.stringTableOffset
+        || static_cast<quint64>(header.gitBranchSize) + header.gitCommitSize + header.unknownMembersSize
+           + header.videoUnknownMembersSize + header.pcmUnknownMembersSize > header.stringTableSize
+        || (header.fieldTableOffset % alignof(BinaryField)) != 0
+        || (header.dropOutTableOffset % alignof(BinaryDropOut)) != 0) {
+        qDebug() << "LdDecodeMetaData::readBinary(): Binary metadata is truncated or corrupt";
+        binaryFile.close();
+        return false;
+    }
+
+    const uchar *binaryData = binaryFile.map(0, static_cast<qint64>(fileSize));
+    if (binaryData == nullptr) {
+        qDebug() << "LdDecodeMetaData::readBinary(): Could not map binary metadata -" << binaryFile.errorString();
+        binaryFile.close();
+        return false;
+    }
+
+    // Check each field's dropouts and unknown members are within their tables
+    const BinaryField *binaryFields = reinterpret_cast<const BinaryField *>(binaryData + header.fieldTableOffset);
+    for (quint32 i = 0; i < header.numberOfFields; i++) {
+        const quint32 *unknownMembersSize = binaryFields[i].unknownMembersSize;
+        quint64 unknownMembersEnd = binaryFields[i].firstUnknownMember;
+        for (qint32 j = 0; j < 5; j++) unknownMembersEnd += unknownMembersSize[j];
+        if (binaryFields[i].firstDropOut > header.numberOfDropOuts
+            || binaryFields[i].numberOfDropOuts > header.numberOfDropOuts - binaryFields[i].firstDropOut
+            || binaryFields[i].firstUnknownMember > header.stringTableSize
+            || unknownMembersEnd > header.stringTableSize) {
+            qDebug() << "LdDecodeMetaData::readBinary(): Binary metadata has invalid dropouts or members";
+            binaryFile.unmap(const_cast<uchar *>(binaryData));
+            binaryFile.close();
+            return false;
+        }
+    }
+
+    // Copy the field table into the columns
+    const BinaryDropOut *binaryDropOuts = reinterpret_cast<const BinaryDropOut *>(binaryData + header.dropOutTableOffset);
+    const char *strings = reinterpret_cast<const char *>(binaryData + header.stringTableOffset);
+    const qint32 numberOfFields = static_cast<qint32>(header.numberOfFields);
+    fields.resize(numberOfFields);
+    for (qint32 i = 0; i < numberOfFields; i++) {
+        const BinaryField &binaryField = binaryFields[i];
+
+        fields.seqNo[i] = binaryField.seqNo;
+        fields.flags[i] = binaryField.flags;
+        fields.syncConf[i] = binaryField.syncConf;
+        fields.medianBurstIRE[i] = binaryField.medianBurstIRE;
+        fields.fieldPhaseID[i] = binaryField.fieldPhaseID;
+        fields.audioSamples[i] = binaryField.audioSamples;
+        fields.diskLoc[i] = binaryField.diskLoc;
+        fields.fileLoc[i] = binaryField.fileLoc;
+        fields.decodeFaults[i] = binaryField.decodeFaults;
+        fields.efmTValues[i] = binaryField.efmTValues;
+        fields.wSNR[i] = binaryField.wSNR;
+        fields.bPSNR[i] = binaryField.bPSNR;
+        for (qint32 line = 0; line < 3; line++) {
+            fields.vbiData[(i * 3) + line] = binaryField.vbiData[line];
+        }
+        fields.fmCodeData[i] = binaryField.fmCodeData;
+        fields.ccData0[i] = binaryField.ccData0;
+        fields.ccData1[i] = binaryField.ccData1;
+
+        if (binaryField.numberOfDropOuts != 0) {
+            DropOuts &dropOuts = fields.dropOuts[i];
+            dropOuts.reserve(static_cast<qint32>(binaryField.numberOfDropOuts));
+            for (quint64 j = binaryField.firstDropOut; j < binaryField.firstDropOut + binaryField.numberOfDropOuts; j++) {
+                dropOuts.append(binaryDropOuts[j].startx, binaryDropOuts[j].endx, binaryDropOuts[j].fieldLine);
+            }
+        }
+
+        const char *unknownMembers = strings + binaryField.firstUnknownMember;
+        fields.unknownMembers[i] = takeString(unknownMembers, binaryField.unknownMembersSize[0]);
+        fields.vitsUnknownMembers[i] = takeString(unknownMembers, binaryField.unknownMembersSize[1]);
+        fields.vbiUnknownMembers[i] = takeString(unknownMembers, binaryField.unknownMembersSize[2]);
+        fields.ntscUnknownMembers[i] = takeString(unknownMembers, binaryField.unknownMembersSize[3]);
+        fields.dropOutsUnknownMembers[i] = takeString(unknownMembers, binaryField.unknownMembersSize[4]);
+    }
+
+    const char *headerStrings = strings;
+    const QByteArray gitBranch = takeString(headerStrings, header.gitBranchSize);
+    const QByteArray gitCommit = takeString(headerStrings, header.gitCommitSize);
+    unknownMembers = takeString(headerStrings, header.unknownMembersSize);
+
+    // Decode the parameters
+    if ((header.flags & headerVideoParametersValid) != 0) {
+        videoParameters.numberOfSequentialFields = header.numberOfSequentialFields;
+        videoParameters.isSourcePal = (header.flags & headerIsSourcePal) != 0;
+        videoParameters.isSubcarrierLocked = (header.flags & headerIsSubcarrierLocked) != 0;
+        videoParameters.isWidescreen = (header.flags & headerIsWidescreen) != 0;
+        videoParameters.colourBurstStart = header.colourBurstStart;
+        videoParameters.colourBurstEnd = header.colourBurstEnd;
+        videoParameters.activeVideoStart = header.activeVideoStart;
+        videoParameters.activeVideoEnd = header.activeVideoEnd;
+        videoParameters.white16bIre = header.white16bIre;
+        videoParameters.black16bIre = header.black16bIre;
+        videoParameters.fieldWidth = header.fieldWidth;
+        videoParameters.fieldHeight = header.fieldHeight;
+        videoParameters.sampleRate = header.sampleRate;
+        videoParameters.fsc = header.fsc;
+        videoParameters.isMapped = (header.flags & headerIsMapped) != 0;
+
+        videoParameters.gitBranch = QString::fromUtf8(gitBranch);
+        videoParameters.gitCommit = QString::fromUtf8(gitCommit);
+        videoParameters.unknownMembers = takeString(headerStrings, header.videoUnknownMembersSize);
+
         videoParameters.isValid = true;
     } else {
-        qCritical("JSON file invalid: videoParameters object is not defined");
-        return videoParameters;
+        headerStrings += header.videoUnknownMembersSize;
     }
 
-    return videoParameters;
+    if ((header.flags & headerPcmAudioParametersValid) != 0) {
+        pcmAudioParameters.sampleRate = header.pcmSampleRate;
+        pcmAudioParameters.isLittleEndian = (header.flags & headerPcmIsLittleEndian) != 0;
+        pcmAudioParameters.isSigned = (header.flags & headerPcmIsSigned) != 0;
+        pcmAudioParameters.bits = header.pcmBits;
+        pcmAudioParameters.unknownMembers = takeString(headerStrings, header.pcmUnknownMembersSize);
+        pcmAudioParameters.isValid = true;
+    }
+
+    binaryFile.unmap(const_cast<uchar *>(binaryData));
+    binaryFile.close();
+
+    return true;
 }
 
-// This method sets the videoParameters metadata
-void LdDecodeMetaData::setVideoParameters(LdDecodeMetaData::VideoParameters _videoParameters)
+// Write the binary sidecar for the current metadata.
+// Returns true on success.
+bool LdDecodeMetaData::writeBinary(const QString &binaryFileName, const QFileInfo &jsonFileInfo) const
 {
-    videoParameters = _videoParameters;
-    
-    // Write the video parameters
-    json.setValue({"videoParameters", "numberOfSequentialFields"}, getNumberOfFields());
-    json.setValue({"videoParameters", "isSourcePal"}, _videoParameters.isSourcePal);
-    json.setValue({"videoParameters", "isSubcarrierLocked"}, _videoParameters.isSubcarrierLocked);
-    json.setValue({"videoParameters", "isWidescreen"}, _videoParameters.isWidescreen);
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+    return false;
+#endif
+
+    // Build the tables. The string table starts with the strings from the
+    // header, and the fields' unknown members follow.
+    const QByteArray gitBranch = videoParameters.gitBranch.toUtf8();
+    const QByteArray gitCommit = videoParameters.gitCommit.toUtf8();
+    QByteArray stringTable = gitBranch + gitCommit + unknownMembers
+                             + videoParameters.unknownMembers + pcmAudioParameters.unknownMembers;
+
+    QVector<BinaryField> binaryFields(fields.size());
+    QVector<BinaryDropOut> binaryDropOuts;
+    for (qint32 i = 0; i < fields.size(); i++) {
+        BinaryField &binaryField = binaryFields[i];
+
+        binaryField.seqNo = fields.seqNo[i];
+        binaryField.syncConf = fields.syncConf[i];
+        binaryField.fieldPhaseID = fields.fieldPhaseID[i];
+        binaryField.audioSamples = fields.audioSamples[i];
+        binaryField.diskLoc = fields.diskLoc[i];
+        binaryField.fileLoc = fields.fileLoc[i];
+        binaryField.decodeFaults = fields.decodeFaults[i];
+        binaryField.efmTValues = fields.efmTValues[i];
+        binaryField.medianBurstIRE = fields.medianBurstIRE[i];
+        binaryField.wSNR = fields.wSNR[i];
+        binaryField.bPSNR = fields.bPSNR[i];
+        for (qint32 line = 0; line < 3; line++) {
+            binaryField.vbiData[line] = fields.vbiData[(i * 3) + line];
+        }
+        binaryField.fmCodeData = fields.fmCodeData[i];
+        binaryField.ccData0 = fields.ccData0[i];
+        binaryField.ccData1 = fields.ccData1[i];
+        binaryField.flags = fields.flags[i];
+
+        const DropOuts &dropOuts = fields.dropOuts[i];
+        binaryField.numberOfDropOuts = static_cast<quint32>(dropOuts.size());
+        binaryField.firstDropOut = static_cast<quint64>(binaryDropOuts.size());
+        for (qint32 j = 0; j < dropOuts.size(); j++) {
+            binaryDropOuts.append({dropOuts.startx(j), dropOuts.endx(j), dropOuts.fieldLine(j)});
+        }
 
-    json.setValue({"videoParameters", "colourBurstStart"}, _videoParameters.colourBurstStart);
-    json.setValue({"videoParameters", "colourBurstEnd"}, _videoParameters.colourBurstEnd);
-    json.setValue({"videoParameters", "activeVideoStart"}, _videoParameters.activeVideoStart);
-    json.setValue({"videoParameters", "activeVideoEnd"}, _videoParameters.activeVideoEnd);
+        const QByteArray *fieldUnknownMembers[5] = {
+            &fields.unknownMembers[i], &fields.vitsUnknownMembers[i],
+            &fields.vbiUnknownMembers[i], &fields.ntscUnknownMembers[i],
+            &fields.dropOutsUnknownMembers[i]
+        };
+        binaryField.firstUnknownMember = static_cast<quint64>(stringTable.size());
+        for (qint32 j = 0; j < 5; j++) {
+            binaryField.unknownMembersSize[j] = static_cast<quint32>(fieldUnknownMembers[j]->size());
+            stringTable.append(*fieldUnknownMembers[j]);
+        }
+    }
 
-    json.setValue({"videoParameters", "white16bIre"}, _videoParameters.white16bIre);
-    json.setValue({"videoParameters", "black16bIre"}, _videoParameters.black16bIre);
+    // Build the header
+    BinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.version = binaryVersion;
+    header.headerSize = sizeof(BinaryHeader);
+    header.jsonSize = jsonFileInfo.size();
+    header.jsonModified = jsonFileInfo.lastModified().toMSecsSinceEpoch();
+    header.fieldTableOffset = sizeof(BinaryHeader);
+    header.numberOfFields = static_cast<quint32>(binaryFields.size());
+    header.fieldSize = sizeof(BinaryField);
+    header.dropOutTableOffset = header.fieldTableOffset + (header.numberOfFields * sizeof(BinaryField));
+    header.numberOfDropOuts = static_cast<quint64>(binaryDropOuts.size());
+    header.stringTableOffset = header.dropOutTableOffset + (header.numberOfDropOuts * sizeof(BinaryDropOut));
+    header.stringTableSize = static_cast<quint32>(stringTable.size());
+    header.gitBranchSize = static_cast<quint32>(gitBranch.size());
+    header.gitCommitSize = static_cast<quint32>(gitCommit.size());
+    header.unknownMembersSize = static_cast<quint32>(unknownMembers.size());
+    header.videoUnknownMembersSize = static_cast<quint32>(videoParameters.unknownMembers.size());
+    header.pcmUnknownMembersSize = static_cast<quint32>(pcmAudioParameters.unknownMembers.size());
 
-    json.setValue({"videoParameters", "fieldWidth"}, _videoParameters.fieldWidth);
-    json.setValue({"videoParameters", "fieldHeight"}, _videoParameters.fieldHeight);
-    json.setValue({"videoParameters", "sampleRate"}, _videoParameters.sampleRate);
-    json.setValue({"videoParameters", "fsc"}, _videoParameters.fsc);
+    if (videoParameters.isValid) {
+        header.flags |= headerVideoParametersValid;
+        if (videoParameters.isSourcePal) header.flags |= headerIsSourcePal;
+        if (videoParameters.isSubcarrierLocked) header.flags |= headerIsSubcarrierLocked;
+        if (videoParameters.isWidescreen) header.flags |= headerIsWidescreen;
+        if (videoParameters.isMapped) header.flags |= headerIsMapped;
+        header.numberOfSequentialFields = videoParameters.numberOfSequentialFields;
+        header.colourBurstStart = videoParameters.colourBurstStart;
+        header.colourBurstEnd = videoParameters.colourBurstEnd;
+        header.activeVideoStart = videoParameters.activeVideoStart;
+        header.activeVideoEnd = videoParameters.activeVideoEnd;
+        header.white16bIre = videoParameters.white16bIre;
+        header.black16bIre = videoParameters.black16bIre;
+        header.fieldWidth = videoParameters.fieldWidth;
+        header.fieldHeight = videoParameters.fieldHeight;
+        header.sampleRate = videoParameters.sampleRate;
+        header.fsc = videoParameters.fsc;
+    }
+
+    if (pcmAudioParameters.isValid) {
+        header.flags |= headerPcmAudioParametersValid;
+        if (pcmAudioParameters.isLittleEndian) header.flags |= headerPcmIsLittleEndian;
+        if (pcmAudioParameters.isSigned) header.flags |= headerPcmIsSigned;
+        header.pcmSampleRate = pcmAudioParameters.sampleRate;
+        header.pcmBits = pcmAudioParameters.bits;
+    }
 
-    json.setValue({"videoParameters", "isMapped"}, _videoParameters.isMapped);
+    // Write the file. Using QSaveFile means a reader will never see a
+    // partly-written sidecar.
+    QSaveFile outputFile(binaryFileName);
+    if (!outputFile.open(QIODevice::WriteOnly)) return false;
 
-    json.setValue({"videoParameters", "gitBranch"}, _videoParameters.gitBranch);
-    json.setValue({"videoParameters", "gitCommit"}, _videoParameters.gitCommit);
-    
+    outputFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    outputFile.write(reinterpret_cast<const char *>(binaryFields.constData()),
+                     static_cast<qint64>(binaryFields.size() * sizeof(BinaryField)));
+    outputFile.write(reinterpret_cast<const char *>(binaryDropOuts.constData()),
+                     static_cast<qint64>(binaryDropOuts.size() * sizeof(BinaryDropOut)));
+    outputFile.write(stringTable);
+
+    return outputFile.commit();
+}
+
+// This method returns the videoParameters metadata
+LdDecodeMetaData::VideoParameters LdDecodeMetaData::getVideoParameters() const
+{
+    if (!videoParameters.isValid) {
+        qCritical("JSON file invalid: videoParameters object is not defined");
+    }
+
+    return videoParameters;
+}
+
+// This method sets the videoParameters metadata
+void LdDecodeMetaData::setVideoParameters(LdDecodeMetaData::VideoParameters _videoParameters)
+{
+    // As with fields, keep the existing unknown members unless replaced
+    if (_videoParameters.unknownMembers.isEmpty()) _videoParameters.unknownMembers = videoParameters.unknownMembers;
+
+    videoParameters = _videoParameters;
+    videoParameters.numberOfSequentialFields = getNumberOfFields();
     videoParameters.isValid = true;
 }
 
 // This method returns the pcmAudioParameters metadata
-LdDecodeMetaData::PcmAudioParameters LdDecodeMetaData::getPcmAudioParameters()
+LdDecodeMetaData::PcmAudioParameters LdDecodeMetaData::getPcmAudioParameters() const
 {
-    if (pcmAudioParameters.isValid) {
-        return pcmAudioParameters;
-    } else if (json.size({"pcmAudioParameters"}) > 0) {
-        // Read the PCM audio data
-        pcmAudioParameters.sampleRate = json.value({"pcmAudioParameters", "sampleRate"}).toInt();
-        pcmAudioParameters.isLittleEndian = json.value({"pcmAudioParameters", "isLittleEndian"}).toBool();
-        pcmAudioParameters.isSigned = json.value({"pcmAudioParameters", "isSigned"}).toBool();
-        pcmAudioParameters.bits = json.value({"pcmAudioParameters", "bits"}).toInt();
-        
-        pcmAudioParameters.isValid = true;
-    } else {
+    if (!pcmAudioParameters.isValid) {
         qCritical("JSON file invalid: pcmAudioParameters is not defined");
-        return pcmAudioParameters;
     }
 
     return pcmAudioParameters;
@@ -184,13 +1252,9 @@ LdDecodeMetaData::PcmAudioParameters LdDecodeMetaData::getPcmAudioParameters()
 // This method sets the pcmAudioParameters metadata
 void LdDecodeMetaData::setPcmAudioParameters(LdDecodeMetaData::PcmAudioParameters _pcmAudioParam)
 {
+    if (_pcmAudioParam.unknownMembers.isEmpty()) _pcmAudioParam.unknownMembers = pcmAudioParameters.unknownMembers;
+
     pcmAudioParameters = _pcmAudioParam;
-    
-    json.setValue({"pcmAudioParameters", "sampleRate"}, _pcmAudioParam.sampleRate);
-    json.setValue({"pcmAudioParameters", "isLittleEndian"}, _pcmAudioParam.isLittleEndian);
-    json.setValue({"pcmAudioParameters", "isSigned"}, _pcmAudioParam.isSigned);
-    json.setValue({"pcmAudioParameters", "bits"}, _pcmAudioParam.bits);
-    
     pcmAudioParameters.isValid = true;
 }
 
@@ -287,203 +1351,139 @@ void LdDecodeMetaData::LineParameters::process(qint32 fieldHeight)
 }
 
 // This method gets the metadata for the specified sequential field number (indexed from 1 (not 0!))
-LdDecodeMetaData::Field LdDecodeMetaData::getField(qint32 sequentialFieldNumber)
+LdDecodeMetaData::Field LdDecodeMetaData::getField(qint32 sequentialFieldNumber) const
 {
-    Field field;
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
     if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
         qCritical() << "LdDecodeMetaData::getField(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return Field();
     }
 
-    // Primary field values
-    field.seqNo = json.value({"fields", fieldNumber, "seqNo"}).toInt();
-    field.isFirstField = json.value({"fields", fieldNumber, "isFirstField"}).toBool();
-    field.syncConf = json.value({"fields", fieldNumber, "syncConf"}).toInt();
-    field.medianBurstIRE = json.value({"fields", fieldNumber, "medianBurstIRE"}).toDouble();
-    field.fieldPhaseID = json.value({"fields", fieldNumber, "fieldPhaseID"}).toInt();
-    field.audioSamples = json.value({"fields", fieldNumber, "audioSamples"}).toInt();
-
-    field.diskLoc = json.value({"fields", fieldNumber, "diskLoc"}).toInt();
-    field.fileLoc = json.value({"fields", fieldNumber, "fileLoc"}).toInt();
-    field.decodeFaults = json.value({"fields", fieldNumber, "decodeFaults"}).toInt();
-    field.efmTValues = json.value({"fields", fieldNumber, "efmTValues"}).toInt();
-
-    // VITS metrics values
-    field.vitsMetrics = getFieldVitsMetrics(sequentialFieldNumber);
-
-    // VBI values
-    field.vbi = getFieldVbi(sequentialFieldNumber);
-
-    // NTSC values
-    field.ntsc = getFieldNtsc(sequentialFieldNumber);
-
-    // dropOuts values
-    field.dropOuts = getFieldDropOuts(sequentialFieldNumber);
-
-    // Padding flag
-    field.pad = json.value({"fields", fieldNumber, "pad"}).toBool();
-
-    return field;
+    return fields.get(fieldNumber);
 }
 
 // This method gets the VITS metrics metadata for the specified sequential field number
-LdDecodeMetaData::VitsMetrics LdDecodeMetaData::getFieldVitsMetrics(qint32 sequentialFieldNumber)
+LdDecodeMetaData::VitsMetrics LdDecodeMetaData::getFieldVitsMetrics(qint32 sequentialFieldNumber) const
 {
-    VitsMetrics vitsMetrics;
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
     if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
         qCritical() << "LdDecodeMetaData::getFieldVitsMetrics(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return VitsMetrics();
     }
 
-    if (json.size({"fields", fieldNumber, "vitsMetrics"}) > 0) {
-        vitsMetrics.inUse = true;
-        vitsMetrics.wSNR = json.value({"fields", fieldNumber, "vitsMetrics", "wSNR"}).toReal();
-        vitsMetrics.bPSNR = json.value({"fields", fieldNumber, "vitsMetrics", "bPSNR"}).toReal();
-    } else {
-        // Mark VITS metrics as undefined
-        vitsMetrics.inUse = false;
-    }
-
-    return vitsMetrics;
+    return fields.getVitsMetrics(fieldNumber);
 }
 
 // This method gets the VBI metadata for the specified sequential field number
-LdDecodeMetaData::Vbi LdDecodeMetaData::getFieldVbi(qint32 sequentialFieldNumber)
+LdDecodeMetaData::Vbi LdDecodeMetaData::getFieldVbi(qint32 sequentialFieldNumber) const
 {
-    Vbi vbi;
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
     if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
         qCritical() << "LdDecodeMetaData::getFieldVbi(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return Vbi();
     }
 
-    if (json.size({"fields", fieldNumber, "vbi"}) > 0) {
-        // Mark VBI as in use
-        vbi.inUse = true;
+    return fields.getVbi(fieldNumber);
+}
 
-        vbi.vbiData.append(json.value({"fields", fieldNumber, "vbi", "vbiData", 0}).toInt()); // Line 16
-        vbi.vbiData.append(json.value({"fields", fieldNumber, "vbi", "vbiData", 1}).toInt()); // Line 17
-        vbi.vbiData.append(json.value({"fields", fieldNumber, "vbi", "vbiData", 2}).toInt()); // Line 18
-    } else {
-        // Mark VBI as undefined
-        vbi.inUse = false;
+// This method gets the NTSC metadata for the specified sequential field number
+LdDecodeMetaData::Ntsc LdDecodeMetaData::getFieldNtsc(qint32 sequentialFieldNumber) const
+{
+    qint32 fieldNumber = sequentialFieldNumber - 1;
 
-        // Resize the VBI data fields to prevent assert issues downstream
-        vbi.vbiData.resize(3);
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
+        qCritical() << "LdDecodeMetaData::getFieldNtsc(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return Ntsc();
     }
 
-    return vbi;
+    return fields.getNtsc(fieldNumber);
 }
 
-// This method gets the NTSC metadata for the specified sequential field number
-LdDecodeMetaData::Ntsc LdDecodeMetaData::getFieldNtsc(qint32 sequentialFieldNumber)
+// This method gets the drop-out metadata for the specified sequential field number.
+// The reference remains valid until the field's metadata is next changed.
+const DropOuts &LdDecodeMetaData::getFieldDropOuts(qint32 sequentialFieldNumber) const
 {
-    Ntsc ntsc;
+    static const DropOuts noDropOuts;
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
     if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
-        qCritical() << "LdDecodeMetaData::getFieldNtsc(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        qCritical() << "LdDecodeMetaData::getFieldDropOuts(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return noDropOuts;
     }
 
-    if (json.size({"fields", fieldNumber, "ntsc"}) > 0) {
-        // Mark as in use
-        ntsc.inUse = true;
+    return fields.dropOuts[fieldNumber];
+}
 
-        ntsc.isFmCodeDataValid = json.value({"fields", fieldNumber, "ntsc", "isFmCodeDataValid"}).toBool();
-        ntsc.fmCodeData = json.value({"fields", fieldNumber, "ntsc", "fmCodeData"}).toInt();
-        ntsc.fieldFlag = json.value({"fields", fieldNumber, "ntsc", "fieldFlag"}).toBool();
-        ntsc.whiteFlag = json.value({"fields", fieldNumber, "ntsc", "whiteFlag"}).toBool();
-        ntsc.ccData0 = json.value({"fields", fieldNumber, "ntsc", "ccData0"}).toInt();
-        ntsc.ccData1 = json.value({"fields", fieldNumber, "ntsc", "ccData1"}).toInt();
-    } else {
-        // Mark ntscSpecific as undefined
-        ntsc.inUse = false;
+// This method gets whether the specified sequential field number is a first field
+bool LdDecodeMetaData::getFieldIsFirstField(qint32 sequentialFieldNumber) const
+{
+    qint32 fieldNumber = sequentialFieldNumber - 1;
+
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
+        qCritical() << "LdDecodeMetaData::getFieldIsFirstField(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return false;
     }
 
-    return ntsc;
+    return (fields.flags[fieldNumber] & fieldIsFirstField) != 0;
 }
 
-// This method gets the drop-out metadata for the specified sequential field number
-DropOuts LdDecodeMetaData::getFieldDropOuts(qint32 sequentialFieldNumber)
+// This method gets the field phase ID for the specified sequential field number
+qint32 LdDecodeMetaData::getFieldPhaseID(qint32 sequentialFieldNumber) const
 {
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
     if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
-        qCritical() << "LdDecodeMetaData::getFieldDropOuts(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        qCritical() << "LdDecodeMetaData::getFieldPhaseID(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return 0;
     }
 
-    // Get the JSON array sizes
-    qint32 startxSize = json.size({"fields", fieldNumber, "dropOuts", "startx"});
-    qint32 endxSize = json.size({"fields", fieldNumber, "dropOuts", "endx"});
-    qint32 fieldLinesSize = json.size({"fields", fieldNumber, "dropOuts", "fieldLines"});
-
-    // Ensure that all three objects are the same size
-    if (startxSize != endxSize && startxSize != fieldLinesSize) {
-        qCritical("JSON file is invalid: Dropouts object is illegal");
-    }
-
-    // Reserve space for the dropouts we have to avoid reallocation.
-    DropOuts dropOuts(startxSize);
-
-    if (startxSize > 0) {
-        // Pre-create the lists used for lookup so we don't have to reallocate
-        // them for every line.
-        QVariantList startx = {"fields", fieldNumber, "dropOuts", "startx", 0};
-        QVariantList endx = {"fields", fieldNumber, "dropOuts", "endx", 0};
-        QVariantList fieldLine = {"fields", fieldNumber, "dropOuts", "fieldLine", 0};
-        for (qint32 doCounter = 0; doCounter < startxSize; doCounter++) {
-            startx.last().setValue(doCounter);
-            endx.last().setValue(doCounter);
-            fieldLine.last().setValue(doCounter);
-            dropOuts.append(json.value(startx).toInt(),
-                            json.value(endx).toInt(),
-                            json.value(fieldLine).toInt());
-        }
-    } else {
-        dropOuts.clear();
+    return fields.fieldPhaseID[fieldNumber];
+}
+
+// This method gets whether the specified sequential field number is padding
+bool LdDecodeMetaData::getFieldPad(qint32 sequentialFieldNumber) const
+{
+    qint32 fieldNumber = sequentialFieldNumber - 1;
+
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
+        qCritical() << "LdDecodeMetaData::getFieldPad(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return false;
     }
 
-    return dropOuts;
+    return (fields.flags[fieldNumber] & fieldPad) != 0;
 }
 
 // This method sets the field metadata for a field
 void LdDecodeMetaData::updateField(LdDecodeMetaData::Field _field, qint32 sequentialFieldNumber)
 {
     if (sequentialFieldNumber < 1) {
-        qCritical() << "LdDecodeMetaData::updateFieldVitsMetrics(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        qCritical() << "LdDecodeMetaData::updateField(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return;
     }
 
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
-    // Write the field data
-    json.setValue({"fields", fieldNumber, "seqNo"}, sequentialFieldNumber);
-    json.setValue({"fields", fieldNumber, "isFirstField"}, _field.isFirstField);
-    json.setValue({"fields", fieldNumber, "syncConf"}, _field.syncConf);
-    json.setValue({"fields", fieldNumber, "medianBurstIRE"}, _field.medianBurstIRE);
-    json.setValue({"fields", fieldNumber, "fieldPhaseID"}, _field.fieldPhaseID);
-    json.setValue({"fields", fieldNumber, "audioSamples"}, _field.audioSamples);
-
-    json.setValue({"fields", fieldNumber, "diskLoc"}, _field.diskLoc);
-    json.setValue({"fields", fieldNumber, "fileLoc"}, _field.fileLoc);
-    json.setValue({"fields", fieldNumber, "decodeFaults"}, _field.decodeFaults);
-    json.setValue({"fields", fieldNumber, "efmTValues"}, _field.efmTValues);
-
-    // Write the VITS metrics data if in use
-    updateFieldVitsMetrics(_field.vitsMetrics, sequentialFieldNumber);
-
-    // Write the VBI data if in use
-    updateFieldVbi(_field.vbi, sequentialFieldNumber);
+    // Extend the field list if needed
+    if (fieldNumber >= fields.size()) fields.resize(fieldNumber + 1);
 
-    // Write the NTSC specific record if in use
-    updateFieldNtsc(_field.ntsc, sequentialFieldNumber);
+    // Keep the existing unknown members, unless the caller has provided some
+    // (as with the JSON, only the members we know about are replaced)
+    if (_field.unknownMembers.isEmpty()) _field.unknownMembers = fields.unknownMembers[fieldNumber];
+    if (_field.vitsMetrics.unknownMembers.isEmpty()) _field.vitsMetrics.unknownMembers = fields.vitsUnknownMembers[fieldNumber];
+    if (_field.vbi.unknownMembers.isEmpty()) _field.vbi.unknownMembers = fields.vbiUnknownMembers[fieldNumber];
+    if (_field.ntsc.unknownMembers.isEmpty()) _field.ntsc.unknownMembers = fields.ntscUnknownMembers[fieldNumber];
+    if (_field.dropOutsUnknownMembers.isEmpty()) _field.dropOutsUnknownMembers = fields.dropOutsUnknownMembers[fieldNumber];
 
-    // Write the drop-out records
-    updateFieldDropOuts(_field.dropOuts, sequentialFieldNumber);
+    // Write the field data
+    fields.set(fieldNumber, _field);
+    fields.seqNo[fieldNumber] = sequentialFieldNumber;
 
-    // Padding flag
-    json.setValue({"fields", fieldNumber, "pad"}, _field.pad);
+    // Validate the VBI and NTSC records
+    updateFieldVbi(_field.vbi, sequentialFieldNumber);
+    updateFieldNtsc(_field.ntsc, sequentialFieldNumber);
 }
 
 // This method sets the field VBI metadata for a field
@@ -491,13 +1491,16 @@ void LdDecodeMetaData::updateFieldVitsMetrics(LdDecodeMetaData::VitsMetrics _vit
 {
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
-    if (fieldNumber >= getNumberOfFields() + 1 || fieldNumber < 0) {
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
         qCritical() << "LdDecodeMetaData::updateFieldVitsMetrics(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return;
     }
 
     if (_vitsMetrics.inUse) {
-        json.setValue({"fields", fieldNumber, "vitsMetrics", "wSNR"}, _vitsMetrics.wSNR);
-        json.setValue({"fields", fieldNumber, "vitsMetrics", "bPSNR"}, _vitsMetrics.bPSNR);
+        fields.setFlag(fieldNumber, fieldVitsMetricsInUse, true);
+        fields.wSNR[fieldNumber] = _vitsMetrics.wSNR;
+        fields.bPSNR[fieldNumber] = _vitsMetrics.bPSNR;
+        if (!_vitsMetrics.unknownMembers.isEmpty()) fields.vitsUnknownMembers[fieldNumber] = _vitsMetrics.unknownMembers;
     }
 }
 
@@ -506,8 +1509,9 @@ void LdDecodeMetaData::updateFieldVbi(LdDecodeMetaData::Vbi _vbi, qint32 sequent
 {
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
-    if (fieldNumber >= getNumberOfFields() + 1 || fieldNumber < 0) {
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
         qCritical() << "LdDecodeMetaData::updateFieldVbi(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return;
     }
 
     if (_vbi.inUse) {
@@ -520,9 +1524,11 @@ void LdDecodeMetaData::updateFieldVbi(LdDecodeMetaData::Vbi _vbi, qint32 sequent
             _vbi.vbiData[2] = -1;
         }
 
-        json.setValue({"fields", fieldNumber, "vbi", "vbiData", 0}, _vbi.vbiData[0]);
-        json.setValue({"fields", fieldNumber, "vbi", "vbiData", 1}, _vbi.vbiData[1]);
-        json.setValue({"fields", fieldNumber, "vbi", "vbiData", 2}, _vbi.vbiData[2]);
+        fields.setFlag(fieldNumber, fieldVbiInUse, true);
+        for (qint32 line = 0; line < 3; line++) {
+            fields.vbiData[(fieldNumber * 3) + line] = _vbi.vbiData[line];
+        }
+        if (!_vbi.unknownMembers.isEmpty()) fields.vbiUnknownMembers[fieldNumber] = _vbi.unknownMembers;
     }
 }
 
@@ -531,19 +1537,21 @@ void LdDecodeMetaData::updateFieldNtsc(LdDecodeMetaData::Ntsc _ntsc, qint32 sequ
 {
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
-    if (fieldNumber >= getNumberOfFields() + 1 || fieldNumber < 0) {
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
         qCritical() << "LdDecodeMetaData::updateFieldNtsc(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return;
     }
 
     if (_ntsc.inUse) {
-        json.setValue({"fields", fieldNumber, "ntsc", "isFmCodeDataValid"}, _ntsc.isFmCodeDataValid);
-        if (_ntsc.isFmCodeDataValid)
-            json.setValue({"fields", fieldNumber, "ntsc", "fmCodeData"}, _ntsc.fmCodeData);
-        else json.setValue({"fields", fieldNumber, "ntsc", "fmCodeData"}, -1);
-        json.setValue({"fields", fieldNumber, "ntsc", "fieldFlag"}, _ntsc.fieldFlag);
-        json.setValue({"fields", fieldNumber, "ntsc", "whiteFlag"}, _ntsc.whiteFlag);
-        json.setValue({"fields", fieldNumber, "ntsc", "ccData0"}, _ntsc.ccData0);
-        json.setValue({"fields", fieldNumber, "ntsc", "ccData1"}, _ntsc.ccData1);
+        if (!_ntsc.isFmCodeDataValid) _ntsc.fmCodeData = -1;
+        fields.setFlag(fieldNumber, fieldNtscInUse, true);
+        fields.setFlag(fieldNumber, fieldIsFmCodeDataValid, _ntsc.isFmCodeDataValid);
+        fields.setFlag(fieldNumber, fieldFieldFlag, _ntsc.fieldFlag);
+        fields.setFlag(fieldNumber, fieldWhiteFlag, _ntsc.whiteFlag);
+        fields.fmCodeData[fieldNumber] = _ntsc.fmCodeData;
+        fields.ccData0[fieldNumber] = _ntsc.ccData0;
+        fields.ccData1[fieldNumber] = _ntsc.ccData1;
+        if (!_ntsc.unknownMembers.isEmpty()) fields.ntscUnknownMembers[fieldNumber] = _ntsc.unknownMembers;
     }
 }
 
@@ -552,21 +1560,12 @@ void LdDecodeMetaData::updateFieldDropOuts(DropOuts _dropOuts, qint32 sequential
 {
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
-    if (fieldNumber >= getNumberOfFields() + 1 || fieldNumber < 0) {
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
         qCritical() << "LdDecodeMetaData::updateFieldDropOuts(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return;
     }
 
-    if (_dropOuts.size() != 0) {
-        // Populate the arrays with the drop out metadata
-        for (qint32 doCounter = 0; doCounter < _dropOuts.size(); doCounter++) {
-            json.setValue({"fields", fieldNumber, "dropOuts", "startx", doCounter}, _dropOuts.startx(doCounter));
-            json.setValue({"fields", fieldNumber, "dropOuts", "endx", doCounter}, _dropOuts.endx(doCounter));
-            json.setValue({"fields", fieldNumber, "dropOuts", "fieldLine", doCounter}, _dropOuts.fieldLine(doCounter));
-        }
-    } else {
-        // If updated dropouts is empty, clear the field's dropouts
-        clearFieldDropOuts(sequentialFieldNumber);
-    }
+    fields.dropOuts[fieldNumber] = _dropOuts;
 }
 
 // This method clears the field dropout metadata for a field
@@ -574,35 +1573,39 @@ void LdDecodeMetaData::clearFieldDropOuts(qint32 sequentialFieldNumber)
 {
     qint32 fieldNumber = sequentialFieldNumber - 1;
 
-    if (fieldNumber >= getNumberOfFields() + 1 || fieldNumber < 0) {
-        qCritical() << "LdDecodeMetaData::updateFieldDropOuts(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+    if (fieldNumber >= getNumberOfFields() || fieldNumber < 0) {
+        qCritical() << "LdDecodeMetaData::clearFieldDropOuts(): Requested field number" << sequentialFieldNumber << "out of bounds!";
+        return;
     }
 
-    json.remove({"fields", fieldNumber, "dropOuts", "startx"});
-    json.remove({"fields", fieldNumber, "dropOuts", "endx"});
-    json.remove({"fields", fieldNumber, "dropOuts", "fieldLine"});
+    fields.dropOuts[fieldNumber].clear();
+}
+
+// This method applies a buffer of changes to the field metadata
+void LdDecodeMetaData::applyFieldUpdates(const FieldUpdates &updates)
+{
+    for (const auto &update : updates.vitsMetrics) updateFieldVitsMetrics(update.second, update.first);
+    for (const auto &update : updates.vbi) updateFieldVbi(update.second, update.first);
+    for (const auto &update : updates.ntsc) updateFieldNtsc(update.second, update.first);
+    for (const auto &update : updates.dropOuts) updateFieldDropOuts(update.second, update.first);
 }
 
 // This method appends a new field to the existing metadata
 void LdDecodeMetaData::appendField(LdDecodeMetaData::Field _field)
 {
-    // Get the field number (and adjust to 0 if there are no fields in the JSON)
-    qint32 fieldNumber = getNumberOfFields();
-    if (fieldNumber < 0) fieldNumber = 0;
-
-    updateField(_field, fieldNumber + 1);
+    updateField(_field, getNumberOfFields() + 1);
 }
 
 // Method to get the available number of fields (according to the metadata)
-qint32 LdDecodeMetaData::getNumberOfFields()
+qint32 LdDecodeMetaData::getNumberOfFields() const
 {
-    return json.size({"fields"});
+    return fields.size();
 }
 
 // Method to set the available number of fields
 void LdDecodeMetaData::setNumberOfFields(qint32 numberOfFields)
 {
-    json.setValue({"videoParameters", "numberOfSequentialFields"}, numberOfFields);
+    videoParameters.numberOfSequentialFields = numberOfFields;
 }
 
 // A note about fields, frames and still-frames:
@@ -666,7 +1669,7 @@ void LdDecodeMetaData::setNumberOfFields(qint32 numberOfFields)
 // the shared-library scope.
 
 // Method to get the available number of still-frames
-qint32 LdDecodeMetaData::getNumberOfFrames()
+qint32 LdDecodeMetaData::getNumberOfFrames() const
 {
     qint32 frameOffset = 0;
 
@@ -674,10 +1677,10 @@ qint32 LdDecodeMetaData::getNumberOfFrames()
     // skip it when counting the number of still-frames
     if (isFirstFieldFirst) {
         // Expecting first field first
-        if (!getField(1).isFirstField) frameOffset = 1;
+        if (!getFieldIsFirstField(1)) frameOffset = 1;
     } else {
         // Expecting second field first
-        if (getField(1).isFirstField) frameOffset = 1;
+        if (getFieldIsFirstField(1)) frameOffset = 1;
     }
 
     return (getNumberOfFields() / 2) - frameOffset;
@@ -685,7 +1688,7 @@ qint32 LdDecodeMetaData::getNumberOfFrames()
 
 // Method to get the first and second field numbers based on the frame number
 // If field = 1 return the firstField, otherwise return second field
-qint32 LdDecodeMetaData::getFieldNumber(qint32 frameNumber, qint32 field)
+qint32 LdDecodeMetaData::getFieldNumber(qint32 frameNumber, qint32 field) const
 {
     qint32 firstFieldNumber = 0;
     qint32 secondFieldNumber = 0;
@@ -710,7 +1713,7 @@ qint32 LdDecodeMetaData::getFieldNumber(qint32 frameNumber, qint32 field)
     // If the field number pointed to by firstFieldNumber doesn't have
     // isFirstField set, move forward field by field until the current
     // field does
-    while (!getField(firstFieldNumber).isFirstField) {
+    while (!getFieldIsFirstField(firstFieldNumber)) {
         firstFieldNumber++;
         secondFieldNumber++;
 
@@ -738,7 +1741,7 @@ qint32 LdDecodeMetaData::getFieldNumber(qint32 frameNumber, qint32 field)
     }
 
     // Test for a buggy TBC file...
-    if (getField(secondFieldNumber).isFirstField) {
+    if (getFieldIsFirstField(secondFieldNumber)) {
         qCritical() << "LdDecodeMetaData::getFieldNumber(): Both of the determined fields have isFirstField set - the TBC source video is probably broken...";
     }
 
@@ -746,13 +1749,13 @@ qint32 LdDecodeMetaData::getFieldNumber(qint32 frameNumber, qint32 field)
 }
 
 // Method to get the first field number based on the frame number
-qint32 LdDecodeMetaData::getFirstFieldNumber(qint32 frameNumber)
+qint32 LdDecodeMetaData::getFirstFieldNumber(qint32 frameNumber) const
 {
     return getFieldNumber(frameNumber, 1);
 }
 
 // Method to get the second field number based on the frame number
-qint32 LdDecodeMetaData::getSecondFieldNumber(qint32 frameNumber)
+qint32 LdDecodeMetaData::getSecondFieldNumber(qint32 frameNumber) const
 {
     return getFieldNumber(frameNumber, 2);
 }
@@ -764,7 +1767,7 @@ void LdDecodeMetaData::setIsFirstFieldFirst(bool flag)
 }
 
 // Method to get the isFirstFieldFirst flag
-bool LdDecodeMetaData::getIsFirstFieldFirst()
+bool LdDecodeMetaData::getIsFirstFieldFirst() const
 {
     return isFirstFieldFirst;
 }
@@ -858,7 +1861,8 @@ void LdDecodeMetaData::generatePcmAudioMap()
 
     for (qint32 fieldNo = 0; fieldNo < numberOfFields; fieldNo++) {
         // Each audio sample is 16 bit - and there are 2 samples per stereo pair
-        pcmAudioFieldLengthMap[fieldNo] = static_cast<qint32>(getField(fieldNo+1).audioSamples);
+        // (numberOfSequentialFields may not match the number of field records)
+        pcmAudioFieldLengthMap[fieldNo] = fieldNo < fields.size() ? fields.audioSamples[fieldNo] : 0;
 
         if (fieldNo == 0) {
             // First field starts at 0 units
@@ -871,15 +1875,160 @@ void LdDecodeMetaData::generatePcmAudioMap()
 }
 
 // Method to get the start sample location of the specified sequential field number
-qint32 LdDecodeMetaData::getFieldPcmAudioStart(qint32 sequentialFieldNumber)
+qint32 LdDecodeMetaData::getFieldPcmAudioStart(qint32 sequentialFieldNumber) const
 {
     if (pcmAudioFieldStartSampleMap.size() < sequentialFieldNumber) return -1;
     return pcmAudioFieldStartSampleMap[sequentialFieldNumber];
 }
 
 // Method to get the sample length of the specified sequential field number
-qint32 LdDecodeMetaData::getFieldPcmAudioLength(qint32 sequentialFieldNumber)
+qint32 LdDecodeMetaData::getFieldPcmAudioLength(qint32 sequentialFieldNumber) const
 {
     if (pcmAudioFieldLengthMap.size() < sequentialFieldNumber) return -1;
     return pcmAudioFieldLengthMap[sequentialFieldNumber];
 }
+
+// Field update buffer methods ----------------------------------------------------------------------------------------
+
+void LdDecodeMetaData::FieldUpdates::updateFieldVitsMetrics(LdDecodeMetaData::VitsMetrics _vitsMetrics, qint32 sequentialFieldNumber)
+{
+    vitsMetrics.append(qMakePair(sequentialFieldNumber, _vitsMetrics));
+}
+
+void LdDecodeMetaData::FieldUpdates::updateFieldVbi(LdDecodeMetaData::Vbi _vbi, qint32 sequentialFieldNumber)
+{
+    vbi.append(qMakePair(sequentialFieldNumber, _vbi));
+}
+
+void LdDecodeMetaData::FieldUpdates::updateFieldNtsc(LdDecodeMetaData::Ntsc _ntsc, qint32 sequentialFieldNumber)
+{
+    ntsc.append(qMakePair(sequentialFieldNumber, _ntsc));
+}
+
+void LdDecodeMetaData::FieldUpdates::updateFieldDropOuts(DropOuts _dropOuts, qint32 sequentialFieldNumber)
+{
+    dropOuts.append(qMakePair(sequentialFieldNumber, std::move(_dropOuts)));
+}
+
+// Add the changes from another buffer after the changes in this one
+void LdDecodeMetaData::FieldUpdates::append(const FieldUpdates &other)
+{
+    vitsMetrics += other.vitsMetrics;
+    vbi += other.vbi;
+    ntsc += other.ntsc;
+    dropOuts += other.dropOuts;
+}
+
+// Return the number of changes in the buffer
+qint32 LdDecodeMetaData::FieldUpdates::size() const
+{
+    return vitsMetrics.size() + vbi.size() + ntsc.size() + dropOuts.size();
+}
+
+void LdDecodeMetaData::FieldUpdates::clear()
+{
+    vitsMetrics.clear();
+    vbi.clear();
+    ntsc.clear();
+    dropOuts.clear();
+}
+
+// Return the numbers of the fields changed in the buffer, in order
+QVector<qint32> LdDecodeMetaData::FieldUpdates::getFieldNumbers() const
+{
+    QVector<qint32> fieldNumbers;
+    for (const auto &update : vitsMetrics) fieldNumbers.append(update.first);
+    for (const auto &update : vbi) fieldNumbers.append(update.first);
+    for (const auto &update : ntsc) fieldNumbers.append(update.first);
+    for (const auto &update : dropOuts) fieldNumbers.append(update.first);
+
+    std::sort(fieldNumbers.begin(), fieldNumbers.end());
+    fieldNumbers.erase(std::unique(fieldNumbers.begin(), fieldNumbers.end()), fieldNumbers.end());
+
+    return fieldNumbers;
+}
+
+// Read a field record, adding its members to the buffer. The record must
+// include seqNo; members other than vitsMetrics, vbi, ntsc and dropOuts are
+// ignored.
+void LdDecodeMetaData::FieldUpdates::readRecord(JsonReader &reader)
+{
+    qint32 seqNo = -1;
+    VitsMetrics recordVitsMetrics;
+    Vbi recordVbi;
+    Ntsc recordNtsc;
+    DropOuts recordDropOuts;
+    QByteArray recordDropOutsUnknownMembers;
+    bool hasDropOuts = false;
+    std::string member;
+
+    reader.beginObject();
+    while (reader.readMember(member)) {
+        if (member == "seqNo") reader.read(seqNo);
+        else if (member == "vitsMetrics") recordVitsMetrics.read(reader);
+        else if (member == "vbi") recordVbi.read(reader);
+        else if (member == "ntsc") recordNtsc.read(reader);
+        else if (member == "dropOuts") {
+            readDropOuts(reader, recordDropOuts, recordDropOutsUnknownMembers);
+            hasDropOuts = true;
+        }
+        else reader.discard();
+    }
+    reader.endObject();
+
+    if (seqNo < 1) reader.raiseError("Field record has no valid seqNo");
+    if (reader.hasError()) return;
+
+    if (recordVitsMetrics.inUse) updateFieldVitsMetrics(recordVitsMetrics, seqNo);
+    if (recordVbi.inUse) updateFieldVbi(recordVbi, seqNo);
+    if (recordNtsc.inUse) updateFieldNtsc(recordNtsc, seqNo);
+    if (hasDropOuts) updateFieldDropOuts(recordDropOuts, seqNo);
+}
+
+// Return the index of the last change to a field in a list of changes, or -1
+// if there isn't one
+template <typename T>
+static qint32 findLastUpdate(const QVector<QPair<qint32, T>> &updates, qint32 sequentialFieldNumber)
+{
+    for (qint32 i = updates.size() - 1; i >= 0; i--) {
+        if (updates[i].first == sequentialFieldNumber) return i;
+    }
+    return -1;
+}
+
+// Write a field record containing the changes to one field. Where a member
+// has been changed more than once, only the last change is written.
+void LdDecodeMetaData::FieldUpdates::writeRecord(JsonWriter &writer, qint32 sequentialFieldNumber) const
+{
+    // Find the last change of each type for this field
+    const qint32 vitsMetricsIndex = findLastUpdate(vitsMetrics, sequentialFieldNumber);
+    const qint32 vbiIndex = findLastUpdate(vbi, sequentialFieldNumber);
+    const qint32 ntscIndex = findLastUpdate(ntsc, sequentialFieldNumber);
+    const qint32 dropOutsIndex = findLastUpdate(dropOuts, sequentialFieldNumber);
+
+    writer.beginObject();
+    writer.writeMember("seqNo");
+    writer.write(sequentialFieldNumber);
+
+    if (vitsMetricsIndex != -1) {
+        writer.writeMember("vitsMetrics");
+        vitsMetrics[vitsMetricsIndex].second.write(writer);
+    }
+
+    if (vbiIndex != -1) {
+        writer.writeMember("vbi");
+        vbi[vbiIndex].second.write(writer);
+    }
+
+    if (ntscIndex != -1) {
+        writer.writeMember("ntsc");
+        ntsc[ntscIndex].second.write(writer);
+    }
+
+    if (dropOutsIndex != -1) {
+        writer.writeMember("dropOuts");
+        writeDropOuts(writer, dropOuts[dropOutsIndex].second, QByteArray());
+    }
+
+    writer.endObject();
+}
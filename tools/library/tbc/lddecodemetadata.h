@@ -26,24 +26,37 @@
 #define LDDECODEMETADATA_H
 
 #include <QVector>
-#include <QTemporaryFile>
+#include <QPair>
 #include <QDebug>
+#include <QFile>
+#include <QFileInfo>
 
-#include "../JsonWax/JsonWax.h"
 #include "vbidecoder.h"
 #include "dropouts.h"
 
+class JsonReader;
+class JsonWriter;
+
 class LdDecodeMetaData
 {
 
 public:
 
+    // Each of the structures that's read from the JSON keeps any members it
+    // doesn't recognise in unknownMembers, as JSON text, so that they're
+    // written back out unchanged.
+
     // VBI Metadata definition
     struct Vbi {
-        Vbi() : inUse(false) {}
+        Vbi() : inUse(false), vbiData(3) {}
+
+        void read(JsonReader &reader);
+        void write(JsonWriter &writer) const;
 
         bool inUse;
         QVector<qint32> vbiData;
+
+        QByteArray unknownMembers;
     };
 
     // Pseudo metadata items - these values are populated automatically by the library
@@ -78,8 +91,15 @@ public:
     
     // Video metadata definition
     struct VideoParameters {
-        VideoParameters() : isValid(false) {}
-        
+        VideoParameters() : numberOfSequentialFields(0), isSourcePal(false), isSubcarrierLocked(false),
+            isWidescreen(false), colourBurstStart(0), colourBurstEnd(0), activeVideoStart(0),
+            activeVideoEnd(0), white16bIre(0), black16bIre(0), fieldWidth(0), fieldHeight(0),
+            sampleRate(0), fsc(0), isMapped(false), firstActiveFieldLine(-1), lastActiveFieldLine(-1),
+            firstActiveFrameLine(-1), lastActiveFrameLine(-1), isValid(false) {}
+
+        void read(JsonReader &reader);
+        void write(JsonWriter &writer) const;
+
         qint32 numberOfSequentialFields;
 
         bool isSourcePal;
@@ -109,6 +129,8 @@ public:
         qint32 lastActiveFieldLine;
         qint32 firstActiveFrameLine;
         qint32 lastActiveFrameLine;
+
+        QByteArray unknownMembers;
         
         // Flags if our data has been initialized yet
         bool isValid;
@@ -118,9 +140,14 @@ public:
     struct VitsMetrics {
         VitsMetrics() : inUse(false), wSNR(0), bPSNR(0) {}
 
+        void read(JsonReader &reader);
+        void write(JsonWriter &writer) const;
+
         bool inUse;
         qreal wSNR;
         qreal bPSNR;
+
+        QByteArray unknownMembers;
     };
 
     // NTSC Specific metadata definition
@@ -128,6 +155,9 @@ public:
         Ntsc() : inUse(false), isFmCodeDataValid(false), fmCodeData(0), fieldFlag(false),
             whiteFlag(false), ccData0(0), ccData1(0) {}
 
+        void read(JsonReader &reader);
+        void write(JsonWriter &writer) const;
+
         bool inUse;
         bool isFmCodeDataValid;
         qint32 fmCodeData;
@@ -135,17 +165,24 @@ public:
         bool whiteFlag;
         qint32 ccData0;
         qint32 ccData1;
+
+        QByteArray unknownMembers;
     };
 
     // PCM sound metadata definition
     struct PcmAudioParameters {
-        PcmAudioParameters() : isValid(false) {}
-        
+        PcmAudioParameters() : sampleRate(0), isLittleEndian(false), isSigned(false), bits(0), isValid(false) {}
+
+        void read(JsonReader &reader);
+        void write(JsonWriter &writer) const;
+
         qint32 sampleRate;
         bool isLittleEndian;
         bool isSigned;
         qint32 bits;
 
+        QByteArray unknownMembers;
+
         // Flags if our data has been initialized yet
         bool isValid;
     };
@@ -153,7 +190,11 @@ public:
     // Field metadata definition
     struct Field {
         Field() : seqNo(0), isFirstField(false), syncConf(0), medianBurstIRE(0),
-            fieldPhaseID(0), audioSamples(0), pad(false) {}
+            fieldPhaseID(0), audioSamples(0), pad(false), diskLoc(0), fileLoc(0), decodeFaults(0),
+            efmTValues(0) {}
+
+        void read(JsonReader &reader);
+        void write(JsonWriter &writer) const;
 
         qint32 seqNo;       // Note: This is the unique primary-key
         bool isFirstField;
@@ -166,12 +207,15 @@ public:
         Vbi vbi;
         Ntsc ntsc;
         DropOuts dropOuts;
+        QByteArray dropOutsUnknownMembers;
         bool pad;
 
-        qint32 diskLoc;
-        qint32 fileLoc;
+        double diskLoc;
+        qint64 fileLoc;
         qint32 decodeFaults;
         qint32 efmTValues;
+
+        QByteArray unknownMembers;
     };
 
     // Overall metadata definition
@@ -181,6 +225,35 @@ public:
         QVector<Field> fields;
     };
 
+    // A buffer of changes to field metadata. While worker threads are reading
+    // the metadata, each can collect its changes in its own FieldUpdates;
+    // once they have finished, the changes are applied with applyFieldUpdates.
+    class FieldUpdates {
+    public:
+        void updateFieldVitsMetrics(LdDecodeMetaData::VitsMetrics _vitsMetrics, qint32 sequentialFieldNumber);
+        void updateFieldVbi(LdDecodeMetaData::Vbi _vbi, qint32 sequentialFieldNumber);
+        void updateFieldNtsc(LdDecodeMetaData::Ntsc _ntsc, qint32 sequentialFieldNumber);
+        void updateFieldDropOuts(DropOuts _dropOuts, qint32 sequentialFieldNumber);
+        void append(const FieldUpdates &other);
+
+        qint32 size() const;
+        void clear();
+        QVector<qint32> getFieldNumbers() const;
+
+        // Read or write the changes to one field as a JSON object, in the
+        // same format as a field record in the JSON metadata
+        void readRecord(JsonReader &reader);
+        void writeRecord(JsonWriter &writer, qint32 sequentialFieldNumber) const;
+
+    private:
+        friend class LdDecodeMetaData;
+
+        QVector<QPair<qint32, VitsMetrics>> vitsMetrics;
+        QVector<QPair<qint32, Vbi>> vbi;
+        QVector<QPair<qint32, Ntsc>> ntsc;
+        QVector<QPair<qint32, DropOuts>> dropOuts;
+    };
+
     // CLV timecode (used by frame number conversion methods)
     struct ClvTimecode {
         qint32 hours;
@@ -198,21 +271,25 @@ public:
     bool read(QString fileName);
     bool write(QString fileName);
 
-    VideoParameters getVideoParameters();
+    VideoParameters getVideoParameters() const;
     void setVideoParameters(VideoParameters _videoParameters);
 
-    PcmAudioParameters getPcmAudioParameters();
+    PcmAudioParameters getPcmAudioParameters() const;
     void setPcmAudioParameters(PcmAudioParameters _pcmAudioParam);
 
     // Handle line parameters
     void processLineParameters(LdDecodeMetaData::LineParameters &_lineParameters);
 
-    // Get field metadata
-    Field getField(qint32 sequentialFieldNumber);
-    VitsMetrics getFieldVitsMetrics(qint32 sequentialFieldNumber);
-    Vbi getFieldVbi(qint32 sequentialFieldNumber);
-    Ntsc getFieldNtsc(qint32 sequentialFieldNumber);
-    DropOuts getFieldDropOuts(qint32 sequentialFieldNumber);
+    // Get field metadata. The const methods can be called from any number of
+    // threads at once, provided nothing is changing the metadata.
+    Field getField(qint32 sequentialFieldNumber) const;
+    VitsMetrics getFieldVitsMetrics(qint32 sequentialFieldNumber) const;
+    Vbi getFieldVbi(qint32 sequentialFieldNumber) const;
+    Ntsc getFieldNtsc(qint32 sequentialFieldNumber) const;
+    const DropOuts &getFieldDropOuts(qint32 sequentialFieldNumber) const;
+    bool getFieldIsFirstField(qint32 sequentialFieldNumber) const;
+    qint32 getFieldPhaseID(qint32 sequentialFieldNumber) const;
+    bool getFieldPad(qint32 sequentialFieldNumber) const;
 
     // Set field metadata
     void updateField(Field _field, qint32 sequentialFieldNumber);
@@ -221,35 +298,88 @@ public:
     void updateFieldNtsc(LdDecodeMetaData::Ntsc _ntsc, qint32 sequentialFieldNumber);
     void updateFieldDropOuts(DropOuts _dropOuts, qint32 sequentialFieldNumber);
     void clearFieldDropOuts(qint32 sequentialFieldNumber);
+    void applyFieldUpdates(const FieldUpdates &updates);
 
     void appendField(Field _field);
     
     void setNumberOfFields(qint32 numberOfFields);
-    qint32 getNumberOfFields();
-    qint32 getNumberOfFrames();
-    qint32 getFirstFieldNumber(qint32 frameNumber);
-    qint32 getSecondFieldNumber(qint32 frameNumber);
+    qint32 getNumberOfFields() const;
+    qint32 getNumberOfFrames() const;
+    qint32 getFirstFieldNumber(qint32 frameNumber) const;
+    qint32 getSecondFieldNumber(qint32 frameNumber) const;
 
     void setIsFirstFieldFirst(bool flag);
-    bool getIsFirstFieldFirst();
+    bool getIsFirstFieldFirst() const;
 
     qint32 convertClvTimecodeToFrameNumber(LdDecodeMetaData::ClvTimecode clvTimeCode);
     LdDecodeMetaData::ClvTimecode convertFrameNumberToClvTimecode(qint32 clvFrameNumber);
 
     // PCM Analogue audio helper methods
-    qint32 getFieldPcmAudioStart(qint32 sequentialFieldNumber);
-    qint32 getFieldPcmAudioLength(qint32 sequentialFieldNumber);
+    qint32 getFieldPcmAudioStart(qint32 sequentialFieldNumber) const;
+    qint32 getFieldPcmAudioLength(qint32 sequentialFieldNumber) const;
 
 private:
-    JsonWax json;
     bool isFirstFieldFirst;
     VideoParameters videoParameters;
     LineParameters lineParameters;
     PcmAudioParameters pcmAudioParameters;
+
+    // Field metadata, stored as a column for each member so that one member
+    // of a field can be read without building a whole Field. The columns
+    // are filled in once by read(), and only changed by the update methods,
+    // so any number of threads can use the const accessors at once.
+    struct FieldColumns {
+        qint32 size() const { return seqNo.size(); }
+        void clear();
+        void reserve(qint32 size);
+        void resize(qint32 size);
+        void append(const Field &field);
+
+        Field get(qint32 fieldNumber) const;
+        VitsMetrics getVitsMetrics(qint32 fieldNumber) const;
+        Vbi getVbi(qint32 fieldNumber) const;
+        Ntsc getNtsc(qint32 fieldNumber) const;
+        void set(qint32 fieldNumber, const Field &field);
+        void setFlag(qint32 fieldNumber, quint32 flag, bool value);
+
+        QVector<qint32> seqNo;
+        QVector<quint32> flags;
+        QVector<qint32> syncConf;
+        QVector<qreal> medianBurstIRE;
+        QVector<qint32> fieldPhaseID;
+        QVector<qint32> audioSamples;
+        QVector<double> diskLoc;
+        QVector<qint64> fileLoc;
+        QVector<qint32> decodeFaults;
+        QVector<qint32> efmTValues;
+        QVector<qreal> wSNR;
+        QVector<qreal> bPSNR;
+        QVector<qint32> vbiData;    // Three entries per field
+        QVector<qint32> fmCodeData;
+        QVector<qint32> ccData0;
+        QVector<qint32> ccData1;
+        QVector<DropOuts> dropOuts;
+        QVector<QByteArray> unknownMembers;
+        QVector<QByteArray> vitsUnknownMembers;
+        QVector<QByteArray> vbiUnknownMembers;
+        QVector<QByteArray> ntscUnknownMembers;
+        QVector<QByteArray> dropOutsUnknownMembers;
+    };
+    FieldColumns fields;
+
+    // Top-level members that weren't recognised when reading the JSON
+    QByteArray unknownMembers;
+
     QVector<qint32> pcmAudioFieldStartSampleMap;
     QVector<qint32> pcmAudioFieldLengthMap;
 
-    qint32 getFieldNumber(qint32 frameNumber, qint32 field);
+    qint32 getFieldNumber(qint32 frameNumber, qint32 field) const;
+    void readFields(JsonReader &reader);
+    void writeFields(JsonWriter &writer) const;
+
+    static QString getBinaryFileName(const QString &jsonFileName);
+    bool readBinary(const QString &binaryFileName, const QFileInfo &jsonFileInfo);
+    bool writeBinary(const QString &binaryFileName, const QFileInfo &jsonFileInfo) const;
     void generatePcmAudioMap();
 };
 
@@ -0,0 +1,152 @@
+/************************************************************************
+
+    metadatajournal.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "metadatajournal.h"
+
+#include "jsonio.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <sstream>
+
+MetadataJournal::MetadataJournal()
+    : writeFailed(false)
+{
+}
+
+MetadataJournal::~MetadataJournal()
+{
+    close();
+}
+
+// Return the name of the journal for a JSON file
+QString MetadataJournal::getJournalFileName(const QString &jsonFileName)
+{
+    if (jsonFileName.endsWith(".json")) return jsonFileName.left(jsonFileName.size() - 5) + ".journal";
+    return jsonFileName + ".journal";
+}
+
+bool MetadataJournal::open(const QString &_fileName, bool resume, LdDecodeMetaData::FieldUpdates &updates)
+{
+    close();
+    fileName = _fileName;
+    writeFailed = false;
+    updates.clear();
+
+    std::ios::openmode mode = std::ios::out | std::ios::trunc;
+    if (resume && QFileInfo::exists(fileName)) {
+        qint64 validLength;
+        if (!readJournal(updates, validLength)) return false;
+
+        // Discard any incomplete record at the end, and add to what's left
+        QFile journalFile(fileName);
+        if (!journalFile.resize(validLength)) {
+            qCritical() << "Could not truncate metadata journal" << fileName << "-" << journalFile.errorString();
+            return false;
+        }
+        mode = std::ios::out | std::ios::app;
+    }
+
+    output.open(QFile::encodeName(fileName).constData(), mode);
+    if (output.fail()) {
+        qCritical() << "Could not open metadata journal" << fileName;
+        return false;
+    }
+
+    return true;
+}
+
+// Add the changes in updates to the journal, one record per field.
+//
+// If writing fails, a warning is shown and nothing more is written. This
+// isn't fatal, as the tool still has the changes in memory; it just means the
+// journal can't be used to resume.
+void MetadataJournal::write(const LdDecodeMetaData::FieldUpdates &updates)
+{
+    // Format the records before taking the lock
+    std::ostringstream records;
+    JsonWriter writer(records);
+    for (qint32 fieldNumber : updates.getFieldNumbers()) {
+        updates.writeRecord(writer, fieldNumber);
+        records << '\n';
+    }
+
+    QMutexLocker locker(&mutex);
+    if (!output.is_open() || writeFailed) return;
+
+    // Flush straight away, so the records survive if the tool is killed
+    output << records.str();
+    output.flush();
+
+    if (output.fail()) {
+        qWarning() << "Writing to metadata journal" << fileName << "failed - it cannot be used to resume processing";
+        writeFailed = true;
+    }
+}
+
+void MetadataJournal::close()
+{
+    if (output.is_open()) output.close();
+}
+
+// Close the journal and delete it. Call this once the changes in the journal
+// have been written to the JSON metadata.
+void MetadataJournal::remove()
+{
+    close();
+    if (!fileName.isEmpty() && QFileInfo::exists(fileName) && !QFile::remove(fileName)) {
+        qWarning() << "Could not remove metadata journal" << fileName;
+    }
+}
+
+// Read the records in an existing journal into updates, and set validLength
+// to the length of the complete records. Returns true on success.
+bool MetadataJournal::readJournal(LdDecodeMetaData::FieldUpdates &updates, qint64 &validLength)
+{
+    std::ifstream input(QFile::encodeName(fileName).constData());
+    if (input.fail()) {
+        qCritical() << "Could not open metadata journal" << fileName;
+        return false;
+    }
+
+    JsonReader reader(input);
+    validLength = 0;
+    while (!reader.atEnd()) {
+        validLength = static_cast<qint64>(input.tellg());
+        updates.readRecord(reader);
+    }
+
+    if (reader.hasError()) {
+        // This is expected if the tool was interrupted while writing, and
+        // the records before this one are still usable
+        qWarning() << "Ignoring incomplete record in metadata journal" << fileName << "-" << reader.errorString();
+    } else {
+        validLength = QFileInfo(fileName).size();
+    }
+
+    qInfo() << "Metadata journal" << fileName << "contains results for" << updates.getFieldNumbers().size() << "fields";
+
+    return true;
+}
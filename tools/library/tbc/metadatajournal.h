@@ -0,0 +1,92 @@
+/************************************************************************
+
+    metadatajournal.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef METADATAJOURNAL_H
+#define METADATAJOURNAL_H
+
+#include <QMutex>
+#include <QString>
+
+#include <fstream>
+
+#include "lddecodemetadata.h"
+
+// An append-only journal of changes to field metadata.
+//
+// Tools that process a whole TBC file keep their results in memory, and only
+// write the JSON metadata once they've finished. So that an interrupted run
+// doesn't lose all its work, they also write each result to the journal as
+// soon as it's produced.
+//
+// The journal contains one JSON object per line, each holding the changed
+// members of one field in the same form as the JSON metadata's field records
+// (for example, {"seqNo":10,"vitsMetrics":{"wSNR":41.2,"bPSNR":38.9}}).
+// Each write is flushed straight away, so if the tool is killed, at most the
+// last record will be incomplete; this is ignored when the journal is read.
+//
+// To resume an interrupted run, open the journal with resume set, apply the
+// changes it returns to the metadata, and skip the fields they cover. Once
+// LdDecodeMetaData::write has succeeded (it replaces the JSON file
+// atomically, so the old file survives an interrupted write), remove the
+// journal.
+class MetadataJournal
+{
+public:
+    MetadataJournal();
+    ~MetadataJournal();
+
+    // Prevent copying or assignment
+    MetadataJournal(const MetadataJournal &) = delete;
+    MetadataJournal& operator=(const MetadataJournal &) = delete;
+
+    // Return the name of the journal for a JSON file
+    static QString getJournalFileName(const QString &jsonFileName);
+
+    // Open the journal for writing. If resume is true and the journal
+    // already exists, the changes in it are returned in updates, and new
+    // records are added after them; otherwise, any existing journal is
+    // replaced. Returns true on success.
+    bool open(const QString &_fileName, bool resume, LdDecodeMetaData::FieldUpdates &updates);
+
+    // Add the changes in updates to the journal. This can be called from any
+    // thread.
+    void write(const LdDecodeMetaData::FieldUpdates &updates);
+
+    void close();
+
+    // Close the journal and delete it
+    void remove();
+
+private:
+    QString fileName;
+
+    // Output stream (guarded by mutex while the journal is open)
+    QMutex mutex;
+    std::ofstream output;
+    bool writeFailed;
+
+    bool readJournal(LdDecodeMetaData::FieldUpdates &updates, qint64 &validLength);
+};
+
+#endif // METADATAJOURNAL_H
@@ -26,6 +26,7 @@
 #define SOURCEAUDIO_H
 
 #include <QVector>
+#include <QDataStream>
 #include <QDebug>
 #include <QFileInfo>
 #include <QFile>
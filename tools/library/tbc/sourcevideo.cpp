@@ -26,6 +26,37 @@
 
 #include <cstdio>
 
+#if defined(Q_OS_UNIX)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Give the kernel a hint about how a region of the mapped input will be used.
+// This is advisory only, so failures are ignored.
+#if defined(Q_OS_UNIX)
+static void adviseMapping(const uchar *start, qint64 length, int advice)
+{
+    // The start address must be page-aligned
+    const quintptr pageSize = static_cast<quintptr>(sysconf(_SC_PAGESIZE));
+    const quintptr startAddress = reinterpret_cast<quintptr>(start);
+    const quintptr alignedAddress = startAddress & ~(pageSize - 1);
+
+    posix_madvise(reinterpret_cast<void *>(alignedAddress),
+                  static_cast<size_t>(length) + (startAddress - alignedAddress), advice);
+}
+#endif
+
+// A memory mapping of the input file. This has its own QFile, so it can
+// outlive the SourceVideo that created it while Data objects still refer to it.
+struct SourceVideo::Mapping {
+    QFile file;
+    const uchar *data = nullptr;
+
+    ~Mapping() {
+        if (data != nullptr) file.unmap(const_cast<uchar *>(data));
+    }
+};
+
 // Class constructor
 SourceVideo::SourceVideo()
 {
@@ -43,7 +74,10 @@ SourceVideo::SourceVideo()
 
 SourceVideo::~SourceVideo()
 {
-    if (isSourceVideoOpen) inputFile.close();
+    if (isSourceVideoOpen) {
+        unmapInputFile();
+        inputFile.close();
+    }
 }
 
 // Source Video file manipulation methods -----------------------------------------------------------------------------
@@ -87,6 +121,9 @@ bool SourceVideo::open(QString filename, qint32 _fieldLength, qint32 _fieldLineL
         qint64 tAvailableFields = (inputFile.size() / fieldByteLength);
         availableFields = static_cast<qint32>(tAvailableFields);
         qDebug() << "SourceVideo::open(): Successful -" << availableFields << "fields available";
+
+        // Memory-map the file if we can; if not, fall back to reading it
+        mapInputFile();
     }
 
     // Initialise cache
@@ -107,6 +144,7 @@ void SourceVideo::close()
     }
 
     qDebug() << "SourceVideo::close(): Called, closing the source video file and emptying the frame cache";
+    unmapInputFile();
     inputFile.close();
     isSourceVideoOpen = false;
     inputFilePos = -1;
@@ -133,31 +171,60 @@ qint32 SourceVideo::getFieldLength()
     return fieldLength;
 }
 
+// Memory-map the whole input file.
+// Returns true on success; on failure the input will be read through inputFile instead.
+bool SourceVideo::mapInputFile()
+{
+    // Pipes and other sequential devices can't be mapped
+    if (inputFile.isSequential()) return false;
+
+    const qint64 mappedSize = inputFile.size();
+    if (mappedSize == 0) return false;
+
+    std::shared_ptr<Mapping> newMapping = std::make_shared<Mapping>();
+    newMapping->file.setFileName(inputFile.fileName());
+    if (newMapping->file.open(QIODevice::ReadOnly)) {
+        newMapping->data = newMapping->file.map(0, mappedSize);
+    }
+    if (newMapping->data == nullptr) {
+        qDebug() << "SourceVideo::mapInputFile(): Could not map input file, falling back to buffered reads -" << newMapping->file.errorString();
+        return false;
+    }
+
+#if defined(Q_OS_UNIX)
+    // Most tools read through the input in order
+    adviseMapping(newMapping->data, mappedSize, POSIX_MADV_SEQUENTIAL);
+#endif
+
+    mapping = std::move(newMapping);
+
+    qDebug() << "SourceVideo::mapInputFile(): Mapped" << mappedSize << "bytes of input";
+    return true;
+}
+
+// Stop using the mapping of the input file, if it is mapped. It's unmapped
+// once no Data refers to it.
+void SourceVideo::unmapInputFile()
+{
+    mapping.reset();
+}
+
 // Frame data retrieval methods ---------------------------------------------------------------------------------------
 
-// Method to retrieve a range of field lines from a single video field.
-// If startFieldLine and endFieldLine are both -1, read the whole field.
-SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFieldLine, qint32 endFieldLine)
+// Work out the position and length in bytes within the input file of a range
+// of field lines (with the same arguments as getVideoField).
+void SourceVideo::getFieldRange(qint32 fieldNumber, qint32 startFieldLine, qint32 endFieldLine,
+                                qint64 &startPosition, qint64 &readLength)
 {
     // Adjust the field number to index from zero
     fieldNumber--;
 
-    // Ensure source video is open
-    if (!isSourceVideoOpen) qFatal("Application requested TBC field before opening TBC file - Fatal error");
-
     // Calculate the position of the require field line data
-    qint64 requiredStartPosition = static_cast<qint64>(fieldByteLength) * static_cast<qint64>(fieldNumber);
-    qint64 requiredReadLength;
+    startPosition = static_cast<qint64>(fieldByteLength) * static_cast<qint64>(fieldNumber);
 
     if (startFieldLine == -1 && endFieldLine == -1) {
         // Read the whole field
-
-        // Check the cache (we only cache whole fields)
-        if (fieldCache.contains(fieldNumber)) {
-            return *fieldCache.object(fieldNumber);
-        }
-
-        requiredReadLength = static_cast<qint64>(fieldByteLength);
+        readLength = static_cast<qint64>(fieldByteLength);
     } else {
         // Read a range of lines
 
@@ -169,19 +236,56 @@ SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFie
         if (fieldLineLength == -1) qFatal("Application did not set field line length when opening TBC file");
         if (startFieldLine < 0) qFatal("Application requested out-of-bounds field line");
 
-        requiredStartPosition += static_cast<qint64>(fieldLineLength) * static_cast<qint64>(startFieldLine);
-        requiredReadLength = static_cast<qint64>(endFieldLine - startFieldLine + 1) * static_cast<qint64>(fieldLineLength);
+        startPosition += static_cast<qint64>(fieldLineLength) * static_cast<qint64>(startFieldLine);
+        readLength = static_cast<qint64>(endFieldLine - startFieldLine + 1) * static_cast<qint64>(fieldLineLength);
     }
 
     // Check the requested field and lines are valid
     if (availableFields != -1
-        && (requiredStartPosition < 0
-            || requiredStartPosition + requiredReadLength > (static_cast<qint64>(fieldByteLength) * availableFields))) {
+        && (startPosition < 0
+            || startPosition + readLength > (static_cast<qint64>(fieldByteLength) * availableFields))) {
         qFatal("Application requested field line range that exceeds the boundaries of the input TBC file");
     }
+}
+
+// Method to retrieve a range of field lines from a single video field.
+// If startFieldLine and endFieldLine are both -1, read the whole field.
+SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFieldLine, qint32 endFieldLine)
+{
+    // Ensure source video is open
+    if (!isSourceVideoOpen) qFatal("Application requested TBC field before opening TBC file - Fatal error");
+
+    // Calculate the position of the require field line data
+    qint64 requiredStartPosition, requiredReadLength;
+    getFieldRange(fieldNumber, startFieldLine, endFieldLine, requiredStartPosition, requiredReadLength);
 
-    // Resize the output buffer
-    outputFieldData.resize(static_cast<qint32>(requiredReadLength) / 2);
+    // If the input is memory-mapped, return a Data that refers to the mapping
+    // without copying it (the page cache makes the field cache redundant)
+    if (mapping != nullptr) {
+        const uchar *fieldStart = mapping->data + requiredStartPosition;
+
+#if defined(Q_OS_UNIX)
+        // Ask the kernel to start reading this range in now
+        adviseMapping(fieldStart, requiredReadLength, POSIX_MADV_WILLNEED);
+#endif
+
+        return Data::fromExternal(reinterpret_cast<const quint16 *>(fieldStart),
+                                  static_cast<qint32>(requiredReadLength / 2), mapping);
+    }
+
+    // Adjust the field number to index from zero
+    fieldNumber--;
+
+    if (startFieldLine == -1 && endFieldLine == -1) {
+        // Check the cache (we only cache whole fields)
+        if (fieldCache.contains(fieldNumber)) {
+            return *fieldCache.object(fieldNumber);
+        }
+    }
+
+    // Read into a new buffer, as the caller and the cache may still be
+    // sharing the previous one
+    Data fieldData(static_cast<qint32>(requiredReadLength) / 2);
 
     // Seek to the correct file position (if not already there)
     if (inputFilePos != requiredStartPosition) {
@@ -194,8 +298,8 @@ SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFie
                 // Seeking forwards -- try reading and discarding data instead
                 qint64 discardBytes = requiredStartPosition - inputFilePos;
                 while (discardBytes > 0) {
-                    qint64 readBytes = inputFile.read(reinterpret_cast<char *>(outputFieldData.data()),
-                                                      qMin(discardBytes, static_cast<qint64>(outputFieldData.size() * 2)));
+                    qint64 readBytes = inputFile.read(reinterpret_cast<char *>(fieldData.data()),
+                                                      qMin(discardBytes, static_cast<qint64>(fieldData.size() * 2)));
                     if (readBytes <= 0) {
                         qFatal("Could not seek or read forwards to required field position in input TBC file");
                     }
@@ -210,7 +314,7 @@ SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFie
     qint64 totalReceivedBytes = 0;
     qint64 receivedBytes = 0;
     do {
-        receivedBytes = inputFile.read(reinterpret_cast<char *>(outputFieldData.data()) + totalReceivedBytes,
+        receivedBytes = inputFile.read(reinterpret_cast<char *>(fieldData.data()) + totalReceivedBytes,
                                        requiredReadLength - totalReceivedBytes);
         if (receivedBytes > 0) {
             totalReceivedBytes += receivedBytes;
@@ -223,22 +327,9 @@ SourceVideo::Data SourceVideo::getVideoField(qint32 fieldNumber, qint32 startFie
 
     if (startFieldLine == -1 && endFieldLine == -1) {
         // Insert the field data into the cache
-        fieldCache.insert(fieldNumber, new Data(outputFieldData), 1);
+        fieldCache.insert(fieldNumber, new Data(fieldData), 1);
     }
 
     // Return the data
-    return outputFieldData;
+    return fieldData;
 }
-
-
-
-
-
-
-
-
-
-
-
-
-
@@ -30,14 +30,25 @@
 #include <QDebug>
 #include <QVector>
 
+#include <memory>
+
+#include "videobuffer.h"
+
 class SourceVideo
 {
 public:
-    // A QVector of timebase-corrected video samples.
+    // A buffer of timebase-corrected video samples.
     // This is usually a complete field, but it may be a partial field if
     // you've requested fewer lines from getVideoField (or if you've sliced it
-    // yourself).
-    using Data = QVector<quint16>;
+    // yourself). Copying a Data shares the samples rather than copying them;
+    // see VideoBuffer.
+    //
+    // When the input file is memory-mapped, the Data returned by
+    // getVideoField refers directly to the mapping, so reading a field
+    // doesn't copy it; the samples are only copied if you write to them. The
+    // mapping stays valid while any Data refers to it, even after the
+    // SourceVideo is closed.
+    using Data = VideoBuffer;
 
     SourceVideo();
     ~SourceVideo();
@@ -68,10 +79,17 @@ private:
     qint32 fieldByteLength;
     qint32 fieldLineLength;
 
-    Data outputFieldData;
+    // Memory-mapped input (nullptr if the input is read through inputFile)
+    struct Mapping;
+    std::shared_ptr<Mapping> mapping;
 
     // Field caching
     QCache<qint32, Data> fieldCache;
+
+    bool mapInputFile();
+    void unmapInputFile();
+    void getFieldRange(qint32 fieldNumber, qint32 startFieldLine, qint32 endFieldLine,
+                       qint64 &startPosition, qint64 &readLength);
 };
 
 #endif // SOURCEVIDEO_H
@@ -0,0 +1,157 @@
+/************************************************************************
+
+    testdropoutindex.cpp
+
+    Unit tests and benchmark for DropOutIndex
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using std::cerr;
+
+#include "dropoutindex.h"
+
+// Field dimensions used for testing (PAL)
+static constexpr qint32 FIELD_WIDTH = 1135;
+static constexpr qint32 FIELD_HEIGHT = 313;
+
+// Check a point by scanning the whole list, as the tools originally did
+bool referenceIsDropout(const DropOuts &dropOuts, qint32 fieldLine, qint32 x)
+{
+    for (qint32 i = 0; i < dropOuts.size(); i++) {
+        if (dropOuts.fieldLine(i) == fieldLine && x >= dropOuts.startx(i) && x <= dropOuts.endx(i)) return true;
+    }
+    return false;
+}
+
+// Check a range by scanning the whole list
+bool referenceOverlaps(const DropOuts &dropOuts, qint32 fieldLine, qint32 startx, qint32 endx)
+{
+    for (qint32 i = 0; i < dropOuts.size(); i++) {
+        if (dropOuts.fieldLine(i) == fieldLine && dropOuts.startx(i) <= dropOuts.endx(i) && startx <= endx
+            && endx >= dropOuts.startx(i) && dropOuts.endx(i) >= startx) return true;
+    }
+    return false;
+}
+
+// Make a field's worth of random dropouts, in random order, with some
+// overlapping, touching or empty
+DropOuts makeDropOuts(std::mt19937 &rng, qint32 count)
+{
+    std::uniform_int_distribution<qint32> lineDist(1, FIELD_HEIGHT);
+    std::uniform_int_distribution<qint32> xDist(0, FIELD_WIDTH - 1);
+    std::uniform_int_distribution<qint32> lengthDist(-2, 60);
+
+    DropOuts dropOuts;
+    for (qint32 i = 0; i < count; i++) {
+        const qint32 fieldLine = lineDist(rng);
+        const qint32 startx = xDist(rng);
+        const qint32 endx = startx + lengthDist(rng);
+        dropOuts.append(startx, endx, fieldLine);
+
+        // Sometimes add a dropout that touches the previous one
+        if ((i % 7) == 0) dropOuts.append(endx + 1, endx + 10, fieldLine);
+    }
+
+    return dropOuts;
+}
+
+// Compare the index against scans of the original list
+void testQueries()
+{
+    cerr << "Testing queries\n";
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint32> xDist(-10, FIELD_WIDTH + 10);
+    std::uniform_int_distribution<qint32> lengthDist(-1, 100);
+    QVector<quint8> lineMap(FIELD_WIDTH + 40);
+
+    for (qint32 count : {0, 1, 2, 10, 100, 1000}) {
+        for (qint32 test = 0; test < 2; test++) {
+            const DropOuts dropOuts = makeDropOuts(rng, count);
+            const DropOutIndex index(dropOuts);
+            assert(index.empty() == (count == 0));
+
+            for (qint32 fieldLine = -1; fieldLine <= FIELD_HEIGHT + 2; fieldLine++) {
+                // Point queries, and a map of the whole line (including either side)
+                bool anyDropouts = false;
+                index.fillLine(fieldLine, -20, lineMap.size(), lineMap.data());
+                for (qint32 x = -20; x < FIELD_WIDTH + 20; x++) {
+                    const bool expected = referenceIsDropout(dropOuts, fieldLine, x);
+                    assert(index.isDropout(fieldLine, x) == expected);
+                    assert(lineMap[x + 20] == (expected ? 1 : 0));
+                    anyDropouts |= expected;
+                }
+                assert(index.lineHasDropouts(fieldLine) == anyDropouts);
+
+                // Range queries
+                for (qint32 i = 0; i < 200; i++) {
+                    const qint32 startx = xDist(rng);
+                    const qint32 endx = startx + lengthDist(rng);
+                    assert(index.overlaps(fieldLine, startx, endx) == referenceOverlaps(dropOuts, fieldLine, startx, endx));
+                }
+            }
+        }
+    }
+}
+
+// Compare the speed of checking every pixel in a field
+void benchmarkQueries()
+{
+    std::mt19937 rng(42);
+    const DropOuts dropOuts = makeDropOuts(rng, 500);
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 referenceCount = 0;
+    for (qint32 fieldLine = 1; fieldLine <= FIELD_HEIGHT; fieldLine++) {
+        for (qint32 x = 0; x < FIELD_WIDTH; x++) {
+            if (referenceIsDropout(dropOuts, fieldLine, x)) referenceCount++;
+        }
+    }
+    const qint64 referenceTime = timer.nsecsElapsed();
+
+    timer.restart();
+    const DropOutIndex index(dropOuts);
+    qint64 count = 0;
+    QVector<quint8> lineMap(FIELD_WIDTH);
+    for (qint32 fieldLine = 1; fieldLine <= FIELD_HEIGHT; fieldLine++) {
+        index.fillLine(fieldLine, 0, FIELD_WIDTH, lineMap.data());
+        for (qint32 x = 0; x < FIELD_WIDTH; x++) count += lineMap[x];
+    }
+    const qint64 indexTime = timer.nsecsElapsed();
+
+    assert(count == referenceCount);
+    cerr << "Checking a field with " << dropOuts.size() << " dropouts took " << (indexTime / 1000) << " us; "
+         << "scanning the list took " << (referenceTime / 1000) << " us\n";
+}
+
+int main()
+{
+    testQueries();
+    benchmarkQueries();
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testdropoutindex.cpp \
+    ../dropoutindex.cpp \
+    ../dropouts.cpp
+
+HEADERS += \
+    ../dropoutindex.h \
+    ../dropouts.h
+
+INCLUDEPATH += \
+    ..
+
+target.CONFIG += no_default_install
@@ -0,0 +1,229 @@
+/************************************************************************
+
+    testfieldprefetcher.cpp
+
+    Unit tests for FieldPrefetcher
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+#include <QVector>
+
+#include <cassert>
+#include <iostream>
+
+using std::cerr;
+
+#include "fieldprefetcher.h"
+#include "sourcevideo.h"
+
+// A small field, so the source file is quick to write
+static constexpr qint32 FIELD_LENGTH = 1000;
+static constexpr qint32 NUM_FIELDS = 100;
+
+// The prefetcher is set up with 2 frames of read-ahead and 1 frame retained
+// behind the read position, so the ring holds 2 + (2 * 2) = 6 fields
+static constexpr qint32 DEPTH_FRAMES = 2;
+static constexpr qint32 RETAIN_FRAMES = 1;
+static constexpr qint32 RETAIN_FIELDS = 2 * RETAIN_FRAMES;
+
+// The sample value that the test source has at a position in a field
+static quint16 sampleValue(qint32 fieldNumber, qint32 position)
+{
+    return static_cast<quint16>((fieldNumber * 7919) + position);
+}
+
+// Write a .tbc file where every sample identifies its field and position
+static void writeSource(const QString &fileName)
+{
+    QVector<quint16> fieldData(FIELD_LENGTH);
+
+    QFile file(fileName);
+    bool ok = file.open(QIODevice::WriteOnly);
+    assert(ok);
+    for (qint32 fieldNumber = 1; fieldNumber <= NUM_FIELDS; fieldNumber++) {
+        for (qint32 i = 0; i < FIELD_LENGTH; i++) fieldData[i] = sampleValue(fieldNumber, i);
+
+        const qint64 size = static_cast<qint64>(FIELD_LENGTH) * sizeof(quint16);
+        const qint64 written = file.write(reinterpret_cast<const char *>(fieldData.data()), size);
+        assert(written == size);
+    }
+    file.close();
+}
+
+// Get a field through the prefetcher and check it's the right one
+static void checkField(FieldPrefetcher &prefetcher, qint32 fieldNumber)
+{
+    const SourceVideo::Data data = prefetcher.getVideoField(fieldNumber);
+    assert(data.size() == FIELD_LENGTH);
+    for (qint32 i = 0; i < FIELD_LENGTH; i++) {
+        assert(data[i] == sampleValue(fieldNumber, i));
+    }
+}
+
+// Get a field, and check whether the request had to wait for a read. A
+// request for a field in the ring may also wait if the I/O thread hasn't got
+// to it yet, so only a request outside the ring has a predictable count.
+static void checkStall(FieldPrefetcher &prefetcher, qint32 fieldNumber, bool expectStall)
+{
+    const qint64 before = prefetcher.getStallCount();
+    checkField(prefetcher, fieldNumber);
+    assert((prefetcher.getStallCount() - before) == (expectStall ? 1 : 0));
+}
+
+// Fields requested in order, as a single worker thread would
+void testInOrder(SourceVideo &sourceVideo)
+{
+    cerr << "Testing in-order requests\n";
+
+    FieldPrefetcher prefetcher(sourceVideo, DEPTH_FRAMES, RETAIN_FRAMES);
+    prefetcher.startPrefetch(1, NUM_FIELDS);
+    for (qint32 fieldNumber = 1; fieldNumber <= NUM_FIELDS; fieldNumber++) {
+        checkField(prefetcher, fieldNumber);
+    }
+    prefetcher.stopPrefetch();
+}
+
+// Fields requested out of order within a small window, as several worker
+// threads taking frames from a shared counter would
+void testOutOfOrder(SourceVideo &sourceVideo)
+{
+    cerr << "Testing out-of-order requests\n";
+
+    FieldPrefetcher prefetcher(sourceVideo, DEPTH_FRAMES, RETAIN_FRAMES);
+    prefetcher.startPrefetch(1, NUM_FIELDS);
+    for (qint32 fieldNumber = 1; fieldNumber + 3 <= NUM_FIELDS; fieldNumber += 4) {
+        checkField(prefetcher, fieldNumber + 1);
+        checkField(prefetcher, fieldNumber);
+        checkField(prefetcher, fieldNumber + 3);
+        checkField(prefetcher, fieldNumber + 2);
+
+        // Asking for the same field twice should give the same data
+        checkField(prefetcher, fieldNumber + 3);
+    }
+    prefetcher.stopPrefetch();
+}
+
+// Fields outside the ring should be read synchronously
+void testOutsideWindow(SourceVideo &sourceVideo)
+{
+    cerr << "Testing requests outside the window\n";
+
+    // Only prefetch the first 20 fields
+    FieldPrefetcher prefetcher(sourceVideo, DEPTH_FRAMES, RETAIN_FRAMES);
+    prefetcher.startPrefetch(1, 20);
+    for (qint32 fieldNumber = 1; fieldNumber <= 10; fieldNumber++) {
+        checkField(prefetcher, fieldNumber);
+    }
+
+    // Beyond the end of the prefetched range
+    checkStall(prefetcher, 50, true);
+    checkStall(prefetcher, NUM_FIELDS, true);
+
+    // Long before the window
+    checkStall(prefetcher, 1, true);
+
+    prefetcher.stopPrefetch();
+}
+
+// Once the read position has moved on, fields further back than the retained
+// frames should be evicted from the ring, and read synchronously if asked for
+void testEviction(SourceVideo &sourceVideo)
+{
+    cerr << "Testing eviction from the ring\n";
+
+    FieldPrefetcher prefetcher(sourceVideo, DEPTH_FRAMES, RETAIN_FRAMES);
+    prefetcher.startPrefetch(1, NUM_FIELDS);
+    for (qint32 fieldNumber = 1; fieldNumber <= 40; fieldNumber++) {
+        checkField(prefetcher, fieldNumber);
+
+        // The retained fields are still in the ring
+        for (qint32 retained = qMax(1, fieldNumber - RETAIN_FIELDS + 1); retained <= fieldNumber; retained++) {
+            checkStall(prefetcher, retained, false);
+        }
+
+        // The field before them has been evicted
+        if (fieldNumber > RETAIN_FIELDS) {
+            checkStall(prefetcher, fieldNumber - RETAIN_FIELDS, true);
+        }
+    }
+    prefetcher.stopPrefetch();
+}
+
+// Stopping the prefetcher part-way through should leave it reading
+// synchronously, and it should be possible to start it again from anywhere
+void testRestart(SourceVideo &sourceVideo)
+{
+    cerr << "Testing stopping and restarting\n";
+
+    FieldPrefetcher prefetcher(sourceVideo, DEPTH_FRAMES, RETAIN_FRAMES);
+    prefetcher.startPrefetch(1, NUM_FIELDS);
+    for (qint32 fieldNumber = 1; fieldNumber <= 30; fieldNumber++) {
+        checkField(prefetcher, fieldNumber);
+    }
+
+    // While stopped, fields are read directly and not counted as stalls
+    prefetcher.stopPrefetch();
+    for (qint32 fieldNumber = 28; fieldNumber <= 35; fieldNumber++) {
+        checkStall(prefetcher, fieldNumber, false);
+    }
+
+    // Stopping again does nothing
+    prefetcher.stopPrefetch();
+
+    // Restart further on; the stall count is reset
+    prefetcher.startPrefetch(60, NUM_FIELDS);
+    assert(prefetcher.getStallCount() == 0);
+    for (qint32 fieldNumber = 60; fieldNumber <= 80; fieldNumber++) {
+        checkField(prefetcher, fieldNumber);
+    }
+
+    // Restart back where we stopped, without stopping first
+    prefetcher.startPrefetch(31, NUM_FIELDS);
+    for (qint32 fieldNumber = 31; fieldNumber <= NUM_FIELDS; fieldNumber++) {
+        checkField(prefetcher, fieldNumber);
+    }
+
+    // The destructor should stop the I/O thread
+}
+
+int main()
+{
+    QTemporaryDir tempDir;
+    assert(tempDir.isValid());
+    const QString fileName = tempDir.filePath("test.tbc");
+    writeSource(fileName);
+
+    SourceVideo sourceVideo;
+    bool ok = sourceVideo.open(fileName, FIELD_LENGTH);
+    assert(ok);
+    assert(sourceVideo.getNumberOfAvailableFields() == NUM_FIELDS);
+
+    testInOrder(sourceVideo);
+    testOutOfOrder(sourceVideo);
+    testOutsideWindow(sourceVideo);
+    testEviction(sourceVideo);
+    testRestart(sourceVideo);
+
+    sourceVideo.close();
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testfieldprefetcher.cpp \
+    ../fieldprefetcher.cpp \
+    ../sourcevideo.cpp \
+    ../videobuffer.cpp \
+    ../videobufferpool.cpp
+
+HEADERS += \
+    ../fieldprefetcher.h \
+    ../sourcevideo.h \
+    ../videobuffer.h \
+    ../videobufferpool.h
+
+INCLUDEPATH += \
+    ..
+
+target.CONFIG += no_default_install
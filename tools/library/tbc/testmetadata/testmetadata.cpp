@@ -0,0 +1,688 @@
+/************************************************************************
+
+    testmetadata.cpp
+
+    Unit tests and benchmark for LdDecodeMetaData
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using std::cerr;
+
+#include "JsonWax.h"
+#include "jsonio.h"
+#include "lddecodemetadata.h"
+#include "metadatajournal.h"
+
+// Test JsonReader on small inputs
+void testReader()
+{
+    cerr << "Testing JsonReader\n";
+
+    // Read a structure with nested values, skipping unknown members
+    {
+        std::istringstream input(
+            "{\"a\": 1, \"skip\": {\"x\": [1, 2, {\"y\": null}], \"z\": \"}\"},\n"
+            " \"b\": [2.5, -3e2, NaN], \"c\": true, \"d\": \"q\\\"\\u00e9\\ud83d\\ude00\"}");
+        JsonReader reader(input);
+
+        qint32 a = 0;
+        QVector<double> b;
+        bool c = false;
+        QString d;
+
+        std::string member;
+        reader.beginObject();
+        while (reader.readMember(member)) {
+            if (member == "a") {
+                reader.read(a);
+            } else if (member == "b") {
+                reader.beginArray();
+                while (reader.readElement()) {
+                    double value;
+                    reader.read(value);
+                    b.append(value);
+                }
+                reader.endArray();
+            } else if (member == "c") {
+                reader.read(c);
+            } else if (member == "d") {
+                reader.read(d);
+            } else {
+                reader.discard();
+            }
+        }
+        reader.endObject();
+
+        assert(!reader.hasError());
+        assert(a == 1);
+        assert(b.size() == 3);
+        assert(b[0] == 2.5);
+        assert(b[1] == -300.0);
+        assert(std::isnan(b[2]));
+        assert(c);
+        assert(d == QString::fromUtf8("q\"\xc3\xa9\xf0\x9f\x98\x80"));
+    }
+
+    // Non-integer numbers are rounded when read as integers
+    {
+        std::istringstream input("[1.6, -1.6, null]");
+        JsonReader reader(input);
+
+        QVector<qint32> values;
+        reader.beginArray();
+        while (reader.readElement()) {
+            qint32 value = -1;
+            reader.read(value);
+            values.append(value);
+        }
+        reader.endArray();
+
+        assert(!reader.hasError());
+        assert(values.size() == 3);
+        assert(values[0] == 2);
+        assert(values[1] == -2);
+        assert(values[2] == 0);
+    }
+
+    // Errors are sticky, and stop loops
+    {
+        std::istringstream input("{\"a\": [1, 2");
+        JsonReader reader(input);
+
+        std::string member;
+        qint32 count = 0;
+        reader.beginObject();
+        while (reader.readMember(member)) {
+            reader.beginArray();
+            while (reader.readElement()) {
+                qint32 value;
+                reader.read(value);
+                count++;
+            }
+            reader.endArray();
+        }
+        reader.endObject();
+
+        assert(reader.hasError());
+        assert(count == 2);
+    }
+
+    // Type mismatches are errors
+    {
+        std::istringstream input("\"not a number\"");
+        JsonReader reader(input);
+
+        qint32 value;
+        reader.read(value);
+        assert(reader.hasError());
+    }
+}
+
+// Test JsonWriter by writing values and checking the output
+void testWriter()
+{
+    cerr << "Testing JsonWriter\n";
+
+    std::ostringstream output;
+    {
+        JsonWriter writer(output);
+        writer.beginObject();
+        writer.writeMember("a");
+        writer.write(static_cast<qint32>(-42));
+        writer.writeMember("b");
+        writer.beginArray();
+        writer.writeElement();
+        writer.write(0.1);
+        writer.writeElement();
+        writer.write(false);
+        writer.endArray();
+        writer.writeMember("c");
+        writer.write(QString::fromUtf8("tab\t\"quote\" \xc3\xa9"));
+        writer.endObject();
+    }
+
+    assert(output.str() == "{\"a\":-42,\"b\":[0.1,false],\"c\":\"tab\\t\\\"quote\\\" \xc3\xa9\"}");
+}
+
+// Generate synthetic metadata for a disc with the given number of fields
+void generateMetaData(LdDecodeMetaData &metaData, qint32 numFields)
+{
+    for (qint32 i = 0; i < numFields; i++) {
+        LdDecodeMetaData::Field field;
+
+        field.isFirstField = (i % 2) == 0;
+        field.syncConf = 100 - (i % 7);
+        field.medianBurstIRE = 20.0 + (i % 100) / 64.0;
+        field.fieldPhaseID = (i % 8) + 1;
+        field.audioSamples = 882 + (i % 3);
+        field.diskLoc = i;
+        field.fileLoc = i * 2;
+
+        field.vitsMetrics.inUse = true;
+        field.vitsMetrics.wSNR = 40.0 + (i % 50) / 8.0;
+        field.vitsMetrics.bPSNR = 38.0 + (i % 30) / 4.0;
+
+        field.vbi.inUse = true;
+        field.vbi.vbiData = {0x8BA000 + (i % 4), field.isFirstField ? 0xF80000 + (i / 2) : 0, -1};
+
+        // Give some fields a few dropouts
+        for (qint32 j = 0; j < (i % 4); j++) {
+            field.dropOuts.append(100 + j, 200 + j, 10 + (i % 300));
+        }
+
+        metaData.appendField(field);
+    }
+
+    LdDecodeMetaData::VideoParameters videoParameters;
+    videoParameters.isSourcePal = true;
+    videoParameters.colourBurstStart = 98;
+    videoParameters.colourBurstEnd = 138;
+    videoParameters.activeVideoStart = 185;
+    videoParameters.activeVideoEnd = 1107;
+    videoParameters.white16bIre = 54016;
+    videoParameters.black16bIre = 16384;
+    videoParameters.fieldWidth = 1135;
+    videoParameters.fieldHeight = 313;
+    videoParameters.sampleRate = 17734475;
+    videoParameters.fsc = 4433618;
+    videoParameters.gitBranch = "main";
+    videoParameters.gitCommit = "0123abc";
+    metaData.setVideoParameters(videoParameters);
+
+    LdDecodeMetaData::PcmAudioParameters pcmAudioParameters;
+    pcmAudioParameters.sampleRate = 44100;
+    pcmAudioParameters.isLittleEndian = true;
+    pcmAudioParameters.isSigned = true;
+    pcmAudioParameters.bits = 16;
+    metaData.setPcmAudioParameters(pcmAudioParameters);
+}
+
+// Check that two Field structs are field-by-field identical
+void assertSame(const LdDecodeMetaData::Field &actual, const LdDecodeMetaData::Field &expected)
+{
+    assert(actual.seqNo == expected.seqNo);
+    assert(actual.isFirstField == expected.isFirstField);
+    assert(actual.syncConf == expected.syncConf);
+    assert(actual.medianBurstIRE == expected.medianBurstIRE);
+    assert(actual.fieldPhaseID == expected.fieldPhaseID);
+    assert(actual.audioSamples == expected.audioSamples);
+    assert(actual.diskLoc == expected.diskLoc);
+    assert(actual.fileLoc == expected.fileLoc);
+    assert(actual.decodeFaults == expected.decodeFaults);
+    assert(actual.efmTValues == expected.efmTValues);
+    assert(actual.unknownMembers == expected.unknownMembers);
+
+    assert(actual.vitsMetrics.inUse == expected.vitsMetrics.inUse);
+    assert(actual.vitsMetrics.wSNR == expected.vitsMetrics.wSNR);
+    assert(actual.vitsMetrics.bPSNR == expected.vitsMetrics.bPSNR);
+    assert(actual.vitsMetrics.unknownMembers == expected.vitsMetrics.unknownMembers);
+
+    assert(actual.vbi.inUse == expected.vbi.inUse);
+    assert(actual.vbi.vbiData == expected.vbi.vbiData);
+
+    assert(actual.ntsc.inUse == expected.ntsc.inUse);
+
+    assert(actual.dropOuts.size() == expected.dropOuts.size());
+    assert(actual.dropOutsUnknownMembers == expected.dropOutsUnknownMembers);
+    for (qint32 i = 0; i < actual.dropOuts.size(); i++) {
+        assert(actual.dropOuts.startx(i) == expected.dropOuts.startx(i));
+        assert(actual.dropOuts.endx(i) == expected.dropOuts.endx(i));
+        assert(actual.dropOuts.fieldLine(i) == expected.dropOuts.fieldLine(i));
+    }
+
+    assert(actual.pad == expected.pad);
+}
+
+// Read the contents of a file into a byte array
+QByteArray readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    bool ok = file.open(QIODevice::ReadOnly);
+    assert(ok);
+    return file.readAll();
+}
+
+// Load metadata using a JsonWax document, as LdDecodeMetaData used to do,
+// extracting the values that most tools use. Returns the sum of audioSamples
+// so the work can't be optimised away.
+qint64 loadWithJsonWax(const QString &fileName)
+{
+    JsonWax json;
+    bool ok = json.loadFile(fileName);
+    assert(ok);
+
+    qint64 total = 0;
+    const qint32 numFields = json.size({"fields"});
+    for (qint32 i = 0; i < numFields; i++) {
+        total += json.value({"fields", i, "audioSamples"}).toInt();
+        total += json.value({"fields", i, "isFirstField"}).toBool() ? 1 : 0;
+        total += json.value({"fields", i, "vbi", "vbiData", 1}).toInt();
+
+        const qint32 numDropOuts = json.size({"fields", i, "dropOuts", "startx"});
+        for (qint32 j = 0; j < numDropOuts; j++) {
+            total += json.value({"fields", i, "dropOuts", "startx", j}).toInt();
+        }
+    }
+
+    return total;
+}
+
+// Extract the same values as loadWithJsonWax through LdDecodeMetaData, so that
+// the readers are timed doing the same work
+qint64 sumFields(const LdDecodeMetaData &metaData)
+{
+    qint64 total = 0;
+    for (qint32 i = 1; i <= metaData.getNumberOfFields(); i++) {
+        const LdDecodeMetaData::Field field = metaData.getField(i);
+        total += field.audioSamples;
+        total += field.isFirstField ? 1 : 0;
+        total += field.vbi.vbiData[1];
+        for (qint32 j = 0; j < field.dropOuts.size(); j++) {
+            total += field.dropOuts.startx(j);
+        }
+    }
+
+    return total;
+}
+
+// Check that metadata matches what generateMetaData produced
+void assertSameMetaData(const LdDecodeMetaData &actual, const LdDecodeMetaData &expected, qint32 numFields)
+{
+    assert(actual.getNumberOfFields() == numFields);
+    assert(actual.getVideoParameters().numberOfSequentialFields == numFields);
+    assert(actual.getVideoParameters().fieldWidth == 1135);
+    assert(actual.getVideoParameters().gitCommit == "0123abc");
+    assert(actual.getPcmAudioParameters().sampleRate == 44100);
+    for (qint32 i = 1; i <= numFields; i++) {
+        assertSame(actual.getField(i), expected.getField(i));
+    }
+}
+
+// Test writing and reading back metadata, and compare the speed of the
+// binary sidecar and streaming reader with the old JsonWax approach
+void testMetaData(qint32 numFields)
+{
+    cerr << "Testing LdDecodeMetaData with " << numFields << " fields\n";
+
+    QTemporaryDir tempDir;
+    assert(tempDir.isValid());
+    const QString firstFileName = tempDir.filePath("first.tbc.json");
+    const QString secondFileName = tempDir.filePath("second.tbc.json");
+
+    // Generate and write the metadata
+    LdDecodeMetaData original;
+    generateMetaData(original, numFields);
+    bool ok = original.write(firstFileName);
+    assert(ok);
+    assert(QFile::exists(tempDir.filePath("first.tbc.bin")));
+
+    // Read it back using the binary sidecar. The sidecar is decoded on
+    // demand, so include a pass over the fields in the time.
+    QElapsedTimer timer;
+    timer.start();
+    LdDecodeMetaData binaryMetaData;
+    ok = binaryMetaData.read(firstFileName);
+    assert(ok);
+    const qint64 binaryTotal = sumFields(binaryMetaData);
+    const qint64 binaryTime = timer.elapsed();
+    assertSameMetaData(binaryMetaData, original, numFields);
+
+    // Read it back from the JSON
+    ok = QFile::remove(tempDir.filePath("first.tbc.bin"));
+    assert(ok);
+    timer.restart();
+    LdDecodeMetaData metaData;
+    ok = metaData.read(firstFileName);
+    assert(ok);
+    const qint64 streamingTotal = sumFields(metaData);
+    const qint64 streamingTime = timer.elapsed();
+    assertSameMetaData(metaData, original, numFields);
+
+    // Writing it again should produce an identical file
+    ok = metaData.write(secondFileName);
+    assert(ok);
+    assert(readFile(firstFileName) == readFile(secondFileName));
+
+    // Time the old approach, and check it sees the same values
+    timer.restart();
+    const qint64 jsonWaxTotal = loadWithJsonWax(firstFileName);
+    const qint64 jsonWaxTime = timer.elapsed();
+
+    assert(binaryTotal == jsonWaxTotal);
+    assert(streamingTotal == jsonWaxTotal);
+
+    cerr << "Binary sidecar: " << binaryTime << " ms, streaming reader: " << streamingTime
+         << " ms, JsonWax: " << jsonWaxTime << " ms\n";
+}
+
+// Test the per-member field accessors and update methods, and compare the
+// speed of reading single members with building a whole Field
+void testFieldAccessors(qint32 numFields)
+{
+    cerr << "Testing field accessors with " << numFields << " fields\n";
+
+    LdDecodeMetaData metaData;
+    generateMetaData(metaData, numFields);
+    const LdDecodeMetaData &constMetaData = metaData;
+
+    // The accessors agree with getField
+    for (qint32 i = 1; i <= numFields; i++) {
+        const LdDecodeMetaData::Field field = constMetaData.getField(i);
+        assert(field.seqNo == i);
+        assert(constMetaData.getFieldIsFirstField(i) == field.isFirstField);
+        assert(constMetaData.getFieldPhaseID(i) == field.fieldPhaseID);
+        assert(constMetaData.getFieldPad(i) == field.pad);
+        assert(constMetaData.getFieldVitsMetrics(i).bPSNR == field.vitsMetrics.bPSNR);
+        assert(constMetaData.getFieldVbi(i).vbiData == field.vbi.vbiData);
+        assert(constMetaData.getFieldDropOuts(i).size() == field.dropOuts.size());
+    }
+
+    // Out-of-range fields return defaults
+    assert(!constMetaData.getFieldIsFirstField(numFields + 1));
+    assert(constMetaData.getFieldDropOuts(0).empty());
+
+    // Updating one member of a field leaves the others alone
+    LdDecodeMetaData::Ntsc ntsc;
+    ntsc.inUse = true;
+    ntsc.whiteFlag = true;
+    ntsc.ccData0 = 42;
+    metaData.updateFieldNtsc(ntsc, 3);
+    LdDecodeMetaData::Vbi vbi;
+    vbi.inUse = true;
+    vbi.vbiData = {1, 2};
+    metaData.updateFieldVbi(vbi, 3);
+    metaData.clearFieldDropOuts(4);
+
+    LdDecodeMetaData::Field field = metaData.getField(3);
+    assert(field.ntsc.inUse && field.ntsc.whiteFlag && !field.ntsc.fieldFlag);
+    assert(field.ntsc.ccData0 == 42 && field.ntsc.fmCodeData == -1);
+    assert(field.vbi.vbiData == QVector<qint32>({-1, -1, -1}));
+    assert(field.isFirstField && field.fieldPhaseID == 3);
+    assert(metaData.getFieldDropOuts(3).size() == 2);
+    assert(metaData.getFieldDropOuts(4).empty());
+
+    // Buffered updates change nothing until they're applied, and later
+    // buffers override earlier ones
+    QVector<LdDecodeMetaData::FieldUpdates> threadUpdates(2);
+    LdDecodeMetaData::VitsMetrics vitsMetrics;
+    vitsMetrics.inUse = true;
+    vitsMetrics.bPSNR = 12.5;
+    threadUpdates[0].updateFieldVitsMetrics(vitsMetrics, 5);
+    threadUpdates[0].updateFieldDropOuts(DropOuts({10}, {20}, {30}), 6);
+    threadUpdates[1].updateFieldDropOuts(DropOuts({11, 12}, {21, 22}, {31, 32}), 6);
+    assert(threadUpdates[0].size() == 2);
+    assert(metaData.getFieldVitsMetrics(5).bPSNR != 12.5);
+
+    for (const auto &updates : threadUpdates) metaData.applyFieldUpdates(updates);
+    assert(metaData.getFieldVitsMetrics(5).inUse && metaData.getFieldVitsMetrics(5).bPSNR == 12.5);
+    assert(metaData.getFieldDropOuts(6).size() == 2);
+    assert(metaData.getFieldDropOuts(6).startx(1) == 12);
+
+    threadUpdates[0].clear();
+    assert(threadUpdates[0].size() == 0);
+
+    // Time reading members through getField and through the accessors
+    const qint32 numFrames = constMetaData.getNumberOfFrames();
+    QElapsedTimer timer;
+    qint64 fieldTotal = 0;
+    timer.start();
+    for (qint32 frame = 1; frame <= numFrames; frame++) {
+        const qint32 firstField = constMetaData.getFirstFieldNumber(frame);
+        fieldTotal += constMetaData.getField(firstField).fieldPhaseID;
+        fieldTotal += constMetaData.getField(firstField).dropOuts.size();
+    }
+    const qint64 fieldTime = timer.nsecsElapsed();
+
+    qint64 accessorTotal = 0;
+    timer.restart();
+    for (qint32 frame = 1; frame <= numFrames; frame++) {
+        const qint32 firstField = constMetaData.getFirstFieldNumber(frame);
+        accessorTotal += constMetaData.getFieldPhaseID(firstField);
+        accessorTotal += constMetaData.getFieldDropOuts(firstField).size();
+    }
+    const qint64 accessorTime = timer.nsecsElapsed();
+    assert(accessorTotal == fieldTotal);
+
+    cerr << "getField: " << (fieldTime / qMax(numFrames, 1)) << " ns/frame, accessors: "
+         << (accessorTime / qMax(numFrames, 1)) << " ns/frame\n";
+}
+
+// Metadata as written by ld-decode with --verbose-vits, including members
+// that LdDecodeMetaData doesn't know about, fractional diskLocs, and fileLocs
+// beyond 2^31. The members are in the order LdDecodeMetaData writes them
+// (known members first, then unknown ones), so rewriting this should
+// reproduce it exactly.
+static const char verboseJson[] =
+    "{\"pcmAudioParameters\":{\"sampleRate\":44100,\"isLittleEndian\":true,\"isSigned\":true,\"bits\":16},"
+    "\"videoParameters\":{\"numberOfSequentialFields\":2,\"isSourcePal\":false,\"isSubcarrierLocked\":false,"
+    "\"isWidescreen\":false,\"colourBurstStart\":74,\"colourBurstEnd\":106,\"activeVideoStart\":134,"
+    "\"activeVideoEnd\":894,\"white16bIre\":51200,\"black16bIre\":15360,\"fieldWidth\":910,\"fieldHeight\":263,"
+    "\"sampleRate\":14318181,\"fsc\":3579545,\"isMapped\":false,\"gitBranch\":\"main\",\"gitCommit\":\"1234abc\","
+    "\"system\":\"NTSC\"},"
+    "\"fields\":["
+    "{\"seqNo\":1,\"isFirstField\":true,\"syncConf\":100,\"medianBurstIRE\":19.8,\"fieldPhaseID\":1,"
+    "\"audioSamples\":0,\"diskLoc\":12.3,\"fileLoc\":3000000000,\"decodeFaults\":0,\"efmTValues\":0,"
+    "\"vitsMetrics\":{\"wSNR\":43.5,\"bPSNR\":41.25,\"ntscWhiteFlagSNR\":32.1,\"whiteIRE\":100.2,"
+    "\"whiteRFLevel\":-0.5,\"greyPSNR\":44.8,\"greyIRE\":49.9,\"blackLineRFLevel\":0.25,"
+    "\"blackLinePreTBCIRE\":7.4},"
+    "\"vbi\":{\"vbiData\":[0,8892416,8892416]},"
+    "\"ntsc\":{\"isFmCodeDataValid\":false,\"fmCodeData\":-1,\"fieldFlag\":false,\"whiteFlag\":false,"
+    "\"ccData0\":-1,\"ccData1\":-1,\"isVideoIdDataValid\":true,\"videoIdData\":1234},"
+    "\"dropOuts\":{\"startx\":[100],\"endx\":[120],\"fieldLine\":[30],\"severity\":[2]},"
+    "\"pad\":false,\"cavFrameNr\":1,\"notes\":[\"a \\\"quoted\\\" string\",{\"nested\":null}]},"
+    "{\"seqNo\":2,\"isFirstField\":false,\"syncConf\":100,\"medianBurstIRE\":19.9,\"fieldPhaseID\":2,"
+    "\"audioSamples\":0,\"diskLoc\":12.8,\"fileLoc\":3000477640,\"decodeFaults\":0,\"efmTValues\":0,"
+    "\"vitsMetrics\":{\"wSNR\":43.25,\"bPSNR\":41,\"greyPSNR\":45.1,\"greyIRE\":50.1},"
+    "\"pad\":false,\"clvMinutes\":5,\"clvSeconds\":12,\"clvFrameNr\":3}"
+    "],"
+    "\"extraData\":{\"tool\":\"test\"}}";
+
+// Test that members LdDecodeMetaData doesn't know about survive being read
+// and written, through both the JSON and the binary sidecar
+void testUnknownMembers()
+{
+    cerr << "Testing round trip of ld-decode's verbose output\n";
+
+    QTemporaryDir tempDir;
+    assert(tempDir.isValid());
+    const QString inputFileName = tempDir.filePath("input.tbc.json");
+    const QString outputFileName = tempDir.filePath("output.tbc.json");
+    const QByteArray expected(verboseJson);
+
+    QFile inputFile(inputFileName);
+    bool ok = inputFile.open(QIODevice::WriteOnly);
+    assert(ok);
+    const qint64 written = inputFile.write(expected);
+    assert(written == expected.size());
+    inputFile.close();
+
+    // Read the JSON and write it out again
+    LdDecodeMetaData metaData;
+    ok = metaData.read(inputFileName);
+    assert(ok);
+    assert(metaData.getField(1).diskLoc == 12.3);
+    assert(metaData.getField(1).fileLoc == Q_INT64_C(3000000000));
+    assert(metaData.getField(2).fileLoc == Q_INT64_C(3000477640));
+    assert(metaData.getFieldVitsMetrics(2).unknownMembers == "\"greyPSNR\":45.1,\"greyIRE\":50.1");
+    assert(metaData.getField(1).dropOutsUnknownMembers == "\"severity\":[2]");
+    ok = metaData.write(outputFileName);
+    assert(ok);
+    assert(readFile(outputFileName) == expected);
+
+    // Read that back through the binary sidecar, then update one field's VITS
+    // metrics as ld-process-vits does, and replace another field with a Field
+    // that has no unknown members. The unknown members should be kept.
+    LdDecodeMetaData binaryMetaData;
+    ok = binaryMetaData.read(outputFileName);
+    assert(ok);
+    assert(binaryMetaData.getField(2).diskLoc == 12.8);
+
+    LdDecodeMetaData::VitsMetrics vitsMetrics;
+    vitsMetrics.inUse = true;
+    vitsMetrics.wSNR = 43.5;
+    vitsMetrics.bPSNR = 41.25;
+    binaryMetaData.updateFieldVitsMetrics(vitsMetrics, 1);
+    LdDecodeMetaData::Field field = binaryMetaData.getField(2);
+    field.unknownMembers.clear();
+    binaryMetaData.updateField(field, 2);
+
+    ok = binaryMetaData.write(outputFileName);
+    assert(ok);
+    assert(readFile(outputFileName) == expected);
+
+    // vbiData can only hold three lines, so more than that should be an error
+    // rather than being dropped
+    QByteArray longVbi = expected;
+    longVbi.replace("[0,8892416,8892416]", "[0,8892416,8892416,1]");
+    ok = inputFile.open(QIODevice::WriteOnly);
+    assert(ok);
+    const qint64 longWritten = inputFile.write(longVbi);
+    assert(longWritten == longVbi.size());
+    inputFile.close();
+    LdDecodeMetaData longVbiMetaData;
+    ok = longVbiMetaData.read(inputFileName);
+    assert(!ok);
+}
+
+// Test that a binary sidecar that doesn't match its JSON file is ignored
+void testStaleSidecar()
+{
+    cerr << "Testing stale binary sidecar\n";
+
+    QTemporaryDir tempDir;
+    assert(tempDir.isValid());
+    const QString jsonFileName = tempDir.filePath("test.tbc.json");
+    const QString binaryFileName = tempDir.filePath("test.tbc.bin");
+    const QString savedFileName = tempDir.filePath("saved.bin");
+
+    // Write some metadata, and keep a copy of its sidecar
+    LdDecodeMetaData first;
+    generateMetaData(first, 10);
+    bool ok = first.write(jsonFileName);
+    assert(ok);
+    ok = QFile::copy(binaryFileName, savedFileName);
+    assert(ok);
+
+    // Replace it with different metadata, then put the old sidecar back
+    LdDecodeMetaData second;
+    generateMetaData(second, 8);
+    ok = second.write(jsonFileName);
+    assert(ok);
+    ok = QFile::remove(binaryFileName) && QFile::rename(savedFileName, binaryFileName);
+    assert(ok);
+
+    // The old sidecar should be ignored
+    LdDecodeMetaData metaData;
+    ok = metaData.read(jsonFileName);
+    assert(ok);
+    assertSameMetaData(metaData, second, 8);
+}
+
+// Write a journal, cut it off part-way through a record as an interrupted
+// run would, and check that resuming recovers the complete records
+void testJournal()
+{
+    cerr << "Testing metadata journal\n";
+
+    QTemporaryDir tempDir;
+    assert(tempDir.isValid());
+    const QString journalFileName = MetadataJournal::getJournalFileName(tempDir.filePath("test.tbc.json"));
+    assert(journalFileName == tempDir.filePath("test.tbc.journal"));
+
+    MetadataJournal journal;
+    auto writeField = [&](qint32 fieldNumber) {
+        LdDecodeMetaData::FieldUpdates fieldUpdates;
+        LdDecodeMetaData::VitsMetrics vitsMetrics;
+        vitsMetrics.inUse = true;
+        vitsMetrics.wSNR = 40.0 + fieldNumber;
+        vitsMetrics.bPSNR = 30.5;
+        fieldUpdates.updateFieldVitsMetrics(vitsMetrics, fieldNumber);
+        fieldUpdates.updateFieldDropOuts(DropOuts({fieldNumber}, {fieldNumber + 10}, {20}), fieldNumber);
+        journal.write(fieldUpdates);
+    };
+
+    // Start a new journal with three fields
+    LdDecodeMetaData::FieldUpdates updates;
+    bool ok = journal.open(journalFileName, false, updates);
+    assert(ok);
+    assert(updates.size() == 0);
+    for (qint32 fieldNumber = 1; fieldNumber <= 3; fieldNumber++) writeField(fieldNumber);
+    journal.close();
+
+    // Cut the last record short
+    QFile journalFile(journalFileName);
+    ok = journalFile.resize(journalFile.size() - 10);
+    assert(ok);
+
+    // Resuming returns the complete records, and appends after them
+    ok = journal.open(journalFileName, true, updates);
+    assert(ok);
+    assert(updates.getFieldNumbers() == QVector<qint32>({1, 2}));
+    writeField(3);
+    journal.close();
+
+    ok = journal.open(journalFileName, true, updates);
+    assert(ok);
+    assert(updates.getFieldNumbers() == QVector<qint32>({1, 2, 3}));
+    journal.close();
+
+    LdDecodeMetaData metaData;
+    generateMetaData(metaData, 5);
+    metaData.applyFieldUpdates(updates);
+    assert(metaData.getFieldVitsMetrics(3).wSNR == 43.0);
+    assert(metaData.getFieldVitsMetrics(3).bPSNR == 30.5);
+    assert(metaData.getFieldDropOuts(2).size() == 1);
+    assert(metaData.getFieldDropOuts(2).endx(0) == 12);
+
+    // Not resuming replaces the journal, and removing it deletes the file
+    ok = journal.open(journalFileName, false, updates);
+    assert(ok);
+    assert(updates.size() == 0);
+    journal.remove();
+    assert(!QFile::exists(journalFileName));
+}
+
+int main(int argc, char *argv[])
+{
+    // The number of fields to generate can be given on the command line;
+    // the default is about the size of a full CAV side
+    qint32 numFields = 200000;
+    if (argc > 1) numFields = atoi(argv[1]);
+
+    testReader();
+    testWriter();
+    testMetaData(numFields);
+    testFieldAccessors(numFields);
+    testUnknownMembers();
+    testStaleSidecar();
+    testJournal();
+
+    return 0;
+}
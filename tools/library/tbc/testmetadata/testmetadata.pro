@@ -0,0 +1,24 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testmetadata.cpp \
+    ../dropouts.cpp \
+    ../jsonio.cpp \
+    ../lddecodemetadata.cpp \
+    ../metadatajournal.cpp \
+    ../vbidecoder.cpp
+
+HEADERS += \
+    ../dropouts.h \
+    ../jsonio.h \
+    ../lddecodemetadata.h \
+    ../metadatajournal.h \
+    ../vbidecoder.h \
+    ../../JsonWax/JsonWax.h
+
+INCLUDEPATH += \
+    .. \
+    ../../JsonWax
+
+target.CONFIG += no_default_install
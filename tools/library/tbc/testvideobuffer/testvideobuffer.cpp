@@ -0,0 +1,326 @@
+/************************************************************************
+
+    testvideobuffer.cpp
+
+    Unit tests for VideoBuffer
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QVector>
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <utility>
+
+using std::cerr;
+
+#include "videobuffer.h"
+#include "videobufferpool.h"
+
+// Check that buffer contains the samples in expected
+void checkContents(const VideoBuffer &buffer, const QVector<quint16> &expected)
+{
+    assert(buffer.size() == expected.size());
+    assert(buffer.isEmpty() == expected.isEmpty());
+    for (qint32 i = 0; i < expected.size(); i++) {
+        assert(buffer[i] == expected[i]);
+        assert(buffer.at(i) == expected[i]);
+        assert(buffer.constData()[i] == expected[i]);
+    }
+}
+
+// Construction, and the QVector-like modifiers
+void testConstruct()
+{
+    cerr << "Testing construction and modifiers\n";
+
+    const VideoBuffer empty;
+    assert(empty.isEmpty());
+    assert(empty.constData() == nullptr);
+    assert(empty.begin() == empty.end());
+
+    // New samples are zero
+    VideoBuffer buffer(4);
+    checkContents(buffer, {0, 0, 0, 0});
+
+    const VideoBuffer filled(3, 7);
+    checkContents(filled, {7, 7, 7});
+
+    const quint16 samples[] = {1, 2, 3, 4, 5};
+    buffer = VideoBuffer(samples, 5);
+    checkContents(buffer, {1, 2, 3, 4, 5});
+
+    buffer.resize(7);
+    checkContents(buffer, {1, 2, 3, 4, 5, 0, 0});
+    buffer.resize(3);
+    checkContents(buffer, {1, 2, 3});
+    buffer.resize(5);
+    checkContents(buffer, {1, 2, 3, 0, 0});
+
+    buffer.append(9);
+    checkContents(buffer, {1, 2, 3, 0, 0, 9});
+    buffer.remove(0, 2);
+    checkContents(buffer, {3, 0, 0, 9});
+    buffer.remove(2, 2);
+    checkContents(buffer, {3, 0});
+
+    buffer.fill(6);
+    checkContents(buffer, {6, 6});
+    buffer.fill(5, 3);
+    checkContents(buffer, {5, 5, 5});
+
+    buffer[1] = 4;
+    checkContents(buffer, {5, 4, 5});
+    assert(buffer != VideoBuffer(3, 5));
+
+    checkContents(VideoBuffer(samples, 5).mid(1, 3), {2, 3, 4});
+    checkContents(VideoBuffer(samples, 5).mid(3), {4, 5});
+    checkContents(VideoBuffer(samples, 5).mid(3, 10), {4, 5});
+    checkContents(VideoBuffer(samples, 5).mid(5), {});
+
+    buffer.clear();
+    assert(buffer.isEmpty());
+
+    // Appending to an empty buffer
+    for (quint16 i = 0; i < 100; i++) buffer.append(i);
+    assert(buffer.size() == 100);
+    for (qint32 i = 0; i < 100; i++) assert(buffer[i] == i);
+}
+
+// Copies share samples, and writes copy them only when they're shared
+void testSharing()
+{
+    cerr << "Testing sharing\n";
+
+    const quint16 samples[] = {1, 2, 3, 4};
+    VideoBuffer a(samples, 4);
+    assert(!a.isShared());
+
+    // Copying shares the samples
+    qint64 bytesCopied = VideoBuffer::getBytesCopied();
+    VideoBuffer b = a;
+    assert(a.isShared() && b.isShared());
+    assert(a.constData() == b.constData());
+    assert(a == b);
+
+    // Reading through a const reference doesn't copy
+    const VideoBuffer &constB = b;
+    assert(constB[2] == 3);
+    assert(constB.data() == a.constData());
+    assert(VideoBuffer::getBytesCopied() == bytesCopied);
+
+    // Writing to a shared buffer copies it, leaving the other unchanged
+    b[0] = 10;
+    assert(a.constData() != b.constData());
+    assert(!a.isShared() && !b.isShared());
+    checkContents(a, {1, 2, 3, 4});
+    checkContents(b, {10, 2, 3, 4});
+    assert(VideoBuffer::getBytesCopied() == bytesCopied + 4 * 2);
+
+    // Writing to an unshared buffer doesn't copy it
+    bytesCopied = VideoBuffer::getBytesCopied();
+    const quint16 *bData = b.constData();
+    b[1] = 11;
+    b.resize(3);
+    b.remove(0, 1);
+    assert(b.constData() == bData);
+    checkContents(b, {11, 3});
+    assert(VideoBuffer::getBytesCopied() == bytesCopied);
+
+    // Filling a shared buffer replaces its samples without copying them
+    VideoBuffer c = a;
+    c.fill(5);
+    checkContents(a, {1, 2, 3, 4});
+    checkContents(c, {5, 5, 5, 5});
+    assert(VideoBuffer::getBytesCopied() == bytesCopied);
+
+    // Resizing a shared buffer only copies the samples that are kept
+    VideoBuffer d = a;
+    d.resize(2);
+    checkContents(a, {1, 2, 3, 4});
+    checkContents(d, {1, 2});
+    assert(VideoBuffer::getBytesCopied() == bytesCopied + 2 * 2);
+
+    // The samples outlive the buffer they were created in
+    VideoBuffer e;
+    {
+        VideoBuffer f(3, 8);
+        e = f;
+    }
+    assert(!e.isShared());
+    checkContents(e, {8, 8, 8});
+
+    // Self-assignment
+    const VideoBuffer &eRef = e;
+    e = eRef;
+    checkContents(e, {8, 8, 8});
+}
+
+// Moving transfers samples without sharing or copying them
+void testMoving()
+{
+    cerr << "Testing moving\n";
+
+    const qint64 bytesCopied = VideoBuffer::getBytesCopied();
+
+    VideoBuffer a(1000, 1);
+    const quint16 *aData = a.constData();
+
+    VideoBuffer b = std::move(a);
+    assert(a.isEmpty());
+    assert(b.constData() == aData);
+    assert(!b.isShared());
+
+    VideoBuffer c;
+    c = std::move(b);
+    assert(b.isEmpty());
+    assert(c.constData() == aData);
+
+    // Hand a buffer through a queue, as the worker pools do
+    QVector<VideoBuffer> queue(4);
+    queue[2] = std::move(c);
+    VideoBuffer d = std::move(queue[2]);
+    assert(queue[2].isEmpty());
+    assert(d.constData() == aData);
+    d[0] = 2;
+    assert(d.constData() == aData);
+
+    // Buffers in a QVector are shared when the QVector is copied
+    queue[0] = d;
+    QVector<VideoBuffer> queueCopy = queue;
+    assert(queueCopy.at(0).constData() == aData);
+
+    assert(VideoBuffer::getBytesCopied() == bytesCopied);
+}
+
+// External samples are used without copying, and kept alive by the buffers
+void testExternal()
+{
+    cerr << "Testing external samples\n";
+
+    const qint64 bytesCopied = VideoBuffer::getBytesCopied();
+
+    const std::shared_ptr<QVector<quint16>> owner = std::make_shared<QVector<quint16>>(QVector<quint16>({1, 2, 3, 4}));
+    const quint16 *samples = owner->constData();
+
+    VideoBuffer a = VideoBuffer::fromExternal(samples, 4, owner);
+    assert(owner.use_count() == 2);
+
+    // Reading and sharing don't copy the samples
+    assert(a.constData() == samples);
+    checkContents(a, {1, 2, 3, 4});
+    VideoBuffer b = a;
+    const VideoBuffer &constB = b;
+    assert(constB.data() == samples);
+    assert(VideoBuffer::getBytesCopied() == bytesCopied);
+
+    // External samples are never written to, even if only one buffer refers
+    // to them
+    a = VideoBuffer();
+    assert(b.isShared());
+    b[0] = 10;
+    assert(b.constData() != samples);
+    assert(!b.isShared());
+    checkContents(b, {10, 2, 3, 4});
+    assert(samples[0] == 1);
+    assert(VideoBuffer::getBytesCopied() == bytesCopied + 4 * 2);
+
+    // The owner is released along with the last buffer
+    assert(owner.use_count() == 1);
+
+    // Replacing external samples doesn't copy them
+    VideoBuffer c = VideoBuffer::fromExternal(samples, 4, std::make_shared<int>(0));
+    c.fill(5);
+    checkContents(c, {5, 5, 5, 5});
+    assert(VideoBuffer::getBytesCopied() == bytesCopied + 4 * 2);
+}
+
+// Size classes, alignment, and reuse of blocks by the pool
+void testPool()
+{
+    cerr << "Testing pool\n";
+
+    // Block sizes are aligned, and waste at most 1/8 of the block
+    for (size_t size = 1; size < 20 * 1024 * 1024; size += 1 + (size / 7)) {
+        const size_t blockSize = VideoBufferPool::getBlockSize(size);
+        assert(blockSize >= size);
+        assert((blockSize % VideoBufferPool::ALIGNMENT) == 0);
+        assert(size <= 8 * VideoBufferPool::ALIGNMENT || (blockSize - size) <= (blockSize / 8));
+    }
+
+    // Sizes in the same class share blocks
+    assert(VideoBufferPool::getBlockSize(1000) == VideoBufferPool::getBlockSize(1020));
+
+    // Samples are aligned, and the capacity includes the rest of the block
+    for (qint32 size : {1, 100, 1000, 355255, 5000000}) {
+        VideoBuffer buffer(size);
+        assert((reinterpret_cast<uintptr_t>(buffer.constData()) % VideoBufferPool::ALIGNMENT) == 0);
+
+        const quint16 *data = buffer.constData();
+        buffer.resize(static_cast<qint32>(VideoBufferPool::getBlockSize(64 + (size * 2)) - 64) / 2);
+        assert(buffer.constData() == data);
+    }
+
+    // In a steady state of allocating and freeing field-sized buffers (here,
+    // a PAL field, and an output frame too large for an arena), nothing new
+    // is allocated after the first round
+    const qint32 fieldSize = 1135 * 313;
+    const qint32 frameSize = 928 * 576 * 3;
+    QVector<VideoBuffer> buffers(10);
+    for (auto &buffer: buffers) buffer = VideoBuffer(fieldSize);
+    buffers.append(VideoBuffer(frameSize));
+    buffers.clear();
+
+    const VideoBufferPool::Statistics before = VideoBufferPool::getStatistics();
+    for (qint32 round = 0; round < 100; round++) {
+        for (qint32 i = 0; i < 10; i++) buffers.append(VideoBuffer(fieldSize));
+        buffers.append(VideoBuffer(frameSize));
+        buffers.clear();
+    }
+    const VideoBufferPool::Statistics after = VideoBufferPool::getStatistics();
+
+    assert(after.allocations == before.allocations);
+    assert(after.reuses == before.reuses + (100 * 11));
+    assert(after.releases == before.releases + (100 * 11));
+    assert(after.bytesReserved == before.bytesReserved);
+    assert(after.bytesFree == before.bytesFree);
+    cerr << "Pool has " << after.bytesReserved << " bytes reserved, " << after.bytesFree << " free\n";
+
+    // Huge pages only change how new memory is allocated
+    VideoBufferPool::setHugePages(true);
+    {
+        VideoBuffer buffer(frameSize);
+        assert((reinterpret_cast<uintptr_t>(buffer.constData()) % VideoBufferPool::ALIGNMENT) == 0);
+        buffer[frameSize - 1] = 1;
+    }
+    VideoBufferPool::setHugePages(false);
+}
+
+int main()
+{
+    testConstruct();
+    testSharing();
+    testMoving();
+    testExternal();
+    testPool();
+
+    return 0;
+}
@@ -0,0 +1,16 @@
+CONFIG += c++11 testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    testvideobuffer.cpp \
+    ../videobuffer.cpp \
+    ../videobufferpool.cpp
+
+HEADERS += \
+    ../videobuffer.h \
+    ../videobufferpool.h
+
+INCLUDEPATH += \
+    ..
+
+target.CONFIG += no_default_install
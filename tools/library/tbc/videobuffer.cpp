@@ -0,0 +1,255 @@
+/************************************************************************
+
+    videobuffer.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "videobuffer.h"
+
+#include "videobufferpool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+// Bytes copied by detachShared
+static std::atomic<qint64> bytesCopied(0);
+
+VideoBuffer::VideoBuffer(qint32 size)
+    : d(nullptr)
+{
+    if (size <= 0) return;
+
+    // Like QVector, new samples are zero
+    d = allocate(size);
+    d->size = size;
+    memset(d->samples(), 0, static_cast<size_t>(size) * sizeof(quint16));
+}
+
+VideoBuffer::VideoBuffer(qint32 size, quint16 value)
+    : d(nullptr)
+{
+    fill(value, size);
+}
+
+// Copy size samples into a new buffer
+VideoBuffer::VideoBuffer(const quint16 *samples, qint32 size)
+    : d(nullptr)
+{
+    if (size <= 0) return;
+
+    d = allocate(size);
+    d->size = size;
+    std::copy(samples, samples + size, d->samples());
+}
+
+VideoBuffer VideoBuffer::fromExternal(const quint16 *samples, qint32 size, std::shared_ptr<const void> owner)
+{
+    VideoBuffer buffer;
+    if (size <= 0) return buffer;
+
+    size_t blockSize;
+    void *memory = VideoBufferPool::allocate(sizeof(Header), blockSize);
+
+    // The samples are never written through sampleData, because isShared is
+    // always true for an external buffer
+    Header *header = new (memory) Header;
+    header->ref.store(1, std::memory_order_relaxed);
+    header->size = size;
+    header->capacity = size;
+    header->sampleData = const_cast<quint16 *>(samples);
+    header->owner = std::move(owner);
+
+    buffer.d = header;
+    return buffer;
+}
+
+VideoBuffer &VideoBuffer::operator=(const VideoBuffer &other)
+{
+    if (other.d != d) {
+        if (other.d != nullptr) other.d->ref.fetch_add(1, std::memory_order_relaxed);
+        release();
+        d = other.d;
+    }
+
+    return *this;
+}
+
+VideoBuffer &VideoBuffer::operator=(VideoBuffer &&other) noexcept
+{
+    if (&other != this) {
+        release();
+        d = other.d;
+        other.d = nullptr;
+    }
+
+    return *this;
+}
+
+// Resize the buffer, keeping the existing samples; new samples are zero
+void VideoBuffer::resize(qint32 newSize)
+{
+    newSize = std::max(newSize, 0);
+    const qint32 oldSize = size();
+    if (newSize == oldSize) return;
+
+    if (newSize == 0) {
+        // Keep an unshared buffer's allocation for reuse, like QVector
+        if (isShared()) release();
+        else if (d != nullptr) d->size = 0;
+        return;
+    }
+
+    if (d == nullptr || isShared() || newSize > d->capacity) {
+        reallocate(newSize, std::min(oldSize, newSize));
+    }
+    if (newSize > oldSize) {
+        memset(d->samples() + oldSize, 0, static_cast<size_t>(newSize - oldSize) * sizeof(quint16));
+    }
+    d->size = newSize;
+}
+
+// Set every sample to value, resizing the buffer first if size isn't -1.
+// The existing samples are all overwritten, so a shared buffer is replaced
+// with a new one rather than being copied.
+void VideoBuffer::fill(quint16 value, qint32 newSize)
+{
+    if (newSize == -1) newSize = size();
+    newSize = std::max(newSize, 0);
+
+    if (d == nullptr || isShared() || newSize > d->capacity) {
+        release();
+        if (newSize == 0) return;
+        d = allocate(newSize);
+    }
+
+    d->size = newSize;
+    std::fill(d->samples(), d->samples() + newSize, value);
+}
+
+// Add a sample to the end of the buffer
+void VideoBuffer::append(quint16 value)
+{
+    const qint32 oldSize = size();
+    if (d == nullptr || isShared() || oldSize == d->capacity) {
+        // Grow geometrically, so repeated appends are amortised
+        reallocate(std::max(oldSize + 1, (oldSize * 3) / 2), oldSize);
+    }
+
+    d->samples()[oldSize] = value;
+    d->size = oldSize + 1;
+}
+
+// Remove count samples starting from position
+void VideoBuffer::remove(qint32 position, qint32 count)
+{
+    if (count <= 0) return;
+    Q_ASSERT(position >= 0 && position + count <= size());
+
+    quint16 *samples = data();
+    std::copy(samples + position + count, samples + d->size, samples + position);
+    d->size -= count;
+}
+
+// Return a new buffer containing a copy of length samples starting from
+// position. If length is -1, or extends past the end of the buffer, copy to
+// the end of the buffer.
+VideoBuffer VideoBuffer::mid(qint32 position, qint32 length) const
+{
+    const qint32 bufferSize = size();
+    if (position < 0 || position >= bufferSize) return VideoBuffer();
+    if (length < 0 || length > bufferSize - position) length = bufferSize - position;
+
+    return VideoBuffer(constData() + position, length);
+}
+
+bool VideoBuffer::operator==(const VideoBuffer &other) const
+{
+    if (d == other.d) return true;
+    if (size() != other.size()) return false;
+
+    return std::equal(begin(), end(), other.begin());
+}
+
+qint64 VideoBuffer::getBytesCopied()
+{
+    return bytesCopied.load(std::memory_order_relaxed);
+}
+
+// Private methods ----------------------------------------------------------------------------------------------------
+
+// Allocate a new unshared buffer with space for at least capacity samples
+// (and size 0). The capacity includes any spare space in the pool's block.
+VideoBuffer::Header *VideoBuffer::allocate(qint32 capacity)
+{
+    static_assert(sizeof(Header) % VideoBufferPool::ALIGNMENT == 0, "Header must preserve the samples' alignment");
+
+    size_t blockSize;
+    void *memory = VideoBufferPool::allocate(sizeof(Header) + (static_cast<size_t>(capacity) * sizeof(quint16)), blockSize);
+
+    Header *header = new (memory) Header;
+    header->ref.store(1, std::memory_order_relaxed);
+    header->size = 0;
+    header->capacity = static_cast<qint32>((blockSize - sizeof(Header)) / sizeof(quint16));
+    header->sampleData = reinterpret_cast<quint16 *>(header + 1);
+
+    return header;
+}
+
+// Drop this buffer's reference to its samples, freeing them if it was the
+// last one
+void VideoBuffer::release()
+{
+    if (d == nullptr) return;
+
+    if (d->ref.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        const size_t blockSize = d->owner != nullptr ? VideoBufferPool::getBlockSize(sizeof(Header))
+                                                     : sizeof(Header) + (static_cast<size_t>(d->capacity) * sizeof(quint16));
+        d->~Header();
+        VideoBufferPool::release(d, blockSize);
+    }
+    d = nullptr;
+}
+
+// Give this buffer a private copy of its shared samples
+void VideoBuffer::detachShared()
+{
+    reallocate(d->capacity, d->size);
+}
+
+// Move the samples to a new unshared allocation with the given capacity,
+// keeping the first keepSize samples
+void VideoBuffer::reallocate(qint32 capacity, qint32 keepSize)
+{
+    Header *newD = allocate(capacity);
+    newD->size = keepSize;
+
+    if (keepSize != 0) {
+        std::copy(d->samples(), d->samples() + keepSize, newD->samples());
+
+        // Copying out of a shared buffer is the copy we're trying to avoid;
+        // copying out of an unshared one is just growing it
+        if (isShared()) bytesCopied.fetch_add(static_cast<qint64>(keepSize) * sizeof(quint16), std::memory_order_relaxed);
+    }
+
+    release();
+    d = newD;
+}
@@ -0,0 +1,155 @@
+/************************************************************************
+
+    videobuffer.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef VIDEOBUFFER_H
+#define VIDEOBUFFER_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <memory>
+
+// A reference-counted buffer of 16-bit video samples, used to pass fields
+// (and frames) between threads without copying them.
+//
+// Copying a VideoBuffer just shares the samples with the original, and
+// moving one transfers them, leaving the original empty. A buffer's samples
+// are never modified while they're shared: writing to a shared buffer
+// through any non-const method first gives it a private copy of the samples
+// (like a QVector, which this replaces, and which it mimics the interface of).
+//
+// Those copies are what a program passing buffers between threads wants to
+// avoid, so the number of bytes copied this way is counted, and can be
+// retrieved with getBytesCopied. To avoid copies, hand buffers on by
+// std::move when you've finished with them, and read shared buffers through
+// const references.
+//
+// The samples are stored in blocks from VideoBufferPool, so allocating a
+// buffer normally reuses the memory of one that has been freed, and the
+// samples are aligned to VideoBufferPool::ALIGNMENT bytes. Alternatively, a
+// buffer can refer to read-only samples owned by something else, such as a
+// memory-mapped file (see fromExternal); these are copied when written to.
+class VideoBuffer
+{
+public:
+    using value_type = quint16;
+    using iterator = quint16 *;
+    using const_iterator = const quint16 *;
+
+    VideoBuffer() : d(nullptr) {}
+    explicit VideoBuffer(qint32 size);
+    VideoBuffer(qint32 size, quint16 value);
+    VideoBuffer(const quint16 *samples, qint32 size);
+    ~VideoBuffer() { release(); }
+
+    // Return a buffer that refers to size samples owned by something else,
+    // without copying them. The samples must not change while any buffer
+    // refers to them; owner is kept alive until then.
+    static VideoBuffer fromExternal(const quint16 *samples, qint32 size, std::shared_ptr<const void> owner);
+
+    VideoBuffer(const VideoBuffer &other) : d(other.d) {
+        if (d != nullptr) d->ref.fetch_add(1, std::memory_order_relaxed);
+    }
+    VideoBuffer(VideoBuffer &&other) noexcept : d(other.d) {
+        other.d = nullptr;
+    }
+    VideoBuffer &operator=(const VideoBuffer &other);
+    VideoBuffer &operator=(VideoBuffer &&other) noexcept;
+
+    // Size
+    qint32 size() const { return d == nullptr ? 0 : d->size; }
+    qint32 count() const { return size(); }
+    bool empty() const { return size() == 0; }
+    bool isEmpty() const { return size() == 0; }
+
+    // Read access
+    const quint16 *constData() const { return d == nullptr ? nullptr : d->samples(); }
+    const quint16 *data() const { return constData(); }
+    const quint16 &at(qint32 index) const { return d->samples()[index]; }
+    const quint16 &operator[](qint32 index) const { return d->samples()[index]; }
+    const_iterator begin() const { return constData(); }
+    const_iterator end() const { return constData() + size(); }
+    const_iterator constBegin() const { return begin(); }
+    const_iterator constEnd() const { return end(); }
+
+    // Write access (copying the samples first if they are shared)
+    quint16 *data() { detach(); return d == nullptr ? nullptr : d->samples(); }
+    quint16 &operator[](qint32 index) { return data()[index]; }
+    iterator begin() { return data(); }
+    iterator end() { return data() + size(); }
+
+    // Modifiers
+    void resize(qint32 size);
+    void fill(quint16 value, qint32 size = -1);
+    void append(quint16 value);
+    void remove(qint32 position, qint32 count);
+    void clear() { release(); }
+
+    // Return a new buffer containing a copy of part of this one
+    VideoBuffer mid(qint32 position, qint32 length = -1) const;
+
+    // Make sure this buffer's samples are not shared with any other buffer
+    void detach() {
+        if (isShared()) detachShared();
+    }
+
+    // Return true if this buffer's samples are shared with another buffer, or
+    // are external, so writing to it would copy them
+    bool isShared() const {
+        return d != nullptr && (d->ref.load(std::memory_order_acquire) != 1 || d->owner != nullptr);
+    }
+
+    bool operator==(const VideoBuffer &other) const;
+    bool operator!=(const VideoBuffer &other) const { return !(*this == other); }
+
+    // Return the total number of bytes that have been copied because a shared
+    // buffer was written to (in all threads)
+    static qint64 getBytesCopied();
+
+private:
+    // The samples follow the header in the same block, unless they're
+    // external. The header is padded to the block alignment, so the samples
+    // are aligned too.
+    struct alignas(64) Header {
+        std::atomic<qint32> ref;
+        qint32 size;
+        qint32 capacity;
+        quint16 *sampleData;
+
+        // The owner of external samples (or null)
+        std::shared_ptr<const void> owner;
+
+        quint16 *samples() { return sampleData; }
+    };
+    Header *d;
+
+    static Header *allocate(qint32 capacity);
+    void release();
+    void detachShared();
+    void reallocate(qint32 capacity, qint32 keepSize);
+};
+
+Q_DECLARE_TYPEINFO(VideoBuffer, Q_MOVABLE_TYPE);
+
+#endif // VIDEOBUFFER_H
@@ -0,0 +1,193 @@
+/************************************************************************
+
+    videobufferpool.cpp
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "videobufferpool.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#if defined(Q_OS_LINUX)
+#include <sys/mman.h>
+#endif
+
+// Definitions of static constexpr data members, for compatibility with
+// pre-C++17 compilers
+constexpr size_t VideoBufferPool::ALIGNMENT;
+constexpr size_t VideoBufferPool::HUGE_PAGE_SIZE;
+constexpr size_t VideoBufferPool::ARENA_SIZE;
+constexpr size_t VideoBufferPool::MAX_ARENA_BLOCK;
+constexpr size_t VideoBufferPool::MAX_FREE_LARGE_BYTES;
+
+namespace {
+    // The pool's state. This is allocated on first use and never destroyed,
+    // so that buffers can safely be released during program exit.
+    struct PoolState {
+        QMutex mutex;
+        bool hugePages = false;
+
+        // Free blocks, indexed by block size
+        QHash<quint64, QVector<void *>> freeLists;
+        size_t freeLargeBytes = 0;
+
+        // The unused part of the current arena
+        uchar *arenaNext = nullptr;
+        size_t arenaRemaining = 0;
+
+        VideoBufferPool::Statistics statistics {0, 0, 0, 0, 0};
+    };
+
+    PoolState &getState()
+    {
+        static PoolState *state = new PoolState;
+        return *state;
+    }
+
+    size_t roundUp(size_t size, size_t multiple)
+    {
+        return ((size + multiple - 1) / multiple) * multiple;
+    }
+
+    size_t getBlockSizeFor(size_t size, bool hugePages)
+    {
+        // Small blocks are a multiple of the alignment
+        const size_t smallLimit = 8 * VideoBufferPool::ALIGNMENT;
+        if (size <= smallLimit) return roundUp(qMax(size, static_cast<size_t>(1)), VideoBufferPool::ALIGNMENT);
+
+        // Otherwise, there are eight size classes for each power of two, so
+        // at most 1/8 of a block is wasted. For size in (2^n, 2^(n + 1)], the
+        // step is 2^(n - 3).
+        size_t powerOfTwo = smallLimit;
+        while (powerOfTwo * 2 < size) powerOfTwo *= 2;
+        size_t blockSize = roundUp(size, powerOfTwo / 8);
+
+        // Blocks too big for an arena are allocated in whole huge pages
+        if (hugePages && blockSize > VideoBufferPool::MAX_ARENA_BLOCK) {
+            blockSize = roundUp(blockSize, VideoBufferPool::HUGE_PAGE_SIZE);
+        }
+
+        return blockSize;
+    }
+
+    // Get memory from the system. You must hold the pool's mutex to call this.
+    void *allocateFromSystem(PoolState &pool, size_t size)
+    {
+        const size_t alignment = pool.hugePages ? VideoBufferPool::HUGE_PAGE_SIZE : VideoBufferPool::ALIGNMENT;
+        void *memory = qMallocAligned(size, alignment);
+        Q_CHECK_PTR(memory);
+
+#if defined(Q_OS_LINUX) && defined(MADV_HUGEPAGE)
+        // This is only advice, so it doesn't matter if it fails
+        if (pool.hugePages) madvise(memory, size, MADV_HUGEPAGE);
+#endif
+
+        pool.statistics.bytesReserved += static_cast<qint64>(size);
+        return memory;
+    }
+}
+
+void *VideoBufferPool::allocate(size_t size, size_t &blockSize)
+{
+    PoolState &pool = getState();
+    QMutexLocker locker(&pool.mutex);
+
+    blockSize = getBlockSizeFor(size, pool.hugePages);
+
+    // Is there a free block of the right size?
+    auto it = pool.freeLists.find(blockSize);
+    if (it != pool.freeLists.end() && !it->isEmpty()) {
+        void *block = it->takeLast();
+        if (blockSize > MAX_ARENA_BLOCK) pool.freeLargeBytes -= blockSize;
+        pool.statistics.reuses++;
+        pool.statistics.bytesFree -= static_cast<qint64>(blockSize);
+        return block;
+    }
+
+    pool.statistics.allocations++;
+
+    if (blockSize > MAX_ARENA_BLOCK) {
+        // Too big for an arena -- allocate it by itself
+        return allocateFromSystem(pool, blockSize);
+    }
+
+    if (blockSize > pool.arenaRemaining) {
+        // Start a new arena. The rest of the old one is wasted, but that's
+        // at most MAX_ARENA_BLOCK bytes.
+        pool.arenaNext = static_cast<uchar *>(allocateFromSystem(pool, ARENA_SIZE));
+        pool.arenaRemaining = ARENA_SIZE;
+    }
+
+    void *block = pool.arenaNext;
+    pool.arenaNext += blockSize;
+    pool.arenaRemaining -= blockSize;
+    return block;
+}
+
+void VideoBufferPool::release(void *block, size_t blockSize)
+{
+    if (block == nullptr) return;
+
+    PoolState &pool = getState();
+    QMutexLocker locker(&pool.mutex);
+
+    pool.statistics.releases++;
+
+    if (blockSize > MAX_ARENA_BLOCK) {
+        // Large blocks can be given back to the system if we have too many
+        if (pool.freeLargeBytes + blockSize > MAX_FREE_LARGE_BYTES) {
+            qFreeAligned(block);
+            pool.statistics.bytesReserved -= static_cast<qint64>(blockSize);
+            return;
+        }
+        pool.freeLargeBytes += blockSize;
+    }
+
+    pool.freeLists[blockSize].append(block);
+    pool.statistics.bytesFree += static_cast<qint64>(blockSize);
+}
+
+void VideoBufferPool::setHugePages(bool enabled)
+{
+    PoolState &pool = getState();
+    QMutexLocker locker(&pool.mutex);
+
+    pool.hugePages = enabled;
+}
+
+VideoBufferPool::Statistics VideoBufferPool::getStatistics()
+{
+    PoolState &pool = getState();
+    QMutexLocker locker(&pool.mutex);
+
+    return pool.statistics;
+}
+
+size_t VideoBufferPool::getBlockSize(size_t size)
+{
+    PoolState &pool = getState();
+    QMutexLocker locker(&pool.mutex);
+
+    return getBlockSizeFor(size, pool.hugePages);
+}
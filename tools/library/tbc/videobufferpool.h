@@ -0,0 +1,86 @@
+/************************************************************************
+
+    videobufferpool.h
+
+    ld-decode-tools TBC library
+    Copyright (C) 2021 Adam Sampson
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef VIDEOBUFFERPOOL_H
+#define VIDEOBUFFERPOOL_H
+
+#include <QtGlobal>
+
+#include <cstddef>
+
+// A process-wide pool of memory blocks for VideoBuffers.
+//
+// The tools allocate and free a field-sized buffer for every field they
+// process. Rather than going to the system allocator each time (which, for
+// blocks this size, usually means mapping and faulting in fresh pages), the
+// pool keeps released blocks on free lists and hands them out again.
+//
+// Requested sizes are rounded up to a size class, with eight classes per
+// power of two, so buffers of similar sizes can share blocks. Blocks up to
+// MAX_ARENA_BLOCK bytes are carved out of large arenas; arenas are never
+// returned to the system, so the pool holds on to the peak amount of memory
+// in use. Larger blocks are allocated individually, and freed if the free
+// lists are holding too much memory.
+//
+// All blocks are aligned to ALIGNMENT bytes. If huge pages are enabled, new
+// arenas and large blocks are aligned to HUGE_PAGE_SIZE and the system is
+// asked to back them with huge pages (on Linux, using transparent huge pages).
+class VideoBufferPool
+{
+public:
+    static constexpr size_t ALIGNMENT = 64;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    static constexpr size_t ARENA_SIZE = 32 * 1024 * 1024;
+    static constexpr size_t MAX_ARENA_BLOCK = ARENA_SIZE / 4;
+    static constexpr size_t MAX_FREE_LARGE_BYTES = 256 * 1024 * 1024;
+
+    struct Statistics {
+        // Blocks that had to be allocated because no free block was available
+        qint64 allocations;
+        // Blocks that were reused from a free list
+        qint64 reuses;
+        // Blocks that were released back to the pool
+        qint64 releases;
+        // Bytes obtained from the system, and not yet returned
+        qint64 bytesReserved;
+        // Bytes in blocks on the free lists
+        qint64 bytesFree;
+    };
+
+    // Return a block of at least size bytes, setting blockSize to its actual size
+    static void *allocate(size_t size, size_t &blockSize);
+
+    // Return a block to the pool. blockSize must be the size allocate returned.
+    static void release(void *block, size_t blockSize);
+
+    // Enable or disable huge pages for memory allocated from now on
+    static void setHugePages(bool enabled);
+
+    static Statistics getStatistics();
+
+    // Return the size of the block that would be allocated for size bytes
+    static size_t getBlockSize(size_t size);
+};
+
+#endif // VIDEOBUFFERPOOL_H